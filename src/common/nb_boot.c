@@ -0,0 +1,496 @@
+/*
+ * nb_boot.c - Parallel Startup Orchestrator and Boot Timeline
+ *
+ * NetBlade OS v3.x Common Library
+ * Copyright (c) 2024-2026 Enterprise Systems Inc. All rights reserved.
+ *
+ * Startup tasks form a dependency graph and run on a small thread pool.
+ * Whenever a thread is free it takes the ready task with the best
+ * priority, so critical VRFs and the HA role are up before bulk work
+ * starts.
+ *
+ * The timeline is measured from the moment the kernel started the
+ * process (from /proc/self/stat, 10 ms resolution), not from when this
+ * module was first used, so time spent loading and parsing
+ * configuration before startup is counted.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+#include <stdbool.h>
+#include <stdatomic.h>
+#include <time.h>
+#include <unistd.h>
+#include <pthread.h>
+#include "nb_boot.h"
+#include "nb_mutex.h"
+#include "syslog.h"
+
+typedef struct {
+    nb_boot_task_info_t info;
+    nb_boot_fn_t        fn;
+    void               *ctx;
+    uint8_t             deps[NB_BOOT_MAX_DEPS];
+    uint8_t             dep_count;
+} nb_boot_task_t;
+
+static const char *nb_boot_milestone_names[NB_BOOT_MILESTONES] = {
+    [NB_BOOT_PROCESS_START]  = "process_start",
+    [NB_BOOT_CRITICAL_READY] = "critical_ready",
+    [NB_BOOT_TIMERS_READY]   = "timers_ready",
+    [NB_BOOT_INIT_DONE]      = "init_done",
+    [NB_BOOT_FIRST_SESSION]  = "first_session",
+    [NB_BOOT_CONVERGED]      = "converged",
+};
+
+static const char *nb_boot_state_names[] = {
+    "pending", "running", "done", "failed", "skipped",
+};
+
+static struct {
+    nb_boot_task_t    tasks[NB_BOOT_MAX_TASKS];
+    int               count;
+    int               finished;
+    int               running;
+    bool              critical_failed;
+    nb_mutex_t        lock;
+    pthread_cond_t    cond;
+
+    /* Sessions already counted as converged, until NB_BOOT_CONVERGED */
+    const void      **converged_set;
+    uint32_t          converged_mask;
+
+    uint64_t          start_boot_ns;    /* Process start on CLOCK_BOOTTIME */
+    _Atomic uint64_t  milestones[NB_BOOT_MILESTONES];
+    _Atomic uint32_t  sessions_expected;
+    _Atomic uint32_t  sessions_converged;
+} boot = {
+    .lock = NB_MUTEX_INITIALIZER("nb_boot.lock"),
+    .cond = PTHREAD_COND_INITIALIZER,
+};
+
+static uint64_t nb_boot_clock_ns(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_BOOTTIME, &ts);
+    return (uint64_t)ts.tv_sec * 1000000000ULL + (uint64_t)ts.tv_nsec;
+}
+
+/* Field 22 of /proc/self/stat: start time in clock ticks after boot */
+static uint64_t nb_boot_process_start(void)
+{
+    char buf[1024];
+    unsigned long long ticks = 0;
+
+    FILE *f = fopen("/proc/self/stat", "r");
+    if (!f) return nb_boot_clock_ns();
+
+    size_t n = fread(buf, 1, sizeof(buf) - 1, f);
+    fclose(f);
+    buf[n] = '\0';
+
+    /* comm may contain spaces; fields are counted from the closing paren */
+    char *p = strrchr(buf, ')');
+    if (!p || sscanf(p + 2, "%*c %*d %*d %*d %*d %*d %*u %*u %*u %*u %*u %*u %*u "
+                     "%*d %*d %*d %*d %*d %*d %llu", &ticks) != 1) {
+        return nb_boot_clock_ns();
+    }
+    return (uint64_t)ticks * 1000000000ULL / (uint64_t)sysconf(_SC_CLK_TCK);
+}
+
+static pthread_once_t nb_boot_once = PTHREAD_ONCE_INIT;
+
+static void nb_boot_origin(void)
+{
+    boot.start_boot_ns = nb_boot_process_start();
+}
+
+static uint64_t nb_boot_now(void)
+{
+    pthread_once(&nb_boot_once, nb_boot_origin);
+
+    uint64_t now = nb_boot_clock_ns();
+    return now > boot.start_boot_ns ? now - boot.start_boot_ns : 1;
+}
+
+void nb_boot_mark(uint8_t milestone)
+{
+    uint64_t expected = 0;
+
+    if (milestone >= NB_BOOT_MILESTONES) return;
+
+    uint64_t now = milestone == NB_BOOT_PROCESS_START ? 1 : nb_boot_now();
+    if (atomic_compare_exchange_strong(&boot.milestones[milestone], &expected, now)) {
+        syslog_write(LOG_INFO, "Boot: %s at %.3f s", nb_boot_milestone_names[milestone],
+            (double)now / 1e9);
+    }
+}
+
+uint64_t nb_boot_milestone_ns(uint8_t milestone)
+{
+    if (milestone >= NB_BOOT_MILESTONES) return 0;
+    /* Process start is the origin; stored as 1 so it reads as reached */
+    uint64_t ns = atomic_load(&boot.milestones[milestone]);
+    return milestone == NB_BOOT_PROCESS_START ? 0 : ns;
+}
+
+const char *nb_boot_milestone_name(uint8_t milestone)
+{
+    return milestone < NB_BOOT_MILESTONES ? nb_boot_milestone_names[milestone] : "unknown";
+}
+
+/* Called with the lock held */
+static void nb_boot_check_converged(void)
+{
+    uint32_t expected = atomic_load(&boot.sessions_expected);
+
+    if (expected == 0 || atomic_load(&boot.sessions_converged) < expected) return;
+
+    nb_boot_mark(NB_BOOT_CONVERGED);
+    free(boot.converged_set);
+    boot.converged_set = NULL;
+}
+
+void nb_boot_expect_sessions(uint32_t count)
+{
+    nb_mutex_lock(&boot.lock);
+    atomic_store(&boot.sessions_expected, count);
+    nb_boot_check_converged();
+    nb_mutex_unlock(&boot.lock);
+}
+
+void nb_boot_session_established(void)
+{
+    nb_boot_mark(NB_BOOT_FIRST_SESSION);
+}
+
+/*
+ * A session that flaps during bring-up reaches End-of-RIB more than
+ * once; only its first time counts towards NB_BOOT_CONVERGED.
+ */
+void nb_boot_session_converged(const void *session)
+{
+    if (nb_boot_milestone_ns(NB_BOOT_CONVERGED) != 0) return;
+
+    nb_mutex_lock(&boot.lock);
+
+    if (!boot.converged_set && nb_boot_milestone_ns(NB_BOOT_CONVERGED) == 0) {
+        boot.converged_set = calloc(NB_BOOT_MAX_SESSIONS * 2, sizeof(const void *));
+        boot.converged_mask = NB_BOOT_MAX_SESSIONS * 2 - 1;
+        if (!boot.converged_set) {
+            syslog_write(LOG_WARNING, "Boot: No memory to track converged sessions");
+        }
+    }
+
+    bool counted = false;
+    if (boot.converged_set) {
+        uint32_t i = (uint32_t)(((uintptr_t)session >> 4) * 2654435761u) & boot.converged_mask;
+
+        for (uint32_t probes = 0; probes <= boot.converged_mask; probes++) {
+            if (boot.converged_set[i] == session) {
+                counted = true;
+                break;
+            }
+            if (!boot.converged_set[i]) {
+                boot.converged_set[i] = session;
+                break;
+            }
+            i = (i + 1) & boot.converged_mask;
+        }
+    }
+
+    if (!counted) {
+        atomic_fetch_add(&boot.sessions_converged, 1);
+        nb_boot_check_converged();
+    }
+
+    nb_mutex_unlock(&boot.lock);
+}
+
+bool nb_boot_critical_failed(void)
+{
+    nb_mutex_lock(&boot.lock);
+    bool failed = boot.critical_failed;
+    nb_mutex_unlock(&boot.lock);
+    return failed;
+}
+
+int nb_boot_add(const char *name, nb_boot_fn_t fn, void *ctx, uint8_t priority)
+{
+    if (!fn || priority > NB_BOOT_PRIO_BACKGROUND) return -1;
+
+    nb_mutex_lock(&boot.lock);
+
+    if (boot.count >= NB_BOOT_MAX_TASKS) {
+        nb_mutex_unlock(&boot.lock);
+        return -1;
+    }
+
+    int id = boot.count++;
+    nb_boot_task_t *t = &boot.tasks[id];
+
+    memset(t, 0, sizeof(nb_boot_task_t));
+    strncpy(t->info.name, name, sizeof(t->info.name) - 1);
+    t->info.priority = priority;
+    t->info.state = NB_BOOT_PENDING;
+    t->fn = fn;
+    t->ctx = ctx;
+
+    nb_mutex_unlock(&boot.lock);
+    return id;
+}
+
+int nb_boot_after(int task, int dep)
+{
+    int ret = -1;
+
+    nb_mutex_lock(&boot.lock);
+
+    /* Dependencies only point backwards, so the graph cannot have a cycle */
+    if (task >= 0 && task < boot.count && dep >= 0 && dep < task) {
+        nb_boot_task_t *t = &boot.tasks[task];
+        if (t->dep_count < NB_BOOT_MAX_DEPS) {
+            t->deps[t->dep_count++] = (uint8_t)dep;
+            ret = 0;
+        }
+    }
+
+    nb_mutex_unlock(&boot.lock);
+    return ret;
+}
+
+/*
+ * Called with the lock held once every critical task has finished.
+ * Marks NB_BOOT_CRITICAL_READY only if all of them succeeded; otherwise
+ * the failure is logged once and reported by nb_boot_critical_failed().
+ */
+static void nb_boot_critical_settle(void)
+{
+    int failed = -1;
+
+    for (int i = 0; i < boot.count; i++) {
+        const nb_boot_task_info_t *t = &boot.tasks[i].info;
+        if (t->priority != NB_BOOT_PRIO_CRITICAL) continue;
+        if (t->state == NB_BOOT_PENDING || t->state == NB_BOOT_RUNNING) return;
+        if (t->state != NB_BOOT_DONE && failed < 0) failed = i;
+    }
+
+    if (failed < 0) {
+        nb_boot_mark(NB_BOOT_CRITICAL_READY);
+    } else if (!boot.critical_failed) {
+        boot.critical_failed = true;
+        syslog_write(LOG_CRIT, "Boot: Critical startup failed, %s %s",
+            boot.tasks[failed].info.name, nb_boot_state_names[boot.tasks[failed].info.state]);
+    }
+}
+
+/*
+ * Called with the lock held. Skips tasks whose dependencies failed and
+ * returns the best ready task, or -1.
+ */
+static int nb_boot_next(void)
+{
+    int best = -1;
+
+    for (int i = 0; i < boot.count; i++) {
+        nb_boot_task_t *t = &boot.tasks[i];
+        if (t->info.state != NB_BOOT_PENDING) continue;
+
+        bool ready = true, doomed = false;
+        for (int d = 0; d < t->dep_count; d++) {
+            uint8_t st = boot.tasks[t->deps[d]].info.state;
+            if (st == NB_BOOT_FAILED || st == NB_BOOT_SKIPPED) doomed = true;
+            if (st != NB_BOOT_DONE) ready = false;
+        }
+
+        if (doomed) {
+            /* Dependencies come earlier, so one forward pass settles the chain */
+            t->info.state = NB_BOOT_SKIPPED;
+            boot.finished++;
+            syslog_write(LOG_ERR, "Boot: Skipping %s, a dependency failed", t->info.name);
+            continue;
+        }
+        if (ready && (best < 0 || t->info.priority < boot.tasks[best].info.priority)) {
+            best = i;
+        }
+    }
+    return best;
+}
+
+static void *nb_boot_worker(void *arg)
+{
+    (void)arg;
+
+    nb_mutex_lock(&boot.lock);
+    for (;;) {
+        int id = nb_boot_next();
+
+        if (id < 0) {
+            if (boot.finished == boot.count) break;
+            if (boot.running == 0) {
+                /* Nothing running and nothing ready: cannot happen with backward deps */
+                break;
+            }
+            nb_cond_wait(&boot.cond, &boot.lock);
+            continue;
+        }
+
+        nb_boot_task_t *t = &boot.tasks[id];
+        t->info.state = NB_BOOT_RUNNING;
+        t->info.start_ns = nb_boot_now();
+        boot.running++;
+        nb_mutex_unlock(&boot.lock);
+
+        int ret = t->fn(t->ctx);
+
+        nb_mutex_lock(&boot.lock);
+        t->info.end_ns = nb_boot_now();
+        t->info.result = ret;
+        t->info.state = ret == 0 ? NB_BOOT_DONE : NB_BOOT_FAILED;
+        boot.running--;
+        boot.finished++;
+
+        if (ret != 0) {
+            syslog_write(LOG_ERR, "Boot: %s failed (%d)", t->info.name, ret);
+        }
+        nb_boot_critical_settle();
+        pthread_cond_broadcast(&boot.cond);
+    }
+    pthread_cond_broadcast(&boot.cond);
+    nb_mutex_unlock(&boot.lock);
+    return NULL;
+}
+
+int nb_boot_run(int threads)
+{
+    pthread_t tids[NB_BOOT_MAX_THREADS];
+    int started = 0, failed = 0;
+
+    if (threads < 1) threads = 1;
+    if (threads > NB_BOOT_MAX_THREADS) threads = NB_BOOT_MAX_THREADS;
+
+    nb_boot_mark(NB_BOOT_PROCESS_START);
+    uint64_t t0 = nb_boot_now();
+
+    nb_mutex_lock(&boot.lock);
+    boot.finished = 0;
+    boot.running = 0;
+    boot.critical_failed = false;
+    bool critical = false;
+    for (int i = 0; i < boot.count; i++) {
+        if (boot.tasks[i].info.priority == NB_BOOT_PRIO_CRITICAL) critical = true;
+    }
+    nb_mutex_unlock(&boot.lock);
+
+    if (!critical) nb_boot_mark(NB_BOOT_CRITICAL_READY);
+
+    /* The calling thread is one of the workers */
+    for (int i = 1; i < threads; i++) {
+        if (pthread_create(&tids[started], NULL, nb_boot_worker, NULL) == 0) started++;
+    }
+    nb_boot_worker(NULL);
+    for (int i = 0; i < started; i++) {
+        pthread_join(tids[i], NULL);
+    }
+
+    /* A critical task skipped last is only settled here */
+    nb_mutex_lock(&boot.lock);
+    if (critical) nb_boot_critical_settle();
+    nb_mutex_unlock(&boot.lock);
+
+    for (int i = 0; i < boot.count; i++) {
+        if (boot.tasks[i].info.state != NB_BOOT_DONE) failed++;
+    }
+
+    nb_boot_mark(NB_BOOT_INIT_DONE);
+    syslog_write(LOG_INFO, "Boot: %d tasks on %d threads in %.1f ms, %d failed or skipped",
+        boot.count, threads, (double)(nb_boot_now() - t0) / 1e6, failed);
+
+    return failed ? -1 : 0;
+}
+
+int nb_boot_get_tasks(nb_boot_task_info_t *tasks, int max)
+{
+    int n = 0;
+
+    nb_mutex_lock(&boot.lock);
+    for (int i = 0; i < boot.count && n < max; i++) {
+        tasks[n++] = boot.tasks[i].info;
+    }
+    nb_mutex_unlock(&boot.lock);
+
+    return n;
+}
+
+int nb_boot_export(const char *path)
+{
+    nb_boot_task_info_t tasks[NB_BOOT_MAX_TASKS];
+    char tmp[256];
+
+    int n = nb_boot_get_tasks(tasks, NB_BOOT_MAX_TASKS);
+
+    snprintf(tmp, sizeof(tmp), "%s.tmp", path);
+    FILE *f = fopen(tmp, "w");
+    if (!f) {
+        syslog_write(LOG_ERR, "Boot: Cannot open %s", tmp);
+        return -1;
+    }
+
+    fprintf(f, "# HELP netblade_boot_milestone_seconds Time from process start to milestone\n");
+    fprintf(f, "# TYPE netblade_boot_milestone_seconds gauge\n");
+    for (uint8_t m = 0; m < NB_BOOT_MILESTONES; m++) {
+        if (m != NB_BOOT_PROCESS_START && nb_boot_milestone_ns(m) == 0) continue;
+        fprintf(f, "netblade_boot_milestone_seconds{milestone=\"%s\"} %.6f\n",
+            nb_boot_milestone_names[m], (double)nb_boot_milestone_ns(m) / 1e9);
+    }
+
+    fprintf(f, "# HELP netblade_boot_critical_failed A critical startup task failed or was skipped\n");
+    fprintf(f, "# TYPE netblade_boot_critical_failed gauge\n");
+    fprintf(f, "netblade_boot_critical_failed %d\n", nb_boot_critical_failed() ? 1 : 0);
+
+    fprintf(f, "# HELP netblade_boot_task_start_seconds Time from process start to task start\n");
+    fprintf(f, "# TYPE netblade_boot_task_start_seconds gauge\n");
+    for (int i = 0; i < n; i++) {
+        if (tasks[i].start_ns == 0) continue;
+        fprintf(f, "netblade_boot_task_start_seconds{task=\"%s\"} %.6f\n",
+            tasks[i].name, (double)tasks[i].start_ns / 1e9);
+    }
+
+    fprintf(f, "# HELP netblade_boot_task_duration_seconds Task run time\n");
+    fprintf(f, "# TYPE netblade_boot_task_duration_seconds gauge\n");
+    for (int i = 0; i < n; i++) {
+        if (tasks[i].end_ns == 0) continue;
+        fprintf(f, "netblade_boot_task_duration_seconds{task=\"%s\",state=\"%s\"} %.6f\n",
+            tasks[i].name, nb_boot_state_names[tasks[i].state],
+            (double)(tasks[i].end_ns - tasks[i].start_ns) / 1e9);
+    }
+
+    /* Writers to a textfile collector must replace, never rewrite in place */
+    if (fclose(f) != 0 || rename(tmp, path) != 0) {
+        syslog_write(LOG_ERR, "Boot: Cannot write %s", path);
+        unlink(tmp);
+        return -1;
+    }
+    return 0;
+}
+
+void nb_boot_dump(void)
+{
+    nb_boot_task_info_t tasks[NB_BOOT_MAX_TASKS];
+    int n = nb_boot_get_tasks(tasks, NB_BOOT_MAX_TASKS);
+
+    syslog_write(LOG_INFO, "Boot timeline:");
+    for (uint8_t m = 1; m < NB_BOOT_MILESTONES; m++) {
+        uint64_t ns = nb_boot_milestone_ns(m);
+        if (ns) syslog_write(LOG_INFO, "  %-16s %9.3f s", nb_boot_milestone_names[m], (double)ns / 1e9);
+    }
+    if (nb_boot_critical_failed()) syslog_write(LOG_INFO, "  critical startup FAILED");
+    for (int i = 0; i < n; i++) {
+        syslog_write(LOG_INFO, "  task %-20s prio %d %-8s %9.3f s +%.1f ms",
+            tasks[i].name, tasks[i].priority, nb_boot_state_names[tasks[i].state],
+            (double)tasks[i].start_ns / 1e9,
+            (double)(tasks[i].end_ns - tasks[i].start_ns) / 1e6);
+    }
+}
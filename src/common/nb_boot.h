@@ -0,0 +1,96 @@
+/*
+ * nb_boot.h - Parallel Startup Orchestrator and Boot Timeline
+ *
+ * NetBlade OS v3.x Common Library
+ * Copyright (c) 2024-2026 Enterprise Systems Inc. All rights reserved.
+ */
+
+#ifndef NB_BOOT_H
+#define NB_BOOT_H
+
+#include <stdint.h>
+#include <stdbool.h>
+
+#define NB_BOOT_MAX_TASKS       32
+#define NB_BOOT_MAX_DEPS        8
+#define NB_BOOT_MAX_THREADS     8
+#define NB_BOOT_MAX_SESSIONS    16384   /* Matches BGP_IO_MAX_CONNS */
+#define NB_BOOT_METRICS_PATH    "/var/lib/netblade/metrics/boot.prom"
+
+/* Ready tasks start in priority order */
+#define NB_BOOT_PRIO_CRITICAL   0   /* Critical VRFs, HA role */
+#define NB_BOOT_PRIO_NORMAL     1
+#define NB_BOOT_PRIO_BACKGROUND 2
+
+/* Task states */
+#define NB_BOOT_PENDING         0
+#define NB_BOOT_RUNNING         1
+#define NB_BOOT_DONE            2
+#define NB_BOOT_FAILED          3
+#define NB_BOOT_SKIPPED         4   /* A dependency failed */
+
+/* Timeline milestones */
+#define NB_BOOT_PROCESS_START   0
+#define NB_BOOT_CRITICAL_READY  1   /* Every critical task succeeded */
+#define NB_BOOT_TIMERS_READY    2   /* bgp_timers_init() complete */
+#define NB_BOOT_INIT_DONE       3   /* Every task done */
+#define NB_BOOT_FIRST_SESSION   4   /* First BGP session Established */
+#define NB_BOOT_CONVERGED       5   /* Every expected session past End-of-RIB */
+#define NB_BOOT_MILESTONES      6
+
+typedef int (*nb_boot_fn_t)(void *ctx);
+
+typedef struct {
+    char     name[32];
+    uint8_t  priority;
+    uint8_t  state;
+    int      result;
+    uint64_t start_ns;          /* Since process start */
+    uint64_t end_ns;
+} nb_boot_task_info_t;
+
+/*
+ * Startup is described as tasks and dependencies, then run:
+ *
+ *   int vrf  = nb_boot_add("vrf-critical", vrf_up_critical, NULL, NB_BOOT_PRIO_CRITICAL);
+ *   int ha   = nb_boot_add("cluster", cluster_boot, &cfg, NB_BOOT_PRIO_CRITICAL);
+ *   int rest = nb_boot_add("vrf-rest", vrf_up_rest, NULL, NB_BOOT_PRIO_NORMAL);
+ *   int tmr  = nb_boot_add("bgp-timers", bgp_timers_boot, NULL, NB_BOOT_PRIO_NORMAL);
+ *   nb_boot_after(rest, vrf);
+ *   nb_boot_after(tmr, rest);
+ *   nb_boot_run(4);
+ *
+ * Tasks whose dependencies are met run concurrently. A failed task
+ * skips everything that depends on it.
+ */
+int nb_boot_add(const char *name, nb_boot_fn_t fn, void *ctx, uint8_t priority);
+/* task runs after dep; dep must have been added first */
+int nb_boot_after(int task, int dep);
+/* Returns 0 if every task succeeded */
+int nb_boot_run(int threads);
+/* A critical task failed or was skipped; NB_BOOT_CRITICAL_READY is never marked */
+bool nb_boot_critical_failed(void);
+
+/* First call for a milestone records it; later calls are ignored */
+void nb_boot_mark(uint8_t milestone);
+/* Nanoseconds from process start, or 0 if not reached */
+uint64_t nb_boot_milestone_ns(uint8_t milestone);
+const char *nb_boot_milestone_name(uint8_t milestone);
+
+/*
+ * Sessions that must converge before NB_BOOT_CONVERGED. The BGP side
+ * reports each session's first Established and End-of-RIB through
+ * bgp_admission; a session is identified by its context pointer and
+ * counted once however often it flaps.
+ */
+void nb_boot_expect_sessions(uint32_t count);
+void nb_boot_session_established(void);
+void nb_boot_session_converged(const void *session);
+
+int nb_boot_get_tasks(nb_boot_task_info_t *tasks, int max);
+
+/* Prometheus text format, for the node exporter textfile collector */
+int nb_boot_export(const char *path);
+void nb_boot_dump(void);
+
+#endif /* NB_BOOT_H */
@@ -0,0 +1,287 @@
+/*
+ * nb_mutex.c - Instrumented Mutex and Lock Contention Profiler
+ *
+ * NetBlade OS v3.x Common Library
+ * Copyright (c) 2024-2026 Enterprise Systems Inc. All rights reserved.
+ *
+ * While profiling is on, every acquisition is tried first; only a
+ * failed trylock is timed, and the wait is charged both to the waiting
+ * site and to the site that held the lock at the time. Hold time is
+ * measured from acquisition to unlock. Statistics are written by the
+ * lock holder only, so they need no extra synchronisation; the dump
+ * reads them unlocked and may be off by an acquisition or two.
+ *
+ * The registry lock is taken with arbitrary profiled locks held, so
+ * nothing under it may take an nb_mutex_t. A reset therefore only bumps
+ * a generation; each lock clears its own statistics the next time it
+ * is acquired, and the dump skips locks not acquired since.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+#include "nb_mutex.h"
+#include "syslog.h"
+
+#define NB_LOCKPROF_TOP_SITES   5
+
+_Atomic bool nb_lockprof_enabled = false;
+static _Atomic uint64_t nb_lockprof_gen = 1;
+
+static struct {
+    pthread_mutex_t  lock;
+    nb_mutex_t      *head;
+} lockprof = {
+    .lock = PTHREAD_MUTEX_INITIALIZER,
+};
+
+static const nb_lock_site_t nb_site_other = { "(other)", 0 };
+
+static uint64_t nb_now_ns(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000000000ULL + (uint64_t)ts.tv_nsec;
+}
+
+static void nb_hist_add(uint64_t *hist, uint64_t ns)
+{
+    int b = ns ? 63 - __builtin_clzll(ns) : 0;
+    if (b >= NB_LOCK_HIST_BUCKETS) b = NB_LOCK_HIST_BUCKETS - 1;
+    hist[b]++;
+}
+
+/* Upper bound of the bucket holding the given percentile */
+static uint64_t nb_hist_pct(const uint64_t *hist, uint64_t total, int pct)
+{
+    uint64_t want = (total * (uint64_t)pct + 99) / 100;
+    uint64_t seen = 0;
+
+    if (total == 0) return 0;
+
+    for (int b = 0; b < NB_LOCK_HIST_BUCKETS; b++) {
+        seen += hist[b];
+        if (seen >= want) return 2ULL << b;
+    }
+    return 2ULL << (NB_LOCK_HIST_BUCKETS - 1);
+}
+
+static nb_lock_site_stats_t *nb_site_slot(nb_mutex_t *m, const nb_lock_site_t *site)
+{
+    for (int i = 0; i < NB_LOCK_MAX_SITES - 1; i++) {
+        nb_lock_site_stats_t *s = &m->sites[i];
+        if (s->site == site) return s;
+        if (!s->site) {
+            s->site = site;
+            return s;
+        }
+    }
+
+    nb_lock_site_stats_t *s = &m->sites[NB_LOCK_MAX_SITES - 1];
+    s->site = &nb_site_other;
+    return s;
+}
+
+/* Other locks may be held here: see the note at the top */
+static void nb_lockprof_register(nb_mutex_t *m)
+{
+    pthread_mutex_lock(&lockprof.lock);
+    if (!atomic_load_explicit(&m->registered, memory_order_relaxed)) {
+        m->next = lockprof.head;
+        lockprof.head = m;
+        atomic_store_explicit(&m->registered, true, memory_order_release);
+    }
+    pthread_mutex_unlock(&lockprof.lock);
+}
+
+/* Caller holds m */
+static void nb_stats_refresh(nb_mutex_t *m)
+{
+    uint64_t gen = atomic_load_explicit(&nb_lockprof_gen, memory_order_relaxed);
+
+    if (m->reset_gen == gen) return;
+
+    m->acquisitions = 0;
+    m->contended = 0;
+    m->wait_max_ns = 0;
+    m->hold_max_ns = 0;
+    memset(m->wait_hist, 0, sizeof(m->wait_hist));
+    memset(m->hold_hist, 0, sizeof(m->hold_hist));
+    memset(m->sites, 0, sizeof(m->sites));
+    m->reset_gen = gen;
+}
+
+static void nb_hold_begin(nb_mutex_t *m, const nb_lock_site_t *site)
+{
+    uint64_t now = nb_now_ns();
+
+    m->acquired_ns = now ? now : 1;
+    atomic_store_explicit(&m->holder, site, memory_order_relaxed);
+}
+
+static void nb_hold_end(nb_mutex_t *m)
+{
+    uint64_t hold = nb_now_ns() - m->acquired_ns;
+    const nb_lock_site_t *site = atomic_load_explicit(&m->holder, memory_order_relaxed);
+
+    nb_hist_add(m->hold_hist, hold);
+    if (hold > m->hold_max_ns) m->hold_max_ns = hold;
+    if (site) nb_site_slot(m, site)->hold_ns += hold;
+
+    atomic_store_explicit(&m->holder, NULL, memory_order_relaxed);
+    m->acquired_ns = 0;
+}
+
+void nb_mutex_init(nb_mutex_t *m, const char *name)
+{
+    memset(m, 0, sizeof(nb_mutex_t));
+    pthread_mutex_init(&m->mutex, NULL);
+    m->name = name;
+}
+
+void nb_mutex_destroy(nb_mutex_t *m)
+{
+    if (atomic_load_explicit(&m->registered, memory_order_acquire)) {
+        pthread_mutex_lock(&lockprof.lock);
+        for (nb_mutex_t **pp = &lockprof.head; *pp; pp = &(*pp)->next) {
+            if (*pp == m) {
+                *pp = m->next;
+                break;
+            }
+        }
+        atomic_store_explicit(&m->registered, false, memory_order_relaxed);
+        pthread_mutex_unlock(&lockprof.lock);
+    }
+    pthread_mutex_destroy(&m->mutex);
+}
+
+void nb_mutex_lock_prof(nb_mutex_t *m, const nb_lock_site_t *site)
+{
+    const nb_lock_site_t *blocker = NULL;
+    uint64_t wait = 0;
+    bool contended = false;
+
+    if (!atomic_load_explicit(&m->registered, memory_order_acquire)) {
+        nb_lockprof_register(m);
+    }
+
+    if (pthread_mutex_trylock(&m->mutex) != 0) {
+        contended = true;
+        blocker = atomic_load_explicit(&m->holder, memory_order_relaxed);
+        uint64_t t0 = nb_now_ns();
+        pthread_mutex_lock(&m->mutex);
+        wait = nb_now_ns() - t0;
+    }
+
+    nb_stats_refresh(m);
+    nb_hold_begin(m, site);
+
+    nb_lock_site_stats_t *s = nb_site_slot(m, site);
+    m->acquisitions++;
+    s->acquisitions++;
+
+    if (contended) {
+        m->contended++;
+        s->contended++;
+        s->wait_ns += wait;
+        nb_hist_add(m->wait_hist, wait);
+        if (wait > m->wait_max_ns) m->wait_max_ns = wait;
+        if (blocker) nb_site_slot(m, blocker)->blocking_ns += wait;
+    }
+}
+
+void nb_mutex_unlock_prof(nb_mutex_t *m)
+{
+    nb_hold_end(m);
+    pthread_mutex_unlock(&m->mutex);
+}
+
+int nb_cond_wait(pthread_cond_t *cond, nb_mutex_t *m)
+{
+    const nb_lock_site_t *site = atomic_load_explicit(&m->holder, memory_order_relaxed);
+    bool profiled = m->acquired_ns != 0;
+
+    if (profiled) nb_hold_end(m);
+    int ret = pthread_cond_wait(cond, &m->mutex);
+    if (profiled) nb_hold_begin(m, site);
+    else m->acquired_ns = 0;
+
+    return ret;
+}
+
+int nb_cond_timedwait(pthread_cond_t *cond, nb_mutex_t *m, const struct timespec *abstime)
+{
+    const nb_lock_site_t *site = atomic_load_explicit(&m->holder, memory_order_relaxed);
+    bool profiled = m->acquired_ns != 0;
+
+    if (profiled) nb_hold_end(m);
+    int ret = pthread_cond_timedwait(cond, &m->mutex, abstime);
+    if (profiled) nb_hold_begin(m, site);
+    else m->acquired_ns = 0;
+
+    return ret;
+}
+
+void nb_lockprof_enable(bool on)
+{
+    atomic_store_explicit(&nb_lockprof_enabled, on, memory_order_relaxed);
+    syslog_write(LOG_INFO, "Lock profiler %s", on ? "enabled" : "disabled");
+}
+
+void nb_lockprof_reset(void)
+{
+    atomic_fetch_add_explicit(&nb_lockprof_gen, 1, memory_order_relaxed);
+}
+
+static int nb_site_cmp(const void *a, const void *b)
+{
+    const nb_lock_site_stats_t *x = a, *y = b;
+    uint64_t kx = x->blocking_ns + x->hold_ns;
+    uint64_t ky = y->blocking_ns + y->hold_ns;
+
+    return kx < ky ? 1 : kx > ky ? -1 : 0;
+}
+
+void nb_lockprof_dump(void)
+{
+    nb_lock_site_stats_t sites[NB_LOCK_MAX_SITES];
+    uint64_t gen = atomic_load_explicit(&nb_lockprof_gen, memory_order_relaxed);
+
+    pthread_mutex_lock(&lockprof.lock);
+    for (nb_mutex_t *m = lockprof.head; m; m = m->next) {
+        if (m->reset_gen != gen || m->acquisitions == 0) continue;
+
+        uint64_t held = 0;
+        for (int b = 0; b < NB_LOCK_HIST_BUCKETS; b++) held += m->hold_hist[b];
+
+        syslog_write(LOG_INFO,
+            "Lock %s: %llu acquisitions, %llu contended (%.2f%%), "
+            "wait p50 %llu p99 %llu max %llu ns, hold p50 %llu p99 %llu max %llu ns",
+            m->name ? m->name : "?",
+            (unsigned long long)m->acquisitions, (unsigned long long)m->contended,
+            100.0 * (double)m->contended / (double)m->acquisitions,
+            (unsigned long long)nb_hist_pct(m->wait_hist, m->contended, 50),
+            (unsigned long long)nb_hist_pct(m->wait_hist, m->contended, 99),
+            (unsigned long long)m->wait_max_ns,
+            (unsigned long long)nb_hist_pct(m->hold_hist, held, 50),
+            (unsigned long long)nb_hist_pct(m->hold_hist, held, 99),
+            (unsigned long long)m->hold_max_ns);
+
+        memcpy(sites, m->sites, sizeof(sites));
+        qsort(sites, NB_LOCK_MAX_SITES, sizeof(sites[0]), nb_site_cmp);
+
+        for (int i = 0; i < NB_LOCKPROF_TOP_SITES && sites[i].site; i++) {
+            syslog_write(LOG_INFO,
+                "  %s:%d: %llu acquisitions, %llu contended, held %llu us, "
+                "waited %llu us, blocked others %llu us",
+                sites[i].site->file, sites[i].site->line,
+                (unsigned long long)sites[i].acquisitions,
+                (unsigned long long)sites[i].contended,
+                (unsigned long long)(sites[i].hold_ns / 1000),
+                (unsigned long long)(sites[i].wait_ns / 1000),
+                (unsigned long long)(sites[i].blocking_ns / 1000));
+        }
+    }
+    pthread_mutex_unlock(&lockprof.lock);
+}
@@ -0,0 +1,103 @@
+/*
+ * nb_mutex.h - Instrumented Mutex and Lock Contention Profiler
+ *
+ * NetBlade OS v3.x Common Library
+ * Copyright (c) 2024-2026 Enterprise Systems Inc. All rights reserved.
+ */
+
+#ifndef NB_MUTEX_H
+#define NB_MUTEX_H
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <stdatomic.h>
+#include <time.h>
+#include <pthread.h>
+
+#define NB_LOCK_HIST_BUCKETS    32      /* log2 ns: 1 ns .. ~4 s */
+#define NB_LOCK_MAX_SITES       16      /* Last one collects the overflow */
+
+typedef struct {
+    const char *file;
+    int         line;
+} nb_lock_site_t;
+
+typedef struct {
+    const nb_lock_site_t *site;
+    uint64_t acquisitions;
+    uint64_t contended;
+    uint64_t wait_ns;           /* Time spent waiting at this site */
+    uint64_t hold_ns;           /* Time held when taken here */
+    uint64_t blocking_ns;       /* Others' wait while held from here */
+} nb_lock_site_stats_t;
+
+typedef struct nb_mutex {
+    pthread_mutex_t        mutex;
+    const char            *name;
+
+    /* Profiling state, written only by the holder */
+    _Atomic(const nb_lock_site_t *) holder;
+    uint64_t               acquired_ns;     /* 0 = this hold is not profiled */
+    uint64_t               acquisitions;
+    uint64_t               contended;
+    uint64_t               wait_max_ns;
+    uint64_t               hold_max_ns;
+    uint64_t               wait_hist[NB_LOCK_HIST_BUCKETS];
+    uint64_t               hold_hist[NB_LOCK_HIST_BUCKETS];
+    nb_lock_site_stats_t   sites[NB_LOCK_MAX_SITES];
+    uint64_t               reset_gen;       /* Stats are stale unless current */
+
+    _Atomic bool           registered;
+    struct nb_mutex       *next;
+} nb_mutex_t;
+
+#define NB_MUTEX_INITIALIZER(lock_name) \
+    { .mutex = PTHREAD_MUTEX_INITIALIZER, .name = (lock_name) }
+
+extern _Atomic bool nb_lockprof_enabled;
+
+void nb_mutex_init(nb_mutex_t *m, const char *name);
+void nb_mutex_destroy(nb_mutex_t *m);
+
+void nb_mutex_lock_prof(nb_mutex_t *m, const nb_lock_site_t *site);
+void nb_mutex_unlock_prof(nb_mutex_t *m);
+
+/*
+ * With profiling off a lock/unlock pair costs one relaxed load and one
+ * store on top of the pthread calls.
+ */
+static inline void nb_mutex_lock_at(nb_mutex_t *m, const nb_lock_site_t *site)
+{
+    if (atomic_load_explicit(&nb_lockprof_enabled, memory_order_relaxed)) {
+        nb_mutex_lock_prof(m, site);
+        return;
+    }
+    pthread_mutex_lock(&m->mutex);
+    m->acquired_ns = 0;
+}
+
+static inline void nb_mutex_unlock(nb_mutex_t *m)
+{
+    if (m->acquired_ns) {
+        nb_mutex_unlock_prof(m);
+        return;
+    }
+    pthread_mutex_unlock(&m->mutex);
+}
+
+/* Records the call site, so contention is attributed to the code holding the lock */
+#define nb_mutex_lock(m) do { \
+        static const nb_lock_site_t nb_site_ = { __FILE__, __LINE__ }; \
+        nb_mutex_lock_at((m), &nb_site_); \
+    } while (0)
+
+/* Condition waits end the current hold and start a new one on wakeup */
+int nb_cond_wait(pthread_cond_t *cond, nb_mutex_t *m);
+int nb_cond_timedwait(pthread_cond_t *cond, nb_mutex_t *m, const struct timespec *abstime);
+
+/* CLI: 'debug lock-profile on|off|reset' and 'show lock-profile' */
+void nb_lockprof_enable(bool on);
+void nb_lockprof_reset(void);
+void nb_lockprof_dump(void);
+
+#endif /* NB_MUTEX_H */
@@ -0,0 +1,274 @@
+/*
+ * nb_numa.c - NUMA Topology and Node-Local Memory
+ *
+ * NetBlade OS v3.x Common Library
+ * Copyright (c) 2024-2026 Enterprise Systems Inc. All rights reserved.
+ *
+ * Just enough NUMA support for placing per-worker state: node and CPU
+ * layout from sysfs, thread pinning, and anonymous mappings with a
+ * preferred-node policy set through mbind(2). Preferred rather than
+ * bound, so an exhausted node degrades to remote memory instead of
+ * failing the allocation. Uses the raw syscalls; no libnuma needed.
+ *
+ * Nodes are numbered densely over the online nodes that have CPUs, so
+ * callers can spread workers over 0..nb_numa_node_count()-1 even when
+ * the kernel's node ids have gaps (offlined or memory-only nodes).
+ *
+ * Large tables can ask for 2 MB pages. The hugetlb pool is exact but
+ * has to be reserved by the administrator; transparent huge pages need
+ * nothing reserved but are best effort, since khugepaged or the fault
+ * path only use them when the range is 2 MB aligned and memory is not
+ * too fragmented.
+ */
+
+#define _GNU_SOURCE
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+#include <stdbool.h>
+#include <errno.h>
+#include <sched.h>
+#include <pthread.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/syscall.h>
+#include <linux/mempolicy.h>
+#include "nb_numa.h"
+#include "syslog.h"
+
+#define NB_NUMA_SYSFS           "/sys/devices/system/node"
+#define NB_NUMA_MAX_CPUS        1024
+#define NB_NUMA_MAX_NODE_ID     64      /* Kernel node ids; one word of mbind mask */
+#define NB_NUMA_THP_ENABLED     "/sys/kernel/mm/transparent_hugepage/enabled"
+
+static pthread_once_t numa_once = PTHREAD_ONCE_INIT;
+
+static struct {
+    int        nodes;
+    int        id[NB_NUMA_MAX_NODES];       /* Kernel node id of each node */
+    cpu_set_t  cpus[NB_NUMA_MAX_NODES];
+    int8_t     cpu_node[NB_NUMA_MAX_CPUS];
+} numa;
+
+static int nb_numa_parse_cpulist(const char *s, cpu_set_t *set)
+{
+    int count = 0;
+
+    CPU_ZERO(set);
+    while (*s && *s != '\n') {
+        char *end;
+        long lo = strtol(s, &end, 10);
+        long hi = lo;
+
+        if (end == s) return -1;
+        if (*end == '-') {
+            s = end + 1;
+            hi = strtol(s, &end, 10);
+        }
+        for (long c = lo; c <= hi && c < NB_NUMA_MAX_CPUS; c++) {
+            CPU_SET((int)c, set);
+            count++;
+        }
+        s = (*end == ',') ? end + 1 : end;
+    }
+    return count;
+}
+
+/* The file is a single list line in cpulist format: "0-1,3" */
+static int nb_numa_read_list(const char *path, cpu_set_t *set)
+{
+    char line[4096];
+    FILE *f = fopen(path, "r");
+
+    if (!f) return -1;
+
+    int count = fgets(line, sizeof(line), f) ? nb_numa_parse_cpulist(line, set) : -1;
+    fclose(f);
+    return count;
+}
+
+static void nb_numa_discover(void)
+{
+    char path[128];
+    cpu_set_t online;
+
+    memset(numa.cpu_node, 0, sizeof(numa.cpu_node));
+    numa.nodes = 0;
+
+    if (nb_numa_read_list(NB_NUMA_SYSFS "/online", &online) > 0) {
+        for (int id = 0; id < NB_NUMA_MAX_NODE_ID; id++) {
+            if (!CPU_ISSET(id, &online)) continue;
+
+            int n = numa.nodes;
+            cpu_set_t cpus;
+
+            snprintf(path, sizeof(path), NB_NUMA_SYSFS "/node%d/cpulist", id);
+            if (nb_numa_read_list(path, &cpus) <= 0) continue;     /* Memory only */
+
+            if (n == NB_NUMA_MAX_NODES) {
+                syslog_write(LOG_WARNING, "NUMA: More than %d nodes, node %d and up "
+                    "treated as node 0", NB_NUMA_MAX_NODES, id);
+                break;
+            }
+            numa.cpus[n] = cpus;
+            for (int c = 0; c < NB_NUMA_MAX_CPUS; c++) {
+                if (CPU_ISSET(c, &numa.cpus[n])) numa.cpu_node[c] = (int8_t)n;
+            }
+            numa.id[n] = id;
+            numa.nodes = n + 1;
+        }
+    }
+
+    /* No sysfs node directory: treat the machine as one node */
+    if (numa.nodes == 0) {
+        numa.nodes = 1;
+        numa.id[0] = 0;
+        sched_getaffinity(0, sizeof(cpu_set_t), &numa.cpus[0]);
+    }
+
+    syslog_write(LOG_INFO, "NUMA: %d node%s", numa.nodes, numa.nodes > 1 ? "s" : "");
+}
+
+int nb_numa_init(void)
+{
+    pthread_once(&numa_once, nb_numa_discover);
+    return 0;
+}
+
+int nb_numa_node_count(void)
+{
+    nb_numa_init();
+    return numa.nodes;
+}
+
+int nb_numa_current_node(void)
+{
+    nb_numa_init();
+    if (numa.nodes == 1) return 0;
+
+    int cpu = sched_getcpu();
+    if (cpu < 0 || cpu >= NB_NUMA_MAX_CPUS) return 0;
+    return numa.cpu_node[cpu];
+}
+
+int nb_numa_pin_thread(int node)
+{
+    if (node < 0 || node >= nb_numa_node_count()) return -1;
+
+    if (sched_setaffinity(0, sizeof(cpu_set_t), &numa.cpus[node]) != 0) {
+        syslog_write(LOG_WARNING, "NUMA: Cannot pin thread to node %d: %s",
+            node, strerror(errno));
+        return -1;
+    }
+    return 0;
+}
+
+static void nb_numa_bind(void *p, size_t size, int node)
+{
+    if (nb_numa_node_count() > 1 && node >= 0 && node < numa.nodes) {
+        unsigned long mask = 1UL << numa.id[node];
+        if (syscall(SYS_mbind, p, size, MPOL_PREFERRED, &mask, NB_NUMA_MAX_NODE_ID + 1, 0) != 0) {
+            syslog_write(LOG_WARNING, "NUMA: mbind to node %d failed: %s", node, strerror(errno));
+        }
+    }
+}
+
+void *nb_numa_alloc(size_t size, int node)
+{
+    void *p = mmap(NULL, size, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+    if (p == MAP_FAILED) return NULL;
+
+    nb_numa_bind(p, size, node);
+    return p;
+}
+
+/* "always" or "madvise" selected; "never" makes advising pointless */
+static bool nb_numa_thp_usable(void)
+{
+    static int usable = -1;
+    char line[128];
+
+    if (usable < 0) {
+        FILE *f = fopen(NB_NUMA_THP_ENABLED, "r");
+        usable = f && fgets(line, sizeof(line), f) && !strstr(line, "[never]");
+        if (f) fclose(f);
+    }
+    return usable;
+}
+
+void *nb_numa_alloc_huge(size_t *size, int node, uint8_t *backing)
+{
+    size_t len = (*size + NB_NUMA_HUGE_PAGE - 1) & ~((size_t)NB_NUMA_HUGE_PAGE - 1);
+    void *p;
+
+    *size = len;
+
+    p = mmap(NULL, len, PROT_READ | PROT_WRITE,
+             MAP_PRIVATE | MAP_ANONYMOUS | MAP_HUGETLB, -1, 0);
+    if (p != MAP_FAILED) {
+        nb_numa_bind(p, len, node);
+        if (backing) *backing = NB_NUMA_PAGES_HUGETLB;
+        return p;
+    }
+
+    if (!nb_numa_thp_usable()) {
+        p = nb_numa_alloc(len, node);
+        if (p && backing) *backing = NB_NUMA_PAGES_SMALL;
+        return p;
+    }
+
+    /* Over-map and trim so the range starts on a huge page boundary */
+    uint8_t *raw = mmap(NULL, len + NB_NUMA_HUGE_PAGE, PROT_READ | PROT_WRITE,
+                        MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+    if (raw == MAP_FAILED) return NULL;
+
+    uintptr_t start = ((uintptr_t)raw + NB_NUMA_HUGE_PAGE - 1) & ~((uintptr_t)NB_NUMA_HUGE_PAGE - 1);
+    size_t head = start - (uintptr_t)raw;
+    if (head) munmap(raw, head);
+    munmap((uint8_t *)start + len, NB_NUMA_HUGE_PAGE - head);
+
+    p = (void *)start;
+    nb_numa_bind(p, len, node);
+    if (madvise(p, len, MADV_HUGEPAGE) != 0) {
+        if (backing) *backing = NB_NUMA_PAGES_SMALL;
+        return p;
+    }
+    if (backing) *backing = NB_NUMA_PAGES_THP;
+    return p;
+}
+
+const char *nb_numa_pages_name(uint8_t backing)
+{
+    switch (backing) {
+    case NB_NUMA_PAGES_HUGETLB: return "hugetlb";
+    case NB_NUMA_PAGES_THP:     return "thp";
+    default:                    return "4k";
+    }
+}
+
+void nb_numa_free(void *p, size_t size)
+{
+    if (p) munmap(p, size);
+}
+
+/*
+ * move_pages(2) with no target nodes only reports where each page is.
+ * Unlike get_mempolicy(MPOL_F_ADDR) it does not fault the page in, and
+ * reports an error rather than a node for the shared zero page, so
+ * memory that has only been read is not attributed to that page's node.
+ */
+int nb_numa_node_of_addr(const void *p)
+{
+    void *page = (void *)((uintptr_t)p & ~((uintptr_t)sysconf(_SC_PAGESIZE) - 1));
+    int status = -1;
+
+    nb_numa_init();
+    if (syscall(SYS_move_pages, 0, 1UL, &page, NULL, &status, 0) != 0 || status < 0) {
+        return -1;
+    }
+    for (int n = 0; n < numa.nodes; n++) {
+        if (numa.id[n] == status) return n;
+    }
+    return -1;
+}
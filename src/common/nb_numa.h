@@ -0,0 +1,55 @@
+/*
+ * nb_numa.h - NUMA Topology and Node-Local Memory
+ *
+ * NetBlade OS v3.x Common Library
+ * Copyright (c) 2024-2026 Enterprise Systems Inc. All rights reserved.
+ */
+
+#ifndef NB_NUMA_H
+#define NB_NUMA_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+#define NB_NUMA_MAX_NODES       8
+#define NB_NUMA_HUGE_PAGE       (2u << 20)
+
+/* What backs an nb_numa_alloc_huge() mapping */
+#define NB_NUMA_PAGES_SMALL     0
+#define NB_NUMA_PAGES_THP       1   /* Transparent huge pages, advised */
+#define NB_NUMA_PAGES_HUGETLB   2   /* Reserved hugetlbfs pool */
+
+/*
+ * Read the node layout from sysfs, once; every other call does this
+ * itself first, so calling it is optional. Nodes are the online nodes
+ * with CPUs, numbered 0..count-1 whatever their kernel ids.
+ */
+int nb_numa_init(void);
+
+int nb_numa_node_count(void);
+/* Node of the CPU the caller is running on */
+int nb_numa_current_node(void);
+
+/* Restrict the calling thread to the CPUs of one node */
+int nb_numa_pin_thread(int node);
+
+/*
+ * Page-aligned memory preferring the given node, rounded up to whole
+ * pages. On single-node systems this is a plain anonymous mapping.
+ */
+void *nb_numa_alloc(size_t size, int node);
+void nb_numa_free(void *p, size_t size);
+
+/*
+ * As nb_numa_alloc(), backed by 2 MB pages when possible: the reserved
+ * hugetlb pool first, then 2 MB-aligned memory advised for transparent
+ * huge pages, then normal pages. *size is rounded up to a whole huge
+ * page and must be passed back to nb_numa_free().
+ */
+void *nb_numa_alloc_huge(size_t *size, int node, uint8_t *backing);
+const char *nb_numa_pages_name(uint8_t backing);
+
+/* Node backing the page at p, or -1 if it has no page of its own yet */
+int nb_numa_node_of_addr(const void *p);
+
+#endif /* NB_NUMA_H */
@@ -0,0 +1,270 @@
+/*
+ * nb_prof.c - Sampling CPU Profiler with Subsystem Attribution
+ *
+ * NetBlade OS v3.x Common Library
+ * Copyright (c) 2024-2026 Enterprise Systems Inc. All rights reserved.
+ *
+ * ITIMER_PROF delivers SIGPROF to whichever thread is burning CPU. The
+ * handler claims a slot in a preallocated buffer, records the thread's
+ * subsystem tag and a backtrace, and returns; nothing in it allocates
+ * or locks. Stacks are aggregated and symbolised only when written
+ * out, after the profiler has stopped. Functions with internal linkage
+ * appear as module+offset unless the binary is linked with -rdynamic.
+ *
+ * backtrace() is not async-signal-safe. It is warmed up before the
+ * handler is installed, so it never loads the unwinder or allocates
+ * from a signal; what remains is the unwinder's lookup of unwind
+ * tables, which on glibc older than 2.35 takes the loader lock. A
+ * sample taken while the same thread is inside dlopen() or dlclose()
+ * can then deadlock it. The profiler is a debug tool: do not leave it
+ * running across module loads on such systems.
+ */
+
+#define _GNU_SOURCE
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+#include <stdatomic.h>
+#include <errno.h>
+#include <signal.h>
+#include <sched.h>
+#include <dlfcn.h>
+#include <execinfo.h>
+#include <sys/time.h>
+#include "nb_prof.h"
+#include "syslog.h"
+
+#define NB_PROF_SKIP_FRAMES     2   /* Handler and signal trampoline */
+
+typedef struct {
+    _Atomic uint8_t depth;      /* 0 until the sample is complete */
+    uint8_t         tag;
+    void           *pc[NB_PROF_MAX_DEPTH];
+} nb_prof_sample_t;
+
+static struct {
+    nb_prof_sample_t  *samples;
+    _Atomic uint32_t   next;
+    _Atomic uint32_t   dropped;
+    _Atomic uint32_t   in_handler;  /* Handlers still running, drained by stop */
+    uint32_t           hz;
+    bool               running;
+    struct sigaction   old_action;
+} prof;
+
+static const char *nb_prof_tag_names[NB_PROF_MAX_TAGS] = {
+    [NB_PROF_OTHER]        = "other",
+    [NB_PROF_BGP_TIMERS]   = "bgp_timers",
+    [NB_PROF_BGP_PARSE]    = "bgp_parse",
+    [NB_PROF_CLUSTER]      = "cluster",
+    [NB_PROF_CLUSTER_SYNC] = "cluster_sync",
+};
+
+__thread volatile uint8_t nb_prof_tag;
+
+static void nb_prof_sigprof(int sig, siginfo_t *si, void *uc)
+{
+    (void)sig;
+    (void)si;
+    (void)uc;
+
+    int saved_errno = errno;
+    atomic_fetch_add_explicit(&prof.in_handler, 1, memory_order_acquire);
+    uint32_t i = atomic_fetch_add_explicit(&prof.next, 1, memory_order_relaxed);
+
+    if (i >= NB_PROF_MAX_SAMPLES || !prof.samples) {
+        atomic_fetch_add_explicit(&prof.dropped, 1, memory_order_relaxed);
+    } else {
+        nb_prof_sample_t *s = &prof.samples[i];
+        int n = backtrace(s->pc, NB_PROF_MAX_DEPTH);
+        s->tag = nb_prof_tag < NB_PROF_MAX_TAGS ? nb_prof_tag : NB_PROF_OTHER;
+        atomic_store_explicit(&s->depth, (uint8_t)(n > 0 ? n : 1), memory_order_release);
+    }
+
+    atomic_fetch_sub_explicit(&prof.in_handler, 1, memory_order_release);
+    errno = saved_errno;
+}
+
+static uint32_t nb_prof_count(void)
+{
+    uint32_t n = atomic_load_explicit(&prof.next, memory_order_relaxed);
+    return n < NB_PROF_MAX_SAMPLES ? n : NB_PROF_MAX_SAMPLES;
+}
+
+int nb_prof_start(uint32_t hz)
+{
+    struct sigaction sa;
+    struct itimerval it;
+    void *warm[2];
+
+    if (prof.running) return -1;
+    if (hz == 0) hz = NB_PROF_DEFAULT_HZ;
+    if (hz > NB_PROF_MAX_HZ) hz = NB_PROF_MAX_HZ;
+
+    if (!prof.samples) {
+        prof.samples = calloc(NB_PROF_MAX_SAMPLES, sizeof(nb_prof_sample_t));
+        if (!prof.samples) return -1;
+    } else {
+        memset(prof.samples, 0, NB_PROF_MAX_SAMPLES * sizeof(nb_prof_sample_t));
+    }
+    atomic_store(&prof.next, 0);
+    atomic_store(&prof.dropped, 0);
+
+    /* The first backtrace() loads the unwinder; never let that happen in the handler */
+    backtrace(warm, 2);
+
+    memset(&sa, 0, sizeof(sa));
+    sa.sa_sigaction = nb_prof_sigprof;
+    sa.sa_flags = SA_SIGINFO | SA_RESTART;
+    sigemptyset(&sa.sa_mask);
+    if (sigaction(SIGPROF, &sa, &prof.old_action) != 0) return -1;
+
+    memset(&it, 0, sizeof(it));
+    it.it_interval.tv_usec = 1000000 / hz;
+    it.it_value = it.it_interval;
+    if (setitimer(ITIMER_PROF, &it, NULL) != 0) {
+        sigaction(SIGPROF, &prof.old_action, NULL);
+        return -1;
+    }
+
+    prof.hz = hz;
+    prof.running = true;
+    syslog_write(LOG_INFO, "CPU profiler: Started at %u Hz", hz);
+    return 0;
+}
+
+/*
+ * Disarm, then ignore SIGPROF so a signal already pending is discarded
+ * rather than delivered to the previous disposition (by default, it
+ * terminates the process). Handlers still running on other threads
+ * finish before the old action returns and the samples are read.
+ */
+void nb_prof_stop(void)
+{
+    struct itimerval it;
+    struct sigaction ign;
+
+    if (!prof.running) return;
+
+    memset(&it, 0, sizeof(it));
+    setitimer(ITIMER_PROF, &it, NULL);
+
+    memset(&ign, 0, sizeof(ign));
+    ign.sa_handler = SIG_IGN;
+    sigemptyset(&ign.sa_mask);
+    sigaction(SIGPROF, &ign, NULL);
+
+    while (atomic_load_explicit(&prof.in_handler, memory_order_acquire) != 0) {
+        sched_yield();
+    }
+
+    sigaction(SIGPROF, &prof.old_action, NULL);
+    prof.running = false;
+
+    syslog_write(LOG_INFO, "CPU profiler: Stopped, %u samples, %u dropped",
+        nb_prof_count(), atomic_load(&prof.dropped));
+}
+
+static int nb_prof_sample_cmp(const void *a, const void *b)
+{
+    const nb_prof_sample_t *x = a, *y = b;
+    uint8_t dx = atomic_load_explicit(&x->depth, memory_order_relaxed);
+    uint8_t dy = atomic_load_explicit(&y->depth, memory_order_relaxed);
+
+    if (x->tag != y->tag) return x->tag < y->tag ? -1 : 1;
+    if (dx != dy) return dx < dy ? -1 : 1;
+    return memcmp(x->pc, y->pc, dx * sizeof(void *));
+}
+
+static void nb_prof_write_frame(FILE *f, void *pc)
+{
+    Dl_info info;
+    int found = dladdr(pc, &info);
+
+    if (found && info.dli_sname) {
+        fprintf(f, ";%s", info.dli_sname);
+    } else if (found && info.dli_fname) {
+        const char *base = strrchr(info.dli_fname, '/');
+        fprintf(f, ";%s+0x%lx", base ? base + 1 : info.dli_fname,
+            (unsigned long)((uintptr_t)pc - (uintptr_t)info.dli_fbase));
+    } else {
+        fprintf(f, ";0x%lx", (unsigned long)(uintptr_t)pc);
+    }
+}
+
+int nb_prof_write_folded(const char *path)
+{
+    if (prof.running || !prof.samples) return -1;
+
+    uint32_t n = nb_prof_count();
+    FILE *f = fopen(path, "w");
+    if (!f) {
+        syslog_write(LOG_ERR, "CPU profiler: Cannot open %s", path);
+        return -1;
+    }
+
+    qsort(prof.samples, n, sizeof(nb_prof_sample_t), nb_prof_sample_cmp);
+
+    uint32_t stacks = 0;
+    for (uint32_t i = 0; i < n; ) {
+        nb_prof_sample_t *s = &prof.samples[i];
+        uint32_t j = i + 1;
+
+        while (j < n && nb_prof_sample_cmp(s, &prof.samples[j]) == 0) j++;
+
+        uint8_t depth = atomic_load_explicit(&s->depth, memory_order_relaxed);
+        if (depth > 0) {
+            fputs(nb_prof_tag_name(s->tag), f);
+            for (int k = depth - 1; k >= NB_PROF_SKIP_FRAMES; k--) {
+                nb_prof_write_frame(f, s->pc[k]);
+            }
+            fprintf(f, " %u\n", j - i);
+            stacks++;
+        }
+        i = j;
+    }
+
+    fclose(f);
+    syslog_write(LOG_INFO, "CPU profiler: Wrote %u stacks from %u samples to %s",
+        stacks, n, path);
+    return 0;
+}
+
+void nb_prof_get_stats(nb_prof_stats_t *stats)
+{
+    uint32_t n = nb_prof_count();
+
+    memset(stats, 0, sizeof(nb_prof_stats_t));
+    stats->running = prof.running;
+    stats->hz = prof.hz;
+    stats->dropped = atomic_load(&prof.dropped);
+
+    for (uint32_t i = 0; i < n && prof.samples; i++) {
+        nb_prof_sample_t *s = &prof.samples[i];
+        if (atomic_load_explicit(&s->depth, memory_order_acquire) == 0) continue;
+        stats->per_tag[s->tag]++;
+        stats->samples++;
+    }
+}
+
+const char *nb_prof_tag_name(uint8_t tag)
+{
+    if (tag >= NB_PROF_MAX_TAGS || !nb_prof_tag_names[tag]) return "other";
+    return nb_prof_tag_names[tag];
+}
+
+void nb_prof_dump(void)
+{
+    nb_prof_stats_t st;
+
+    nb_prof_get_stats(&st);
+    syslog_write(LOG_INFO, "CPU profiler: %s, %u Hz, %u samples, %u dropped",
+        st.running ? "running" : "stopped", st.hz, st.samples, st.dropped);
+
+    for (uint8_t t = 0; t < NB_PROF_MAX_TAGS; t++) {
+        if (st.per_tag[t] == 0) continue;
+        syslog_write(LOG_INFO, "  %-14s %6u samples  %5.1f%%", nb_prof_tag_name(t),
+            st.per_tag[t], 100.0 * st.per_tag[t] / st.samples);
+    }
+}
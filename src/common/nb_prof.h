@@ -0,0 +1,66 @@
+/*
+ * nb_prof.h - Sampling CPU Profiler with Subsystem Attribution
+ *
+ * NetBlade OS v3.x Common Library
+ * Copyright (c) 2024-2026 Enterprise Systems Inc. All rights reserved.
+ */
+
+#ifndef NB_PROF_H
+#define NB_PROF_H
+
+#include <stdint.h>
+#include <stdbool.h>
+
+#define NB_PROF_DEFAULT_HZ      997     /* Off the kernel tick to avoid aliasing */
+#define NB_PROF_MAX_HZ          10000
+#define NB_PROF_MAX_SAMPLES     32768
+#define NB_PROF_MAX_DEPTH       32
+
+/* Subsystem tags; the root frame of every folded stack */
+#define NB_PROF_OTHER           0
+#define NB_PROF_BGP_TIMERS      1
+#define NB_PROF_BGP_PARSE       2   /* Reserved for bgp_peer */
+#define NB_PROF_CLUSTER         3
+#define NB_PROF_CLUSTER_SYNC    4
+#define NB_PROF_MAX_TAGS        8
+
+typedef struct {
+    bool     running;
+    uint32_t hz;
+    uint32_t samples;
+    uint32_t dropped;           /* Buffer full */
+    uint32_t per_tag[NB_PROF_MAX_TAGS];
+} nb_prof_stats_t;
+
+/* Subsystem the calling thread is running, read by the SIGPROF handler */
+extern __thread volatile uint8_t nb_prof_tag;
+
+static inline uint8_t nb_prof_enter(uint8_t tag)
+{
+    uint8_t prev = nb_prof_tag;
+    nb_prof_tag = tag;
+    return prev;
+}
+
+static inline void nb_prof_restore_(uint8_t *prev)
+{
+    nb_prof_tag = *prev;
+}
+
+/* Tag the rest of the enclosing scope; the previous tag returns on any exit */
+#define NB_PROF_SCOPE(tag) \
+    uint8_t nb_prof_prev_ __attribute__((cleanup(nb_prof_restore_), unused)) = \
+        nb_prof_enter(tag)
+
+/* CLI: 'debug cpu-profile start [hz]|stop' and 'show cpu-profile [folded FILE]' */
+int nb_prof_start(uint32_t hz);
+void nb_prof_stop(void);
+
+/* One "tag;root;...;leaf count" line per distinct stack, for flamegraph.pl */
+int nb_prof_write_folded(const char *path);
+
+void nb_prof_get_stats(nb_prof_stats_t *stats);
+const char *nb_prof_tag_name(uint8_t tag);
+void nb_prof_dump(void);
+
+#endif /* NB_PROF_H */
@@ -0,0 +1,645 @@
+/*
+ * nb_telemetry.c - Change-Driven Streaming Telemetry
+ *
+ * NetBlade OS v3.x Common Library
+ * Copyright (c) 2024-2026 Enterprise Systems Inc. All rights reserved.
+ *
+ * Replaces scraping cluster_get_status() and the timer dumps on a fixed
+ * interval. Modules publish their state as keyed integer values, and
+ * subscribers on a local socket are sent values only when they change.
+ *
+ * A state change (role, heartbeat up/down, timer configuration) goes
+ * into a change log and wakes the server thread, so on-change
+ * subscribers see every transition in order. A poller would miss a
+ * transition that reverts before its next scrape. Gauges such as hold
+ * margins change constantly and are not logged; they reach subscribers
+ * only through sample subscriptions. A subscriber that falls behind the
+ * log or fills its buffer is resynchronised with a full snapshot rather
+ * than slowing down producers.
+ *
+ * Snapshots can be larger than a client's buffer, so they are streamed:
+ * a key cursor picks up where the last flush left off, and the client
+ * gets nothing else until the snapshot is through.
+ */
+
+#define _GNU_SOURCE
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+#include <stdbool.h>
+#include <stdatomic.h>
+#include <errno.h>
+#include <time.h>
+#include <poll.h>
+#include <unistd.h>
+#include <pthread.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <sys/eventfd.h>
+#include "nb_telemetry.h"
+#include "nb_mutex.h"
+#include "syslog.h"
+
+#define NB_TELEMETRY_HASH       1024    /* Power of two */
+#define NB_TELEMETRY_IN_BUF     256
+#define NB_TELEMETRY_MAX_WAIT_MS 1000
+
+typedef struct {
+    char             path[NB_TELEMETRY_KEY_LEN];
+    uint8_t          kind;
+    _Atomic int64_t  value;
+    _Atomic uint64_t version;   /* telemetry.version at the last change */
+    int              hash_next; /* Key id + 1; 0 ends the chain */
+} nb_telemetry_key_t;
+
+typedef struct {
+    uint64_t seq;
+    int32_t  key;
+    int64_t  value;
+} nb_telemetry_change_t;
+
+typedef struct {
+    int      fd;                /* -1: slot free */
+    char     in[NB_TELEMETRY_IN_BUF];
+    uint32_t in_len;
+
+    bool     subscribed;
+    bool     on_change;
+    bool     suppress;
+    bool     resync;            /* Send a snapshot once the buffer drains */
+    char     prefix[NB_TELEMETRY_KEY_LEN];
+    size_t   prefix_len;
+    uint32_t sample_ms;
+    uint32_t heartbeat_ms;      /* 0: none */
+    uint64_t next_sample_ms;
+    uint64_t next_heartbeat_ms;
+    uint64_t log_pos;           /* On-change: last log seq sent */
+    uint64_t sample_version;    /* Sample: telemetry.version at the last sample */
+    int      snap_next;         /* Snapshot in progress: next key id; -1: none */
+    uint64_t snap_since;
+    bool     snap_sync;         /* End it with "sync" */
+
+    char    *out;
+    uint32_t out_len;
+} nb_telemetry_client_t;
+
+static struct {
+    nb_telemetry_key_t    keys[NB_TELEMETRY_MAX_KEYS];
+    _Atomic int           nkeys;
+    int                   buckets[NB_TELEMETRY_HASH];  /* Key id + 1 */
+
+    nb_telemetry_change_t log[NB_TELEMETRY_LOG_SIZE];
+    uint64_t              log_seq;
+    _Atomic uint64_t      version;
+    nb_mutex_t            lock;
+
+    int                   listen_fd;
+    int                   event_fd;
+    _Atomic bool          pending;
+    _Atomic bool          running;
+    pthread_t             thread;
+    char                  sock_path[108];
+    nb_telemetry_client_t clients[NB_TELEMETRY_MAX_CLIENTS];
+
+    _Atomic uint64_t      changes;
+    _Atomic uint64_t      updates;
+    _Atomic uint64_t      suppressed;
+    _Atomic uint64_t      resyncs;
+    _Atomic uint32_t      nclients;
+} telemetry = {
+    .lock = NB_MUTEX_INITIALIZER("telemetry.lock"),
+    .listen_fd = -1,
+    .event_fd = -1,
+};
+
+/* Server thread scratch: log entries copied out from under the lock */
+static nb_telemetry_change_t telemetry_batch[NB_TELEMETRY_LOG_SIZE];
+
+static uint64_t nb_telemetry_now_ms(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000ULL + (uint64_t)ts.tv_nsec / 1000000ULL;
+}
+
+static uint32_t nb_telemetry_hash(const char *path)
+{
+    uint32_t h = 2166136261U;
+
+    while (*path) h = (h ^ (uint8_t)*path++) * 16777619U;
+    return h & (NB_TELEMETRY_HASH - 1);
+}
+
+int nb_telemetry_key(const char *path, uint8_t kind)
+{
+    if (!path || strlen(path) >= NB_TELEMETRY_KEY_LEN) return -1;
+
+    uint32_t b = nb_telemetry_hash(path);
+    int id = -1;
+
+    nb_mutex_lock(&telemetry.lock);
+
+    for (int k = telemetry.buckets[b]; k; k = telemetry.keys[k - 1].hash_next) {
+        if (strcmp(telemetry.keys[k - 1].path, path) == 0) {
+            id = k - 1;
+            break;
+        }
+    }
+
+    if (id < 0) {
+        int n = atomic_load_explicit(&telemetry.nkeys, memory_order_relaxed);
+        if (n < NB_TELEMETRY_MAX_KEYS) {
+            nb_telemetry_key_t *k = &telemetry.keys[n];
+            strcpy(k->path, path);
+            k->kind = kind;
+            k->hash_next = telemetry.buckets[b];
+            telemetry.buckets[b] = n + 1;
+            /* The server reads keys below nkeys without the lock */
+            atomic_store_explicit(&telemetry.nkeys, n + 1, memory_order_release);
+            id = n;
+        } else {
+            syslog_write(LOG_ERR, "Telemetry: Key table full, dropping %s", path);
+        }
+    }
+
+    nb_mutex_unlock(&telemetry.lock);
+    return id;
+}
+
+void nb_telemetry_set(int key, int64_t value)
+{
+    if (key < 0 || key >= atomic_load_explicit(&telemetry.nkeys, memory_order_acquire)) return;
+
+    nb_telemetry_key_t *k = &telemetry.keys[key];
+
+    if (atomic_load_explicit(&k->value, memory_order_relaxed) == value) return;
+
+    nb_mutex_lock(&telemetry.lock);
+
+    if (atomic_load_explicit(&k->value, memory_order_relaxed) == value) {
+        nb_mutex_unlock(&telemetry.lock);
+        return;
+    }
+    atomic_store_explicit(&k->value, value, memory_order_relaxed);
+    atomic_store_explicit(&k->version, atomic_fetch_add(&telemetry.version, 1) + 1,
+        memory_order_relaxed);
+
+    if (k->kind == NB_TELEMETRY_STATE) {
+        nb_telemetry_change_t *c = &telemetry.log[++telemetry.log_seq & (NB_TELEMETRY_LOG_SIZE - 1)];
+        c->seq = telemetry.log_seq;
+        c->key = key;
+        c->value = value;
+        atomic_fetch_add_explicit(&telemetry.changes, 1, memory_order_relaxed);
+    }
+
+    nb_mutex_unlock(&telemetry.lock);
+
+    if (k->kind == NB_TELEMETRY_STATE && telemetry.event_fd >= 0 &&
+        !atomic_exchange(&telemetry.pending, true)) {
+        uint64_t one = 1;
+        if (write(telemetry.event_fd, &one, sizeof(one)) < 0) {
+            /* Counter saturated; the server is awake anyway */
+        }
+    }
+}
+
+/* ---------------------------------------------------------------- server */
+
+static bool nb_telemetry_match(const nb_telemetry_client_t *cl, const char *path)
+{
+    return strncmp(path, cl->prefix, cl->prefix_len) == 0;
+}
+
+/* Queue a line if the buffer has room for it */
+static bool nb_telemetry_put(nb_telemetry_client_t *cl, const char *path, int64_t value)
+{
+    int n = snprintf(cl->out + cl->out_len, NB_TELEMETRY_OUT_BUF - cl->out_len,
+        "%s %lld\n", path, (long long)value);
+
+    if (n < 0 || (uint32_t)n >= NB_TELEMETRY_OUT_BUF - cl->out_len) return false;
+    cl->out_len += (uint32_t)n;
+    atomic_fetch_add_explicit(&telemetry.updates, 1, memory_order_relaxed);
+    return true;
+}
+
+/* Queue a change; a client whose buffer is full is resynchronised later */
+static bool nb_telemetry_emit(nb_telemetry_client_t *cl, const char *path, int64_t value)
+{
+    if (cl->resync) return false;
+
+    if (!nb_telemetry_put(cl, path, value)) {
+        cl->resync = true;
+        atomic_fetch_add_explicit(&telemetry.resyncs, 1, memory_order_relaxed);
+        return false;
+    }
+    return true;
+}
+
+static bool nb_telemetry_text(nb_telemetry_client_t *cl, const char *text)
+{
+    size_t n = strlen(text);
+
+    if (n > NB_TELEMETRY_OUT_BUF - cl->out_len) return false;
+    memcpy(cl->out + cl->out_len, text, n);
+    cl->out_len += (uint32_t)n;
+    return true;
+}
+
+/* Continue the snapshot in progress; returns true once it is complete */
+static bool nb_telemetry_snapshot_run(nb_telemetry_client_t *cl)
+{
+    int n = atomic_load_explicit(&telemetry.nkeys, memory_order_acquire);
+
+    for (; cl->snap_next < n; cl->snap_next++) {
+        nb_telemetry_key_t *k = &telemetry.keys[cl->snap_next];
+
+        if (cl->on_change && k->kind != NB_TELEMETRY_STATE) continue;
+        if (!nb_telemetry_match(cl, k->path)) continue;
+        if (cl->snap_since &&
+            atomic_load_explicit(&k->version, memory_order_relaxed) <= cl->snap_since) {
+            atomic_fetch_add_explicit(&telemetry.suppressed, 1, memory_order_relaxed);
+            continue;
+        }
+        /* Buffer full: resume here after the next flush */
+        if (!nb_telemetry_put(cl, k->path,
+                atomic_load_explicit(&k->value, memory_order_relaxed))) return false;
+    }
+
+    if (cl->snap_sync && !nb_telemetry_text(cl, "sync\n")) return false;
+    cl->snap_next = -1;
+    return true;
+}
+
+/*
+ * Every matching key, optionally only those changed since 'since'.
+ * Gauges are only included for sample subscriptions.
+ */
+static void nb_telemetry_snapshot(nb_telemetry_client_t *cl, uint64_t since, bool sync)
+{
+    cl->snap_next = 0;
+    cl->snap_since = since;
+    cl->snap_sync = sync;
+    nb_telemetry_snapshot_run(cl);
+}
+
+/* Full state, then "sync"; changes are streamed from here on */
+static void nb_telemetry_sync(nb_telemetry_client_t *cl, uint64_t now)
+{
+    nb_mutex_lock(&telemetry.lock);
+    cl->log_pos = telemetry.log_seq;
+    nb_mutex_unlock(&telemetry.lock);
+    cl->sample_version = atomic_load(&telemetry.version);
+
+    cl->resync = false;
+    nb_telemetry_snapshot(cl, 0, true);
+
+    cl->next_sample_ms = now + cl->sample_ms;
+    cl->next_heartbeat_ms = now + cl->heartbeat_ms;
+}
+
+static void nb_telemetry_subscribe(nb_telemetry_client_t *cl, char *line, uint64_t now)
+{
+    char *save = NULL;
+    char *verb = strtok_r(line, " \t", &save);
+    char *prefix = strtok_r(NULL, " \t", &save);
+    char *mode = strtok_r(NULL, " \t", &save);
+    char *tok;
+
+    if (!verb || strcmp(verb, "subscribe") != 0 || !prefix || !mode ||
+        strlen(prefix) >= NB_TELEMETRY_KEY_LEN) {
+        nb_telemetry_text(cl, "error usage: subscribe <prefix> on-change|sample <ms> "
+            "[suppress] [heartbeat <ms>]\n");
+        return;
+    }
+
+    nb_telemetry_client_t sub = *cl;
+    sub.suppress = false;
+    sub.sample_ms = 0;
+    sub.heartbeat_ms = 0;
+
+    if (strcmp(mode, "on-change") == 0) {
+        sub.on_change = true;
+    } else if (strcmp(mode, "sample") == 0 && (tok = strtok_r(NULL, " \t", &save))) {
+        sub.on_change = false;
+        sub.sample_ms = (uint32_t)strtoul(tok, NULL, 10);
+        if (sub.sample_ms < NB_TELEMETRY_MIN_SAMPLE_MS) sub.sample_ms = NB_TELEMETRY_MIN_SAMPLE_MS;
+    } else {
+        nb_telemetry_text(cl, "error mode must be on-change or sample <ms>\n");
+        return;
+    }
+
+    while ((tok = strtok_r(NULL, " \t", &save))) {
+        if (strcmp(tok, "suppress") == 0 && !sub.on_change) {
+            sub.suppress = true;
+        } else if (strcmp(tok, "heartbeat") == 0 && (tok = strtok_r(NULL, " \t", &save))) {
+            sub.heartbeat_ms = (uint32_t)strtoul(tok, NULL, 10);
+            if (sub.heartbeat_ms && sub.heartbeat_ms < NB_TELEMETRY_MIN_SAMPLE_MS) {
+                sub.heartbeat_ms = NB_TELEMETRY_MIN_SAMPLE_MS;
+            }
+        } else {
+            nb_telemetry_text(cl, "error unknown option\n");
+            return;
+        }
+    }
+
+    strcpy(sub.prefix, prefix);
+    sub.prefix_len = strlen(prefix);
+    sub.subscribed = true;
+    *cl = sub;
+
+    nb_telemetry_sync(cl, now);
+}
+
+static void nb_telemetry_close(nb_telemetry_client_t *cl)
+{
+    close(cl->fd);
+    cl->fd = -1;
+    free(cl->out);
+    cl->out = NULL;
+    atomic_fetch_sub(&telemetry.nclients, 1);
+}
+
+static void nb_telemetry_accept(uint64_t now)
+{
+    int fd = accept4(telemetry.listen_fd, NULL, NULL, SOCK_NONBLOCK | SOCK_CLOEXEC);
+    if (fd < 0) return;
+
+    for (int i = 0; i < NB_TELEMETRY_MAX_CLIENTS; i++) {
+        nb_telemetry_client_t *cl = &telemetry.clients[i];
+        if (cl->fd >= 0) continue;
+
+        memset(cl, 0, sizeof(*cl));
+        cl->out = malloc(NB_TELEMETRY_OUT_BUF);
+        if (!cl->out) break;
+        cl->fd = fd;
+        cl->snap_next = -1;
+        cl->next_sample_ms = now;
+        atomic_fetch_add(&telemetry.nclients, 1);
+        return;
+    }
+
+    syslog_write(LOG_WARNING, "Telemetry: Refusing subscriber, %d already connected",
+        NB_TELEMETRY_MAX_CLIENTS);
+    close(fd);
+}
+
+/* Returns false if the client went away */
+static bool nb_telemetry_read(nb_telemetry_client_t *cl, uint64_t now)
+{
+    ssize_t n = recv(cl->fd, cl->in + cl->in_len, sizeof(cl->in) - 1 - cl->in_len, 0);
+
+    if (n == 0) return false;
+    if (n < 0) return errno == EAGAIN || errno == EWOULDBLOCK || errno == EINTR;
+
+    cl->in_len += (uint32_t)n;
+    cl->in[cl->in_len] = '\0';
+
+    char *line = cl->in;
+    char *nl;
+    while ((nl = strchr(line, '\n'))) {
+        *nl = '\0';
+        if (nl > line && nl[-1] == '\r') nl[-1] = '\0';
+        if (*line) nb_telemetry_subscribe(cl, line, now);
+        line = nl + 1;
+    }
+
+    cl->in_len -= (uint32_t)(line - cl->in);
+    memmove(cl->in, line, cl->in_len);
+    if (cl->in_len == sizeof(cl->in) - 1) return false;    /* Line too long */
+    return true;
+}
+
+/* Stream logged changes since the client's position */
+static void nb_telemetry_changes(nb_telemetry_client_t *cl)
+{
+    uint32_t count = 0;
+    bool overrun = false;
+
+    nb_mutex_lock(&telemetry.lock);
+    if (telemetry.log_seq - cl->log_pos > NB_TELEMETRY_LOG_SIZE) {
+        overrun = true;
+    } else {
+        for (uint64_t s = cl->log_pos + 1; s <= telemetry.log_seq; s++) {
+            telemetry_batch[count++] = telemetry.log[s & (NB_TELEMETRY_LOG_SIZE - 1)];
+        }
+        cl->log_pos = telemetry.log_seq;
+    }
+    nb_mutex_unlock(&telemetry.lock);
+
+    if (overrun) {
+        cl->resync = true;
+        atomic_fetch_add_explicit(&telemetry.resyncs, 1, memory_order_relaxed);
+        return;
+    }
+
+    for (uint32_t i = 0; i < count; i++) {
+        const char *path = telemetry.keys[telemetry_batch[i].key].path;
+        if (!nb_telemetry_match(cl, path)) continue;
+        if (!nb_telemetry_emit(cl, path, telemetry_batch[i].value)) return;
+    }
+}
+
+static bool nb_telemetry_flush(nb_telemetry_client_t *cl)
+{
+    uint32_t done = 0;
+
+    while (done < cl->out_len) {
+        ssize_t n = send(cl->fd, cl->out + done, cl->out_len - done, MSG_DONTWAIT | MSG_NOSIGNAL);
+        if (n < 0) {
+            if (errno == EINTR) continue;
+            if (errno == EAGAIN || errno == EWOULDBLOCK) break;
+            return false;
+        }
+        done += (uint32_t)n;
+    }
+
+    cl->out_len -= done;
+    if (cl->out_len) memmove(cl->out, cl->out + done, cl->out_len);
+    return true;
+}
+
+/* Work due for one client; returns false if it should be dropped */
+static bool nb_telemetry_service(nb_telemetry_client_t *cl, uint64_t now)
+{
+    if (!cl->subscribed) return true;
+
+    if (cl->resync) {
+        if (cl->out_len == 0) nb_telemetry_sync(cl, now);
+        return true;
+    }
+
+    /* Nothing else until a snapshot in progress is through */
+    if (cl->snap_next >= 0 && !nb_telemetry_snapshot_run(cl)) return true;
+
+    if (cl->heartbeat_ms && now >= cl->next_heartbeat_ms) {
+        /* Everything, so a suppressed stream still refreshes each value */
+        nb_telemetry_snapshot(cl, 0, false);
+        cl->next_heartbeat_ms = now + cl->heartbeat_ms;
+        if (!cl->on_change) {
+            cl->sample_version = atomic_load(&telemetry.version);
+            cl->next_sample_ms = now + cl->sample_ms;
+        }
+        if (cl->snap_next >= 0) return true;
+    }
+
+    if (cl->on_change) {
+        nb_telemetry_changes(cl);
+    } else if (now >= cl->next_sample_ms) {
+        uint64_t version = atomic_load(&telemetry.version);
+        nb_telemetry_snapshot(cl, cl->suppress ? cl->sample_version : 0, false);
+        cl->sample_version = version;
+        /* Stay on the sample grid rather than drifting by the service delay */
+        cl->next_sample_ms += cl->sample_ms;
+        if (cl->next_sample_ms <= now) cl->next_sample_ms = now + cl->sample_ms;
+    }
+    return true;
+}
+
+static void *nb_telemetry_thread(void *arg)
+{
+    struct pollfd pfd[2 + NB_TELEMETRY_MAX_CLIENTS];
+    int slot[2 + NB_TELEMETRY_MAX_CLIENTS];
+
+    (void)arg;
+    pthread_setname_np(pthread_self(), "nb-telemetry");
+
+    while (atomic_load(&telemetry.running)) {
+        uint64_t now = nb_telemetry_now_ms();
+        int64_t wait = NB_TELEMETRY_MAX_WAIT_MS;
+        int n = 0;
+
+        pfd[n].fd = telemetry.listen_fd;
+        pfd[n++].events = POLLIN;
+        pfd[n].fd = telemetry.event_fd;
+        pfd[n++].events = POLLIN;
+
+        for (int i = 0; i < NB_TELEMETRY_MAX_CLIENTS; i++) {
+            nb_telemetry_client_t *cl = &telemetry.clients[i];
+            if (cl->fd < 0) continue;
+
+            pfd[n].fd = cl->fd;
+            pfd[n].events = POLLIN | (cl->out_len || cl->snap_next >= 0 ? POLLOUT : 0);
+            slot[n++] = i;
+
+            if (!cl->subscribed) continue;
+            if (!cl->on_change && (int64_t)(cl->next_sample_ms - now) < wait) {
+                wait = (int64_t)(cl->next_sample_ms - now);
+            }
+            if (cl->heartbeat_ms && (int64_t)(cl->next_heartbeat_ms - now) < wait) {
+                wait = (int64_t)(cl->next_heartbeat_ms - now);
+            }
+        }
+
+        if (poll(pfd, (nfds_t)n, wait > 0 ? (int)wait : 0) < 0 && errno != EINTR) break;
+
+        now = nb_telemetry_now_ms();
+
+        if (pfd[1].revents & POLLIN) {
+            uint64_t v;
+            if (read(telemetry.event_fd, &v, sizeof(v)) < 0) {
+                /* Spurious wakeup */
+            }
+            /* Cleared before reading the log so no change is left unannounced */
+            atomic_store(&telemetry.pending, false);
+        }
+
+        for (int p = 2; p < n; p++) {
+            nb_telemetry_client_t *cl = &telemetry.clients[slot[p]];
+            bool ok = true;
+
+            if (pfd[p].revents & (POLLIN | POLLHUP | POLLERR)) ok = nb_telemetry_read(cl, now);
+            if (ok) ok = nb_telemetry_service(cl, now);
+            if (ok && cl->out_len) ok = nb_telemetry_flush(cl);
+            if (!ok) nb_telemetry_close(cl);
+        }
+
+        if (pfd[0].revents & POLLIN) nb_telemetry_accept(now);
+    }
+
+    return NULL;
+}
+
+int nb_telemetry_start(const char *path)
+{
+    struct sockaddr_un sun = { .sun_family = AF_UNIX };
+
+    if (atomic_load(&telemetry.running)) return -1;
+    if (!path) path = NB_TELEMETRY_PATH;
+    if (strlen(path) >= sizeof(sun.sun_path)) return -1;
+
+    strcpy(sun.sun_path, path);
+    strcpy(telemetry.sock_path, path);
+    for (int i = 0; i < NB_TELEMETRY_MAX_CLIENTS; i++) telemetry.clients[i].fd = -1;
+
+    telemetry.listen_fd = socket(AF_UNIX, SOCK_STREAM | SOCK_NONBLOCK | SOCK_CLOEXEC, 0);
+    if (telemetry.listen_fd < 0) goto fail;
+
+    unlink(path);
+    if (bind(telemetry.listen_fd, (struct sockaddr *)&sun, sizeof(sun)) != 0 ||
+        listen(telemetry.listen_fd, NB_TELEMETRY_MAX_CLIENTS) != 0) goto fail;
+
+    telemetry.event_fd = eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+    if (telemetry.event_fd < 0) goto fail;
+
+    atomic_store(&telemetry.running, true);
+    if (pthread_create(&telemetry.thread, NULL, nb_telemetry_thread, NULL) != 0) {
+        atomic_store(&telemetry.running, false);
+        goto fail;
+    }
+
+    syslog_write(LOG_INFO, "Telemetry: Serving %d keys on %s",
+        atomic_load(&telemetry.nkeys), path);
+    return 0;
+
+fail:
+    syslog_write(LOG_ERR, "Telemetry: Cannot serve on %s: %s", path, strerror(errno));
+    if (telemetry.listen_fd >= 0) close(telemetry.listen_fd);
+    if (telemetry.event_fd >= 0) close(telemetry.event_fd);
+    telemetry.listen_fd = -1;
+    telemetry.event_fd = -1;
+    return -1;
+}
+
+void nb_telemetry_stop(void)
+{
+    if (!atomic_exchange(&telemetry.running, false)) return;
+
+    uint64_t one = 1;
+    if (write(telemetry.event_fd, &one, sizeof(one)) < 0) {
+        /* The thread notices within NB_TELEMETRY_MAX_WAIT_MS anyway */
+    }
+    pthread_join(telemetry.thread, NULL);
+
+    for (int i = 0; i < NB_TELEMETRY_MAX_CLIENTS; i++) {
+        if (telemetry.clients[i].fd >= 0) nb_telemetry_close(&telemetry.clients[i]);
+    }
+
+    int efd = telemetry.event_fd;
+    telemetry.event_fd = -1;
+    close(efd);
+    close(telemetry.listen_fd);
+    telemetry.listen_fd = -1;
+    unlink(telemetry.sock_path);
+}
+
+void nb_telemetry_get_stats(nb_telemetry_stats_t *stats)
+{
+    stats->keys = (uint32_t)atomic_load(&telemetry.nkeys);
+    stats->changes = atomic_load(&telemetry.changes);
+    stats->updates = atomic_load(&telemetry.updates);
+    stats->suppressed = atomic_load(&telemetry.suppressed);
+    stats->resyncs = atomic_load(&telemetry.resyncs);
+    stats->clients = atomic_load(&telemetry.nclients);
+}
+
+void nb_telemetry_dump(void)
+{
+    nb_telemetry_stats_t st;
+
+    nb_telemetry_get_stats(&st);
+    syslog_write(LOG_INFO, "Telemetry: %u keys, %u subscribers; %llu changes logged, "
+        "%llu updates sent, %llu suppressed, %llu resyncs", st.keys, st.clients,
+        (unsigned long long)st.changes, (unsigned long long)st.updates,
+        (unsigned long long)st.suppressed, (unsigned long long)st.resyncs);
+}
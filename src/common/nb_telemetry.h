@@ -0,0 +1,64 @@
+/*
+ * nb_telemetry.h - Change-Driven Streaming Telemetry
+ *
+ * NetBlade OS v3.x Common Library
+ * Copyright (c) 2024-2026 Enterprise Systems Inc. All rights reserved.
+ */
+
+#ifndef NB_TELEMETRY_H
+#define NB_TELEMETRY_H
+
+#include <stdint.h>
+#include <stdbool.h>
+
+#define NB_TELEMETRY_PATH       "/run/netblade/telemetry.sock"
+#define NB_TELEMETRY_MAX_KEYS   4096
+#define NB_TELEMETRY_KEY_LEN    64
+#define NB_TELEMETRY_LOG_SIZE   4096    /* Changes kept for on-change clients; power of two */
+#define NB_TELEMETRY_MAX_CLIENTS 16
+#define NB_TELEMETRY_OUT_BUF    65536   /* Per client */
+#define NB_TELEMETRY_MIN_SAMPLE_MS 100
+
+/* Key kinds */
+#define NB_TELEMETRY_STATE      0   /* Every change is logged and pushed */
+#define NB_TELEMETRY_SAMPLED    1   /* Gauges; only sample subscriptions see them */
+
+typedef struct {
+    uint32_t keys;
+    uint64_t changes;           /* State key changes logged */
+    uint64_t updates;           /* Lines sent to clients */
+    uint64_t suppressed;        /* Sample values not sent because unchanged */
+    uint64_t resyncs;           /* Client fell behind the log or its buffer */
+    uint32_t clients;
+} nb_telemetry_stats_t;
+
+/*
+ * Producers register a key once and set it whenever they like; setting
+ * the value it already has costs one atomic load. Keys are paths such
+ * as "cluster/1/role" or "bgp/vrf/5/hold_time". Returns the key id, or
+ * -1 when the table is full. Registering an existing path returns its id.
+ */
+int nb_telemetry_key(const char *path, uint8_t kind);
+void nb_telemetry_set(int key, int64_t value);
+
+/*
+ * Serve subscriptions on a unix stream socket. Each client sends one
+ * line, which replaces any earlier subscription:
+ *
+ *   subscribe <prefix> on-change [heartbeat <ms>]
+ *   subscribe <prefix> sample <ms> [suppress] [heartbeat <ms>]
+ *
+ * and receives "<path> <value>" lines: every matching key, then "sync",
+ * then updates. On-change streams every logged change in order, so a
+ * state that flips and flips back is still seen. Sample sends the
+ * matching keys every interval; with suppress only those that changed.
+ * Heartbeat resends everything matching at that interval, so a quiet
+ * suppressed stream still proves the values are current.
+ */
+int nb_telemetry_start(const char *path);
+void nb_telemetry_stop(void);
+
+void nb_telemetry_get_stats(nb_telemetry_stats_t *stats);
+void nb_telemetry_dump(void);
+
+#endif /* NB_TELEMETRY_H */
@@ -0,0 +1,327 @@
+/*
+ * cluster_groups.c - HA Failover Groups
+ *
+ * NetBlade OS v3.x High Availability Module
+ * Copyright (c) 2024-2026 Enterprise Systems Inc. All rights reserved.
+ *
+ * A failover group is a set of VRFs (and their VIPs) with its own role
+ * and election, so a tracked failure in one tenant moves only that
+ * tenant. Every group rides the existing heartbeat: roles are packed
+ * two bits per group, so 512 groups cost 128 bytes per heartbeat and
+ * one linear pass per heartbeat received.
+ *
+ * VRFs not in any group keep following the global cluster role.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+#include <stdbool.h>
+#include "cluster_groups.h"
+#include "cluster_state.h"
+#include "cluster_track.h"
+#include "cluster_journal.h"
+#include "vip_announce.h"
+#include "syslog.h"
+
+const char *cluster_group_role_name(uint8_t role)
+{
+    switch (role) {
+        case GROUP_ROLE_INIT:     return "INIT";
+        case GROUP_ROLE_ACTIVE:   return "ACTIVE";
+        case GROUP_ROLE_STANDBY:  return "STANDBY";
+        case GROUP_ROLE_DEGRADED: return "DEGRADED";
+    }
+    return "UNKNOWN";
+}
+
+static bool group_local_preferred(const cluster_groups_t *cg, uint16_t id)
+{
+    const failover_group_t *g = &cg->groups[id];
+
+    switch (g->prefer) {
+        case GROUP_PREFER_LOCAL: return true;
+        case GROUP_PREFER_PEER:  return false;
+    }
+
+    /* Even groups to the lower serial, odd to the higher: active/active */
+    return ((id & 1) == 0) == cg->local_is_lower;
+}
+
+static void group_set_role(cluster_groups_t *cg, uint16_t id, uint8_t role)
+{
+    failover_group_t *g = &cg->groups[id];
+    uint8_t old = g->role;
+
+    if (old == role) return;
+
+    syslog_write(LOG_WARNING, "Cluster group %d (%s): %s -> %s",
+        id, g->name, cluster_group_role_name(old), cluster_group_role_name(role));
+    cluster_journal_log(CJ_EVENT_GROUP_ROLE_CHANGE, cg->cluster_id, old, role, id);
+
+    if (cg->service_cb) {
+        if (role == GROUP_ROLE_ACTIVE || old == GROUP_ROLE_ACTIVE) {
+            cg->service_cb(g, role == GROUP_ROLE_ACTIVE, cg->service_ctx);
+        }
+    } else if (role == GROUP_ROLE_ACTIVE) {
+        for (int i = 0; i < g->vrf_count; i++) {
+            cluster_activate_vrf_virtual_ips(g->vrf_ids[i]);
+        }
+        vip_announce_start_vrfs(g->vrf_ids, g->vrf_count);
+    } else if (old == GROUP_ROLE_ACTIVE) {
+        vip_announce_cancel_vrfs(g->vrf_ids, g->vrf_count);
+        for (int i = 0; i < g->vrf_count; i++) {
+            cluster_release_vrf_virtual_ips(g->vrf_ids[i]);
+        }
+    }
+
+    g->role = role;
+    cg->gen++;
+}
+
+/*
+ * group_next_role - One step of a group's state machine
+ *
+ * ACTIVE yields only to a healthy STANDBY peer and never preempts a
+ * healthy ACTIVE peer. When neither side is healthy the preferred
+ * node serves anyway, since a degraded group beats an unserved one.
+ */
+static uint8_t group_next_role(const cluster_groups_t *cg, uint16_t id)
+{
+    const failover_group_t *g = &cg->groups[id];
+    bool preferred = group_local_preferred(cg, id);
+
+    switch (g->role) {
+        case GROUP_ROLE_INIT:
+            if (!cg->peer_up) return GROUP_ROLE_INIT;
+            return g->healthy ? GROUP_ROLE_STANDBY : GROUP_ROLE_DEGRADED;
+
+        case GROUP_ROLE_ACTIVE:
+            if (!cg->peer_up) return GROUP_ROLE_ACTIVE;
+            if (g->peer_role == GROUP_ROLE_ACTIVE && !preferred)
+                return g->healthy ? GROUP_ROLE_STANDBY : GROUP_ROLE_DEGRADED;
+            if (!g->healthy && g->peer_role == GROUP_ROLE_STANDBY)
+                return GROUP_ROLE_DEGRADED;
+            return GROUP_ROLE_ACTIVE;
+
+        case GROUP_ROLE_STANDBY:
+            if (!g->healthy) return GROUP_ROLE_DEGRADED;
+            if (!cg->peer_up) return GROUP_ROLE_ACTIVE;
+            if (g->peer_role == GROUP_ROLE_DEGRADED) return GROUP_ROLE_ACTIVE;
+            if (g->peer_role == GROUP_ROLE_STANDBY && preferred) return GROUP_ROLE_ACTIVE;
+            return GROUP_ROLE_STANDBY;
+
+        case GROUP_ROLE_DEGRADED:
+            if (g->healthy) return GROUP_ROLE_STANDBY;
+            if (!cg->peer_up) return GROUP_ROLE_ACTIVE;
+            if (g->peer_role == GROUP_ROLE_DEGRADED && preferred) return GROUP_ROLE_ACTIVE;
+            return GROUP_ROLE_DEGRADED;
+    }
+
+    return g->role;
+}
+
+/*
+ * groups_evaluate - Run every configured group to a stable role
+ */
+static bool groups_evaluate(cluster_groups_t *cg)
+{
+    bool changed = false;
+
+    for (uint16_t id = 0; id < cg->max_id; id++) {
+        if (!cg->groups[id].in_use) continue;
+
+        /* At most INIT -> STANDBY -> ACTIVE in one pass */
+        for (int step = 0; step < 3; step++) {
+            uint8_t next = group_next_role(cg, id);
+            if (next == cg->groups[id].role) break;
+            group_set_role(cg, id, next);
+            changed = true;
+        }
+    }
+
+    return changed;
+}
+
+void cluster_groups_init(cluster_groups_t *cg, uint32_t cluster_id)
+{
+    memset(cg, 0, sizeof(cluster_groups_t));
+    cg->cluster_id = cluster_id;
+}
+
+void cluster_groups_set_service_cb(cluster_groups_t *cg, cluster_group_cb_t cb, void *ctx)
+{
+    cg->service_cb = cb;
+    cg->service_ctx = ctx;
+}
+
+bool cluster_groups_owns_vrf(const cluster_groups_t *cg, uint32_t vrf_id)
+{
+    for (uint16_t id = 0; id < cg->max_id; id++) {
+        const failover_group_t *g = &cg->groups[id];
+
+        if (!g->in_use) continue;
+        for (int i = 0; i < g->vrf_count; i++) {
+            if (g->vrf_ids[i] == vrf_id) return true;
+        }
+    }
+    return false;
+}
+
+int cluster_groups_vrfs(const cluster_groups_t *cg, uint32_t *vrf_ids, int max)
+{
+    int n = 0;
+
+    for (uint16_t id = 0; id < cg->max_id; id++) {
+        const failover_group_t *g = &cg->groups[id];
+
+        if (!g->in_use) continue;
+        for (int i = 0; i < g->vrf_count && n < max; i++) {
+            vrf_ids[n++] = g->vrf_ids[i];
+        }
+    }
+    return n;
+}
+
+/*
+ * cluster_groups_add - CLI: 'cluster failover-group <id> name <name> vrf ...'
+ */
+int cluster_groups_add(cluster_groups_t *cg, uint16_t group_id, const char *name,
+                       const uint32_t *vrf_ids, uint8_t vrf_count)
+{
+    if (group_id >= MAX_FAILOVER_GROUPS || vrf_count > MAX_GROUP_VRFS) {
+        syslog_write(LOG_ERR, "Cluster group %d: Invalid id or too many VRFs", group_id);
+        return -1;
+    }
+
+    failover_group_t *g = &cg->groups[group_id];
+    if (g->in_use) {
+        syslog_write(LOG_ERR, "Cluster group %d: Already configured", group_id);
+        return -1;
+    }
+
+    memset(g, 0, sizeof(failover_group_t));
+    g->in_use = true;
+    strncpy(g->name, name, sizeof(g->name) - 1);
+    memcpy(g->vrf_ids, vrf_ids, vrf_count * sizeof(uint32_t));
+    g->vrf_count = vrf_count;
+    g->healthy = true;
+    g->role = GROUP_ROLE_INIT;
+    g->peer_role = GROUP_ROLE_INIT;
+
+    if (group_id >= cg->max_id) {
+        cg->max_id = group_id + 1;
+    }
+    cg->gen++;
+
+    syslog_write(LOG_INFO, "Cluster group %d (%s): Configured with %d VRFs",
+        group_id, g->name, vrf_count);
+
+    groups_evaluate(cg);
+    return 0;
+}
+
+int cluster_groups_remove(cluster_groups_t *cg, uint16_t group_id)
+{
+    if (group_id >= MAX_FAILOVER_GROUPS || !cg->groups[group_id].in_use) return -1;
+
+    if (cg->groups[group_id].role == GROUP_ROLE_ACTIVE) {
+        group_set_role(cg, group_id, GROUP_ROLE_STANDBY);
+    }
+    memset(&cg->groups[group_id], 0, sizeof(failover_group_t));
+
+    while (cg->max_id > 0 && !cg->groups[cg->max_id - 1].in_use) {
+        cg->max_id--;
+    }
+    cg->gen++;
+    return 0;
+}
+
+int cluster_groups_set_tracking(cluster_groups_t *cg, uint16_t group_id,
+                                uint64_t track_mask, uint8_t min_health)
+{
+    if (group_id >= MAX_FAILOVER_GROUPS || !cg->groups[group_id].in_use) return -1;
+
+    cg->groups[group_id].track_mask = track_mask;
+    cg->groups[group_id].min_health = min_health;
+    cluster_groups_health_update(cg);
+    return 0;
+}
+
+int cluster_groups_set_preference(cluster_groups_t *cg, uint16_t group_id,
+                                  uint8_t prefer)
+{
+    if (group_id >= MAX_FAILOVER_GROUPS || !cg->groups[group_id].in_use) return -1;
+    if (prefer > GROUP_PREFER_PEER) return -1;
+
+    cg->groups[group_id].prefer = prefer;
+    groups_evaluate(cg);
+    return 0;
+}
+
+uint16_t cluster_groups_encode(const cluster_groups_t *cg, uint8_t *bitmap)
+{
+    memset(bitmap, 0, GROUP_ROLE_BITMAP_BYTES);
+
+    for (uint16_t id = 0; id < cg->max_id; id++) {
+        if (cg->groups[id].in_use) {
+            bitmap[id >> 2] |= (uint8_t)(cg->groups[id].role << ((id & 3) * 2));
+        }
+    }
+
+    return cg->max_id;
+}
+
+/*
+ * cluster_groups_peer_update - Apply the peer's group roles from a heartbeat
+ *
+ * Groups the peer does not report (not configured there yet) are seen
+ * as INIT, which never triggers a promotion on our side.
+ */
+bool cluster_groups_peer_update(cluster_groups_t *cg, const uint8_t *bitmap,
+                                uint16_t group_count, bool local_is_lower)
+{
+    cg->peer_up = true;
+    cg->local_is_lower = local_is_lower;
+
+    for (uint16_t id = 0; id < cg->max_id; id++) {
+        failover_group_t *g = &cg->groups[id];
+
+        if (!g->in_use) continue;
+        g->peer_role = (id < group_count) ?
+            (bitmap[id >> 2] >> ((id & 3) * 2)) & 3 : GROUP_ROLE_INIT;
+    }
+
+    return groups_evaluate(cg);
+}
+
+/*
+ * cluster_groups_peer_lost - Heartbeat timed out; take over every group we can
+ */
+bool cluster_groups_peer_lost(cluster_groups_t *cg)
+{
+    cg->peer_up = false;
+
+    for (uint16_t id = 0; id < cg->max_id; id++) {
+        cg->groups[id].peer_role = GROUP_ROLE_INIT;
+    }
+
+    return groups_evaluate(cg);
+}
+
+/*
+ * cluster_groups_health_update - Re-check each group's tracked objects
+ */
+bool cluster_groups_health_update(cluster_groups_t *cg)
+{
+    for (uint16_t id = 0; id < cg->max_id; id++) {
+        failover_group_t *g = &cg->groups[id];
+
+        if (!g->in_use) continue;
+        g->healthy = (g->track_mask == 0) ||
+            cluster_track_get_health_mask(g->track_mask) >= g->min_health;
+    }
+
+    return groups_evaluate(cg);
+}
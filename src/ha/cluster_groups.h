@@ -0,0 +1,96 @@
+/*
+ * cluster_groups.h - HA Failover Groups
+ *
+ * NetBlade OS v3.x High Availability Module
+ * Copyright (c) 2024-2026 Enterprise Systems Inc. All rights reserved.
+ */
+
+#ifndef CLUSTER_GROUPS_H
+#define CLUSTER_GROUPS_H
+
+#include <stdint.h>
+#include <stdbool.h>
+
+#define MAX_FAILOVER_GROUPS     512
+#define MAX_GROUP_VRFS          16
+
+/* Group roles, two bits each on the wire */
+#define GROUP_ROLE_INIT         0
+#define GROUP_ROLE_ACTIVE       1
+#define GROUP_ROLE_STANDBY      2
+#define GROUP_ROLE_DEGRADED     3   /* STANDBY, but tracked objects failed */
+
+#define GROUP_ROLE_BITMAP_BYTES (MAX_FAILOVER_GROUPS * 2 / 8)
+
+/* Which node should hold a group when both are healthy */
+#define GROUP_PREFER_AUTO       0   /* Spread groups across the pair by id */
+#define GROUP_PREFER_LOCAL      1
+#define GROUP_PREFER_PEER       2
+
+typedef struct {
+    bool     in_use;
+    char     name[32];
+    uint32_t vrf_ids[MAX_GROUP_VRFS];
+    uint8_t  vrf_count;
+    uint64_t track_mask;        /* cluster_track ids this group depends on */
+    uint8_t  min_health;        /* Below this the group cannot be ACTIVE */
+    uint8_t  prefer;
+    bool     healthy;
+    uint8_t  role;
+    uint8_t  peer_role;
+} failover_group_t;
+
+/*
+ * Brings a group's VRFs into (active) or out of service. Without one,
+ * the group's VRF VIPs are activated/released and announced directly.
+ */
+typedef void (*cluster_group_cb_t)(const failover_group_t *g, bool active, void *ctx);
+
+/*
+ * Group table embedded in a cluster's state; all calls are made with
+ * that cluster's state_lock held.
+ */
+typedef struct {
+    failover_group_t groups[MAX_FAILOVER_GROUPS];
+    uint16_t         max_id;     /* Highest configured id + 1 */
+    uint32_t         gen;        /* Bumped whenever the encoded roles change */
+    uint32_t         cluster_id;
+    bool             peer_up;
+    bool             local_is_lower;    /* Local serial sorts before peer's */
+    cluster_group_cb_t service_cb;
+    void            *service_ctx;
+} cluster_groups_t;
+
+void cluster_groups_init(cluster_groups_t *cg, uint32_t cluster_id);
+void cluster_groups_set_service_cb(cluster_groups_t *cg, cluster_group_cb_t cb, void *ctx);
+
+int cluster_groups_add(cluster_groups_t *cg, uint16_t group_id, const char *name,
+                       const uint32_t *vrf_ids, uint8_t vrf_count);
+int cluster_groups_remove(cluster_groups_t *cg, uint16_t group_id);
+int cluster_groups_set_tracking(cluster_groups_t *cg, uint16_t group_id,
+                                uint64_t track_mask, uint8_t min_health);
+int cluster_groups_set_preference(cluster_groups_t *cg, uint16_t group_id,
+                                  uint8_t prefer);
+
+/*
+ * VRFs bound to a group follow the group's role, not the cluster's.
+ * cluster_groups_vrfs() writes them (at most max) and returns the count.
+ */
+bool cluster_groups_owns_vrf(const cluster_groups_t *cg, uint32_t vrf_id);
+int cluster_groups_vrfs(const cluster_groups_t *cg, uint32_t *vrf_ids, int max);
+
+/* Pack local group roles; returns the number of groups encoded */
+uint16_t cluster_groups_encode(const cluster_groups_t *cg, uint8_t *bitmap);
+
+/*
+ * Run every group's state machine. Each returns true if a local group
+ * role changed, in which case the caller should send a heartbeat now.
+ */
+bool cluster_groups_peer_update(cluster_groups_t *cg, const uint8_t *bitmap,
+                                uint16_t group_count, bool local_is_lower);
+bool cluster_groups_peer_lost(cluster_groups_t *cg);
+bool cluster_groups_health_update(cluster_groups_t *cg);
+
+const char *cluster_group_role_name(uint8_t role);
+
+#endif /* CLUSTER_GROUPS_H */
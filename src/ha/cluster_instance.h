@@ -0,0 +1,89 @@
+/*
+ * cluster_instance.h - HA Cluster Instances
+ *
+ * NetBlade OS v3.x High Availability Module
+ * Copyright (c) 2024-2026 Enterprise Systems Inc. All rights reserved.
+ *
+ * Handle-based API for running more than one cluster per process
+ * (e.g. separate management and data clusters, or a simulator). The
+ * legacy cluster_*() calls in cluster_state.h operate on a built-in
+ * default instance.
+ */
+
+#ifndef CLUSTER_INSTANCE_H
+#define CLUSTER_INSTANCE_H
+
+#include <stdint.h>
+#include <stdbool.h>
+#include "cluster_state.h"
+#include "heartbeat.h"
+#include "heartbeat_stats.h"
+
+typedef struct cluster_state cluster_t;
+
+/*
+ * Side effects of a role change and the heartbeat transport. NULL ops
+ * (or NULL members) select the node-wide defaults: VIP/MAC activation
+ * with paced announcements, and heartbeat_send().
+ */
+typedef struct {
+    void (*activate)(cluster_t *c, void *ctx);
+    void (*release)(cluster_t *c, void *ctx);
+    int  (*send)(cluster_t *c, const heartbeat_msg_t *msg, void *ctx);
+} cluster_ops_t;
+
+/*
+ * The event journal (cluster_journal.h) is shared by every instance in
+ * the process. cluster_state_init() opens it; a process that only uses
+ * cluster_create() must call cluster_journal_open() first, or its
+ * instances' events are not journaled; cluster_create() warns then.
+ */
+cluster_t *cluster_create(uint32_t cluster_id, const char *local_serial,
+                          const cluster_ops_t *ops, void *ops_ctx);
+void cluster_destroy(cluster_t *c);
+
+/* Default instance behind the legacy API */
+cluster_t *cluster_default(void);
+
+/* Find an instance by cluster id, for demuxing received heartbeats */
+cluster_t *cluster_lookup(uint32_t cluster_id);
+
+int cluster_set_timers(cluster_t *c, uint32_t interval_ms, uint32_t timeout_ms);
+
+/*
+ * cluster_run_timers - Tick every instance whose heartbeat is due
+ *
+ * Returns the monotonic time (ns) of the next deadline across all
+ * instances, so one thread can drive any number of clusters.
+ */
+uint64_t cluster_run_timers(uint64_t now_ns);
+
+int cluster_tick(cluster_t *c);
+int cluster_receive(cluster_t *c, const heartbeat_msg_t *msg);
+/* Peer failure detected by the transport itself (see heartbeat_shm.h) */
+void cluster_peer_lost(cluster_t *c);
+int cluster_set_role(cluster_t *c, uint8_t role);
+/* Role swap with the peer during ISSU, see cluster_sync.h */
+int cluster_handover(cluster_t *c, uint8_t role);
+int cluster_status(cluster_t *c, cluster_status_t *status);
+void cluster_set_health(cluster_t *c, uint8_t health);
+int cluster_set_paths(cluster_t *c, uint8_t count);
+int cluster_path_stats(cluster_t *c, uint8_t path_id, hb_path_stats_t *stats);
+
+/* Fast rejoin after reboot, see cluster_persist.h */
+int cluster_enable_persist(cluster_t *c, const char *path);
+void cluster_set_sync_point(cluster_t *c, uint64_t epoch, uint64_t version);
+void cluster_get_sync_point(cluster_t *c, uint64_t *epoch, uint64_t *version);
+/* Bump the epoch for a change log starting over; returns the new epoch */
+uint64_t cluster_new_epoch(cluster_t *c);
+
+int cluster_group_add(cluster_t *c, uint16_t group_id, const char *name,
+                      const uint32_t *vrf_ids, uint8_t vrf_count);
+int cluster_group_remove(cluster_t *c, uint16_t group_id);
+/* Objects in track_mask then count towards the group only, not node-wide health */
+int cluster_group_track(cluster_t *c, uint16_t group_id, uint64_t track_mask,
+                        uint8_t min_health);
+int cluster_group_status(cluster_t *c, uint16_t group_id, uint8_t *local_role,
+                         uint8_t *peer_role);
+
+#endif /* CLUSTER_INSTANCE_H */
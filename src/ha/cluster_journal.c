@@ -0,0 +1,223 @@
+/*
+ * cluster_journal.c - HA Cluster Event Journal
+ *
+ * NetBlade OS v3.x High Availability Module
+ * Copyright (c) 2024-2026 Enterprise Systems Inc. All rights reserved.
+ *
+ * Append-only ring of cluster events in a fixed-size memory-mapped file.
+ * Records land in the page cache as they are written, so the journal
+ * survives a crash of the process even when syslog does not, and is
+ * carried over across restarts for post-mortem analysis of split-brain
+ * incidents.
+ *
+ * Writers claim a slot with a single atomic increment and publish it
+ * by storing the sequence number last: no locks, no syscalls, two
+ * vDSO clock reads per event. Each record carries its own wall-clock
+ * time, so records written before a reboot still read back correctly.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+#include <stdbool.h>
+#include <stdatomic.h>
+#include <time.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include "cluster_journal.h"
+#include "syslog.h"
+
+#define CLUSTER_JOURNAL_MAGIC       0x4e424a4cU     /* "NBJL" */
+#define CLUSTER_JOURNAL_VERSION     2   /* 2: wall-clock time per record */
+
+typedef struct {
+    uint32_t magic;
+    uint32_t version;
+    uint32_t record_size;
+    uint32_t capacity;
+    uint8_t  pad0[48];
+    _Atomic uint64_t next_seq;  /* Own cache line: every writer touches it */
+    uint8_t  pad1[56];
+} cluster_journal_hdr_t;
+
+#define JOURNAL_SIZE \
+    (sizeof(cluster_journal_hdr_t) + \
+     (size_t)CLUSTER_JOURNAL_RECORDS * sizeof(cluster_journal_rec_t))
+
+static cluster_journal_hdr_t *journal_hdr;
+static cluster_journal_rec_t *journal_recs;
+
+static uint64_t journal_clock_ns(clockid_t clk)
+{
+    struct timespec ts;
+    clock_gettime(clk, &ts);
+    return (uint64_t)ts.tv_sec * 1000000000ULL + (uint64_t)ts.tv_nsec;
+}
+
+static bool journal_hdr_valid(const cluster_journal_hdr_t *hdr)
+{
+    return hdr->magic == CLUSTER_JOURNAL_MAGIC &&
+           hdr->version == CLUSTER_JOURNAL_VERSION &&
+           hdr->record_size == sizeof(cluster_journal_rec_t) &&
+           hdr->capacity == CLUSTER_JOURNAL_RECORDS;
+}
+
+/*
+ * cluster_journal_open - Map the journal file, creating it if needed
+ *
+ * An existing journal with a matching layout is appended to, so the
+ * events leading up to a crash are still there after restart.
+ */
+int cluster_journal_open(const char *path)
+{
+    if (journal_hdr) return 0;
+
+    int fd = open(path, O_RDWR | O_CREAT, 0640);
+    if (fd < 0) {
+        syslog_write(LOG_ERR, "Cluster journal: Cannot open %s", path);
+        return -1;
+    }
+
+    if (ftruncate(fd, (off_t)JOURNAL_SIZE) != 0) {
+        syslog_write(LOG_ERR, "Cluster journal: Cannot size %s", path);
+        close(fd);
+        return -1;
+    }
+
+    void *map = mmap(NULL, JOURNAL_SIZE, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+    close(fd);
+
+    if (map == MAP_FAILED) {
+        syslog_write(LOG_ERR, "Cluster journal: Cannot map %s", path);
+        return -1;
+    }
+
+    cluster_journal_hdr_t *hdr = map;
+
+    if (!journal_hdr_valid(hdr)) {
+        memset(map, 0, JOURNAL_SIZE);
+        hdr->magic = CLUSTER_JOURNAL_MAGIC;
+        hdr->version = CLUSTER_JOURNAL_VERSION;
+        hdr->record_size = sizeof(cluster_journal_rec_t);
+        hdr->capacity = CLUSTER_JOURNAL_RECORDS;
+        atomic_store(&hdr->next_seq, 0);
+        syslog_write(LOG_INFO, "Cluster journal: Created %s (%d records)",
+            path, CLUSTER_JOURNAL_RECORDS);
+    } else {
+        syslog_write(LOG_INFO, "Cluster journal: Appending to %s at seq %llu",
+            path, (unsigned long long)atomic_load(&hdr->next_seq));
+    }
+
+    journal_recs = (cluster_journal_rec_t *)(hdr + 1);
+    journal_hdr = hdr;
+    return 0;
+}
+
+void cluster_journal_close(void)
+{
+    if (!journal_hdr) return;
+
+    cluster_journal_hdr_t *hdr = journal_hdr;
+    journal_hdr = NULL;
+    journal_recs = NULL;
+
+    msync(hdr, JOURNAL_SIZE, MS_SYNC);
+    munmap(hdr, JOURNAL_SIZE);
+}
+
+bool cluster_journal_is_open(void)
+{
+    return journal_hdr != NULL;
+}
+
+void cluster_journal_log(uint16_t event, uint32_t cluster_id, uint8_t old_role,
+                         uint8_t new_role, int64_t arg)
+{
+    cluster_journal_hdr_t *hdr = journal_hdr;
+    if (!hdr) return;
+
+    uint64_t seq = atomic_fetch_add_explicit(&hdr->next_seq, 1, memory_order_relaxed) + 1;
+    cluster_journal_rec_t *rec = &journal_recs[(seq - 1) & (CLUSTER_JOURNAL_RECORDS - 1)];
+    _Atomic uint64_t *rec_seq = (_Atomic uint64_t *)&rec->seq;
+
+    /* Invalidate first so a crash mid-write leaves a skippable record */
+    atomic_store_explicit(rec_seq, 0, memory_order_relaxed);
+    atomic_thread_fence(memory_order_release);
+
+    rec->mono_ns = journal_clock_ns(CLOCK_MONOTONIC);
+    rec->real_ns = journal_clock_ns(CLOCK_REALTIME);
+    rec->cluster_id = cluster_id;
+    rec->event = event;
+    rec->old_role = old_role;
+    rec->new_role = new_role;
+    rec->arg = arg;
+
+    atomic_store_explicit(rec_seq, seq, memory_order_release);
+}
+
+int cluster_journal_read(const char *path, cluster_journal_cb_t cb, void *ctx)
+{
+    if (!cb) return -1;
+
+    int fd = open(path, O_RDONLY);
+    if (fd < 0) return -1;
+
+    struct stat st;
+    if (fstat(fd, &st) != 0 || (size_t)st.st_size < JOURNAL_SIZE) {
+        close(fd);
+        return -1;
+    }
+
+    void *map = mmap(NULL, JOURNAL_SIZE, PROT_READ, MAP_SHARED, fd, 0);
+    close(fd);
+    if (map == MAP_FAILED) return -1;
+
+    const cluster_journal_hdr_t *hdr = map;
+    if (!journal_hdr_valid(hdr)) {
+        munmap(map, JOURNAL_SIZE);
+        return -1;
+    }
+
+    const cluster_journal_rec_t *recs = (const cluster_journal_rec_t *)(hdr + 1);
+    uint64_t end = atomic_load((_Atomic uint64_t *)&hdr->next_seq);
+    uint64_t start = (end > CLUSTER_JOURNAL_RECORDS) ? end - CLUSTER_JOURNAL_RECORDS : 0;
+    int count = 0;
+
+    for (uint64_t seq = start + 1; seq <= end; seq++) {
+        const cluster_journal_rec_t *rec = &recs[(seq - 1) & (CLUSTER_JOURNAL_RECORDS - 1)];
+        _Atomic uint64_t *rec_seq = (_Atomic uint64_t *)&rec->seq;
+        cluster_journal_rec_t copy;
+
+        if (atomic_load_explicit(rec_seq, memory_order_acquire) != seq) continue;
+        memcpy(&copy, rec, sizeof(copy));
+        /* A live writer may have reclaimed the slot while we copied it */
+        atomic_thread_fence(memory_order_acquire);
+        if (atomic_load_explicit(rec_seq, memory_order_relaxed) != seq) continue;
+
+        count++;
+        if (cb(&copy, copy.real_ns, ctx) != 0) break;
+    }
+
+    munmap(map, JOURNAL_SIZE);
+    return count;
+}
+
+const char *cluster_journal_event_name(uint16_t event)
+{
+    switch (event) {
+        case CJ_EVENT_ROLE_CHANGE:        return "role-change";
+        case CJ_EVENT_FORCED_ROLE:        return "forced-role";
+        case CJ_EVENT_HEARTBEAT_LOST:     return "heartbeat-lost";
+        case CJ_EVENT_HEARTBEAT_RESTORED: return "heartbeat-restored";
+        case CJ_EVENT_SPLIT_BRAIN:        return "split-brain";
+        case CJ_EVENT_HEALTH_CHANGE:      return "health-change";
+        case CJ_EVENT_GROUP_ROLE_CHANGE:  return "group-role-change";
+        case CJ_EVENT_HANDOVER:           return "handover";
+        case CJ_EVENT_ISSU_SYNC:          return "issu-sync";
+        case CJ_EVENT_REJOIN:             return "rejoin";
+    }
+    return "unknown";
+}
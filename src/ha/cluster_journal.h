@@ -0,0 +1,68 @@
+/*
+ * cluster_journal.h - HA Cluster Event Journal
+ *
+ * NetBlade OS v3.x High Availability Module
+ * Copyright (c) 2024-2026 Enterprise Systems Inc. All rights reserved.
+ */
+
+#ifndef CLUSTER_JOURNAL_H
+#define CLUSTER_JOURNAL_H
+
+#include <stdint.h>
+#include <stdbool.h>
+
+#define CLUSTER_JOURNAL_PATH        "/var/lib/netblade/cluster.journal"
+#define CLUSTER_JOURNAL_RECORDS     65536   /* Must be a power of two */
+
+/* Journal event types */
+#define CJ_EVENT_ROLE_CHANGE        1   /* arg: 0 */
+#define CJ_EVENT_FORCED_ROLE        2   /* arg: 0 */
+#define CJ_EVENT_HEARTBEAT_LOST     3   /* arg: ms since last rx */
+#define CJ_EVENT_HEARTBEAT_RESTORED 4   /* arg: gap in ms */
+#define CJ_EVENT_SPLIT_BRAIN        5   /* arg: 0 */
+#define CJ_EVENT_HEALTH_CHANGE      6   /* arg: new local health */
+#define CJ_EVENT_GROUP_ROLE_CHANGE  7   /* arg: failover group id */
+#define CJ_EVENT_HANDOVER           8   /* arg: 0 */
+#define CJ_EVENT_ISSU_SYNC          9   /* arg: records synced */
+#define CJ_EVENT_REJOIN             10  /* arg: persisted state version */
+
+/*
+ * One record per cache line so concurrent writers never share a line.
+ * seq is written last; a record whose seq is 0 or does not match its
+ * slot was torn by a crash and is skipped by the reader.
+ */
+typedef struct {
+    uint64_t seq;
+    uint64_t mono_ns;       /* CLOCK_MONOTONIC */
+    uint64_t real_ns;       /* CLOCK_REALTIME */
+    uint32_t cluster_id;
+    uint16_t event;
+    uint8_t  old_role;
+    uint8_t  new_role;
+    int64_t  arg;
+    uint8_t  reserved[24];
+} cluster_journal_rec_t;
+
+typedef int (*cluster_journal_cb_t)(const cluster_journal_rec_t *rec,
+                                    uint64_t real_ns, void *ctx);
+
+int cluster_journal_open(const char *path);
+void cluster_journal_close(void);
+bool cluster_journal_is_open(void);
+
+/* Lock-free, safe from any thread; a no-op if the journal is not open */
+void cluster_journal_log(uint16_t event, uint32_t cluster_id, uint8_t old_role,
+                         uint8_t new_role, int64_t arg);
+
+/*
+ * cluster_journal_read - Walk a journal file oldest-first
+ *
+ * Works on the journal of a crashed process, or of a live one: records
+ * being overwritten while read are skipped. real_ns is the record's
+ * wall-clock time as stamped when it was written.
+ */
+int cluster_journal_read(const char *path, cluster_journal_cb_t cb, void *ctx);
+
+const char *cluster_journal_event_name(uint16_t event);
+
+#endif /* CLUSTER_JOURNAL_H */
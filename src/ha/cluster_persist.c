@@ -0,0 +1,106 @@
+/*
+ * cluster_persist.c - Persisted Cluster State
+ *
+ * NetBlade OS v3.x High Availability Module
+ * Copyright (c) 2024-2026 Enterprise Systems Inc. All rights reserved.
+ *
+ * A few dozen bytes that let a rebooted node rejoin as STANDBY at once
+ * instead of starting from INIT: the role it last held, who its peer
+ * was, and how far it had applied the peer's replicated state. Written
+ * to a temporary file and renamed over the old one, so a crash leaves
+ * either the previous state or the new one, never a mix; the CRC
+ * catches anything else.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include "cluster_persist.h"
+#include "syslog.h"
+
+#define CLUSTER_PERSIST_MAGIC   0x4e425053U     /* "NBPS" */
+#define CLUSTER_PERSIST_VERSION 1
+
+typedef struct {
+    uint32_t magic;
+    uint32_t version;
+    uint32_t size;
+    uint32_t crc;
+    cluster_persist_t state;
+} cluster_persist_file_t;
+
+static uint32_t persist_crc32(const uint8_t *p, size_t len)
+{
+    uint32_t crc = 0xffffffffU;
+
+    while (len--) {
+        crc ^= *p++;
+        for (int k = 0; k < 8; k++) {
+            crc = (crc >> 1) ^ (0xedb88320U & (0U - (crc & 1)));
+        }
+    }
+    return ~crc;
+}
+
+int cluster_persist_save(const char *path, const cluster_persist_t *st)
+{
+    char tmp[256];
+    cluster_persist_file_t f;
+
+    memset(&f, 0, sizeof(f));
+    f.magic = CLUSTER_PERSIST_MAGIC;
+    f.version = CLUSTER_PERSIST_VERSION;
+    f.size = sizeof(cluster_persist_t);
+    memcpy(&f.state, st, sizeof(cluster_persist_t));
+    f.crc = persist_crc32((const uint8_t *)&f.state, sizeof(f.state));
+
+    snprintf(tmp, sizeof(tmp), "%s.tmp", path);
+
+    int fd = open(tmp, O_WRONLY | O_CREAT | O_TRUNC, 0640);
+    if (fd < 0) {
+        syslog_write(LOG_ERR, "Cluster persist: Cannot open %s", tmp);
+        return -1;
+    }
+
+    if (write(fd, &f, sizeof(f)) != (ssize_t)sizeof(f) || fdatasync(fd) != 0) {
+        syslog_write(LOG_ERR, "Cluster persist: Cannot write %s", tmp);
+        close(fd);
+        unlink(tmp);
+        return -1;
+    }
+    close(fd);
+
+    if (rename(tmp, path) != 0) {
+        syslog_write(LOG_ERR, "Cluster persist: Cannot replace %s", path);
+        unlink(tmp);
+        return -1;
+    }
+    return 0;
+}
+
+int cluster_persist_load(const char *path, cluster_persist_t *st)
+{
+    cluster_persist_file_t f;
+
+    int fd = open(path, O_RDONLY);
+    if (fd < 0) return -1;
+
+    ssize_t n = read(fd, &f, sizeof(f));
+    close(fd);
+
+    if (n != (ssize_t)sizeof(f) ||
+        f.magic != CLUSTER_PERSIST_MAGIC ||
+        f.version != CLUSTER_PERSIST_VERSION ||
+        f.size != sizeof(cluster_persist_t) ||
+        f.crc != persist_crc32((const uint8_t *)&f.state, sizeof(f.state))) {
+        syslog_write(LOG_WARNING, "Cluster persist: Ignoring invalid %s", path);
+        return -1;
+    }
+
+    memcpy(st, &f.state, sizeof(cluster_persist_t));
+    st->peer_serial[sizeof(st->peer_serial) - 1] = '\0';
+    return 0;
+}
@@ -0,0 +1,29 @@
+/*
+ * cluster_persist.h - Persisted Cluster State
+ *
+ * NetBlade OS v3.x High Availability Module
+ * Copyright (c) 2024-2026 Enterprise Systems Inc. All rights reserved.
+ */
+
+#ifndef CLUSTER_PERSIST_H
+#define CLUSTER_PERSIST_H
+
+#include <stdint.h>
+
+#define CLUSTER_PERSIST_PATH    "/var/lib/netblade/cluster.state"
+
+typedef struct {
+    uint32_t cluster_id;
+    uint8_t  role;              /* Last role held */
+    char     peer_serial[32];
+    uint64_t epoch;             /* Bumped on every promotion in the cluster */
+    uint64_t state_version;     /* Replicated state applied up to (epoch, version) */
+} cluster_persist_t;
+
+/* Atomically replace the state file. Returns 0 or -1 */
+int cluster_persist_save(const char *path, const cluster_persist_t *st);
+
+/* Returns 0, or -1 if the file is missing, torn or from another layout */
+int cluster_persist_load(const char *path, cluster_persist_t *st);
+
+#endif /* CLUSTER_PERSIST_H */
@@ -6,6 +6,11 @@
  *
  * Manages cluster role elections, heartbeat monitoring, and split-brain
  * detection/recovery for 2-node HA pairs.
+ *
+ * All state is per instance (cluster_t), each with its own lock and
+ * heartbeat timers, so any number of clusters can run in one process.
+ * The original cluster_*() entry points drive a built-in default
+ * instance.
  */
 
 #include <stdio.h>
@@ -15,10 +20,22 @@
 #include <stdbool.h>
 #include <time.h>
 #include <pthread.h>
+#include <stdatomic.h>
 #include "cluster_state.h"
+#include "cluster_instance.h"
 #include "heartbeat.h"
 #include "syslog.h"
+#include "nb_mutex.h"
+#include "nb_prof.h"
 #include "interface_manager.h"
+#include "cluster_track.h"
+#include "heartbeat_stats.h"
+#include "cluster_journal.h"
+#include "vip_announce.h"
+#include "cluster_groups.h"
+#include "cluster_persist.h"
+#include "nb_telemetry.h"
+#include "vrf_manager.h"
 
 /* Cluster roles */
 #define CLUSTER_ROLE_INIT       0
@@ -26,7 +43,7 @@
 #define CLUSTER_ROLE_STANDBY    2
 #define CLUSTER_ROLE_SPLIT      3   /* Both nodes active — error state */
 
-/* Heartbeat settings */
+/* Heartbeat settings (defaults; per instance via cluster_set_timers) */
 #define HEARTBEAT_INTERVAL_MS   1000    /* 1 second */
 #define HEARTBEAT_TIMEOUT_MS    3000    /* 3 missed heartbeats */
 #define SPLIT_BRAIN_DELAY_MS    5000    /* Wait before declaring split-brain */
@@ -35,7 +52,19 @@
 #define ELECTION_PRIORITY_SERIAL    0   /* Lower serial number wins */
 #define ELECTION_PRIORITY_UPTIME    1   /* Higher uptime wins */
 
-typedef struct {
+#define CLUSTER_HASH_BUCKETS    256
+#define CLUSTER_RUN_BATCH       64      /* Instances ticked per registry pass */
+
+/* Telemetry keys per instance, "cluster/<id>/<name>" */
+#define CLUSTER_TELEM_ROLE          0
+#define CLUSTER_TELEM_PEER_ROLE     1
+#define CLUSTER_TELEM_HEARTBEAT_UP  2
+#define CLUSTER_TELEM_SPLIT_BRAIN   3
+#define CLUSTER_TELEM_HEALTH        4
+#define CLUSTER_TELEM_HOLD_MARGIN   5   /* ms left before heartbeat timeout; sampled */
+#define CLUSTER_TELEM_KEYS          6
+
+struct cluster_state {
     uint8_t     local_role;
     uint8_t     peer_role;
     bool        heartbeat_up;
@@ -47,115 +76,708 @@ typedef struct {
     bool        split_brain_detected;
     bool        auto_recovery_enabled;
     uint8_t     election_policy;
-    pthread_mutex_t state_lock;
-} cluster_state_t;
+    uint8_t     local_health;       /* From cluster_track, sent in heartbeats */
+    uint8_t     peer_health;        /* Last health reported by peer */
+    uint8_t     path_count;         /* Heartbeat paths in use */
+    hb_path_stats_t paths[HEARTBEAT_MAX_PATHS];
+    cluster_groups_t groups;        /* Per-failover-group roles */
+    bool        handover_pending;   /* Yielded ACTIVE by handover; peer not ACTIVE yet */
+
+    /* Prebuilt heartbeats and the state they were built from */
+    heartbeat_msg_t hb_tmpl[HEARTBEAT_MAX_PATHS];
+    uint8_t     hb_tmpl_paths;      /* 0 = not built */
+    uint8_t     hb_tmpl_role;
+    uint8_t     hb_tmpl_health;
+    uint32_t    hb_tmpl_group_gen;
+
+    /* Persisted for fast rejoin (cluster_enable_persist) */
+    uint64_t    epoch;
+    uint64_t    state_version;      /* Replicated state applied, within epoch */
+    char        persist_path[128];
+    bool        persist_dirty;      /* Sync point moved; written at the next tick */
+    bool        persist_now;        /* Written when state_lock is released */
+    uint64_t    persist_gen;        /* Snapshots taken */
+    uint64_t    persist_written;    /* Newest snapshot on disk; under persist_lock */
+    nb_mutex_t  persist_lock;
+
+    /* Per-instance heartbeat timers (CLOCK_MONOTONIC) */
+    uint32_t    interval_ms;
+    uint32_t    timeout_ms;
+    uint64_t    last_rx_ns;
+    _Atomic uint64_t next_tick_ns;  /* Written under state_lock, peeked without */
+
+    /* Telemetry keys, registered on first publish */
+    int         telem[CLUSTER_TELEM_KEYS];
+    bool        telem_ready;
 
-static cluster_state_t cluster;
+    const cluster_ops_t *ops;
+    void       *ops_ctx;
+    bool        registered;
+    uint32_t    refs;               /* Held by cluster_run_timers; under registry.lock */
+    uint64_t    run_pass;           /* Last cluster_run_timers call to collect it; ditto */
+    struct cluster_state *hash_next;
+    nb_mutex_t      state_lock;
+};
+
+typedef struct cluster_state cluster_state_t;
+
+static cluster_state_t default_cluster;
+
+static struct {
+    cluster_state_t *buckets[CLUSTER_HASH_BUCKETS];
+    nb_mutex_t       lock;
+    pthread_cond_t   released;      /* An instance's refs dropped to 0 */
+    uint64_t         run_pass;
+} registry = {
+    .lock = NB_MUTEX_INITIALIZER("cluster.registry"),
+    .released = PTHREAD_COND_INITIALIZER,
+};
+
+static int cluster_auto_resolve_split_brain(cluster_state_t *c);
+static void cluster_health_changed(uint8_t health, void *ctx);
+
+static uint64_t cluster_clock_ns(clockid_t clk)
+{
+    struct timespec ts;
+    clock_gettime(clk, &ts);
+    return (uint64_t)ts.tv_sec * 1000000000ULL + (uint64_t)ts.tv_nsec;
+}
+
+static void cluster_register(cluster_state_t *c)
+{
+    uint32_t b = c->cluster_id % CLUSTER_HASH_BUCKETS;
+
+    nb_mutex_lock(&registry.lock);
+    c->hash_next = registry.buckets[b];
+    registry.buckets[b] = c;
+    c->registered = true;
+    nb_mutex_unlock(&registry.lock);
+}
 
 /*
- * cluster_state_init - Initialize cluster state machine
+ * cluster_unregister - Remove from the registry
+ *
+ * Returns once no timer pass still holds the instance, so the caller
+ * may free or reinitialise it.
  */
-int cluster_state_init(uint32_t cluster_id, const char *local_serial)
+static void cluster_unregister(cluster_state_t *c)
 {
-    memset(&cluster, 0, sizeof(cluster_state_t));
-    pthread_mutex_init(&cluster.state_lock, NULL);
+    nb_mutex_lock(&registry.lock);
 
-    cluster.cluster_id = cluster_id;
-    strncpy(cluster.local_serial, local_serial, sizeof(cluster.local_serial) - 1);
-    cluster.local_role = CLUSTER_ROLE_INIT;
-    cluster.peer_role = CLUSTER_ROLE_INIT;
-    cluster.heartbeat_up = false;
-    cluster.auto_recovery_enabled = false;
-    cluster.election_policy = ELECTION_PRIORITY_SERIAL;
+    cluster_state_t **pp = &registry.buckets[c->cluster_id % CLUSTER_HASH_BUCKETS];
+    while (*pp) {
+        if (*pp == c) {
+            *pp = c->hash_next;
+            break;
+        }
+        pp = &(*pp)->hash_next;
+    }
+    c->registered = false;
 
-    syslog_write(LOG_INFO, "Cluster %d initialized. Local serial: %s",
-        cluster_id, local_serial);
+    /* A timer pass may still be ticking it outside the registry lock */
+    while (c->refs) nb_cond_wait(&registry.released, &registry.lock);
+
+    nb_mutex_unlock(&registry.lock);
+}
+
+/*
+ * cluster_save - Have the rejoin state written, if persistence is enabled
+ *
+ * Caller must hold state_lock and release it with cluster_unlock(),
+ * which does the write.
+ */
+static void cluster_save(cluster_state_t *c)
+{
+    c->persist_now = true;
+}
+
+/*
+ * cluster_unlock - Release state_lock, then write any saved state
+ *
+ * The snapshot is taken under state_lock, but the write, fdatasync and
+ * rename run after it is released, so heartbeats are never held up by
+ * the disk. persist_lock orders writers; a snapshot older than the one
+ * already on disk is dropped.
+ */
+static void cluster_unlock(cluster_state_t *c)
+{
+    cluster_persist_t st;
+    char path[sizeof(c->persist_path)];
+    uint64_t gen;
+
+    if (!c->persist_now || c->persist_path[0] == '\0') {
+        c->persist_now = false;
+        nb_mutex_unlock(&c->state_lock);
+        return;
+    }
 
+    memset(&st, 0, sizeof(st));
+    st.cluster_id = c->cluster_id;
+    st.role = c->local_role;
+    memcpy(st.peer_serial, c->peer_serial, sizeof(st.peer_serial));
+    st.epoch = c->epoch;
+    st.state_version = c->state_version;
+    memcpy(path, c->persist_path, sizeof(path));
+    gen = ++c->persist_gen;
+    c->persist_now = false;
+    c->persist_dirty = false;
+
+    nb_mutex_unlock(&c->state_lock);
+
+    nb_mutex_lock(&c->persist_lock);
+    if (gen > c->persist_written) {
+        cluster_persist_save(path, &st);
+        c->persist_written = gen;
+    }
+    nb_mutex_unlock(&c->persist_lock);
+}
+
+/*
+ * cluster_publish - Push role and heartbeat state to telemetry
+ *
+ * Called after anything that can change them; unchanged values cost a
+ * load each. Caller must hold state_lock.
+ */
+static void cluster_publish(cluster_state_t *c)
+{
+    static const char *names[CLUSTER_TELEM_KEYS] = {
+        "role", "peer_role", "heartbeat_up", "split_brain", "health", "hold_margin_ms",
+    };
+
+    if (!c->telem_ready) {
+        char path[NB_TELEMETRY_KEY_LEN];
+
+        for (int i = 0; i < CLUSTER_TELEM_KEYS; i++) {
+            snprintf(path, sizeof(path), "cluster/%u/%s", c->cluster_id, names[i]);
+            c->telem[i] = nb_telemetry_key(path, i == CLUSTER_TELEM_HOLD_MARGIN ?
+                NB_TELEMETRY_SAMPLED : NB_TELEMETRY_STATE);
+        }
+        c->telem_ready = true;
+    }
+
+    nb_telemetry_set(c->telem[CLUSTER_TELEM_ROLE], c->local_role);
+    nb_telemetry_set(c->telem[CLUSTER_TELEM_PEER_ROLE], c->peer_role);
+    nb_telemetry_set(c->telem[CLUSTER_TELEM_HEARTBEAT_UP], c->heartbeat_up);
+    nb_telemetry_set(c->telem[CLUSTER_TELEM_SPLIT_BRAIN], c->split_brain_detected);
+    nb_telemetry_set(c->telem[CLUSTER_TELEM_HEALTH], c->local_health);
+}
+
+/*
+ * cluster_global_vips - Bring the VIPs that follow the cluster role up or down
+ *
+ * VRFs bound to a failover group follow the group's role, so with
+ * groups configured only the remaining VRFs are switched here, and only
+ * their announcements are started or cancelled. Caller must hold
+ * state_lock.
+ */
+static void cluster_global_vips(cluster_state_t *c, bool active)
+{
+    uint32_t grouped[MAX_FAILOVER_GROUPS * MAX_GROUP_VRFS];
+    int ngrouped = cluster_groups_vrfs(&c->groups, grouped, MAX_FAILOVER_GROUPS * MAX_GROUP_VRFS);
+
+    if (ngrouped == 0) {
+        if (active) {
+            cluster_activate_virtual_ips();
+            vip_announce_start();
+        } else {
+            vip_announce_cancel();
+            cluster_release_virtual_ips();
+        }
+        return;
+    }
+
+    int count = vrf_manager_get_count();
+    vrf_info_t *vrfs = count > 0 ? calloc((size_t)count, sizeof(vrf_info_t)) : NULL;
+    int n = vrfs ? vrf_manager_get_vrf_list(vrfs, count) : 0;
+
+    if (!active) vip_announce_cancel_except(grouped, ngrouped);
+    for (int i = 0; i < n; i++) {
+        if (cluster_groups_owns_vrf(&c->groups, vrfs[i].vrf_id)) continue;
+        if (active) {
+            cluster_activate_vrf_virtual_ips(vrfs[i].vrf_id);
+        } else {
+            cluster_release_vrf_virtual_ips(vrfs[i].vrf_id);
+        }
+    }
+    if (active) vip_announce_start_except(grouped, ngrouped);
+
+    free(vrfs);
+}
+
+/*
+ * cluster_promote - Take over VIPs and MAC tables
+ *
+ * Caller must hold state_lock.
+ */
+static void cluster_promote(cluster_state_t *c)
+{
+    cluster_journal_log(CJ_EVENT_ROLE_CHANGE, c->cluster_id,
+        c->local_role, CLUSTER_ROLE_ACTIVE, 0);
+    c->local_role = CLUSTER_ROLE_ACTIVE;
+    c->epoch++;
+
+    if (c->ops && c->ops->activate) {
+        c->ops->activate(c, c->ops_ctx);
+    } else {
+        cluster_global_vips(c, true);
+        cluster_activate_mac_tables();
+    }
+    cluster_save(c);
+}
+
+/*
+ * cluster_demote - Give up VIPs and MAC tables
+ *
+ * Caller must hold state_lock.
+ */
+static void cluster_demote(cluster_state_t *c)
+{
+    cluster_journal_log(CJ_EVENT_ROLE_CHANGE, c->cluster_id,
+        c->local_role, CLUSTER_ROLE_STANDBY, 0);
+    c->local_role = CLUSTER_ROLE_STANDBY;
+
+    if (c->ops && c->ops->release) {
+        c->ops->release(c, c->ops_ctx);
+    } else {
+        cluster_global_vips(c, false);
+        cluster_flush_mac_tables();
+    }
+    cluster_save(c);
+}
+
+/*
+ * cluster_build_templates - Prebuild the per-path heartbeat messages
+ *
+ * Everything but the timestamps is fixed until the role, health or a
+ * failover group role changes, so the send path only patches those in
+ * place. Caller must hold state_lock.
+ */
+static void cluster_build_templates(cluster_state_t *c)
+{
+    heartbeat_msg_t *t = &c->hb_tmpl[0];
+
+    memset(t, 0, sizeof(heartbeat_msg_t));
+    t->cluster_id = c->cluster_id;
+    t->sender_role = c->local_role;
+    t->health = c->local_health;
+    /* t was zeroed, so the rest of the field is NUL padding */
+    strncpy(t->sender_serial, c->local_serial, sizeof(t->sender_serial) - 1);
+    t->group_count = cluster_groups_encode(&c->groups, t->group_roles);
+
+    for (uint8_t p = 1; p < c->path_count; p++) {
+        memcpy(&c->hb_tmpl[p], t, sizeof(heartbeat_msg_t));
+        c->hb_tmpl[p].path_id = p;
+    }
+
+    c->hb_tmpl_role = c->local_role;
+    c->hb_tmpl_health = c->local_health;
+    c->hb_tmpl_group_gen = c->groups.gen;
+    c->hb_tmpl_paths = c->path_count;
+}
+
+/*
+ * cluster_send_heartbeat - Send a heartbeat to the peer on every path
+ *
+ * Caller must hold state_lock. Also used outside the tick so that role
+ * and health changes reach the peer without waiting for the next interval.
+ *
+ * Each message echoes the last timestamp the peer sent on that path
+ * plus how long we held it, so the peer can compute RTT and clock
+ * offset for the path.
+ */
+static void cluster_send_heartbeat(cluster_state_t *c, time_t now)
+{
+    if (c->hb_tmpl_paths != c->path_count || c->hb_tmpl_role != c->local_role ||
+        c->hb_tmpl_health != c->local_health || c->hb_tmpl_group_gen != c->groups.gen) {
+        cluster_build_templates(c);
+    }
+
+    for (uint8_t p = 0; p < c->path_count; p++) {
+        hb_path_stats_t *ps = &c->paths[p];
+        heartbeat_msg_t *msg = &c->hb_tmpl[p];
+
+        msg->timestamp = now;
+        msg->echo_ts_ns = ps->echo_ts_ns;
+        msg->echo_hold_ns = ps->echo_ts_ns ?
+            cluster_clock_ns(CLOCK_MONOTONIC) - ps->echo_rx_mono_ns : 0;
+        msg->tx_ts_ns = cluster_clock_ns(CLOCK_REALTIME);
+
+        if (c->ops && c->ops->send) {
+            c->ops->send(c, msg, c->ops_ctx);
+        } else {
+            heartbeat_send(msg);
+        }
+    }
+    c->last_heartbeat_tx = now;
+}
+
+/*
+ * cluster_heartbeat_lost - Peer declared dead
+ *
+ * Caller must hold state_lock.
+ */
+static void cluster_heartbeat_lost(cluster_state_t *c, double ms_since_rx)
+{
+    syslog_write(LOG_WARNING, "Cluster: Heartbeat lost (last rx: %.0f ms ago)",
+        ms_since_rx);
+    cluster_journal_log(CJ_EVENT_HEARTBEAT_LOST, c->cluster_id,
+        c->local_role, c->peer_role, (int64_t)ms_since_rx);
+    c->heartbeat_up = false;
+    c->handover_pending = false;
+
+    /*
+     * Heartbeat lost — if we're STANDBY, we need to determine
+     * if the ACTIVE node has truly failed or if this is a
+     * heartbeat link failure (which could cause split-brain).
+     */
+    if (c->local_role == CLUSTER_ROLE_STANDBY) {
+        syslog_write(LOG_WARNING, "Cluster: STANDBY node lost heartbeat. "
+            "Assuming ACTIVE node failed. Promoting to ACTIVE.");
+        cluster_promote(c);
+    }
+
+    cluster_groups_peer_lost(&c->groups);
+}
+
+/*
+ * cluster_check_health_failover - Move the ACTIVE role to the healthier node
+ *
+ * An ACTIVE node whose health drops below a STANDBY peer's yields; the
+ * STANDBY node sees the peer go STANDBY with lower health and promotes.
+ * Ties between two STANDBY nodes fall back to the lower serial.
+ * Caller must hold state_lock. Returns true if the local role changed.
+ */
+static bool cluster_check_health_failover(cluster_state_t *c)
+{
+    if (!c->heartbeat_up) return false;
+
+    if (c->local_role == CLUSTER_ROLE_ACTIVE &&
+        c->peer_role == CLUSTER_ROLE_STANDBY &&
+        c->local_health < c->peer_health) {
+
+        syslog_write(LOG_WARNING, "Cluster: Local health %d below peer health %d. "
+            "Yielding ACTIVE role.", c->local_health, c->peer_health);
+        cluster_demote(c);
+        return true;
+    }
+
+    /* During a handover the peer is about to promote; don't race it */
+    if (c->local_role == CLUSTER_ROLE_STANDBY &&
+        c->peer_role == CLUSTER_ROLE_STANDBY &&
+        !c->handover_pending &&
+        (c->local_health > c->peer_health ||
+         (c->local_health == c->peer_health &&
+          strcmp(c->local_serial, c->peer_serial) < 0))) {
+
+        syslog_write(LOG_WARNING, "Cluster: Peer yielded ACTIVE role "
+            "(local health %d, peer health %d). Promoting to ACTIVE.",
+            c->local_health, c->peer_health);
+        cluster_promote(c);
+        return true;
+    }
+
+    return false;
+}
+
+/*
+ * cluster_setup - Initialize an instance's state machine
+ */
+static void cluster_setup(cluster_state_t *c, uint32_t cluster_id, const char *local_serial,
+                          const cluster_ops_t *ops, void *ops_ctx)
+{
+    memset(c, 0, sizeof(cluster_state_t));
+    nb_mutex_init(&c->state_lock, "cluster.state_lock");
+    nb_mutex_init(&c->persist_lock, "cluster.persist_lock");
+
+    c->cluster_id = cluster_id;
+    strncpy(c->local_serial, local_serial, sizeof(c->local_serial) - 1);
+    c->local_role = CLUSTER_ROLE_INIT;
+    c->peer_role = CLUSTER_ROLE_INIT;
+    c->heartbeat_up = false;
+    c->auto_recovery_enabled = false;
+    c->election_policy = ELECTION_PRIORITY_SERIAL;
+    c->local_health = CLUSTER_HEALTH_MAX;
+    c->peer_health = CLUSTER_HEALTH_MAX;
+    c->path_count = 1;
+    c->interval_ms = HEARTBEAT_INTERVAL_MS;
+    c->timeout_ms = HEARTBEAT_TIMEOUT_MS;
+    c->ops = ops;
+    c->ops_ctx = ops_ctx;
+    cluster_groups_init(&c->groups, cluster_id);
+}
+
+/*
+ * cluster_create - Create and register an additional cluster instance
+ *
+ * Instances other than the default do not follow cluster_track; their
+ * owner feeds health in with cluster_set_health().
+ */
+cluster_t *cluster_create(uint32_t cluster_id, const char *local_serial,
+                          const cluster_ops_t *ops, void *ops_ctx)
+{
+    if (cluster_lookup(cluster_id)) {
+        syslog_write(LOG_ERR, "Cluster %d: Instance already exists", cluster_id);
+        return NULL;
+    }
+
+    cluster_state_t *c = malloc(sizeof(cluster_state_t));
+    if (!c) return NULL;
+
+    cluster_setup(c, cluster_id, local_serial, ops, ops_ctx);
+    cluster_register(c);
+
+    if (!cluster_journal_is_open()) {
+        syslog_write(LOG_WARNING, "Cluster %d: Event journal not open, events will not be journaled",
+            cluster_id);
+    }
+    return c;
+}
+
+void cluster_destroy(cluster_t *c)
+{
+    if (!c || c == &default_cluster) return;
+
+    cluster_unregister(c);
+
+    nb_mutex_destroy(&c->state_lock);
+    nb_mutex_destroy(&c->persist_lock);
+    free(c);
+}
+
+cluster_t *cluster_default(void)
+{
+    return &default_cluster;
+}
+
+cluster_t *cluster_lookup(uint32_t cluster_id)
+{
+    cluster_state_t *c;
+
+    nb_mutex_lock(&registry.lock);
+    for (c = registry.buckets[cluster_id % CLUSTER_HASH_BUCKETS]; c; c = c->hash_next) {
+        if (c->cluster_id == cluster_id) break;
+    }
+    nb_mutex_unlock(&registry.lock);
+
+    return c;
+}
+
+int cluster_set_timers(cluster_t *c, uint32_t interval_ms, uint32_t timeout_ms)
+{
+    if (interval_ms == 0 || timeout_ms <= interval_ms) {
+        syslog_write(LOG_ERR, "Cluster %d: Timeout %u ms must exceed interval %u ms",
+            c->cluster_id, timeout_ms, interval_ms);
+        return -1;
+    }
+
+    nb_mutex_lock(&c->state_lock);
+    c->interval_ms = interval_ms;
+    c->timeout_ms = timeout_ms;
+    atomic_store_explicit(&c->next_tick_ns, 0, memory_order_relaxed);
+    nb_mutex_unlock(&c->state_lock);
     return 0;
 }
 
+uint64_t cluster_run_timers(uint64_t now_ns)
+{
+    NB_PROF_SCOPE(NB_PROF_CLUSTER);
+
+    cluster_state_t *due[CLUSTER_RUN_BATCH];
+    uint64_t next, pass;
+    int n;
+
+    nb_mutex_lock(&registry.lock);
+    pass = ++registry.run_pass;
+    nb_mutex_unlock(&registry.lock);
+
+    /*
+     * Ticks run outside the registry lock, so role-change callbacks may
+     * look up or create instances. A reference keeps each collected
+     * instance alive until its tick is done, and the pass stamp keeps it
+     * from being collected twice in one call.
+     */
+    do {
+        n = 0;
+        next = UINT64_MAX;
+
+        nb_mutex_lock(&registry.lock);
+        for (int b = 0; b < CLUSTER_HASH_BUCKETS; b++) {
+            for (cluster_state_t *c = registry.buckets[b]; c; c = c->hash_next) {
+                uint64_t t = atomic_load_explicit(&c->next_tick_ns, memory_order_relaxed);
+
+                if (c->run_pass == pass) continue;
+                if (t <= now_ns && n < CLUSTER_RUN_BATCH) {
+                    c->refs++;
+                    c->run_pass = pass;
+                    due[n++] = c;
+                } else if (t < next) {
+                    next = t;
+                }
+            }
+        }
+        nb_mutex_unlock(&registry.lock);
+
+        for (int i = 0; i < n; i++) {
+            cluster_tick(due[i]);
+        }
+
+        nb_mutex_lock(&registry.lock);
+        for (int i = 0; i < n; i++) {
+            uint64_t t = atomic_load_explicit(&due[i]->next_tick_ns, memory_order_relaxed);
+
+            if (t < next) next = t;
+            if (--due[i]->refs == 0) pthread_cond_broadcast(&registry.released);
+        }
+        nb_mutex_unlock(&registry.lock);
+    } while (n == CLUSTER_RUN_BATCH);
+
+    return next;
+}
+
 /*
- * cluster_heartbeat_tick - Process heartbeat state
+ * cluster_tick - Process heartbeat state
  *
- * Called every HEARTBEAT_INTERVAL_MS by the heartbeat daemon.
- * Detects heartbeat loss and triggers role transitions.
+ * Called every interval_ms, either by the heartbeat daemon or from
+ * cluster_run_timers(). Detects heartbeat loss and triggers role
+ * transitions.
  */
-int cluster_heartbeat_tick(void)
+int cluster_tick(cluster_t *c)
 {
-    pthread_mutex_lock(&cluster.state_lock);
+    NB_PROF_SCOPE(NB_PROF_CLUSTER);
+
+    nb_mutex_lock(&c->state_lock);
 
     time_t now = time(NULL);
-    double ms_since_rx = difftime(now, cluster.last_heartbeat_rx) * 1000;
+    uint64_t now_ns = cluster_clock_ns(CLOCK_MONOTONIC);
+    double ms_since_rx = (double)(now_ns - c->last_rx_ns) / 1e6;
+
+    atomic_store_explicit(&c->next_tick_ns, now_ns + (uint64_t)c->interval_ms * 1000000ULL,
+        memory_order_relaxed);
 
     /* Check if heartbeat is alive */
-    if (cluster.heartbeat_up && ms_since_rx > HEARTBEAT_TIMEOUT_MS) {
-        syslog_write(LOG_WARNING, "Cluster: Heartbeat lost (last rx: %.0f ms ago)",
-            ms_since_rx);
-        cluster.heartbeat_up = false;
-
-        /*
-         * Heartbeat lost — if we're STANDBY, we need to determine
-         * if the ACTIVE node has truly failed or if this is a
-         * heartbeat link failure (which could cause split-brain).
-         */
-        if (cluster.local_role == CLUSTER_ROLE_STANDBY) {
-            syslog_write(LOG_WARNING, "Cluster: STANDBY node lost heartbeat. "
-                "Assuming ACTIVE node failed. Promoting to ACTIVE.");
-            cluster.local_role = CLUSTER_ROLE_ACTIVE;
-            cluster_activate_virtual_ips();
-            cluster_activate_mac_tables();
-        }
+    if (c->heartbeat_up && ms_since_rx > c->timeout_ms) {
+        cluster_heartbeat_lost(c, ms_since_rx);
     }
 
     /* Check for split-brain: both nodes claim ACTIVE */
-    if (cluster.local_role == CLUSTER_ROLE_ACTIVE &&
-        cluster.peer_role == CLUSTER_ROLE_ACTIVE) {
+    if (c->local_role == CLUSTER_ROLE_ACTIVE &&
+        c->peer_role == CLUSTER_ROLE_ACTIVE) {
 
-        if (!cluster.split_brain_detected) {
+        if (!c->split_brain_detected) {
             syslog_write(LOG_CRIT, "CLUSTER SPLIT-BRAIN DETECTED: "
-                "Both nodes active! Cluster ID: %d", cluster.cluster_id);
-            cluster.split_brain_detected = true;
+                "Both nodes active! Cluster ID: %d", c->cluster_id);
+            cluster_journal_log(CJ_EVENT_SPLIT_BRAIN, c->cluster_id,
+                c->local_role, c->peer_role, 0);
+            c->split_brain_detected = true;
 
             /* Attempt auto-recovery if enabled (v3.2.0+) */
-            if (cluster.auto_recovery_enabled) {
-                cluster_auto_resolve_split_brain();
+            if (c->auto_recovery_enabled) {
+                cluster_auto_resolve_split_brain(c);
             }
         }
     }
 
     /* Send heartbeat to peer */
-    heartbeat_msg_t msg = {
-        .cluster_id = cluster.cluster_id,
-        .sender_role = cluster.local_role,
-        .timestamp = now,
-    };
-    strncpy(msg.sender_serial, cluster.local_serial, sizeof(msg.sender_serial) - 1);
-    heartbeat_send(&msg);
-    cluster.last_heartbeat_tx = now;
+    cluster_send_heartbeat(c, now);
+
+    /* Sync point advances continuously; write it at most once per tick */
+    if (c->persist_dirty) {
+        cluster_save(c);
+    }
+
+    cluster_publish(c);
+    nb_telemetry_set(c->telem[CLUSTER_TELEM_HOLD_MARGIN], c->heartbeat_up ?
+        (int64_t)c->timeout_ms - (int64_t)ms_since_rx : 0);
 
-    pthread_mutex_unlock(&cluster.state_lock);
+    cluster_unlock(c);
     return 0;
 }
 
 /*
- * cluster_heartbeat_received - Process incoming heartbeat from peer
+ * cluster_peer_lost - Declare the peer dead without waiting for timeout
+ *
+ * For transports with their own, faster liveness detection (shared
+ * memory between supervisors in one chassis).
  */
-int cluster_heartbeat_received(const heartbeat_msg_t *msg)
+void cluster_peer_lost(cluster_t *c)
 {
-    pthread_mutex_lock(&cluster.state_lock);
+    NB_PROF_SCOPE(NB_PROF_CLUSTER);
+
+    nb_mutex_lock(&c->state_lock);
 
-    cluster.last_heartbeat_rx = time(NULL);
-    cluster.heartbeat_up = true;
-    cluster.peer_role = msg->sender_role;
-    strncpy(cluster.peer_serial, msg->sender_serial, sizeof(cluster.peer_serial) - 1);
+    if (c->heartbeat_up) {
+        uint64_t now_ns = cluster_clock_ns(CLOCK_MONOTONIC);
+        cluster_heartbeat_lost(c, (double)(now_ns - c->last_rx_ns) / 1e6);
+    }
+    cluster_publish(c);
+
+    cluster_unlock(c);
+}
+
+/*
+ * cluster_receive - Process incoming heartbeat from peer
+ */
+int cluster_receive(cluster_t *c, const heartbeat_msg_t *msg)
+{
+    NB_PROF_SCOPE(NB_PROF_CLUSTER);
+
+    nb_mutex_lock(&c->state_lock);
+
+    time_t now = time(NULL);
+    uint64_t now_ns = cluster_clock_ns(CLOCK_MONOTONIC);
+
+    if (!c->heartbeat_up && c->last_rx_ns != 0) {
+        cluster_journal_log(CJ_EVENT_HEARTBEAT_RESTORED, c->cluster_id,
+            c->local_role, msg->sender_role,
+            (int64_t)((now_ns - c->last_rx_ns) / 1000000));
+    }
+
+    c->last_heartbeat_rx = now;
+    c->last_rx_ns = now_ns;
+    c->heartbeat_up = true;
+    c->peer_role = msg->sender_role;
+    c->peer_health = msg->health;
+    if (strncmp(c->peer_serial, msg->sender_serial, sizeof(c->peer_serial) - 1) != 0) {
+        c->persist_dirty = true;
+    }
+    if (c->peer_role == CLUSTER_ROLE_ACTIVE) {
+        c->handover_pending = false;
+    }
+    strncpy(c->peer_serial, msg->sender_serial, sizeof(c->peer_serial) - 1);
+
+    /* Timing sample from the echoed timestamp, then remember this one to echo */
+    if (msg->path_id < c->path_count) {
+        hb_path_stats_t *ps = &c->paths[msg->path_id];
+        uint64_t rx_ns = cluster_clock_ns(CLOCK_REALTIME);
+
+        if (msg->echo_ts_ns != 0) {
+            hb_stats_record(ps, msg->echo_ts_ns, msg->tx_ts_ns - msg->echo_hold_ns,
+                msg->tx_ts_ns, rx_ns);
+        }
+        ps->echo_ts_ns = msg->tx_ts_ns;
+        ps->echo_rx_mono_ns = now_ns;
+    }
 
     /* If split-brain was detected and heartbeat is back, log recovery opportunity */
-    if (cluster.split_brain_detected && cluster.heartbeat_up) {
+    if (c->split_brain_detected && c->heartbeat_up) {
         syslog_write(LOG_INFO, "Cluster: Heartbeat restored during split-brain. "
             "Manual or auto recovery can proceed.");
     }
 
-    pthread_mutex_unlock(&cluster.state_lock);
+    bool changed = cluster_check_health_failover(c);
+
+    if (cluster_groups_peer_update(&c->groups, msg->group_roles, msg->group_count,
+            strcmp(c->local_serial, c->peer_serial) < 0)) {
+        changed = true;
+    }
+
+    /* Answer a health-driven or group handover at once rather than on the next tick */
+    if (changed) {
+        cluster_send_heartbeat(c, now);
+    }
+    cluster_publish(c);
+
+    cluster_unlock(c);
     return 0;
 }
 
@@ -165,17 +787,17 @@ int cluster_heartbeat_received(const heartbeat_msg_t *msg)
  * Uses election policy to determine which node becomes STANDBY.
  * Available in v3.2.0+ when 'cluster split-brain-recovery automatic' is configured.
  */
-static int cluster_auto_resolve_split_brain(void)
+static int cluster_auto_resolve_split_brain(cluster_state_t *c)
 {
     syslog_write(LOG_INFO, "Cluster: Auto-resolving split-brain using policy: %s",
-        cluster.election_policy == ELECTION_PRIORITY_SERIAL ? "serial-number" : "uptime");
+        c->election_policy == ELECTION_PRIORITY_SERIAL ? "serial-number" : "uptime");
 
     bool should_demote = false;
 
-    switch (cluster.election_policy) {
+    switch (c->election_policy) {
         case ELECTION_PRIORITY_SERIAL:
             /* Higher serial number becomes STANDBY */
-            should_demote = (strcmp(cluster.local_serial, cluster.peer_serial) > 0);
+            should_demote = (strcmp(c->local_serial, c->peer_serial) > 0);
             break;
         case ELECTION_PRIORITY_UPTIME:
             /* Lower uptime becomes STANDBY (newer boot = likely recovered node) */
@@ -186,63 +808,458 @@ static int cluster_auto_resolve_split_brain(void)
     if (should_demote) {
         syslog_write(LOG_WARNING, "Cluster: Auto-demoting local node to STANDBY "
             "(serial: %s > peer: %s)",
-            cluster.local_serial, cluster.peer_serial);
-        cluster.local_role = CLUSTER_ROLE_STANDBY;
-        cluster_release_virtual_ips();
-        cluster_flush_mac_tables();
-        cluster.split_brain_detected = false;
+            c->local_serial, c->peer_serial);
+        cluster_demote(c);
+        c->split_brain_detected = false;
     } else {
         syslog_write(LOG_INFO, "Cluster: Local node remains ACTIVE "
             "(serial: %s <= peer: %s). Waiting for peer to demote.",
-            cluster.local_serial, cluster.peer_serial);
+            c->local_serial, c->peer_serial);
     }
 
     return 0;
 }
 
 /*
- * cluster_force_role - CLI command to force cluster role
+ * cluster_set_health - Apply a new local health score
+ *
+ * The new score goes to the peer immediately, and if it costs us the
+ * ACTIVE role the failover happens here rather than on heartbeat loss.
+ * The score may be unchanged when only a failover group's objects
+ * moved; then just the groups are re-checked.
  */
-int cluster_force_role(uint8_t role)
+void cluster_set_health(cluster_t *c, uint8_t health)
 {
-    pthread_mutex_lock(&cluster.state_lock);
+    NB_PROF_SCOPE(NB_PROF_CLUSTER);
+
+    nb_mutex_lock(&c->state_lock);
+
+    if (health != c->local_health) {
+        cluster_journal_log(CJ_EVENT_HEALTH_CHANGE, c->cluster_id,
+            c->local_role, c->local_role, health);
+        c->local_health = health;
+        cluster_check_health_failover(c);
+    }
+    cluster_groups_health_update(&c->groups);
+    cluster_send_heartbeat(c, time(NULL));
+    cluster_publish(c);
+
+    cluster_unlock(c);
+}
+
+/*
+ * cluster_health_changed - Tracked object health callback
+ *
+ * Invoked from cluster_track as soon as a tracked object changes state.
+ */
+static void cluster_health_changed(uint8_t health, void *ctx)
+{
+    cluster_set_health((cluster_state_t *)ctx, health);
+}
+
+/*
+ * cluster_set_role - Force cluster role (operator command)
+ */
+int cluster_set_role(cluster_t *c, uint8_t role)
+{
+    NB_PROF_SCOPE(NB_PROF_CLUSTER);
+
+    nb_mutex_lock(&c->state_lock);
 
     syslog_write(LOG_WARNING, "Cluster: Forcing role to %s (operator command)",
         role == CLUSTER_ROLE_ACTIVE ? "ACTIVE" : "STANDBY");
+    cluster_journal_log(CJ_EVENT_FORCED_ROLE, c->cluster_id,
+        c->local_role, role, 0);
 
     if (role == CLUSTER_ROLE_STANDBY) {
-        cluster_release_virtual_ips();
-        cluster_flush_mac_tables();
+        if (c->ops && c->ops->release) {
+            c->ops->release(c, c->ops_ctx);
+        } else {
+            cluster_global_vips(c, false);
+            cluster_flush_mac_tables();
+        }
     } else if (role == CLUSTER_ROLE_ACTIVE) {
-        cluster_activate_virtual_ips();
-        cluster_activate_mac_tables();
+        if (c->local_role != CLUSTER_ROLE_ACTIVE) {
+            c->epoch++;
+        }
+        if (c->ops && c->ops->activate) {
+            c->ops->activate(c, c->ops_ctx);
+        } else {
+            cluster_global_vips(c, true);
+            cluster_activate_mac_tables();
+        }
     }
 
-    cluster.local_role = role;
-    cluster.split_brain_detected = false;
+    c->local_role = role;
+    c->split_brain_detected = false;
+    cluster_save(c);
+    cluster_publish(c);
 
-    pthread_mutex_unlock(&cluster.state_lock);
+    cluster_unlock(c);
     return 0;
 }
 
 /*
- * cluster_get_status - Get cluster status for show commands and API
+ * cluster_handover - Coordinated role change for in-service upgrade
+ *
+ * Unlike cluster_set_role() this assumes the peer already holds our
+ * state and takes the opposite role at the same moment. HA MAC entries
+ * are only switched out of service, and a STANDBY node will not promote
+ * itself again before the peer reports ACTIVE. The new role is sent
+ * to the peer at once.
  */
-int cluster_get_status(cluster_status_t *status)
+int cluster_handover(cluster_t *c, uint8_t role)
+{
+    NB_PROF_SCOPE(NB_PROF_CLUSTER);
+
+    if (role != CLUSTER_ROLE_ACTIVE && role != CLUSTER_ROLE_STANDBY) return -1;
+
+    nb_mutex_lock(&c->state_lock);
+
+    if (role == c->local_role) {
+        nb_mutex_unlock(&c->state_lock);
+        return 0;
+    }
+
+    syslog_write(LOG_INFO, "Cluster: Handover to %s",
+        role == CLUSTER_ROLE_ACTIVE ? "ACTIVE" : "STANDBY");
+    cluster_journal_log(CJ_EVENT_HANDOVER, c->cluster_id, c->local_role, role, 0);
+
+    if (role == CLUSTER_ROLE_ACTIVE) {
+        cluster_promote(c);
+        c->handover_pending = false;
+    } else {
+        cluster_demote(c);
+        c->handover_pending = true;
+    }
+    c->split_brain_detected = false;
+    cluster_send_heartbeat(c, time(NULL));
+    cluster_publish(c);
+
+    cluster_unlock(c);
+    return 0;
+}
+
+/*
+ * cluster_enable_persist - Keep rejoin state in 'path'; rejoin from it
+ *
+ * If the file holds state for this cluster, a node still in INIT skips
+ * the election and comes back as STANDBY with its peer, epoch and
+ * replicated-state version restored, so it only needs the delta since
+ * that version (cluster_sync_request_delta). Returns 1 if it rejoined.
+ */
+int cluster_enable_persist(cluster_t *c, const char *path)
+{
+    cluster_persist_t st;
+    int rejoined = 0;
+
+    nb_mutex_lock(&c->state_lock);
+
+    strncpy(c->persist_path, path, sizeof(c->persist_path) - 1);
+
+    if (c->local_role == CLUSTER_ROLE_INIT &&
+        cluster_persist_load(path, &st) == 0 &&
+        st.cluster_id == c->cluster_id &&
+        (st.role == CLUSTER_ROLE_ACTIVE || st.role == CLUSTER_ROLE_STANDBY)) {
+
+        syslog_write(LOG_INFO, "Cluster %d: Rejoining as STANDBY (was %s, peer %s, "
+            "epoch %llu, state version %llu)", c->cluster_id,
+            st.role == CLUSTER_ROLE_ACTIVE ? "ACTIVE" : "STANDBY", st.peer_serial,
+            (unsigned long long)st.epoch, (unsigned long long)st.state_version);
+        cluster_journal_log(CJ_EVENT_REJOIN, c->cluster_id, st.role,
+            CLUSTER_ROLE_STANDBY, (int64_t)st.state_version);
+
+        c->local_role = CLUSTER_ROLE_STANDBY;
+        memcpy(c->peer_serial, st.peer_serial, sizeof(c->peer_serial));
+        c->epoch = st.epoch;
+        c->state_version = st.state_version;
+        rejoined = 1;
+    }
+    cluster_save(c);
+    cluster_publish(c);
+
+    cluster_unlock(c);
+    return rejoined;
+}
+
+/*
+ * cluster_set_sync_point - Record how far replicated state has been applied
+ *
+ * Epochs only move forward, so a later promotion of this node starts a
+ * newer epoch than anything it has seen.
+ */
+void cluster_set_sync_point(cluster_t *c, uint64_t epoch, uint64_t version)
+{
+    nb_mutex_lock(&c->state_lock);
+
+    if (epoch > c->epoch) {
+        c->epoch = epoch;
+    }
+    c->state_version = version;
+    c->persist_dirty = true;
+
+    nb_mutex_unlock(&c->state_lock);
+}
+
+void cluster_get_sync_point(cluster_t *c, uint64_t *epoch, uint64_t *version)
 {
+    nb_mutex_lock(&c->state_lock);
+    if (epoch) *epoch = c->epoch;
+    if (version) *version = c->state_version;
+    nb_mutex_unlock(&c->state_lock);
+}
+
+/*
+ * cluster_new_epoch - Start a new lineage of replicated state
+ *
+ * For a change log that cannot continue the versions of the one before
+ * it, e.g. after a restart. Persisted at once.
+ */
+uint64_t cluster_new_epoch(cluster_t *c)
+{
+    nb_mutex_lock(&c->state_lock);
+
+    uint64_t epoch = ++c->epoch;
+    cluster_save(c);
+
+    cluster_unlock(c);
+    return epoch;
+}
+
+/*
+ * cluster_status - Get cluster status for show commands and API
+ */
+int cluster_status(cluster_t *c, cluster_status_t *status)
+{
+    NB_PROF_SCOPE(NB_PROF_CLUSTER);
+
     if (!status) return -1;
 
-    pthread_mutex_lock(&cluster.state_lock);
+    nb_mutex_lock(&c->state_lock);
+
+    status->cluster_id = c->cluster_id;
+    status->local_role = c->local_role;
+    status->peer_role = c->peer_role;
+    status->heartbeat_up = c->heartbeat_up;
+    status->split_brain = c->split_brain_detected;
+    status->last_heartbeat = c->last_heartbeat_rx;
+    strncpy(status->local_serial, c->local_serial, sizeof(status->local_serial) - 1);
+    strncpy(status->peer_serial, c->peer_serial, sizeof(status->peer_serial) - 1);
+
+    nb_mutex_unlock(&c->state_lock);
+    return 0;
+}
+
+/*
+ * cluster_set_paths - Set number of heartbeat paths in use
+ */
+int cluster_set_paths(cluster_t *c, uint8_t count)
+{
+    if (count == 0 || count > HEARTBEAT_MAX_PATHS) return -1;
+
+    nb_mutex_lock(&c->state_lock);
+
+    for (uint8_t p = c->path_count; p < count; p++) {
+        hb_stats_reset(&c->paths[p]);
+    }
+    c->path_count = count;
+
+    nb_mutex_unlock(&c->state_lock);
+    return 0;
+}
+
+/*
+ * cluster_path_stats - Get RTT/jitter/offset for one heartbeat path
+ */
+int cluster_path_stats(cluster_t *c, uint8_t path_id, hb_path_stats_t *stats)
+{
+    if (!stats) return -1;
+
+    nb_mutex_lock(&c->state_lock);
+
+    if (path_id >= c->path_count) {
+        nb_mutex_unlock(&c->state_lock);
+        return -1;
+    }
+    memcpy(stats, &c->paths[path_id], sizeof(hb_path_stats_t));
+
+    nb_mutex_unlock(&c->state_lock);
+    return 0;
+}
+
+/*
+ * cluster_group_add - CLI: 'cluster failover-group <id> vrf ...'
+ */
+int cluster_group_add(cluster_t *c, uint16_t group_id, const char *name,
+                      const uint32_t *vrf_ids, uint8_t vrf_count)
+{
+    nb_mutex_lock(&c->state_lock);
+    int ret = cluster_groups_add(&c->groups, group_id, name, vrf_ids, vrf_count);
+    nb_mutex_unlock(&c->state_lock);
+    return ret;
+}
+
+/*
+ * cluster_group_remove - CLI: 'no cluster failover-group <id>'
+ */
+int cluster_group_remove(cluster_t *c, uint16_t group_id)
+{
+    uint64_t old = 0;
+
+    nb_mutex_lock(&c->state_lock);
+    if (group_id < MAX_FAILOVER_GROUPS) old = c->groups.groups[group_id].track_mask;
+    int ret = cluster_groups_remove(&c->groups, group_id);
+    if (ret == 0) {
+        cluster_send_heartbeat(c, time(NULL));
+    }
+    nb_mutex_unlock(&c->state_lock);
+
+    /* Its objects count towards node-wide health again */
+    if (ret == 0) cluster_track_claim(0, old);
+    return ret;
+}
+
+/*
+ * cluster_group_track - CLI: 'cluster failover-group <id> track ...'
+ *
+ * The group's objects leave node-wide health. That is applied after
+ * state_lock is dropped, since the health callback takes it.
+ */
+int cluster_group_track(cluster_t *c, uint16_t group_id, uint64_t track_mask,
+                        uint8_t min_health)
+{
+    uint64_t old = 0;
+
+    nb_mutex_lock(&c->state_lock);
+    if (group_id < MAX_FAILOVER_GROUPS) old = c->groups.groups[group_id].track_mask;
+    int ret = cluster_groups_set_tracking(&c->groups, group_id, track_mask, min_health);
+    if (ret == 0) {
+        cluster_send_heartbeat(c, time(NULL));
+    }
+    nb_mutex_unlock(&c->state_lock);
+
+    if (ret == 0) cluster_track_claim(track_mask, old);
+    return ret;
+}
+
+/*
+ * cluster_group_status - Get one failover group's roles for show commands
+ */
+int cluster_group_status(cluster_t *c, uint16_t group_id, uint8_t *local_role,
+                         uint8_t *peer_role)
+{
+    if (group_id >= MAX_FAILOVER_GROUPS) return -1;
+
+    nb_mutex_lock(&c->state_lock);
+
+    const failover_group_t *g = &c->groups.groups[group_id];
+    if (!g->in_use) {
+        nb_mutex_unlock(&c->state_lock);
+        return -1;
+    }
+    if (local_role) *local_role = g->role;
+    if (peer_role) *peer_role = g->peer_role;
+
+    nb_mutex_unlock(&c->state_lock);
+    return 0;
+}
+
+/*
+ * Legacy single-cluster API, operating on the default instance
+ */
+
+/*
+ * cluster_state_init - Initialize cluster state machine
+ *
+ * Also opens the process-wide event journal, before persistence so a
+ * rejoin is journaled. Without it the cluster still runs, unjournaled.
+ */
+int cluster_state_init(uint32_t cluster_id, const char *local_serial)
+{
+    /* Re-init: unlink the old locks from lockprof before cluster_setup() clears them */
+    if (default_cluster.registered) {
+        cluster_unregister(&default_cluster);
+        nb_mutex_destroy(&default_cluster.state_lock);
+        nb_mutex_destroy(&default_cluster.persist_lock);
+    }
+
+    cluster_setup(&default_cluster, cluster_id, local_serial, NULL, NULL);
+    default_cluster.local_health = cluster_track_get_health();
+    cluster_register(&default_cluster);
+    if (cluster_journal_open(CLUSTER_JOURNAL_PATH) != 0) {
+        syslog_write(LOG_WARNING, "Cluster %d: Running without an event journal", cluster_id);
+    }
+    cluster_enable_persist(&default_cluster, CLUSTER_PERSIST_PATH);
 
-    status->cluster_id = cluster.cluster_id;
-    status->local_role = cluster.local_role;
-    status->peer_role = cluster.peer_role;
-    status->heartbeat_up = cluster.heartbeat_up;
-    status->split_brain = cluster.split_brain_detected;
-    status->last_heartbeat = cluster.last_heartbeat_rx;
-    strncpy(status->local_serial, cluster.local_serial, sizeof(status->local_serial) - 1);
-    strncpy(status->peer_serial, cluster.peer_serial, sizeof(status->peer_serial) - 1);
+    if (cluster_track_subscribe(cluster_health_changed, &default_cluster) != 0) {
+        syslog_write(LOG_ERR, "Cluster %d: Failed to subscribe to health changes",
+            cluster_id);
+        return -1;
+    }
+
+    syslog_write(LOG_INFO, "Cluster %d initialized. Local serial: %s",
+        cluster_id, local_serial);
 
-    pthread_mutex_unlock(&cluster.state_lock);
     return 0;
 }
+
+/*
+ * cluster_heartbeat_tick - Process heartbeat state
+ *
+ * Called every HEARTBEAT_INTERVAL_MS by the heartbeat daemon.
+ */
+int cluster_heartbeat_tick(void)
+{
+    return cluster_tick(&default_cluster);
+}
+
+/*
+ * cluster_heartbeat_received - Process incoming heartbeat from peer
+ */
+int cluster_heartbeat_received(const heartbeat_msg_t *msg)
+{
+    return cluster_receive(&default_cluster, msg);
+}
+
+/*
+ * cluster_force_role - CLI command to force cluster role
+ */
+int cluster_force_role(uint8_t role)
+{
+    return cluster_set_role(&default_cluster, role);
+}
+
+/*
+ * cluster_get_status - Get cluster status for show commands and API
+ */
+int cluster_get_status(cluster_status_t *status)
+{
+    return cluster_status(&default_cluster, status);
+}
+
+int cluster_set_heartbeat_paths(uint8_t count)
+{
+    return cluster_set_paths(&default_cluster, count);
+}
+
+int cluster_get_heartbeat_stats(uint8_t path_id, hb_path_stats_t *stats)
+{
+    return cluster_path_stats(&default_cluster, path_id, stats);
+}
+
+int cluster_failover_group_add(uint16_t group_id, const char *name,
+                               const uint32_t *vrf_ids, uint8_t vrf_count)
+{
+    return cluster_group_add(&default_cluster, group_id, name, vrf_ids, vrf_count);
+}
+
+int cluster_failover_group_track(uint16_t group_id, uint64_t track_mask,
+                                 uint8_t min_health)
+{
+    return cluster_group_track(&default_cluster, group_id, track_mask, min_health);
+}
+
+int cluster_get_group_status(uint16_t group_id, uint8_t *local_role, uint8_t *peer_role)
+{
+    return cluster_group_status(&default_cluster, group_id, local_role, peer_role);
+}
@@ -0,0 +1,937 @@
+/*
+ * cluster_sync.c - In-Service Software Upgrade (ISSU) State Sync
+ *
+ * NetBlade OS v3.x High Availability Module
+ * Copyright (c) 2024-2026 Enterprise Systems Inc. All rights reserved.
+ *
+ * Upgrade without a failover: the STANDBY node is upgraded first, then
+ * the ACTIVE node streams its runtime state (MAC entries, VIPs,
+ * configured timers, and whatever else has registered a record type)
+ * over the cluster channel. Once the peer confirms every record was
+ * applied, the roles are swapped in three messages:
+ *
+ *   ACTIVE  --SWAP_PREPARE-->  STANDBY     (peer checks it is synced)
+ *   ACTIVE  <--SWAP_READY---   STANDBY
+ *   ACTIVE releases, --SWAP_COMMIT(t_release)-->  STANDBY takes over
+ *   ACTIVE  <--SWAP_DONE(loss)--  new ACTIVE
+ *
+ * The new ACTIVE already holds the MAC table, so promotion is the usual
+ * flag flip and nothing is flushed or relearned. Traffic loss is the
+ * gap from release to takeover, with the sender's timestamp corrected
+ * by the heartbeat clock offset.
+ *
+ * Between syncs the ACTIVE node logs every change under an increasing
+ * version (cluster_sync_record) and streams it to a synced peer. The
+ * peer persists how far it got, so after a reboot it asks only for the
+ * changes since then, served from the log as long as they are still in
+ * it and the ACTIVE role has not changed hands in the meantime.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+#include <stdbool.h>
+#include <time.h>
+#include <pthread.h>
+#include "cluster_sync.h"
+#include "cluster_instance.h"
+#include "cluster_journal.h"
+#include "heartbeat_stats.h"
+#include "mac_table.h"
+#include "vip_announce.h"
+#include "bgp_timers.h"
+#include "syslog.h"
+#include "nb_mutex.h"
+#include "nb_prof.h"
+
+#define CS_MAX_TIMER_ENTRIES    256
+#define CS_MAC_CHUNK            256     /* MAC entries copied per table lock hold */
+
+/* Roles as used by cluster_state.c */
+#define CS_ROLE_ACTIVE          1
+#define CS_ROLE_STANDBY         2
+
+typedef struct {
+    cluster_sync_export_cb_t export_cb;
+    cluster_sync_import_cb_t import_cb;
+} cs_provider_t;
+
+/* Wire records; both sides run the same architecture */
+typedef struct {
+    uint8_t  mac[6];
+    uint16_t vlan;
+    uint32_t ifindex;
+    uint32_t age_sec;           /* Seconds since last seen on the sender */
+} cs_mac_rec_t;
+
+typedef struct {
+    uint32_t vrf_id;
+    uint32_t hold_time;
+    uint32_t keepalive;
+} cs_timer_rec_t;
+
+typedef struct {
+    uint32_t ifindex;
+    uint32_t vrf_id;
+    uint8_t  addr[16];
+    uint8_t  addr_len;
+    uint8_t  pad[3];
+} cs_vip_rec_t;
+
+typedef struct {
+    uint64_t version;
+    uint8_t  type;
+    uint8_t  len;
+    uint8_t  data[CS_LOG_MAX_DATA];
+} cs_log_rec_t;
+
+struct cluster_sync {
+    cluster_t              *cluster;
+    uint32_t                cluster_id;
+    cluster_sync_send_cb_t  send;
+    void                   *send_ctx;
+    uint8_t                 state;
+    uint32_t                session;
+    cluster_sync_msg_t      out;            /* BULK_DATA being filled */
+    uint32_t                records_sent;
+    uint32_t                records_applied;
+    uint32_t                records_skipped;
+    uint32_t                bulk_records;   /* BULK_DATA records this session, for BULK_END */
+    uint64_t                begin_ns;
+    uint64_t                sync_ns;
+    int64_t                 loss_ns;
+    bool                    delta;
+
+    /* Change log (ACTIVE side) */
+    cs_log_rec_t           *log;
+    bool                    log_started;
+    uint64_t                log_epoch;
+    uint64_t                log_first;      /* Oldest version still in the log */
+    uint64_t                version;        /* Latest version logged */
+    nb_mutex_t              lock;
+};
+
+static int cs_mac_export(cluster_sync_t *s);
+int cluster_sync_mac_learned(cluster_sync_t *s, const uint8_t mac[6], uint16_t vlan,
+                             uint32_t ifindex)
+{
+    cs_mac_rec_t rec = { .vlan = vlan, .ifindex = ifindex, .age_sec = 0 };
+
+    memcpy(rec.mac, mac, 6);
+    return cluster_sync_record(s, CS_REC_MAC, &rec, sizeof(rec));
+}
+
+int cluster_sync_mac_removed(cluster_sync_t *s, const uint8_t mac[6], uint16_t vlan)
+{
+    cs_mac_rec_t rec = { .vlan = vlan };
+
+    memcpy(rec.mac, mac, 6);
+    return cluster_sync_record(s, CS_REC_MAC_DEL, &rec, sizeof(rec));
+}
+
+int cluster_sync_timers_changed(cluster_sync_t *s, uint32_t vrf_id, uint32_t hold_time,
+                                uint32_t keepalive)
+{
+    cs_timer_rec_t rec = { .vrf_id = vrf_id, .hold_time = hold_time, .keepalive = keepalive };
+
+    return cluster_sync_record(s, CS_REC_BGP_TIMERS, &rec, sizeof(rec));
+}
+
+static int cs_mac_import(const uint8_t *data, uint8_t len);
+static int cs_mac_del_import(const uint8_t *data, uint8_t len)
+{
+    mac_table_t *t = mac_table_ha_instance();
+    cs_mac_rec_t rec;
+
+    if (!t || len != sizeof(rec)) return -1;
+    memcpy(&rec, data, sizeof(rec));
+
+    /* Already aged out here is fine */
+    mac_table_delete(t, rec.mac, rec.vlan);
+    return 0;
+}
+
+static int cs_timer_export(cluster_sync_t *s);
+static int cs_timer_import(const uint8_t *data, uint8_t len);
+static int cs_vip_export(cluster_sync_t *s);
+static int cs_vip_import(const uint8_t *data, uint8_t len);
+
+static cs_provider_t providers[CS_MAX_REC_TYPES] = {
+    [CS_REC_MAC]        = { cs_mac_export, cs_mac_import },
+    [CS_REC_BGP_TIMERS] = { cs_timer_export, cs_timer_import },
+    [CS_REC_VIP]        = { cs_vip_export, cs_vip_import },
+    [CS_REC_MAC_DEL]    = { NULL, cs_mac_del_import },      /* Covered by CS_REC_MAC in bulk */
+};
+static nb_mutex_t providers_lock = NB_MUTEX_INITIALIZER("cluster_sync.providers");
+
+/* Instance fed by the MAC table and BGP timer hooks, and hooks still using it */
+static cluster_sync_t *attached;
+static uint32_t attached_refs;
+static pthread_cond_t attach_released = PTHREAD_COND_INITIALIZER;
+static nb_mutex_t attach_lock = NB_MUTEX_INITIALIZER("cluster_sync.attach");
+
+static uint64_t cs_clock_ns(clockid_t clk)
+{
+    struct timespec ts;
+    clock_gettime(clk, &ts);
+    return (uint64_t)ts.tv_sec * 1000000000ULL + (uint64_t)ts.tv_nsec;
+}
+
+/* MAC table times are CLOCK_MONOTONIC seconds, as used by the forwarding path */
+static uint32_t cs_mac_now(void)
+{
+    return (uint32_t)(cs_clock_ns(CLOCK_MONOTONIC) / 1000000000ULL);
+}
+
+const char *cluster_sync_state_name(uint8_t state)
+{
+    switch (state) {
+        case CS_STATE_IDLE:      return "idle";
+        case CS_STATE_SENDING:   return "sending";
+        case CS_STATE_RECEIVING: return "receiving";
+        case CS_STATE_SYNCED:    return "synced";
+        case CS_STATE_SWAPPING:  return "swapping";
+        case CS_STATE_DONE:      return "done";
+        case CS_STATE_FAILED:    return "failed";
+    }
+    return "unknown";
+}
+
+int cluster_sync_register(uint8_t rec_type, cluster_sync_export_cb_t export_cb,
+                          cluster_sync_import_cb_t import_cb)
+{
+    if (rec_type == 0 || rec_type >= CS_MAX_REC_TYPES) return -1;
+
+    nb_mutex_lock(&providers_lock);
+    providers[rec_type].export_cb = export_cb;
+    providers[rec_type].import_cb = import_cb;
+    nb_mutex_unlock(&providers_lock);
+    return 0;
+}
+
+/*
+ * cs_send - Send one control or data message. Caller holds s->lock.
+ */
+static int cs_send(cluster_sync_t *s, cluster_sync_msg_t *msg, uint16_t type, int64_t arg)
+{
+    msg->type = type;
+    msg->session = s->session;
+    msg->arg = arg;
+    msg->epoch = s->log_epoch;
+    msg->version = s->version;
+    return s->send(msg, s->send_ctx);
+}
+
+static int cs_send_ctl(cluster_sync_t *s, uint16_t type, int64_t arg)
+{
+    cluster_sync_msg_t msg = { 0 };
+    return cs_send(s, &msg, type, arg);
+}
+
+static int cs_flush(cluster_sync_t *s)
+{
+    if (s->out.count == 0) return 0;
+
+    int ret = cs_send(s, &s->out, CS_MSG_BULK_DATA, 0);
+    s->out.count = 0;
+    s->out.len = 0;
+    return ret;
+}
+
+/*
+ * cluster_sync_emit - Append one record to the bulk stream
+ *
+ * Only valid from an export callback during cluster_sync_start().
+ */
+int cluster_sync_emit(cluster_sync_t *s, uint8_t rec_type, const void *data, uint8_t len)
+{
+    if (s->out.len + 2 + len > CS_MAX_PAYLOAD && cs_flush(s) != 0) {
+        return -1;
+    }
+
+    uint8_t *p = &s->out.data[s->out.len];
+    p[0] = rec_type;
+    p[1] = len;
+    memcpy(p + 2, data, len);
+
+    s->out.len += 2 + len;
+    s->out.count++;
+    s->records_sent++;
+    return 0;
+}
+
+cluster_sync_t *cluster_sync_create(cluster_t *c, cluster_sync_send_cb_t send, void *ctx)
+{
+    cluster_status_t st;
+
+    if (!c || !send || cluster_status(c, &st) != 0) return NULL;
+
+    cluster_sync_t *s = calloc(1, sizeof(cluster_sync_t));
+    if (!s) return NULL;
+
+    s->cluster = c;
+    s->cluster_id = st.cluster_id;
+    s->send = send;
+    s->send_ctx = ctx;
+    s->state = CS_STATE_IDLE;
+    s->log = calloc(CS_LOG_RECORDS, sizeof(cs_log_rec_t));
+    if (!s->log) {
+        free(s);
+        return NULL;
+    }
+    s->log_first = 1;
+    nb_mutex_init(&s->lock, "cluster_sync.lock");
+    return s;
+}
+
+void cluster_sync_destroy(cluster_sync_t *s)
+{
+    if (!s) return;
+    cluster_sync_detach(s);
+    nb_mutex_destroy(&s->lock);
+    free(s->log);
+    free(s);
+}
+
+/*
+ * cs_log_sync_epoch - Start a new lineage if we were promoted since
+ *
+ * Versions logged under an earlier epoch describe a peer's view this
+ * node never served from, so they cannot be replayed as a delta.
+ * Caller holds s->lock.
+ */
+static void cs_log_sync_epoch(cluster_sync_t *s)
+{
+    uint64_t epoch;
+
+    /*
+     * Versions are not persisted. A log created after a restart starts
+     * again at 1, so it must not share an epoch with the one before,
+     * whose versions a peer may still hold.
+     */
+    if (!s->log_started) {
+        s->log_started = true;
+        s->log_epoch = cluster_new_epoch(s->cluster);
+        s->log_first = s->version + 1;
+        return;
+    }
+
+    cluster_get_sync_point(s->cluster, &epoch, NULL);
+    if (epoch != s->log_epoch) {
+        s->log_epoch = epoch;
+        s->log_first = s->version + 1;
+    }
+}
+
+int cluster_sync_record(cluster_sync_t *s, uint8_t rec_type, const void *data, uint8_t len)
+{
+    NB_PROF_SCOPE(NB_PROF_CLUSTER_SYNC);
+
+    cluster_status_t st;
+
+    /* The STANDBY's own changes are the ACTIVE's, arriving through cs_apply() */
+    if (cluster_status(s->cluster, &st) != 0 || st.local_role != CS_ROLE_ACTIVE) {
+        return 0;
+    }
+
+    nb_mutex_lock(&s->lock);
+
+    cs_log_sync_epoch(s);
+    s->version++;
+
+    if (len <= CS_LOG_MAX_DATA) {
+        cs_log_rec_t *r = &s->log[s->version & (CS_LOG_RECORDS - 1)];
+
+        r->version = s->version;
+        r->type = rec_type;
+        r->len = len;
+        memcpy(r->data, data, len);
+        if (s->version - s->log_first >= CS_LOG_RECORDS) {
+            s->log_first = s->version - CS_LOG_RECORDS + 1;
+        }
+    } else {
+        /* Can't replay past an unlogged change */
+        s->log_first = s->version + 1;
+    }
+
+    /* Also while SENDING: anything after the bulk snapshot follows it in order */
+    int ret = 0;
+    if (s->state == CS_STATE_SENDING || s->state == CS_STATE_SYNCED) {
+        cluster_sync_msg_t msg = { 0 };
+
+        msg.count = 1;
+        msg.len = 2 + len;
+        msg.data[0] = rec_type;
+        msg.data[1] = len;
+        memcpy(&msg.data[2], data, len);
+        ret = cs_send(s, &msg, CS_MSG_UPDATE, 0);
+    }
+
+    nb_mutex_unlock(&s->lock);
+    return ret;
+}
+
+int cluster_sync_request_delta(cluster_sync_t *s)
+{
+    NB_PROF_SCOPE(NB_PROF_CLUSTER_SYNC);
+
+    uint64_t epoch, version;
+
+    cluster_get_sync_point(s->cluster, &epoch, &version);
+
+    nb_mutex_lock(&s->lock);
+
+    cluster_sync_msg_t msg = { 0 };
+    msg.type = CS_MSG_DELTA_REQUEST;
+    msg.epoch = epoch;
+    msg.version = version;
+    int ret = s->send(&msg, s->send_ctx);
+
+    nb_mutex_unlock(&s->lock);
+
+    syslog_write(LOG_INFO, "Cluster sync: Requested changes since epoch %llu version %llu",
+        (unsigned long long)epoch, (unsigned long long)version);
+    return ret;
+}
+
+/*
+ * cs_send_state - Send a full snapshot, or the logged changes after 'since'
+ *
+ * Caller holds s->lock.
+ */
+static int cs_send_state(cluster_sync_t *s, bool delta, uint64_t since)
+{
+    s->session++;
+    s->state = CS_STATE_SENDING;
+    s->delta = delta;
+    s->records_sent = 0;
+    s->records_applied = 0;
+    s->records_skipped = 0;
+    s->loss_ns = 0;
+    s->out.count = 0;
+    s->out.len = 0;
+    s->begin_ns = cs_clock_ns(CLOCK_MONOTONIC);
+
+    int ret = cs_send_ctl(s, CS_MSG_BULK_BEGIN, CS_PROTO_VERSION);
+
+    if (delta) {
+        for (uint64_t v = since + 1; v <= s->version && ret == 0; v++) {
+            const cs_log_rec_t *r = &s->log[v & (CS_LOG_RECORDS - 1)];
+            ret = cluster_sync_emit(s, r->type, r->data, r->len);
+        }
+    } else {
+        nb_mutex_lock(&providers_lock);
+        for (int t = 1; t < CS_MAX_REC_TYPES && ret == 0; t++) {
+            if (providers[t].export_cb) {
+                ret = providers[t].export_cb(s);
+            }
+        }
+        nb_mutex_unlock(&providers_lock);
+    }
+
+    if (ret == 0) ret = cs_flush(s);
+    if (ret == 0) ret = cs_send_ctl(s, CS_MSG_BULK_END, s->records_sent);
+
+    if (ret != 0) {
+        syslog_write(LOG_ERR, "Cluster sync: Send failed after %u records",
+            s->records_sent);
+        s->state = CS_STATE_FAILED;
+    } else {
+        syslog_write(LOG_INFO, "Cluster sync: Session %u sent %u records (%s)",
+            s->session, s->records_sent, delta ? "delta" : "full");
+    }
+    return ret;
+}
+
+/*
+ * cluster_sync_start - Stream all registered state to the peer
+ *
+ * Runs on the ACTIVE node after the STANDBY peer has been upgraded.
+ * Completion is reported asynchronously by the peer's SYNC_DONE.
+ */
+int cluster_sync_start(cluster_sync_t *s)
+{
+    NB_PROF_SCOPE(NB_PROF_CLUSTER_SYNC);
+
+    cluster_status_t st;
+
+    if (cluster_status(s->cluster, &st) != 0 || st.local_role != CS_ROLE_ACTIVE ||
+        !st.heartbeat_up) {
+        syslog_write(LOG_ERR, "Cluster sync: Must start on ACTIVE with peer up");
+        return -1;
+    }
+
+    nb_mutex_lock(&s->lock);
+
+    if (s->state == CS_STATE_SENDING || s->state == CS_STATE_SWAPPING) {
+        nb_mutex_unlock(&s->lock);
+        return -1;
+    }
+
+    cs_log_sync_epoch(s);
+    int ret = cs_send_state(s, false, 0);
+
+    nb_mutex_unlock(&s->lock);
+    return ret;
+}
+
+/*
+ * cluster_sync_swap - Begin the coordinated role swap
+ */
+int cluster_sync_swap(cluster_sync_t *s)
+{
+    NB_PROF_SCOPE(NB_PROF_CLUSTER_SYNC);
+
+    nb_mutex_lock(&s->lock);
+
+    if (s->state != CS_STATE_SYNCED) {
+        syslog_write(LOG_ERR, "Cluster sync: Cannot swap in state %s",
+            cluster_sync_state_name(s->state));
+        nb_mutex_unlock(&s->lock);
+        return -1;
+    }
+
+    s->state = CS_STATE_SWAPPING;
+    int ret = cs_send_ctl(s, CS_MSG_SWAP_PREPARE, 0);
+
+    nb_mutex_unlock(&s->lock);
+    return ret;
+}
+
+/* Returns the records found in msg, applied or skipped */
+static uint32_t cs_apply(cluster_sync_t *s, const cluster_sync_msg_t *msg)
+{
+    uint16_t off = 0, i;
+
+    for (i = 0; i < msg->count && off + 2 <= msg->len; i++) {
+        uint8_t type = msg->data[off];
+        uint8_t len = msg->data[off + 1];
+
+        if (off + 2 + len > msg->len) break;
+
+        /* Newer senders may carry types this release doesn't know */
+        cluster_sync_import_cb_t import_cb =
+            (type < CS_MAX_REC_TYPES) ? providers[type].import_cb : NULL;
+
+        if (import_cb && import_cb(&msg->data[off + 2], len) == 0) {
+            s->records_applied++;
+        } else {
+            s->records_skipped++;
+        }
+        off += 2 + len;
+    }
+    return i;
+}
+
+/*
+ * cs_loss_ns - Release-to-takeover gap, in local time
+ *
+ * The release stamp is the peer's wall clock; the heartbeat offset
+ * (peer minus local) brings it onto ours.
+ */
+static int64_t cs_loss_ns(cluster_sync_t *s, int64_t release_ns)
+{
+    hb_path_stats_t ps;
+    int64_t offset = 0;
+
+    if (cluster_path_stats(s->cluster, 0, &ps) == 0 && ps.samples > 0) {
+        offset = ps.offset_ns;
+    }
+
+    return (int64_t)cs_clock_ns(CLOCK_REALTIME) - (release_ns - offset);
+}
+
+int cluster_sync_receive(cluster_sync_t *s, const cluster_sync_msg_t *msg)
+{
+    NB_PROF_SCOPE(NB_PROF_CLUSTER_SYNC);
+
+    int ret = 0;
+
+    nb_mutex_lock(&s->lock);
+
+    if (msg->type != CS_MSG_BULK_BEGIN && msg->type != CS_MSG_DELTA_REQUEST &&
+        msg->session != s->session) {
+        nb_mutex_unlock(&s->lock);
+        return -1;
+    }
+
+    switch (msg->type) {
+        case CS_MSG_BULK_BEGIN:
+            s->session = msg->session;
+            s->state = CS_STATE_RECEIVING;
+            s->records_applied = 0;
+            s->records_skipped = 0;
+            s->bulk_records = 0;
+            s->begin_ns = cs_clock_ns(CLOCK_MONOTONIC);
+            syslog_write(LOG_INFO, "Cluster sync: Session %u from peer (version %lld)",
+                msg->session, (long long)msg->arg);
+            break;
+
+        case CS_MSG_BULK_DATA:
+            if (s->state != CS_STATE_RECEIVING) break;
+            nb_mutex_lock(&providers_lock);
+            s->bulk_records += cs_apply(s, msg);
+            nb_mutex_unlock(&providers_lock);
+            break;
+
+        case CS_MSG_BULK_END:
+            if (s->state != CS_STATE_RECEIVING) break;
+            s->sync_ns = cs_clock_ns(CLOCK_MONOTONIC) - s->begin_ns;
+
+            /* Live UPDATEs may arrive mid-transfer; only the bulk must add up */
+            if ((int64_t)s->bulk_records != msg->arg) {
+                syslog_write(LOG_ERR, "Cluster sync: Got %u of %lld records",
+                    s->bulk_records, (long long)msg->arg);
+                s->state = CS_STATE_FAILED;
+                ret = cs_send_ctl(s, CS_MSG_SYNC_FAIL, s->records_applied);
+                break;
+            }
+
+            s->state = CS_STATE_SYNCED;
+            cluster_set_sync_point(s->cluster, msg->epoch, msg->version);
+            syslog_write(LOG_INFO, "Cluster sync: Applied %u records (%u skipped) in %llu us",
+                s->records_applied, s->records_skipped,
+                (unsigned long long)(s->sync_ns / 1000));
+            ret = cs_send_ctl(s, CS_MSG_SYNC_DONE, s->records_applied);
+            break;
+
+        case CS_MSG_SYNC_DONE:
+            if (s->state != CS_STATE_SENDING) break;
+            s->state = CS_STATE_SYNCED;
+            s->records_applied = (uint32_t)msg->arg;
+            s->sync_ns = cs_clock_ns(CLOCK_MONOTONIC) - s->begin_ns;
+            cluster_journal_log(CJ_EVENT_ISSU_SYNC, s->cluster_id, 0, 0, msg->arg);
+            syslog_write(LOG_INFO, "Cluster sync: Peer synced %lld/%u records in %llu us",
+                (long long)msg->arg, s->records_sent,
+                (unsigned long long)(s->sync_ns / 1000));
+            break;
+
+        case CS_MSG_SYNC_FAIL:
+            syslog_write(LOG_ERR, "Cluster sync: Peer reported sync failure");
+            if (s->state == CS_STATE_SWAPPING) {
+                /* Peer lost its synced state; we still hold ACTIVE */
+                s->state = CS_STATE_FAILED;
+            } else if (s->state == CS_STATE_SENDING) {
+                s->state = CS_STATE_FAILED;
+            }
+            break;
+
+        case CS_MSG_SWAP_PREPARE:
+            if (s->state != CS_STATE_SYNCED) {
+                ret = cs_send_ctl(s, CS_MSG_SYNC_FAIL, 0);
+                break;
+            }
+            s->state = CS_STATE_SWAPPING;
+            ret = cs_send_ctl(s, CS_MSG_SWAP_READY, 0);
+            break;
+
+        case CS_MSG_SWAP_READY: {
+            if (s->state != CS_STATE_SWAPPING) break;
+
+            int64_t release_ns = (int64_t)cs_clock_ns(CLOCK_REALTIME);
+            cluster_handover(s->cluster, CS_ROLE_STANDBY);
+            ret = cs_send_ctl(s, CS_MSG_SWAP_COMMIT, release_ns);
+            break;
+        }
+
+        case CS_MSG_SWAP_COMMIT:
+            if (s->state != CS_STATE_SWAPPING) break;
+
+            cluster_handover(s->cluster, CS_ROLE_ACTIVE);
+            s->loss_ns = cs_loss_ns(s, msg->arg);
+            s->state = CS_STATE_DONE;
+            syslog_write(LOG_INFO, "Cluster sync: Took over ACTIVE, traffic loss %lld us",
+                (long long)(s->loss_ns / 1000));
+            ret = cs_send_ctl(s, CS_MSG_SWAP_DONE, s->loss_ns);
+            break;
+
+        case CS_MSG_SWAP_DONE:
+            if (s->state != CS_STATE_SWAPPING) break;
+            s->loss_ns = msg->arg;
+            s->state = CS_STATE_DONE;
+            syslog_write(LOG_INFO, "Cluster sync: Handover complete, traffic loss %lld us",
+                (long long)(s->loss_ns / 1000));
+            break;
+
+        case CS_MSG_UPDATE:
+            if (s->state != CS_STATE_SYNCED && s->state != CS_STATE_RECEIVING) break;
+            nb_mutex_lock(&providers_lock);
+            cs_apply(s, msg);
+            nb_mutex_unlock(&providers_lock);
+            if (s->state == CS_STATE_SYNCED) {
+                cluster_set_sync_point(s->cluster, msg->epoch, msg->version);
+            }
+            break;
+
+        case CS_MSG_DELTA_REQUEST: {
+            cluster_status_t st;
+
+            if (cluster_status(s->cluster, &st) != 0 || st.local_role != CS_ROLE_ACTIVE ||
+                s->state == CS_STATE_SENDING || s->state == CS_STATE_SWAPPING) {
+                break;
+            }
+
+            cs_log_sync_epoch(s);
+            bool delta = msg->epoch == s->log_epoch &&
+                         msg->version + 1 >= s->log_first &&
+                         msg->version <= s->version;
+            if (!delta) {
+                syslog_write(LOG_INFO, "Cluster sync: Peer at epoch %llu version %llu "
+                    "is outside the log (epoch %llu, versions %llu-%llu); full sync",
+                    (unsigned long long)msg->epoch, (unsigned long long)msg->version,
+                    (unsigned long long)s->log_epoch, (unsigned long long)s->log_first,
+                    (unsigned long long)s->version);
+            }
+            ret = cs_send_state(s, delta, msg->version);
+            break;
+        }
+
+        default:
+            ret = -1;
+            break;
+    }
+
+    nb_mutex_unlock(&s->lock);
+    return ret;
+}
+
+/*
+ * Hooks into the owners of the built-in record types, run outside the
+ * owners' locks. A reference keeps the attached instance alive; no
+ * lock is held while recording, since imports applied under s->lock
+ * come back through these hooks.
+ */
+static cluster_sync_t *cs_attached_get(void)
+{
+    nb_mutex_lock(&attach_lock);
+    cluster_sync_t *s = attached;
+    if (s) attached_refs++;
+    nb_mutex_unlock(&attach_lock);
+    return s;
+}
+
+static void cs_attached_put(void)
+{
+    nb_mutex_lock(&attach_lock);
+    if (--attached_refs == 0) pthread_cond_broadcast(&attach_released);
+    nb_mutex_unlock(&attach_lock);
+}
+
+static void cs_mac_changed(const uint8_t mac[6], uint16_t vlan, uint32_t ifindex,
+                           bool removed, void *ctx)
+{
+    cluster_sync_t *s = cs_attached_get();
+
+    (void)ctx;
+    if (!s) return;
+
+    if (removed) {
+        cluster_sync_mac_removed(s, mac, vlan);
+    } else {
+        cluster_sync_mac_learned(s, mac, vlan, ifindex);
+    }
+    cs_attached_put();
+}
+
+static void cs_timers_changed(uint32_t vrf_id, uint32_t hold_time, uint32_t keepalive,
+                              void *ctx)
+{
+    cluster_sync_t *s = cs_attached_get();
+
+    (void)ctx;
+    if (!s) return;
+
+    cluster_sync_timers_changed(s, vrf_id, hold_time, keepalive);
+    cs_attached_put();
+}
+
+int cluster_sync_attach(cluster_sync_t *s)
+{
+    mac_table_t *t = mac_table_ha_instance();
+
+    nb_mutex_lock(&attach_lock);
+
+    if (attached && attached != s) {
+        nb_mutex_unlock(&attach_lock);
+        syslog_write(LOG_ERR, "Cluster sync: Another instance is already attached");
+        return -1;
+    }
+    attached = s;
+
+    nb_mutex_unlock(&attach_lock);
+
+    if (t) mac_table_set_change_cb(t, cs_mac_changed, NULL);
+    bgp_timers_set_change_cb(cs_timers_changed, NULL);
+    return 0;
+}
+
+void cluster_sync_detach(cluster_sync_t *s)
+{
+    mac_table_t *t = mac_table_ha_instance();
+    bool was_attached;
+
+    nb_mutex_lock(&attach_lock);
+    was_attached = (attached == s);
+    if (was_attached) {
+        attached = NULL;
+        while (attached_refs) nb_cond_wait(&attach_released, &attach_lock);
+    }
+    nb_mutex_unlock(&attach_lock);
+
+    if (!was_attached) return;
+    if (t) mac_table_set_change_cb(t, NULL, NULL);
+    bgp_timers_set_change_cb(NULL, NULL);
+}
+
+void cluster_sync_get_stats(cluster_sync_t *s, cluster_sync_stats_t *stats)
+{
+    nb_mutex_lock(&s->lock);
+
+    stats->state = s->state;
+    stats->records_sent = s->records_sent;
+    stats->records_applied = s->records_applied;
+    stats->records_skipped = s->records_skipped;
+    stats->sync_ns = s->sync_ns;
+    stats->delta = s->delta;
+    stats->version = s->version;
+    stats->loss_ns = s->loss_ns;
+
+    nb_mutex_unlock(&s->lock);
+}
+
+/*
+ * Built-in record types
+ */
+
+typedef struct {
+    uint32_t        now;
+    uint32_t        count;
+    cs_mac_rec_t    recs[CS_MAC_CHUNK];
+} cs_mac_walk_t;
+
+static int cs_mac_collect(const uint8_t mac[6], uint16_t vlan, uint32_t ifindex,
+                          uint32_t last_seen, void *ctx)
+{
+    cs_mac_walk_t *w = ctx;
+    cs_mac_rec_t *rec = &w->recs[w->count++];
+
+    memcpy(rec->mac, mac, 6);
+    rec->vlan = vlan;
+    rec->ifindex = ifindex;
+    rec->age_sec = ((int32_t)(w->now - last_seen) > 0) ? w->now - last_seen : 0;
+    return 0;
+}
+
+/*
+ * cs_mac_export - Copy the HA entries out a chunk at a time
+ *
+ * The forwarding path learns into the same table, so it is never held
+ * across a send. Entries learned or moved between chunks may be missed
+ * or sent twice; the live updates that follow the snapshot cover them.
+ */
+static int cs_mac_export(cluster_sync_t *s)
+{
+    mac_table_t *t = mac_table_ha_instance();
+    if (!t) return 0;
+
+    cs_mac_walk_t *w = malloc(sizeof(cs_mac_walk_t));
+    if (!w) return -1;
+
+    uint32_t cursor = 0;
+    int ret = 0;
+
+    w->now = cs_mac_now();
+    do {
+        w->count = 0;
+        mac_table_walk_from(t, MAC_OWNER_HA, &cursor, CS_MAC_CHUNK, cs_mac_collect, w);
+
+        for (uint32_t i = 0; i < w->count && ret == 0; i++) {
+            ret = cluster_sync_emit(s, CS_REC_MAC, &w->recs[i], sizeof(cs_mac_rec_t));
+        }
+    } while (ret == 0 && w->count == CS_MAC_CHUNK);
+
+    free(w);
+    return ret;
+}
+
+static int cs_mac_import(const uint8_t *data, uint8_t len)
+{
+    mac_table_t *t = mac_table_ha_instance();
+    cs_mac_rec_t rec;
+
+    if (!t || len != sizeof(rec)) return -1;
+    memcpy(&rec, data, sizeof(rec));
+
+    /* Keep the sender's idle time so synced entries age out on schedule */
+    return mac_table_learn(t, rec.mac, rec.vlan, rec.ifindex, MAC_OWNER_HA,
+        cs_mac_now() - rec.age_sec);
+}
+
+static int cs_timer_export(cluster_sync_t *s)
+{
+    uint32_t vrf_ids[CS_MAX_TIMER_ENTRIES];
+    uint32_t hold[CS_MAX_TIMER_ENTRIES];
+    uint32_t keepalive[CS_MAX_TIMER_ENTRIES];
+
+    int n = bgp_timers_get_configured(vrf_ids, hold, keepalive, CS_MAX_TIMER_ENTRIES);
+
+    for (int i = 0; i < n; i++) {
+        cs_timer_rec_t rec = {
+            .vrf_id = vrf_ids[i],
+            .hold_time = hold[i],
+            .keepalive = keepalive[i],
+        };
+        if (cluster_sync_emit(s, CS_REC_BGP_TIMERS, &rec, sizeof(rec)) != 0) {
+            return -1;
+        }
+    }
+    return 0;
+}
+
+static int cs_timer_import(const uint8_t *data, uint8_t len)
+{
+    cs_timer_rec_t rec;
+
+    if (len != sizeof(rec)) return -1;
+    memcpy(&rec, data, sizeof(rec));
+
+    return bgp_timers_set(rec.vrf_id, rec.hold_time, rec.keepalive);
+}
+
+static int cs_vip_export(cluster_sync_t *s)
+{
+    vip_announce_entry_t *list = malloc(MAX_ANNOUNCE_VIPS * sizeof(vip_announce_entry_t));
+    if (!list) return -1;
+
+    int n = vip_announce_get_list(list, MAX_ANNOUNCE_VIPS);
+    int ret = 0;
+
+    for (int i = 0; i < n && ret == 0; i++) {
+        cs_vip_rec_t rec = {
+            .ifindex = list[i].ifindex,
+            .vrf_id = list[i].vrf_id,
+            .addr_len = list[i].addr_len,
+        };
+        memcpy(rec.addr, list[i].addr, sizeof(rec.addr));
+        ret = cluster_sync_emit(s, CS_REC_VIP, &rec, sizeof(rec));
+    }
+
+    free(list);
+    return ret;
+}
+
+static int cs_vip_import(const uint8_t *data, uint8_t len)
+{
+    cs_vip_rec_t rec;
+
+    if (len != sizeof(rec)) return -1;
+    memcpy(&rec, data, sizeof(rec));
+
+    /* Already configured here: only the VRF binding may differ */
+    int id = vip_announce_find(rec.ifindex, rec.addr, rec.addr_len);
+    if (id < 0) id = vip_announce_add(rec.ifindex, rec.addr, rec.addr_len);
+    if (id < 0) return -1;
+
+    return vip_announce_set_vrf(id, rec.vrf_id);
+}
@@ -0,0 +1,133 @@
+/*
+ * cluster_sync.h - In-Service Software Upgrade (ISSU) State Sync
+ *
+ * NetBlade OS v3.x High Availability Module
+ * Copyright (c) 2024-2026 Enterprise Systems Inc. All rights reserved.
+ */
+
+#ifndef CLUSTER_SYNC_H
+#define CLUSTER_SYNC_H
+
+#include <stdint.h>
+#include <stdbool.h>
+#include "cluster_instance.h"
+
+#define CS_PROTO_VERSION        1
+#define CS_MAX_PAYLOAD          1400    /* One message per MTU-sized frame */
+#define CS_MAX_REC_TYPES        16
+#define CS_LOG_RECORDS          65536   /* Changes kept for delta sync; power of two */
+#define CS_LOG_MAX_DATA         22
+
+/* Messages on the cluster channel */
+#define CS_MSG_BULK_BEGIN       1   /* arg: CS_PROTO_VERSION */
+#define CS_MSG_BULK_DATA        2
+#define CS_MSG_BULK_END         3   /* arg: records sent */
+#define CS_MSG_SYNC_DONE        4   /* arg: records applied */
+#define CS_MSG_SYNC_FAIL        5
+#define CS_MSG_SWAP_PREPARE     6
+#define CS_MSG_SWAP_READY       7
+#define CS_MSG_SWAP_COMMIT      8   /* arg: release time, sender CLOCK_REALTIME ns */
+#define CS_MSG_SWAP_DONE        9   /* arg: measured traffic loss in ns */
+#define CS_MSG_DELTA_REQUEST    10  /* epoch/version: applied up to */
+#define CS_MSG_UPDATE           11  /* One live change; version: its version */
+
+/* Record types carried in BULK_DATA */
+#define CS_REC_MAC              1   /* HA-owned MAC entries */
+#define CS_REC_BGP_TIMERS       2   /* User-configured per-VRF BGP timers */
+#define CS_REC_VIP              3   /* Configured VIPs and their VRFs */
+#define CS_REC_BGP_SESSION      4   /* Reserved for bgp_peer */
+#define CS_REC_MAC_DEL          5   /* HA-owned MAC entry deleted or aged out */
+
+/* ISSU states */
+#define CS_STATE_IDLE           0
+#define CS_STATE_SENDING        1   /* Bulk sent, waiting for SYNC_DONE */
+#define CS_STATE_RECEIVING      2
+#define CS_STATE_SYNCED         3
+#define CS_STATE_SWAPPING       4
+#define CS_STATE_DONE           5
+#define CS_STATE_FAILED         6
+
+typedef struct {
+    uint16_t type;
+    uint16_t count;             /* Records in data[] */
+    uint32_t session;
+    int64_t  arg;
+    uint64_t epoch;             /* Sender's state lineage */
+    uint64_t version;           /* State version covered once this is applied */
+    uint16_t len;               /* Bytes used in data[] */
+    uint8_t  data[CS_MAX_PAYLOAD];
+} cluster_sync_msg_t;
+
+typedef struct {
+    uint8_t  state;
+    uint32_t records_sent;
+    uint32_t records_applied;
+    uint32_t records_skipped;   /* Unknown type or failed import */
+    uint64_t sync_ns;           /* BULK_BEGIN -> SYNC_DONE */
+    bool     delta;             /* Last sync sent only changes since the peer's version */
+    uint64_t version;
+    int64_t  loss_ns;           /* Old ACTIVE release -> new ACTIVE in service */
+} cluster_sync_stats_t;
+
+typedef struct cluster_sync cluster_sync_t;
+
+/*
+ * Transport for sync messages. It must queue rather than deliver into
+ * the peer's cluster_sync_receive() from the same call stack.
+ */
+typedef int (*cluster_sync_send_cb_t)(const cluster_sync_msg_t *msg, void *ctx);
+
+/* A state owner exports with cluster_sync_emit() and applies one record on import */
+typedef int (*cluster_sync_export_cb_t)(cluster_sync_t *s);
+typedef int (*cluster_sync_import_cb_t)(const uint8_t *data, uint8_t len);
+
+int cluster_sync_register(uint8_t rec_type, cluster_sync_export_cb_t export_cb,
+                          cluster_sync_import_cb_t import_cb);
+int cluster_sync_emit(cluster_sync_t *s, uint8_t rec_type, const void *data, uint8_t len);
+
+cluster_sync_t *cluster_sync_create(cluster_t *c, cluster_sync_send_cb_t send, void *ctx);
+void cluster_sync_destroy(cluster_sync_t *s);
+
+/* On the ACTIVE node: push all registered state to the upgraded peer */
+int cluster_sync_start(cluster_sync_t *s);
+/* On the ACTIVE node, once SYNCED: hand the ACTIVE role to the peer */
+int cluster_sync_swap(cluster_sync_t *s);
+
+/*
+ * On the ACTIVE node: log a change to replicated state under a new
+ * version and push it to the peer if it is synced. Records up to
+ * CS_LOG_MAX_DATA bytes are kept for delta sync. Elsewhere a no-op,
+ * so owners can report every change, including ones applied from the
+ * peer. A log's first record starts a new epoch (cluster_new_epoch),
+ * since its versions restart at 1.
+ */
+int cluster_sync_record(cluster_sync_t *s, uint8_t rec_type, const void *data, uint8_t len);
+
+/* Built-in record types: HA MAC learned, moved or removed, BGP timers configured */
+int cluster_sync_mac_learned(cluster_sync_t *s, const uint8_t mac[6], uint16_t vlan,
+                             uint32_t ifindex);
+int cluster_sync_mac_removed(cluster_sync_t *s, const uint8_t mac[6], uint16_t vlan);
+int cluster_sync_timers_changed(cluster_sync_t *s, uint32_t vrf_id, uint32_t hold_time,
+                                uint32_t keepalive);
+
+/*
+ * Record changes to the node-wide built-in state (the HA MAC table and
+ * configured BGP timers) in s from now on. One instance at a time;
+ * cluster_sync_destroy() detaches.
+ */
+int cluster_sync_attach(cluster_sync_t *s);
+void cluster_sync_detach(cluster_sync_t *s);
+
+/*
+ * On a STANDBY that rejoined from persisted state: ask for the changes
+ * since its sync point. The peer falls back to a full bulk sync if it
+ * no longer has them or the epoch has moved on.
+ */
+int cluster_sync_request_delta(cluster_sync_t *s);
+
+int cluster_sync_receive(cluster_sync_t *s, const cluster_sync_msg_t *msg);
+
+void cluster_sync_get_stats(cluster_sync_t *s, cluster_sync_stats_t *stats);
+const char *cluster_sync_state_name(uint8_t state);
+
+#endif /* CLUSTER_SYNC_H */
@@ -0,0 +1,461 @@
+/*
+ * cluster_track.c - HA Tracked Object Health
+ *
+ * NetBlade OS v3.x High Availability Module
+ * Copyright (c) 2024-2026 Enterprise Systems Inc. All rights reserved.
+ *
+ * Tracks objects whose failure should move the cluster (uplink state,
+ * BGP sessions, route presence) and folds them into a single health
+ * score. Each down object subtracts its weight from CLUSTER_HEALTH_MAX.
+ * State changes are pushed in by the owning subsystem, so subscribers
+ * see a new score as soon as the event is delivered — nothing polls.
+ *
+ * Objects a failover group tracks are claimed by it and left out of
+ * the node-wide score: a tenant's failure moves that tenant's group,
+ * not the whole node. Subscribers are still called when one of them
+ * changes, so groups can re-check their own health.
+ *
+ * Subscribers are called without track_lock, by one thread at a time
+ * and always with the newest score. Changes that land while a delivery
+ * is running are picked up by its next pass, so an older score never
+ * reaches a subscriber after a newer one.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+#include <stdbool.h>
+#include <pthread.h>
+#include "cluster_track.h"
+#include "interface_manager.h"
+#include "syslog.h"
+#include "nb_mutex.h"
+
+#define MAX_HEALTH_SUBSCRIBERS  8
+
+typedef struct {
+    bool        in_use;
+    uint8_t     type;
+    uint8_t     weight;
+    bool        up;
+    uint32_t    ifindex;        /* TRACK_TYPE_INTERFACE */
+    uint32_t    vrf_id;         /* TRACK_TYPE_BGP_SESSION / TRACK_TYPE_ROUTE */
+    uint8_t     addr[16];       /* Peer address or route prefix */
+    uint8_t     addr_len;       /* 4 or 16 */
+    uint8_t     prefix_len;     /* TRACK_TYPE_ROUTE only */
+} track_object_t;
+
+typedef struct {
+    cluster_health_cb_t cb;
+    void               *ctx;
+} health_subscriber_t;
+
+typedef struct {
+    track_object_t      objects[MAX_TRACK_OBJECTS];
+    health_subscriber_t subscribers[MAX_HEALTH_SUBSCRIBERS];
+    int                 subscriber_count;
+    uint8_t             health;
+    uint8_t             claims[MAX_TRACK_OBJECTS];  /* Failover groups tracking each id */
+    uint64_t            grouped;                    /* Ids with claims */
+    uint32_t            gen;                        /* Changes subscribers must see */
+    uint32_t            delivered;                  /* ...and have been given */
+    bool                delivering;
+    nb_mutex_t          track_lock;
+} track_table_t;
+
+static track_table_t track;
+
+static const char *track_type_name(uint8_t type)
+{
+    switch (type) {
+        case TRACK_TYPE_INTERFACE:   return "interface";
+        case TRACK_TYPE_BGP_SESSION: return "bgp-session";
+        case TRACK_TYPE_ROUTE:       return "route";
+    }
+    return "unknown";
+}
+
+/*
+ * track_compute_health - Recompute health over a set of tracked objects
+ *
+ * Bit i of mask selects object i. Caller must hold track_lock.
+ */
+static uint8_t track_compute_health_mask(uint64_t mask)
+{
+    int health = CLUSTER_HEALTH_MAX;
+
+    for (int i = 0; i < MAX_TRACK_OBJECTS; i++) {
+        if (!(mask & (1ULL << i))) continue;
+        if (track.objects[i].in_use && !track.objects[i].up) {
+            health -= track.objects[i].weight;
+        }
+    }
+
+    return (health < 0) ? 0 : (uint8_t)health;
+}
+
+static uint8_t track_compute_health(void)
+{
+    return track_compute_health_mask(~track.grouped);
+}
+
+/*
+ * track_set_health - Store a new node-wide score
+ *
+ * Caller holds track_lock. Subscribers are due a call if the score
+ * moved or 'changed' says a grouped object did. Returns true if the
+ * caller must run track_deliver() once the lock is dropped; false if
+ * nothing changed or another delivery will pick this up.
+ */
+static bool track_set_health(uint8_t health, bool changed)
+{
+    if (health != track.health) {
+        syslog_write(LOG_WARNING, "Cluster track: Health changed %d -> %d",
+            track.health, health);
+        track.health = health;
+        changed = true;
+    }
+    if (!changed) return false;
+
+    track.gen++;
+    if (track.delivering) return false;
+    track.delivering = true;
+    return true;
+}
+
+/*
+ * track_deliver - Call subscribers until they have the latest score
+ *
+ * Runs without track_lock held, so a subscriber may call back into
+ * this module; what it changes is delivered on the next pass.
+ */
+static void track_deliver(void)
+{
+    health_subscriber_t subs[MAX_HEALTH_SUBSCRIBERS];
+
+    nb_mutex_lock(&track.track_lock);
+    while (track.delivered != track.gen) {
+        uint8_t health = track.health;
+        int sub_count = track.subscriber_count;
+
+        memcpy(subs, track.subscribers, sizeof(track.subscribers));
+        track.delivered = track.gen;
+        nb_mutex_unlock(&track.track_lock);
+
+        for (int i = 0; i < sub_count; i++) {
+            subs[i].cb(health, subs[i].ctx);
+        }
+
+        nb_mutex_lock(&track.track_lock);
+    }
+    track.delivering = false;
+    nb_mutex_unlock(&track.track_lock);
+}
+
+/*
+ * track_update - Apply a state change to every matching object
+ *
+ * Recomputes health and notifies subscribers outside the lock.
+ */
+static void track_update(uint8_t type, uint32_t key, const uint8_t *addr,
+                         uint8_t addr_len, uint8_t prefix_len, bool up)
+{
+    bool changed = false, grouped = false, deliver;
+    uint8_t health;
+
+    nb_mutex_lock(&track.track_lock);
+
+    for (int i = 0; i < MAX_TRACK_OBJECTS; i++) {
+        track_object_t *obj = &track.objects[i];
+
+        if (!obj->in_use || obj->type != type || obj->up == up)
+            continue;
+
+        if (type == TRACK_TYPE_INTERFACE) {
+            if (obj->ifindex != key)
+                continue;
+        } else {
+            if (obj->vrf_id != key || obj->addr_len != addr_len ||
+                memcmp(obj->addr, addr, addr_len) != 0)
+                continue;
+            if (type == TRACK_TYPE_ROUTE && obj->prefix_len != prefix_len)
+                continue;
+        }
+
+        obj->up = up;
+        changed = true;
+        if (track.grouped & (1ULL << i)) grouped = true;
+        syslog_write(LOG_INFO, "Cluster track %d (%s): %s",
+            i, track_type_name(type), up ? "UP" : "DOWN");
+    }
+
+    health = changed ? track_compute_health() : track.health;
+    deliver = track_set_health(health, grouped);
+
+    nb_mutex_unlock(&track.track_lock);
+
+    if (deliver) track_deliver();
+}
+
+static void track_link_event(uint32_t ifindex, bool link_up, void *ctx)
+{
+    (void)ctx;
+    cluster_track_interface_event(ifindex, link_up);
+}
+
+/*
+ * track_add - Claim a free slot for a new tracked object
+ *
+ * New objects start UP; the caller seeds the real state afterwards.
+ */
+static int track_add(const track_object_t *tmpl)
+{
+    int id = -1;
+
+    nb_mutex_lock(&track.track_lock);
+
+    for (int i = 0; i < MAX_TRACK_OBJECTS; i++) {
+        if (!track.objects[i].in_use) {
+            track.objects[i] = *tmpl;
+            track.objects[i].in_use = true;
+            track.objects[i].up = true;
+            id = i;
+            break;
+        }
+    }
+
+    nb_mutex_unlock(&track.track_lock);
+
+    if (id < 0) {
+        syslog_write(LOG_ERR, "Cluster track: Table full (%d objects)",
+            MAX_TRACK_OBJECTS);
+    } else {
+        syslog_write(LOG_INFO, "Cluster track %d: Tracking %s weight %d",
+            id, track_type_name(tmpl->type), tmpl->weight);
+    }
+
+    return id;
+}
+
+/*
+ * cluster_track_init - Initialize tracked object table
+ *
+ * Subscribes to interface link events so uplink failures are seen
+ * immediately rather than on the next heartbeat tick.
+ */
+int cluster_track_init(void)
+{
+    memset(&track, 0, sizeof(track_table_t));
+    nb_mutex_init(&track.track_lock, "cluster_track.track_lock");
+    track.health = CLUSTER_HEALTH_MAX;
+
+    if (interface_manager_subscribe_link(track_link_event, NULL) != 0) {
+        syslog_write(LOG_ERR, "Cluster track: Failed to subscribe to link events");
+        return -1;
+    }
+
+    return 0;
+}
+
+int cluster_track_add_interface(uint32_t ifindex, uint8_t weight)
+{
+    track_object_t tmpl = {
+        .type = TRACK_TYPE_INTERFACE,
+        .weight = weight,
+        .ifindex = ifindex,
+    };
+    bool link_up = false;
+    int id = track_add(&tmpl);
+
+    if (id >= 0 && interface_manager_get_link_state(ifindex, &link_up) == 0 && !link_up) {
+        cluster_track_interface_event(ifindex, false);
+    }
+
+    return id;
+}
+
+int cluster_track_add_bgp_session(uint32_t vrf_id, const uint8_t *peer_addr,
+                                  uint8_t addr_len, uint8_t weight)
+{
+    if (addr_len != 4 && addr_len != 16) return -1;
+
+    track_object_t tmpl = {
+        .type = TRACK_TYPE_BGP_SESSION,
+        .weight = weight,
+        .vrf_id = vrf_id,
+        .addr_len = addr_len,
+    };
+    memcpy(tmpl.addr, peer_addr, addr_len);
+
+    /* Sessions are tracked before they come up; start DOWN */
+    int id = track_add(&tmpl);
+    if (id >= 0) {
+        cluster_track_bgp_event(vrf_id, peer_addr, addr_len, false);
+    }
+
+    return id;
+}
+
+int cluster_track_add_route(uint32_t vrf_id, const uint8_t *prefix,
+                            uint8_t addr_len, uint8_t prefix_len, uint8_t weight)
+{
+    if (addr_len != 4 && addr_len != 16) return -1;
+    if (prefix_len > addr_len * 8) return -1;
+
+    track_object_t tmpl = {
+        .type = TRACK_TYPE_ROUTE,
+        .weight = weight,
+        .vrf_id = vrf_id,
+        .addr_len = addr_len,
+        .prefix_len = prefix_len,
+    };
+    memcpy(tmpl.addr, prefix, addr_len);
+
+    /* Route presence is unknown until the RIB reports it; start DOWN */
+    int id = track_add(&tmpl);
+    if (id >= 0) {
+        cluster_track_route_event(vrf_id, prefix, addr_len, prefix_len, false);
+    }
+
+    return id;
+}
+
+/*
+ * cluster_track_remove - Stop tracking an object
+ *
+ * A removed DOWN object no longer counts against health, so this
+ * may raise the score and notify subscribers.
+ */
+int cluster_track_remove(int track_id)
+{
+    bool deliver;
+
+    if (track_id < 0 || track_id >= MAX_TRACK_OBJECTS) return -1;
+
+    nb_mutex_lock(&track.track_lock);
+
+    if (!track.objects[track_id].in_use) {
+        nb_mutex_unlock(&track.track_lock);
+        return -1;
+    }
+
+    bool grouped = !track.objects[track_id].up && (track.grouped & (1ULL << track_id));
+    memset(&track.objects[track_id], 0, sizeof(track_object_t));
+    deliver = track_set_health(track_compute_health(), grouped);
+
+    nb_mutex_unlock(&track.track_lock);
+
+    if (deliver) track_deliver();
+    return 0;
+}
+
+/*
+ * cluster_track_interface_event - Link state change from interface_manager
+ */
+void cluster_track_interface_event(uint32_t ifindex, bool link_up)
+{
+    track_update(TRACK_TYPE_INTERFACE, ifindex, NULL, 0, 0, link_up);
+}
+
+/*
+ * cluster_track_bgp_event - Called by the BGP FSM on entering or
+ * leaving Established
+ */
+void cluster_track_bgp_event(uint32_t vrf_id, const uint8_t *peer_addr,
+                             uint8_t addr_len, bool established)
+{
+    track_update(TRACK_TYPE_BGP_SESSION, vrf_id, peer_addr, addr_len, 0, established);
+}
+
+/*
+ * cluster_track_route_event - Called by the RIB when a tracked prefix
+ * is installed or withdrawn
+ */
+void cluster_track_route_event(uint32_t vrf_id, const uint8_t *prefix,
+                               uint8_t addr_len, uint8_t prefix_len, bool present)
+{
+    track_update(TRACK_TYPE_ROUTE, vrf_id, prefix, addr_len, prefix_len, present);
+}
+
+uint8_t cluster_track_get_health(void)
+{
+    nb_mutex_lock(&track.track_lock);
+    uint8_t health = track.health;
+    nb_mutex_unlock(&track.track_lock);
+    return health;
+}
+
+/*
+ * cluster_track_get_health_mask - Health over a subset of tracked objects
+ *
+ * Used by failover groups, which only care about their own objects.
+ */
+uint8_t cluster_track_get_health_mask(uint64_t mask)
+{
+    nb_mutex_lock(&track.track_lock);
+    uint8_t health = track_compute_health_mask(mask);
+    nb_mutex_unlock(&track.track_lock);
+    return health;
+}
+
+/*
+ * cluster_track_claim - Failover groups taking or dropping objects
+ *
+ * Claimed objects count only towards the groups that track them, not
+ * the node-wide score. Claims are counted per id, so overlapping groups
+ * each pass their whole old and new masks. Must not be called with a
+ * lock a subscriber takes: a change to the score is delivered here.
+ */
+void cluster_track_claim(uint64_t claim, uint64_t release)
+{
+    bool deliver;
+
+    nb_mutex_lock(&track.track_lock);
+
+    for (int i = 0; i < MAX_TRACK_OBJECTS; i++) {
+        if (claim & (1ULL << i)) track.claims[i]++;
+        if ((release & (1ULL << i)) && track.claims[i] > 0) track.claims[i]--;
+
+        if (track.claims[i]) track.grouped |= 1ULL << i;
+        else track.grouped &= ~(1ULL << i);
+    }
+    deliver = track_set_health(track_compute_health(), false);
+
+    nb_mutex_unlock(&track.track_lock);
+
+    if (deliver) track_deliver();
+}
+
+/*
+ * cluster_track_subscribe - Register for health score changes
+ *
+ * Registering the same callback and context again is a no-op, so an
+ * owner that re-initialises is still called once per change.
+ */
+int cluster_track_subscribe(cluster_health_cb_t cb, void *ctx)
+{
+    if (!cb) return -1;
+
+    nb_mutex_lock(&track.track_lock);
+
+    for (int i = 0; i < track.subscriber_count; i++) {
+        if (track.subscribers[i].cb == cb && track.subscribers[i].ctx == ctx) {
+            nb_mutex_unlock(&track.track_lock);
+            return 0;
+        }
+    }
+
+    if (track.subscriber_count >= MAX_HEALTH_SUBSCRIBERS) {
+        nb_mutex_unlock(&track.track_lock);
+        syslog_write(LOG_ERR, "Cluster track: Too many health subscribers");
+        return -1;
+    }
+
+    track.subscribers[track.subscriber_count].cb = cb;
+    track.subscribers[track.subscriber_count].ctx = ctx;
+    track.subscriber_count++;
+
+    nb_mutex_unlock(&track.track_lock);
+    return 0;
+}
@@ -0,0 +1,57 @@
+/*
+ * cluster_track.h - HA Tracked Object Health
+ *
+ * NetBlade OS v3.x High Availability Module
+ * Copyright (c) 2024-2026 Enterprise Systems Inc. All rights reserved.
+ */
+
+#ifndef CLUSTER_TRACK_H
+#define CLUSTER_TRACK_H
+
+#include <stdint.h>
+#include <stdbool.h>
+
+/* Tracked object types */
+#define TRACK_TYPE_INTERFACE    0   /* Interface link state */
+#define TRACK_TYPE_BGP_SESSION  1   /* BGP session Established */
+#define TRACK_TYPE_ROUTE        2   /* Route present in VRF RIB */
+
+#define MAX_TRACK_OBJECTS       64
+#define CLUSTER_HEALTH_MAX      255     /* All tracked objects up */
+
+/*
+ * Called whenever the node-wide health score changes, and when an
+ * object claimed by a failover group changes state (with the score
+ * unchanged) so groups can re-check. Runs synchronously in the thread
+ * that delivered a tracked event, one call at a time and never with an
+ * older score than the last. Events that arrive during a call are
+ * delivered by that thread afterwards, coalesced to the newest score.
+ */
+typedef void (*cluster_health_cb_t)(uint8_t health, void *ctx);
+
+int cluster_track_init(void);
+
+/* Returns a track id (>= 0) or -1 if the table is full */
+int cluster_track_add_interface(uint32_t ifindex, uint8_t weight);
+int cluster_track_add_bgp_session(uint32_t vrf_id, const uint8_t *peer_addr,
+                                  uint8_t addr_len, uint8_t weight);
+int cluster_track_add_route(uint32_t vrf_id, const uint8_t *prefix,
+                            uint8_t addr_len, uint8_t prefix_len, uint8_t weight);
+int cluster_track_remove(int track_id);
+
+/* Event entry points for the owning subsystems */
+void cluster_track_interface_event(uint32_t ifindex, bool link_up);
+void cluster_track_bgp_event(uint32_t vrf_id, const uint8_t *peer_addr,
+                             uint8_t addr_len, bool established);
+void cluster_track_route_event(uint32_t vrf_id, const uint8_t *prefix,
+                               uint8_t addr_len, uint8_t prefix_len, bool present);
+
+/* Node-wide score: every object not claimed by a failover group */
+uint8_t cluster_track_get_health(void);
+/* Bit i of mask selects track id i */
+uint8_t cluster_track_get_health_mask(uint64_t mask);
+/* Failover groups claiming (and releasing) the objects they track */
+void cluster_track_claim(uint64_t claim, uint64_t release);
+int cluster_track_subscribe(cluster_health_cb_t cb, void *ctx);
+
+#endif /* CLUSTER_TRACK_H */
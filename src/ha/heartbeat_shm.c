@@ -0,0 +1,386 @@
+/*
+ * heartbeat_shm.c - Shared-Memory Heartbeat Transport
+ *
+ * NetBlade OS v3.x High Availability Module
+ * Copyright (c) 2024-2026 Enterprise Systems Inc. All rights reserved.
+ *
+ * On dual-supervisor chassis both cluster members run on one host, so
+ * the heartbeat can bypass the network entirely. Each supervisor owns
+ * one cache-line-aligned slot of a shared mapping:
+ *
+ *  - pulse: a counter and timestamp bumped every pulse_us by a
+ *    dedicated thread. The peer's monitor sleeps until the last pulse
+ *    plus 'miss' pulse intervals, then checks whether the counter has
+ *    moved. A supervisor that dies or hangs stops pulsing and is
+ *    declared lost at that deadline, typically well under a millisecond.
+ *
+ *  - msg: the last heartbeat_msg_t, published under a seqlock so the
+ *    reader never blocks the writer and retries on a torn copy.
+ *    Publishing also bumps the pulse, which doubles as a futex word,
+ *    so messages are delivered as soon as they are written. A writer
+ *    that dies mid-write leaves the sequence odd for good, so the
+ *    reader gives up after a bounded number of tries and the loss
+ *    deadline still runs; the writer evens it out when it reattaches.
+ *
+ * Only a published message wakes the futex, and only while the peer's
+ * monitor is flagged as waiting. A plain pulse is a couple of stores,
+ * and the monitor wakes about once per loss window.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+#include <stdbool.h>
+#include <stdatomic.h>
+#include <errno.h>
+#include <time.h>
+#include <pthread.h>
+#include <sched.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/syscall.h>
+#include <linux/futex.h>
+#include "heartbeat_shm.h"
+#include "syslog.h"
+
+#define HB_SHM_MAGIC        0x4e424853U     /* "NBHS" */
+#define HB_SHM_INIT         0x4e424869U     /* Creator is filling in the header */
+#define HB_SHM_VERSION      1
+#define HB_SHM_INIT_WAIT_MS 1000
+#define HB_SHM_READ_TRIES   1024            /* A write is a ~300 byte copy */
+
+typedef struct {
+    _Atomic uint32_t pulse;             /* Futex word */
+    _Atomic uint32_t waiting;           /* Peer's monitor is in FUTEX_WAIT */
+    _Atomic uint64_t pulse_mono_ns;
+    uint32_t         pid;
+    uint8_t          pad0[44];
+    _Atomic uint32_t msg_seq;           /* Odd while a write is in progress */
+    uint8_t          pad1[60];
+    heartbeat_msg_t  msg;
+} __attribute__((aligned(64))) hb_shm_slot_t;
+
+typedef struct {
+    _Atomic uint32_t magic;
+    uint32_t         version;
+    uint32_t         slot_size;
+    uint8_t          pad[52];
+    hb_shm_slot_t    slot[2];
+} hb_shm_region_t;
+
+struct hb_shm {
+    hb_shm_region_t *region;
+    hb_shm_slot_t   *local;
+    hb_shm_slot_t   *peer;
+    cluster_t       *cluster;
+    uint32_t         pulse_us;
+    uint32_t         miss;
+    _Atomic bool     running;
+    pthread_t        pulse_thread;
+    pthread_t        monitor_thread;
+    uint32_t         last_msg_seq;
+    hb_shm_stats_t   stats;
+};
+
+static uint64_t hb_shm_clock_ns(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000000000ULL + (uint64_t)ts.tv_nsec;
+}
+
+static int futex_wait(_Atomic uint32_t *addr, uint32_t val, uint64_t timeout_ns)
+{
+    struct timespec ts = {
+        .tv_sec = (time_t)(timeout_ns / 1000000000ULL),
+        .tv_nsec = (long)(timeout_ns % 1000000000ULL),
+    };
+    /* Not FUTEX_PRIVATE: the word is shared between processes */
+    return (int)syscall(SYS_futex, (uint32_t *)addr, FUTEX_WAIT, val, &ts, NULL, 0);
+}
+
+static void futex_wake(_Atomic uint32_t *addr)
+{
+    syscall(SYS_futex, (uint32_t *)addr, FUTEX_WAKE, 1, NULL, NULL, 0);
+}
+
+static void hb_shm_pulse(hb_shm_t *h, bool wake)
+{
+    atomic_store_explicit(&h->local->pulse_mono_ns, hb_shm_clock_ns(), memory_order_release);
+    /* Sequentially consistent against the monitor's waiting/pulse pair */
+    atomic_fetch_add(&h->local->pulse, 1);
+
+    if (wake && atomic_load(&h->local->waiting)) {
+        futex_wake(&h->local->pulse);
+    }
+}
+
+hb_shm_t *hb_shm_open(const char *name, uint8_t slot)
+{
+    if (slot > 1) return NULL;
+
+    int fd = shm_open(name, O_RDWR | O_CREAT, 0600);
+    if (fd < 0) {
+        syslog_write(LOG_ERR, "HB shm: Cannot open %s", name);
+        return NULL;
+    }
+
+    /* A new object is zero-filled, so two racing creators agree on it */
+    if (ftruncate(fd, sizeof(hb_shm_region_t)) != 0) {
+        syslog_write(LOG_ERR, "HB shm: Cannot size %s", name);
+        close(fd);
+        return NULL;
+    }
+
+    hb_shm_region_t *region = mmap(NULL, sizeof(hb_shm_region_t),
+        PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+    close(fd);
+
+    if (region == MAP_FAILED) {
+        syslog_write(LOG_ERR, "HB shm: Cannot map %s", name);
+        return NULL;
+    }
+
+    /* The header is complete before the magic makes it visible */
+    uint32_t expect = 0;
+    if (atomic_compare_exchange_strong(&region->magic, &expect, HB_SHM_INIT)) {
+        region->version = HB_SHM_VERSION;
+        region->slot_size = sizeof(hb_shm_slot_t);
+        atomic_store_explicit(&region->magic, HB_SHM_MAGIC, memory_order_release);
+        expect = HB_SHM_MAGIC;
+    }
+    for (int ms = 0; expect == HB_SHM_INIT && ms < HB_SHM_INIT_WAIT_MS; ms++) {
+        usleep(1000);
+        expect = atomic_load_explicit(&region->magic, memory_order_acquire);
+    }
+    if (expect != HB_SHM_MAGIC || region->version != HB_SHM_VERSION ||
+        region->slot_size != sizeof(hb_shm_slot_t)) {
+        syslog_write(LOG_ERR, "HB shm: %s has an incompatible layout", name);
+        munmap(region, sizeof(hb_shm_region_t));
+        return NULL;
+    }
+
+    hb_shm_t *h = calloc(1, sizeof(hb_shm_t));
+    if (!h) {
+        munmap(region, sizeof(hb_shm_region_t));
+        return NULL;
+    }
+
+    h->region = region;
+    h->local = &region->slot[slot];
+    h->peer = &region->slot[slot ^ 1];
+    h->pulse_us = HB_SHM_DEFAULT_PULSE_US;
+    h->miss = HB_SHM_DEFAULT_MISS;
+    h->local->pid = (uint32_t)getpid();
+
+    /* We died mid-write last time: drop the torn message, make the sequence even */
+    uint32_t seq = atomic_load(&h->local->msg_seq);
+    if (seq & 1) {
+        memset(&h->local->msg, 0, sizeof(heartbeat_msg_t));
+        atomic_store_explicit(&h->local->msg_seq, seq + 1, memory_order_release);
+        syslog_write(LOG_WARNING, "HB shm: Slot %d was left mid-write, message dropped", slot);
+    }
+    h->last_msg_seq = atomic_load(&h->peer->msg_seq);
+
+    syslog_write(LOG_INFO, "HB shm: Attached to %s as slot %d", name, slot);
+    return h;
+}
+
+void hb_shm_close(hb_shm_t *h)
+{
+    if (!h) return;
+
+    hb_shm_stop(h);
+    munmap(h->region, sizeof(hb_shm_region_t));
+    free(h);
+}
+
+int hb_shm_configure(hb_shm_t *h, uint32_t pulse_us, uint32_t miss)
+{
+    if (pulse_us == 0 || miss < 2) return -1;
+    if (atomic_load(&h->running)) return -1;
+
+    h->pulse_us = pulse_us;
+    h->miss = miss;
+    return 0;
+}
+
+int hb_shm_send(hb_shm_t *h, const heartbeat_msg_t *msg)
+{
+    hb_shm_slot_t *s = h->local;
+    uint32_t seq = atomic_load_explicit(&s->msg_seq, memory_order_relaxed);
+
+    atomic_store_explicit(&s->msg_seq, seq + 1, memory_order_relaxed);
+    atomic_thread_fence(memory_order_release);
+    memcpy(&s->msg, msg, sizeof(heartbeat_msg_t));
+    atomic_store_explicit(&s->msg_seq, seq + 2, memory_order_release);
+
+    h->stats.msgs_sent++;
+    hb_shm_pulse(h, true);
+    return 0;
+}
+
+int hb_shm_cluster_send(cluster_t *c, const heartbeat_msg_t *msg, void *ctx)
+{
+    (void)c;
+    return hb_shm_send((hb_shm_t *)ctx, msg);
+}
+
+/*
+ * hb_shm_read_msg - Seqlock read of the peer's last heartbeat
+ *
+ * Returns true with a consistent copy in *msg if a new message was
+ * published since the last read. Gives up after HB_SHM_READ_TRIES,
+ * leaving the message for the next pulse: a peer that died mid-write
+ * must not keep the monitor from reaching its loss deadline.
+ */
+static bool hb_shm_read_msg(hb_shm_t *h, heartbeat_msg_t *msg)
+{
+    hb_shm_slot_t *s = h->peer;
+
+    for (int tries = 0; tries < HB_SHM_READ_TRIES; tries++) {
+        uint32_t seq = atomic_load_explicit(&s->msg_seq, memory_order_acquire);
+
+        if (seq == h->last_msg_seq) return false;
+        if (seq & 1) {
+            h->stats.read_retries++;
+            continue;
+        }
+
+        memcpy(msg, &s->msg, sizeof(heartbeat_msg_t));
+        atomic_thread_fence(memory_order_acquire);
+
+        if (atomic_load_explicit(&s->msg_seq, memory_order_relaxed) == seq) {
+            h->last_msg_seq = seq;
+            return true;
+        }
+        h->stats.read_retries++;
+    }
+
+    h->stats.read_abandoned++;
+    return false;
+}
+
+static void *hb_shm_pulse_thread(void *arg)
+{
+    hb_shm_t *h = arg;
+    struct sched_param sp = { .sched_priority = sched_get_priority_min(SCHED_FIFO) };
+    struct timespec next;
+
+    /*
+     * A late pulse is a false failover, so pulse from the real-time
+     * class when allowed. Absolute deadlines keep oversleeps from
+     * accumulating.
+     */
+    if (pthread_setschedparam(pthread_self(), SCHED_FIFO, &sp) != 0) {
+        syslog_write(LOG_DEBUG, "HB shm: No SCHED_FIFO for pulse thread");
+    }
+    clock_gettime(CLOCK_MONOTONIC, &next);
+
+    while (atomic_load(&h->running)) {
+        hb_shm_pulse(h, false);
+        h->stats.pulses++;
+
+        next.tv_nsec += (long)h->pulse_us * 1000;
+        while (next.tv_nsec >= 1000000000L) {
+            next.tv_nsec -= 1000000000L;
+            next.tv_sec++;
+        }
+        clock_nanosleep(CLOCK_MONOTONIC, TIMER_ABSTIME, &next, NULL);
+    }
+    return NULL;
+}
+
+static void *hb_shm_monitor_thread(void *arg)
+{
+    hb_shm_t *h = arg;
+    hb_shm_slot_t *peer = h->peer;
+    uint64_t timeout_ns = (uint64_t)h->pulse_us * h->miss * 1000ULL;
+    uint32_t seen = atomic_load(&peer->pulse);
+    uint64_t deadline = hb_shm_clock_ns() + timeout_ns;
+    heartbeat_msg_t msg;
+
+    while (atomic_load(&h->running)) {
+        uint64_t now = hb_shm_clock_ns();
+
+        if (now < deadline) {
+            atomic_store(&peer->waiting, 1);
+            if (atomic_load_explicit(&peer->pulse, memory_order_acquire) == seen) {
+                futex_wait(&peer->pulse, seen, deadline - now);
+            }
+            atomic_store(&peer->waiting, 0);
+            h->stats.wakeups++;
+        }
+
+        uint32_t pulse = atomic_load_explicit(&peer->pulse, memory_order_acquire);
+        if (pulse != seen) {
+            /* Pulses don't wake us, so time the window from the latest one */
+            seen = pulse;
+            deadline = atomic_load_explicit(&peer->pulse_mono_ns, memory_order_acquire) +
+                       timeout_ns;
+
+            if (!h->stats.peer_alive) {
+                syslog_write(LOG_INFO, "HB shm: Peer (pid %d) alive", peer->pid);
+                h->stats.peer_alive = true;
+            }
+            if (hb_shm_read_msg(h, &msg)) {
+                h->stats.msgs_received++;
+                cluster_receive(h->cluster, &msg);
+            }
+            continue;
+        }
+
+        if (hb_shm_clock_ns() < deadline) continue;
+
+        if (h->stats.peer_alive) {
+            uint64_t last = atomic_load(&peer->pulse_mono_ns);
+
+            h->stats.peer_alive = false;
+            h->stats.losses++;
+            h->stats.last_detect_ns = hb_shm_clock_ns() - last;
+            syslog_write(LOG_WARNING, "HB shm: Peer (pid %d) silent for %llu us",
+                peer->pid, (unsigned long long)(h->stats.last_detect_ns / 1000));
+            cluster_peer_lost(h->cluster);
+        }
+        deadline = hb_shm_clock_ns() + timeout_ns;
+    }
+    return NULL;
+}
+
+int hb_shm_start(hb_shm_t *h, cluster_t *c)
+{
+    if (!c) return -1;
+    if (atomic_exchange(&h->running, true)) return 0;
+
+    h->cluster = c;
+    if (pthread_create(&h->pulse_thread, NULL, hb_shm_pulse_thread, h) != 0) {
+        atomic_store(&h->running, false);
+        return -1;
+    }
+    if (pthread_create(&h->monitor_thread, NULL, hb_shm_monitor_thread, h) != 0) {
+        atomic_store(&h->running, false);
+        pthread_join(h->pulse_thread, NULL);
+        return -1;
+    }
+
+    syslog_write(LOG_INFO, "HB shm: Started (pulse %u us, loss after %u missed)",
+        h->pulse_us, h->miss);
+    return 0;
+}
+
+void hb_shm_stop(hb_shm_t *h)
+{
+    if (!atomic_exchange(&h->running, false)) return;
+
+    /* The monitor wakes by its own deadline at the latest */
+    pthread_join(h->pulse_thread, NULL);
+    pthread_join(h->monitor_thread, NULL);
+}
+
+void hb_shm_get_stats(hb_shm_t *h, hb_shm_stats_t *stats)
+{
+    memcpy(stats, &h->stats, sizeof(hb_shm_stats_t));
+    stats->running = atomic_load(&h->running);
+}
@@ -0,0 +1,56 @@
+/*
+ * heartbeat_shm.h - Shared-Memory Heartbeat Transport
+ *
+ * NetBlade OS v3.x High Availability Module
+ * Copyright (c) 2024-2026 Enterprise Systems Inc. All rights reserved.
+ */
+
+#ifndef HEARTBEAT_SHM_H
+#define HEARTBEAT_SHM_H
+
+#include <stdint.h>
+#include <stdbool.h>
+#include "heartbeat.h"
+#include "cluster_instance.h"
+
+#define HB_SHM_DEFAULT_NAME         "/netblade-hb"
+#define HB_SHM_DEFAULT_PULSE_US     100
+#define HB_SHM_DEFAULT_MISS         5       /* Pulses missed before declaring loss */
+
+typedef struct {
+    bool     running;
+    bool     peer_alive;
+    uint64_t pulses;
+    uint64_t msgs_sent;
+    uint64_t msgs_received;
+    uint64_t read_retries;      /* Seqlock reads that raced a write */
+    uint64_t read_abandoned;    /* Reads given up on a write that did not finish */
+    uint64_t wakeups;
+    uint32_t losses;
+    uint64_t last_detect_ns;    /* Peer's last pulse -> loss declared */
+} hb_shm_stats_t;
+
+typedef struct hb_shm hb_shm_t;
+
+/*
+ * Map (creating if needed) the region shared by both supervisors. Each
+ * side owns one slot: 0 or 1, fixed per supervisor position.
+ */
+hb_shm_t *hb_shm_open(const char *name, uint8_t slot);
+void hb_shm_close(hb_shm_t *h);
+
+int hb_shm_configure(hb_shm_t *h, uint32_t pulse_us, uint32_t miss);
+
+/* Start the pulse and monitor threads, delivering to cluster c */
+int hb_shm_start(hb_shm_t *h, cluster_t *c);
+void hb_shm_stop(hb_shm_t *h);
+
+/* Publish a heartbeat to the peer; single writer (the cluster's state lock) */
+int hb_shm_send(hb_shm_t *h, const heartbeat_msg_t *msg);
+
+/* cluster_ops_t.send adapter, with the hb_shm_t as ctx */
+int hb_shm_cluster_send(cluster_t *c, const heartbeat_msg_t *msg, void *ctx);
+
+void hb_shm_get_stats(hb_shm_t *h, hb_shm_stats_t *stats);
+
+#endif /* HEARTBEAT_SHM_H */
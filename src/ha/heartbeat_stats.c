@@ -0,0 +1,117 @@
+/*
+ * heartbeat_stats.c - Heartbeat Path Timing Statistics
+ *
+ * NetBlade OS v3.x High Availability Module
+ * Copyright (c) 2024-2026 Enterprise Systems Inc. All rights reserved.
+ *
+ * Computes round-trip time, jitter and peer clock offset for each
+ * heartbeat path from echoed timestamps, and keeps rolling histograms
+ * of each so interval/timeout tuning can be based on measured behavior.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+#include <stdbool.h>
+#include "heartbeat_stats.h"
+#include "syslog.h"
+
+static int hist_bucket(uint64_t value_ns)
+{
+    uint64_t us = value_ns / 1000;
+    int b = 0;
+
+    while (us > 1 && b < HB_HIST_BUCKETS - 1) {
+        us >>= 1;
+        b++;
+    }
+    return b;
+}
+
+static void hist_add(hb_histogram_t *h, uint64_t value_ns)
+{
+    if (h->count == HB_STATS_WINDOW) {
+        h->buckets[hist_bucket(h->ring[h->head])]--;
+    } else {
+        h->count++;
+    }
+
+    h->ring[h->head] = value_ns;
+    h->buckets[hist_bucket(value_ns)]++;
+    h->head = (h->head + 1) % HB_STATS_WINDOW;
+}
+
+void hb_stats_reset(hb_path_stats_t *ps)
+{
+    memset(ps, 0, sizeof(hb_path_stats_t));
+}
+
+void hb_stats_record(hb_path_stats_t *ps, uint64_t t1, uint64_t t2,
+                     uint64_t t3, uint64_t t4)
+{
+    int64_t rtt = ((int64_t)(t4 - t1)) - ((int64_t)(t3 - t2));
+    int64_t offset = (((int64_t)(t2 - t1)) + ((int64_t)(t3 - t4))) / 2;
+
+    /* Clock steps or a stale echo can produce nonsense; drop it */
+    if (rtt < 0) return;
+
+    if (ps->samples > 0) {
+        int64_t d = rtt - ps->last_rtt_ns;
+        if (d < 0) d = -d;
+        ps->jitter_ns = (uint64_t)((int64_t)ps->jitter_ns + (d - (int64_t)ps->jitter_ns) / 16);
+        hist_add(&ps->jitter, ps->jitter_ns);
+    }
+
+    /*
+     * Queueing delay inflates the offset error by up to RTT/2, so the
+     * lowest-RTT sample in the window is the best offset estimate.
+     */
+    ps->offset_age++;
+    if (ps->samples == 0 || rtt <= ps->offset_min_rtt_ns ||
+        ps->offset_age >= HB_STATS_WINDOW) {
+        ps->offset_ns = offset;
+        ps->offset_min_rtt_ns = rtt;
+        ps->offset_age = 0;
+    }
+
+    ps->last_rtt_ns = rtt;
+    ps->last_offset_ns = offset;
+    ps->samples++;
+
+    hist_add(&ps->rtt, (uint64_t)rtt);
+    hist_add(&ps->offset, (uint64_t)(offset < 0 ? -offset : offset));
+}
+
+uint64_t hb_histogram_percentile(const hb_histogram_t *h, unsigned pct)
+{
+    if (h->count == 0) return 0;
+
+    uint32_t target = (uint32_t)(((uint64_t)h->count * pct + 99) / 100);
+    uint32_t seen = 0;
+
+    for (int b = 0; b < HB_HIST_BUCKETS; b++) {
+        seen += h->buckets[b];
+        if (seen >= target) {
+            return (2ULL << b) * 1000;
+        }
+    }
+    return (2ULL << (HB_HIST_BUCKETS - 1)) * 1000;
+}
+
+/*
+ * hb_stats_dump - Debug function to dump one path's measurements
+ */
+void hb_stats_dump(int path_id, const hb_path_stats_t *ps)
+{
+    syslog_write(LOG_DEBUG, "Heartbeat path %d: samples=%llu rtt=%lld us "
+        "p50<=%llu us p99<=%llu us jitter=%llu us offset=%lld us (min-rtt %lld us)",
+        path_id,
+        (unsigned long long)ps->samples,
+        (long long)(ps->last_rtt_ns / 1000),
+        (unsigned long long)(hb_histogram_percentile(&ps->rtt, 50) / 1000),
+        (unsigned long long)(hb_histogram_percentile(&ps->rtt, 99) / 1000),
+        (unsigned long long)(ps->jitter_ns / 1000),
+        (long long)(ps->offset_ns / 1000),
+        (long long)(ps->offset_min_rtt_ns / 1000));
+}
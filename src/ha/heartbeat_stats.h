@@ -0,0 +1,63 @@
+/*
+ * heartbeat_stats.h - Heartbeat Path Timing Statistics
+ *
+ * NetBlade OS v3.x High Availability Module
+ * Copyright (c) 2024-2026 Enterprise Systems Inc. All rights reserved.
+ */
+
+#ifndef HEARTBEAT_STATS_H
+#define HEARTBEAT_STATS_H
+
+#include <stdint.h>
+#include <stdbool.h>
+
+#define HEARTBEAT_MAX_PATHS     4
+#define HB_STATS_WINDOW         256     /* Samples kept per histogram */
+#define HB_HIST_BUCKETS         32      /* Bucket i holds values in [2^i, 2^(i+1)) us */
+
+/*
+ * Rolling histogram over the last HB_STATS_WINDOW samples. The ring
+ * remembers each sample so it can be removed from its bucket when it
+ * ages out of the window.
+ */
+typedef struct {
+    uint32_t buckets[HB_HIST_BUCKETS];
+    uint64_t ring[HB_STATS_WINDOW];
+    uint32_t head;
+    uint32_t count;
+} hb_histogram_t;
+
+typedef struct {
+    /* Echo state for the next heartbeat sent on this path */
+    uint64_t        echo_ts_ns;         /* Peer tx timestamp to reflect back */
+    uint64_t        echo_rx_mono_ns;    /* When we received it (monotonic) */
+
+    /* Measurements */
+    uint64_t        samples;
+    int64_t         last_rtt_ns;
+    uint64_t        jitter_ns;          /* RFC 3550 style smoothed |delta RTT| */
+    int64_t         last_offset_ns;     /* Peer clock minus local clock */
+    int64_t         offset_ns;          /* Offset from the lowest-RTT sample in window */
+    int64_t         offset_min_rtt_ns;
+    uint32_t        offset_age;         /* Samples since offset_ns was taken */
+    hb_histogram_t  rtt;
+    hb_histogram_t  jitter;
+    hb_histogram_t  offset;             /* |offset| */
+} hb_path_stats_t;
+
+void hb_stats_reset(hb_path_stats_t *ps);
+
+/*
+ * hb_stats_record - Add one echo sample (NTP-style timestamps)
+ *   t1: our original tx (local realtime)   t2: peer rx (peer realtime)
+ *   t3: peer tx (peer realtime)            t4: our rx (local realtime)
+ */
+void hb_stats_record(hb_path_stats_t *ps, uint64_t t1, uint64_t t2,
+                     uint64_t t3, uint64_t t4);
+
+/* Upper bound of the bucket containing the pct-th percentile, in ns */
+uint64_t hb_histogram_percentile(const hb_histogram_t *h, unsigned pct);
+
+void hb_stats_dump(int path_id, const hb_path_stats_t *ps);
+
+#endif /* HEARTBEAT_STATS_H */
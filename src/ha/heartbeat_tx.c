@@ -0,0 +1,120 @@
+/*
+ * heartbeat_tx.c - Connected-Socket Heartbeat Transport
+ *
+ * NetBlade OS v3.x High Availability Module
+ * Copyright (c) 2024-2026 Enterprise Systems Inc. All rights reserved.
+ *
+ * One UDP socket per heartbeat path, connected to the peer once at
+ * configuration time. A send is then a single send() of the cluster's
+ * prebuilt message: no route or neighbour lookup per packet beyond the
+ * kernel's cached dst, no allocation and no address arguments.
+ * Sends never block; a full socket buffer counts as an error and the
+ * next interval tries again.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+#include <errno.h>
+#include <unistd.h>
+#include <sys/socket.h>
+#include <netinet/in.h>
+#include "heartbeat_tx.h"
+#include "syslog.h"
+
+typedef struct {
+    int                fd;          /* -1 if the path is not configured */
+    hb_tx_path_stats_t stats;
+} hb_tx_path_t;
+
+struct hb_tx {
+    hb_tx_path_t paths[HEARTBEAT_MAX_PATHS];
+};
+
+hb_tx_t *hb_tx_create(void)
+{
+    hb_tx_t *t = calloc(1, sizeof(hb_tx_t));
+    if (!t) return NULL;
+
+    for (int p = 0; p < HEARTBEAT_MAX_PATHS; p++) {
+        t->paths[p].fd = -1;
+    }
+    return t;
+}
+
+void hb_tx_destroy(hb_tx_t *t)
+{
+    if (!t) return;
+
+    for (uint8_t p = 0; p < HEARTBEAT_MAX_PATHS; p++) {
+        hb_tx_clear_path(t, p);
+    }
+    free(t);
+}
+
+int hb_tx_set_path(hb_tx_t *t, uint8_t path_id, const struct sockaddr *local,
+                   const struct sockaddr *peer, socklen_t addr_len)
+{
+    if (path_id >= HEARTBEAT_MAX_PATHS || !peer) return -1;
+
+    int fd = socket(peer->sa_family, SOCK_DGRAM | SOCK_NONBLOCK | SOCK_CLOEXEC, 0);
+    if (fd < 0) {
+        syslog_write(LOG_ERR, "HB tx: Path %d socket failed: %s", path_id, strerror(errno));
+        return -1;
+    }
+
+    int tos = HB_TX_DSCP_CS6 << 2;
+    if (peer->sa_family == AF_INET6) {
+        setsockopt(fd, IPPROTO_IPV6, IPV6_TCLASS, &tos, sizeof(tos));
+    } else {
+        setsockopt(fd, IPPROTO_IP, IP_TOS, &tos, sizeof(tos));
+    }
+
+    if ((local && bind(fd, local, addr_len) != 0) || connect(fd, peer, addr_len) != 0) {
+        syslog_write(LOG_ERR, "HB tx: Path %d bind/connect failed: %s",
+            path_id, strerror(errno));
+        close(fd);
+        return -1;
+    }
+
+    hb_tx_clear_path(t, path_id);
+    t->paths[path_id].fd = fd;
+    memset(&t->paths[path_id].stats, 0, sizeof(hb_tx_path_stats_t));
+    return 0;
+}
+
+void hb_tx_clear_path(hb_tx_t *t, uint8_t path_id)
+{
+    if (path_id >= HEARTBEAT_MAX_PATHS || t->paths[path_id].fd < 0) return;
+
+    close(t->paths[path_id].fd);
+    t->paths[path_id].fd = -1;
+}
+
+int hb_tx_cluster_send(cluster_t *c, const heartbeat_msg_t *msg, void *ctx)
+{
+    hb_tx_t *t = ctx;
+
+    (void)c;
+
+    if (msg->path_id >= HEARTBEAT_MAX_PATHS) return -1;
+
+    hb_tx_path_t *p = &t->paths[msg->path_id];
+    if (p->fd < 0) return -1;
+
+    if (send(p->fd, msg, sizeof(heartbeat_msg_t), MSG_DONTWAIT) != (ssize_t)sizeof(heartbeat_msg_t)) {
+        p->stats.send_errors++;
+        return -1;
+    }
+    p->stats.sent++;
+    return 0;
+}
+
+int hb_tx_get_stats(hb_tx_t *t, uint8_t path_id, hb_tx_path_stats_t *stats)
+{
+    if (path_id >= HEARTBEAT_MAX_PATHS || !stats) return -1;
+
+    memcpy(stats, &t->paths[path_id].stats, sizeof(hb_tx_path_stats_t));
+    return 0;
+}
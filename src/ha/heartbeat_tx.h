@@ -0,0 +1,43 @@
+/*
+ * heartbeat_tx.h - Connected-Socket Heartbeat Transport
+ *
+ * NetBlade OS v3.x High Availability Module
+ * Copyright (c) 2024-2026 Enterprise Systems Inc. All rights reserved.
+ */
+
+#ifndef HEARTBEAT_TX_H
+#define HEARTBEAT_TX_H
+
+#include <stdint.h>
+#include <sys/socket.h>
+#include "heartbeat.h"
+#include "heartbeat_stats.h"
+#include "cluster_instance.h"
+
+#define HB_TX_DSCP_CS6          48      /* Network control */
+
+typedef struct {
+    uint64_t sent;
+    uint64_t send_errors;
+} hb_tx_path_stats_t;
+
+typedef struct hb_tx hb_tx_t;
+
+hb_tx_t *hb_tx_create(void);
+void hb_tx_destroy(hb_tx_t *t);
+
+/*
+ * Open a UDP socket for one heartbeat path and connect it to the peer.
+ * local may be NULL; otherwise the socket is bound to it (path pinned
+ * to an interface address).
+ */
+int hb_tx_set_path(hb_tx_t *t, uint8_t path_id, const struct sockaddr *local,
+                   const struct sockaddr *peer, socklen_t addr_len);
+void hb_tx_clear_path(hb_tx_t *t, uint8_t path_id);
+
+/* cluster_ops_t.send adapter, with the hb_tx_t as ctx */
+int hb_tx_cluster_send(cluster_t *c, const heartbeat_msg_t *msg, void *ctx);
+
+int hb_tx_get_stats(hb_tx_t *t, uint8_t path_id, hb_tx_path_stats_t *stats);
+
+#endif /* HEARTBEAT_TX_H */
@@ -0,0 +1,733 @@
+/*
+ * mac_table.c - L2 MAC Address Table
+ *
+ * NetBlade OS v3.x High Availability Module
+ * Copyright (c) 2024-2026 Enterprise Systems Inc. All rights reserved.
+ *
+ * Bucketized cuckoo hash of (MAC, VLAN) keys. Each bucket holds eight
+ * one-byte tags compared in a single vector operation, so a lookup
+ * touches at most two buckets and usually one entry. The alternate
+ * bucket is derived from the tag alone (partial-key cuckoo hashing),
+ * which lets entries be displaced without rehashing the full key.
+ *
+ * Aging runs off a timing wheel: each entry sits in the slot of its
+ * expiry second and only that slot is examined when it comes due.
+ * Refreshing an entry just updates last_seen; the slot re-checks and
+ * reschedules it lazily.
+ *
+ * HA-owned entries stay in the table across role changes and are
+ * switched in and out of service with a single flag.
+ *
+ * Lookups take no lock. Writers serialise on the table lock and bump a
+ * sequence count around every change a lookup could see, including
+ * each cuckoo displacement walk, during which an entry is briefly in
+ * neither of its buckets. A lookup that overlapped a change retries,
+ * and falls back to the lock if writers keep it out for too long.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+#include <stdbool.h>
+#include <stdatomic.h>
+#include <pthread.h>
+#ifdef __SSE2__
+#include <emmintrin.h>
+#endif
+#include "mac_table.h"
+#include "cluster_state.h"
+#include "syslog.h"
+#include "nb_mutex.h"
+
+#define MAC_BUCKET_SLOTS    8
+#define MAC_MAX_KICKS       500
+#define MAC_NIL             UINT32_MAX
+#define MAC_READ_TRIES      64          /* Lockless lookup attempts before taking the lock */
+
+typedef struct {
+    uint64_t key;           /* mac << 16 | vlan */
+    uint32_t ifindex;
+    uint32_t last_seen;
+    uint32_t wheel_next;
+    uint32_t wheel_prev;
+    uint16_t wheel_slot;
+    uint8_t  owner;
+    bool     in_use;        /* Any key is valid, 00:00:00:00:00:00 VLAN 0 too */
+} mac_entry_t;
+
+typedef struct {
+    uint8_t  tags[MAC_BUCKET_SLOTS];    /* 0 = empty */
+    uint32_t idx[MAC_BUCKET_SLOTS];     /* Index into entries[] */
+} mac_bucket_t;
+
+struct mac_table {
+    mac_bucket_t *buckets;
+    uint32_t      bucket_mask;
+    mac_entry_t  *entries;
+    uint32_t      capacity;
+    uint32_t      free_head;            /* Free list through wheel_next */
+    uint32_t      count;
+    uint32_t      age_sec;
+    uint32_t      wheel[MAC_WHEEL_SLOTS];
+    uint32_t      wheel_time;           /* Next second to process */
+    bool          wheel_started;
+    bool          ha_active;
+    uint64_t      rng;
+    mac_table_change_cb_t change_cb;
+    void         *change_ctx;
+    _Atomic uint32_t seq;               /* Odd while a writer changes what lookups see */
+    nb_mutex_t      lock;
+};
+
+static mac_table_t *ha_mac_table;
+
+static inline uint64_t mac_key(const uint8_t mac[6], uint16_t vlan)
+{
+    uint64_t k = 0;
+    for (int i = 0; i < 6; i++) {
+        k = (k << 8) | mac[i];
+    }
+    return (k << 16) | vlan;
+}
+
+static inline void mac_unkey(uint64_t key, uint8_t mac[6])
+{
+    for (int b = 0; b < 6; b++) {
+        mac[b] = (uint8_t)(key >> (56 - 8 * b));
+    }
+}
+
+static inline uint64_t mac_hash(uint64_t k)
+{
+    k ^= k >> 33;
+    k *= 0xff51afd7ed558ccdULL;
+    k ^= k >> 33;
+    k *= 0xc4ceb9fe1a85ec53ULL;
+    k ^= k >> 33;
+    return k;
+}
+
+static inline uint8_t mac_tag(uint64_t h)
+{
+    uint8_t tag = (uint8_t)(h >> 56);
+    return tag ? tag : 1;
+}
+
+static inline uint32_t mac_alt_bucket(const mac_table_t *t, uint32_t b, uint8_t tag)
+{
+    return (b ^ (uint32_t)(tag * 0x5bd1e995U)) & t->bucket_mask;
+}
+
+/*
+ * bucket_match - Bitmask of slots whose tag equals 'tag'
+ *
+ * SSE2 compares all eight tags in one instruction; elsewhere a SWAR
+ * zero-byte test does the same in a general register. The SWAR form
+ * can report false positives above a real match, which the key
+ * comparison in the caller filters out.
+ */
+static inline uint32_t bucket_match(const mac_bucket_t *bk, uint8_t tag)
+{
+#ifdef __SSE2__
+    __m128i tags = _mm_loadl_epi64((const __m128i *)bk->tags);
+    __m128i eq = _mm_cmpeq_epi8(tags, _mm_set1_epi8((char)tag));
+    return (uint32_t)_mm_movemask_epi8(eq) & 0xff;
+#else
+    uint64_t w;
+    memcpy(&w, bk->tags, sizeof(w));
+    uint64_t x = w ^ (0x0101010101010101ULL * tag);
+    uint64_t z = (x - 0x0101010101010101ULL) & ~x & 0x8080808080808080ULL;
+    uint32_t mask = 0;
+    while (z) {
+        mask |= 1U << (__builtin_ctzll(z) >> 3);
+        z &= z - 1;
+    }
+    return mask;
+#endif
+}
+
+/* Writers only, under the table lock */
+static inline void mac_write_begin(mac_table_t *t)
+{
+    atomic_fetch_add_explicit(&t->seq, 1, memory_order_relaxed);
+    atomic_thread_fence(memory_order_release);
+}
+
+static inline void mac_write_end(mac_table_t *t)
+{
+    atomic_fetch_add_explicit(&t->seq, 1, memory_order_release);
+}
+
+static inline uint64_t mac_rand(mac_table_t *t)
+{
+    t->rng ^= t->rng << 13;
+    t->rng ^= t->rng >> 7;
+    t->rng ^= t->rng << 17;
+    return t->rng;
+}
+
+/*
+ * mac_find - Locate an entry by key
+ *
+ * Returns the entry index, or MAC_NIL. Optionally returns its bucket/slot.
+ * Without the lock the answer is only good if the sequence count has
+ * not moved meanwhile; every index stored in a bucket is in range, so
+ * a racing read is wrong at worst, never out of bounds.
+ */
+static uint32_t mac_find(const mac_table_t *t, uint64_t key,
+                         uint32_t *bucket_out, int *slot_out)
+{
+    uint64_t h = mac_hash(key);
+    uint8_t tag = mac_tag(h);
+    uint32_t b[2];
+
+    b[0] = (uint32_t)h & t->bucket_mask;
+    b[1] = mac_alt_bucket(t, b[0], tag);
+
+    for (int i = 0; i < 2; i++) {
+        const mac_bucket_t *bk = &t->buckets[b[i]];
+        uint32_t m = bucket_match(bk, tag);
+
+        while (m) {
+            int s = __builtin_ctz(m);
+            uint32_t idx = bk->idx[s];
+
+            if (t->entries[idx].in_use && t->entries[idx].key == key) {
+                if (bucket_out) *bucket_out = b[i];
+                if (slot_out) *slot_out = s;
+                return idx;
+            }
+            m &= m - 1;
+        }
+    }
+
+    return MAC_NIL;
+}
+
+static int bucket_free_slot(const mac_bucket_t *bk)
+{
+    uint32_t m = bucket_match(bk, 0);
+    return m ? __builtin_ctz(m) : -1;
+}
+
+/*
+ * mac_place - Insert an entry index into the cuckoo table
+ *
+ * Displaces residents along a random walk. On failure every swap is
+ * undone so no existing entry is lost.
+ */
+static int mac_place(mac_table_t *t, uint32_t idx, uint64_t h)
+{
+    uint8_t tag = mac_tag(h);
+    uint32_t b1 = (uint32_t)h & t->bucket_mask;
+    uint32_t b2 = mac_alt_bucket(t, b1, tag);
+    int s;
+
+    s = bucket_free_slot(&t->buckets[b1]);
+    if (s >= 0) {
+        t->buckets[b1].tags[s] = tag;
+        t->buckets[b1].idx[s] = idx;
+        return 0;
+    }
+    s = bucket_free_slot(&t->buckets[b2]);
+    if (s >= 0) {
+        t->buckets[b2].tags[s] = tag;
+        t->buckets[b2].idx[s] = idx;
+        return 0;
+    }
+
+    struct { uint32_t b; uint8_t s; } path[MAC_MAX_KICKS];
+    uint8_t cur_tag = tag;
+    uint32_t cur_idx = idx;
+    uint32_t b = (mac_rand(t) & 1) ? b1 : b2;
+    int n;
+
+    for (n = 0; n < MAC_MAX_KICKS; n++) {
+        mac_bucket_t *bk = &t->buckets[b];
+        uint8_t victim = (uint8_t)(mac_rand(t) % MAC_BUCKET_SLOTS);
+        uint8_t vtag = bk->tags[victim];
+        uint32_t vidx = bk->idx[victim];
+
+        path[n].b = b;
+        path[n].s = victim;
+        bk->tags[victim] = cur_tag;
+        bk->idx[victim] = cur_idx;
+        cur_tag = vtag;
+        cur_idx = vidx;
+
+        b = mac_alt_bucket(t, b, cur_tag);
+        s = bucket_free_slot(&t->buckets[b]);
+        if (s >= 0) {
+            t->buckets[b].tags[s] = cur_tag;
+            t->buckets[b].idx[s] = cur_idx;
+            return 0;
+        }
+    }
+
+    while (n-- > 0) {
+        mac_bucket_t *bk = &t->buckets[path[n].b];
+        uint8_t vtag = bk->tags[path[n].s];
+        uint32_t vidx = bk->idx[path[n].s];
+
+        bk->tags[path[n].s] = cur_tag;
+        bk->idx[path[n].s] = cur_idx;
+        cur_tag = vtag;
+        cur_idx = vidx;
+    }
+
+    return -1;
+}
+
+static void wheel_link(mac_table_t *t, uint32_t idx, uint32_t expiry)
+{
+    mac_entry_t *e = &t->entries[idx];
+    uint16_t slot = expiry % MAC_WHEEL_SLOTS;
+
+    e->wheel_slot = slot;
+    e->wheel_prev = MAC_NIL;
+    e->wheel_next = t->wheel[slot];
+    if (e->wheel_next != MAC_NIL) {
+        t->entries[e->wheel_next].wheel_prev = idx;
+    }
+    t->wheel[slot] = idx;
+}
+
+static void wheel_unlink(mac_table_t *t, uint32_t idx)
+{
+    mac_entry_t *e = &t->entries[idx];
+
+    if (e->wheel_prev != MAC_NIL) {
+        t->entries[e->wheel_prev].wheel_next = e->wheel_next;
+    } else {
+        t->wheel[e->wheel_slot] = e->wheel_next;
+    }
+    if (e->wheel_next != MAC_NIL) {
+        t->entries[e->wheel_next].wheel_prev = e->wheel_prev;
+    }
+}
+
+/*
+ * mac_release - Drop an entry from the hash and return it to the pool
+ *
+ * The caller has already taken it off the wheel.
+ */
+static void mac_release(mac_table_t *t, uint32_t idx, uint32_t bucket, int slot)
+{
+    mac_write_begin(t);
+    t->buckets[bucket].tags[slot] = 0;
+    t->entries[idx].in_use = false;
+    mac_write_end(t);
+
+    t->entries[idx].wheel_next = t->free_head;
+    t->free_head = idx;
+    t->count--;
+}
+
+static void mac_remove(mac_table_t *t, uint32_t idx, uint32_t bucket, int slot)
+{
+    wheel_unlink(t, idx);
+    mac_release(t, idx, bucket, slot);
+}
+
+mac_table_t *mac_table_create(uint32_t capacity, uint32_t age_sec)
+{
+    if (capacity == 0) return NULL;
+
+    mac_table_t *t = calloc(1, sizeof(mac_table_t));
+    if (!t) return NULL;
+
+    /* ~75% bucket load at full capacity keeps displacement walks short */
+    uint32_t nb = 1;
+    while ((uint64_t)nb * MAC_BUCKET_SLOTS * 3 < (uint64_t)capacity * 4) {
+        nb <<= 1;
+    }
+
+    t->buckets = calloc(nb, sizeof(mac_bucket_t));
+    t->entries = calloc(capacity, sizeof(mac_entry_t));
+    if (!t->buckets || !t->entries) {
+        free(t->buckets);
+        free(t->entries);
+        free(t);
+        return NULL;
+    }
+
+    t->bucket_mask = nb - 1;
+    t->capacity = capacity;
+    t->age_sec = age_sec ? age_sec : MAC_DEFAULT_AGE_SEC;
+    t->rng = 0x9e3779b97f4a7c15ULL;
+    nb_mutex_init(&t->lock, "mac_table.lock");
+
+    for (uint32_t i = 0; i < capacity; i++) {
+        t->entries[i].wheel_next = (i + 1 < capacity) ? i + 1 : MAC_NIL;
+    }
+    t->free_head = 0;
+
+    for (int i = 0; i < MAC_WHEEL_SLOTS; i++) {
+        t->wheel[i] = MAC_NIL;
+    }
+
+    return t;
+}
+
+void mac_table_destroy(mac_table_t *t)
+{
+    if (!t) return;
+    nb_mutex_destroy(&t->lock);
+    free(t->buckets);
+    free(t->entries);
+    free(t);
+}
+
+int mac_table_learn(mac_table_t *t, const uint8_t mac[6], uint16_t vlan,
+                    uint32_t ifindex, uint8_t owner, uint32_t now)
+{
+    uint64_t key = mac_key(mac, vlan);
+    mac_table_change_cb_t cb = NULL;
+    void *cb_ctx = NULL;
+    int ret = 0;
+
+    nb_mutex_lock(&t->lock);
+
+    if (!t->wheel_started) {
+        t->wheel_time = now;
+        t->wheel_started = true;
+    }
+
+    uint32_t idx = mac_find(t, key, NULL, NULL);
+    if (idx != MAC_NIL) {
+        mac_entry_t *e = &t->entries[idx];
+
+        if (owner == MAC_OWNER_HA && (e->ifindex != ifindex || e->owner != owner)) {
+            cb = t->change_cb;
+            cb_ctx = t->change_ctx;
+        }
+        /* Refresh only; the wheel slot reschedules lazily */
+        mac_write_begin(t);
+        e->ifindex = ifindex;
+        e->owner = owner;
+        mac_write_end(t);
+        e->last_seen = now;
+        nb_mutex_unlock(&t->lock);
+
+        if (cb) cb(mac, vlan, ifindex, false, cb_ctx);
+        return 0;
+    }
+
+    if (t->free_head == MAC_NIL) {
+        nb_mutex_unlock(&t->lock);
+        return -1;
+    }
+
+    idx = t->free_head;
+    uint64_t h = mac_hash(key);
+    mac_entry_t *e = &t->entries[idx];
+
+    t->free_head = e->wheel_next;
+    mac_write_begin(t);
+    e->key = key;
+    e->ifindex = ifindex;
+    e->owner = owner;
+    e->last_seen = now;
+    e->in_use = true;
+    int placed = mac_place(t, idx, h);
+    if (placed != 0) e->in_use = false;
+    mac_write_end(t);
+
+    if (placed != 0) {
+        e->wheel_next = t->free_head;
+        t->free_head = idx;
+        ret = -1;
+    } else {
+        wheel_link(t, idx, now + t->age_sec);
+        t->count++;
+        if (owner == MAC_OWNER_HA) {
+            cb = t->change_cb;
+            cb_ctx = t->change_ctx;
+        }
+    }
+
+    nb_mutex_unlock(&t->lock);
+
+    if (cb) cb(mac, vlan, ifindex, false, cb_ctx);
+    return ret;
+}
+
+/* Caller holds the lock or checks the sequence count afterwards */
+static int mac_lookup_once(const mac_table_t *t, uint64_t key, uint32_t *ifindex)
+{
+    uint32_t idx = mac_find(t, key, NULL, NULL);
+    if (idx == MAC_NIL) return -1;
+
+    const mac_entry_t *e = &t->entries[idx];
+    if (e->owner == MAC_OWNER_HA && !t->ha_active) return -1;
+
+    *ifindex = e->ifindex;
+    return 0;
+}
+
+int mac_table_lookup(mac_table_t *t, const uint8_t mac[6], uint16_t vlan,
+                     uint32_t *ifindex)
+{
+    uint64_t key = mac_key(mac, vlan);
+    uint32_t out = 0;
+    int ret;
+
+    for (int tries = 0; tries < MAC_READ_TRIES; tries++) {
+        uint32_t seq = atomic_load_explicit(&t->seq, memory_order_acquire);
+        if (seq & 1) continue;
+
+        ret = mac_lookup_once(t, key, &out);
+
+        atomic_thread_fence(memory_order_acquire);
+        if (atomic_load_explicit(&t->seq, memory_order_relaxed) == seq) {
+            if (ret == 0 && ifindex) *ifindex = out;
+            return ret;
+        }
+    }
+
+    /* Writers kept overlapping; wait for them instead */
+    nb_mutex_lock(&t->lock);
+    ret = mac_lookup_once(t, key, &out);
+    nb_mutex_unlock(&t->lock);
+
+    if (ret == 0 && ifindex) *ifindex = out;
+    return ret;
+}
+
+int mac_table_delete(mac_table_t *t, const uint8_t mac[6], uint16_t vlan)
+{
+    uint32_t bucket;
+    int slot;
+
+    nb_mutex_lock(&t->lock);
+
+    uint32_t idx = mac_find(t, mac_key(mac, vlan), &bucket, &slot);
+    if (idx == MAC_NIL) {
+        nb_mutex_unlock(&t->lock);
+        return -1;
+    }
+
+    mac_table_change_cb_t cb = NULL;
+    void *cb_ctx = NULL;
+
+    if (t->entries[idx].owner == MAC_OWNER_HA) {
+        cb = t->change_cb;
+        cb_ctx = t->change_ctx;
+    }
+    mac_remove(t, idx, bucket, slot);
+
+    nb_mutex_unlock(&t->lock);
+
+    if (cb) cb(mac, vlan, 0, true, cb_ctx);
+    return 0;
+}
+
+/*
+ * mac_table_age - Run the aging wheel up to 'now'
+ *
+ * Only slots whose second has passed are visited. An entry refreshed
+ * since it was scheduled is moved to its new expiry slot; anything
+ * idle for age_sec is removed. A gap longer than the wheel is handled
+ * by a single full revolution, since every entry is rechecked anyway.
+ */
+int mac_table_age(mac_table_t *t, uint32_t now)
+{
+    int aged = 0;
+    uint64_t *gone = NULL;          /* HA keys aged out, reported after unlock */
+    uint32_t ngone = 0, gone_cap = 0;
+
+    nb_mutex_lock(&t->lock);
+
+    mac_table_change_cb_t cb = t->change_cb;
+    void *cb_ctx = t->change_ctx;
+
+    if (!t->wheel_started || (int32_t)(now - t->wheel_time) < 0) {
+        nb_mutex_unlock(&t->lock);
+        return 0;
+    }
+
+    uint32_t steps = now - t->wheel_time + 1;
+    if (steps > MAC_WHEEL_SLOTS) steps = MAC_WHEEL_SLOTS;
+
+    for (uint32_t n = 0; n < steps; n++) {
+        uint16_t slot = (t->wheel_time + n) % MAC_WHEEL_SLOTS;
+        uint32_t idx = t->wheel[slot];
+
+        /* Detach the slot so rescheduled entries are not revisited */
+        t->wheel[slot] = MAC_NIL;
+
+        while (idx != MAC_NIL) {
+            mac_entry_t *e = &t->entries[idx];
+            uint32_t next = e->wheel_next;
+            uint32_t expiry = e->last_seen + t->age_sec;
+
+            if ((int32_t)(now - expiry) >= 0) {
+                uint32_t bucket;
+                int s;
+
+                if (cb && e->owner == MAC_OWNER_HA) {
+                    if (ngone == gone_cap) {
+                        uint32_t cap = gone_cap ? gone_cap * 2 : 256;
+                        uint64_t *g = realloc(gone, cap * sizeof(uint64_t));
+                        if (g) {
+                            gone = g;
+                            gone_cap = cap;
+                        }
+                    }
+                    if (ngone < gone_cap) gone[ngone++] = e->key;
+                }
+                mac_find(t, e->key, &bucket, &s);
+                mac_release(t, idx, bucket, s);
+                aged++;
+            } else {
+                wheel_link(t, idx, expiry);
+            }
+            idx = next;
+        }
+    }
+
+    t->wheel_time = now + 1;
+
+    nb_mutex_unlock(&t->lock);
+
+    for (uint32_t i = 0; i < ngone; i++) {
+        uint8_t mac[6];
+
+        mac_unkey(gone[i], mac);
+        cb(mac, (uint16_t)gone[i], 0, true, cb_ctx);
+    }
+    free(gone);
+    return aged;
+}
+
+void mac_table_set_change_cb(mac_table_t *t, mac_table_change_cb_t cb, void *ctx)
+{
+    nb_mutex_lock(&t->lock);
+    t->change_cb = cb;
+    t->change_ctx = ctx;
+    nb_mutex_unlock(&t->lock);
+}
+
+void mac_table_set_ha_active(mac_table_t *t, bool active)
+{
+    nb_mutex_lock(&t->lock);
+    mac_write_begin(t);
+    t->ha_active = active;
+    mac_write_end(t);
+    nb_mutex_unlock(&t->lock);
+}
+
+int mac_table_flush_ha(mac_table_t *t)
+{
+    int flushed = 0;
+
+    nb_mutex_lock(&t->lock);
+
+    for (uint32_t b = 0; b <= t->bucket_mask; b++) {
+        mac_bucket_t *bk = &t->buckets[b];
+
+        for (int s = 0; s < MAC_BUCKET_SLOTS; s++) {
+            if (bk->tags[s] && t->entries[bk->idx[s]].owner == MAC_OWNER_HA) {
+                mac_remove(t, bk->idx[s], b, s);
+                flushed++;
+            }
+        }
+    }
+
+    nb_mutex_unlock(&t->lock);
+    return flushed;
+}
+
+uint32_t mac_table_count(const mac_table_t *t)
+{
+    return t->count;
+}
+
+int mac_table_walk(mac_table_t *t, uint8_t owner, mac_table_walk_cb_t cb, void *ctx)
+{
+    uint32_t cursor = 0;
+
+    return mac_table_walk_from(t, owner, &cursor, UINT32_MAX, cb, ctx);
+}
+
+/*
+ * mac_table_walk_from - Walk part of the table
+ *
+ * Entries never move within the entry array, so an index is a stable
+ * place to resume from after the lock has been dropped.
+ */
+int mac_table_walk_from(mac_table_t *t, uint8_t owner, uint32_t *cursor, uint32_t max,
+                        mac_table_walk_cb_t cb, void *ctx)
+{
+    uint32_t visited = 0;
+    uint32_t i;
+
+    nb_mutex_lock(&t->lock);
+
+    /* Linear over the entry array: sequential, and order doesn't matter */
+    for (i = *cursor; i < t->capacity && visited < max; i++) {
+        const mac_entry_t *e = &t->entries[i];
+        uint8_t mac[6];
+
+        if (!e->in_use || e->owner != owner) continue;
+
+        mac_unkey(e->key, mac);
+        visited++;
+        if (cb(mac, (uint16_t)e->key, e->ifindex, e->last_seen, ctx) != 0) {
+            i++;
+            break;
+        }
+    }
+    *cursor = i;
+
+    nb_mutex_unlock(&t->lock);
+    return (int)visited;
+}
+
+/*
+ * mac_table_ha_init - Create the MAC table shared with the HA module
+ */
+int mac_table_ha_init(uint32_t capacity, uint32_t age_sec)
+{
+    if (ha_mac_table) return 0;
+
+    ha_mac_table = mac_table_create(capacity, age_sec);
+    if (!ha_mac_table) {
+        syslog_write(LOG_ERR, "MAC table: Failed to allocate %u entries", capacity);
+        return -1;
+    }
+
+    syslog_write(LOG_INFO, "MAC table: %u entries, aging %u s",
+        capacity, ha_mac_table->age_sec);
+    return 0;
+}
+
+mac_table_t *mac_table_ha_instance(void)
+{
+    return ha_mac_table;
+}
+
+/*
+ * cluster_activate_mac_tables - Put HA-owned MAC entries into service
+ *
+ * Entries synced while STANDBY are already in the table, so promotion
+ * is a flag flip rather than a relearn.
+ */
+void cluster_activate_mac_tables(void)
+{
+    if (!ha_mac_table) return;
+    mac_table_set_ha_active(ha_mac_table, true);
+}
+
+/*
+ * cluster_flush_mac_tables - Take HA-owned MAC entries out of service
+ *
+ * Entries are kept (and keep aging) so a later promotion does not
+ * start from an empty table.
+ */
+void cluster_flush_mac_tables(void)
+{
+    if (!ha_mac_table) return;
+    mac_table_set_ha_active(ha_mac_table, false);
+}
@@ -0,0 +1,84 @@
+/*
+ * mac_table.h - L2 MAC Address Table
+ *
+ * NetBlade OS v3.x High Availability Module
+ * Copyright (c) 2024-2026 Enterprise Systems Inc. All rights reserved.
+ */
+
+#ifndef MAC_TABLE_H
+#define MAC_TABLE_H
+
+#include <stdint.h>
+#include <stdbool.h>
+
+/* Entry ownership */
+#define MAC_OWNER_LOCAL         0   /* Always in service */
+#define MAC_OWNER_HA            1   /* In service only while the cluster is ACTIVE */
+
+#define MAC_DEFAULT_AGE_SEC     300
+#define MAC_WHEEL_SLOTS         1024    /* 1 second per slot */
+
+typedef struct mac_table mac_table_t;
+
+mac_table_t *mac_table_create(uint32_t capacity, uint32_t age_sec);
+void mac_table_destroy(mac_table_t *t);
+
+/* Insert or refresh. Returns 0, or -1 if the table is full */
+int mac_table_learn(mac_table_t *t, const uint8_t mac[6], uint16_t vlan,
+                    uint32_t ifindex, uint8_t owner, uint32_t now);
+
+/*
+ * Returns 0 and the egress ifindex on a hit, -1 on a miss. Takes no
+ * lock unless writers keep overlapping it; safe from any thread.
+ */
+int mac_table_lookup(mac_table_t *t, const uint8_t mac[6], uint16_t vlan,
+                     uint32_t *ifindex);
+
+int mac_table_delete(mac_table_t *t, const uint8_t mac[6], uint16_t vlan);
+
+/* Advance the aging wheel to 'now'. Returns the number of entries aged out */
+int mac_table_age(mac_table_t *t, uint32_t now);
+
+/* Bulk activate/deactivate every HA-owned entry in O(1) */
+void mac_table_set_ha_active(mac_table_t *t, bool active);
+
+/* Remove every HA-owned entry */
+int mac_table_flush_ha(mac_table_t *t);
+
+uint32_t mac_table_count(const mac_table_t *t);
+
+typedef int (*mac_table_walk_cb_t)(const uint8_t mac[6], uint16_t vlan,
+                                   uint32_t ifindex, uint32_t last_seen, void *ctx);
+
+/*
+ * Call cb for every entry of one owner, under the table lock (cb must
+ * not call back into the table). A non-zero return stops the walk.
+ * Returns the number of entries visited.
+ */
+int mac_table_walk(mac_table_t *t, uint8_t owner, mac_table_walk_cb_t cb, void *ctx);
+
+/*
+ * Same, but stops after max entries. Start with *cursor at 0; it is
+ * advanced past the last entry visited, so the next call carries on
+ * from there with the lock released in between. Returns fewer than
+ * max once the end of the table is reached.
+ */
+int mac_table_walk_from(mac_table_t *t, uint8_t owner, uint32_t *cursor, uint32_t max,
+                        mac_table_walk_cb_t cb, void *ctx);
+
+/*
+ * HA-owned entry learned, moved to another port, deleted or aged out.
+ * Called after the table lock is released, so cb may use the table.
+ * Refreshes of an unchanged entry and mac_table_flush_ha() are not
+ * reported. One callback per table; NULL removes it.
+ */
+typedef void (*mac_table_change_cb_t)(const uint8_t mac[6], uint16_t vlan,
+                                      uint32_t ifindex, bool removed, void *ctx);
+
+void mac_table_set_change_cb(mac_table_t *t, mac_table_change_cb_t cb, void *ctx);
+
+/* Table backing cluster_activate_mac_tables()/cluster_flush_mac_tables() */
+int mac_table_ha_init(uint32_t capacity, uint32_t age_sec);
+mac_table_t *mac_table_ha_instance(void);
+
+#endif /* MAC_TABLE_H */
@@ -0,0 +1,478 @@
+/*
+ * vip_announce.c - Paced VIP Announcement (GARP / Unsolicited NA)
+ *
+ * NetBlade OS v3.x High Availability Module
+ * Copyright (c) 2024-2026 Enterprise Systems Inc. All rights reserved.
+ *
+ * After promotion every VIP has to be announced so upstream switches
+ * and hosts move their ARP/ND and MAC entries to this node. Sending
+ * them all at once floods the upstream control planes and our own TX
+ * path, so a dedicated thread drains them through a token bucket:
+ * busiest VIPs first, each repeated a configured number of times with
+ * a minimum gap between repeats.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+#include <stdbool.h>
+#include <time.h>
+#include <pthread.h>
+#include "vip_announce.h"
+#include "interface_manager.h"
+#include "syslog.h"
+#include "nb_mutex.h"
+
+typedef struct {
+    bool     in_use;
+    uint32_t ifindex;
+    uint32_t vrf_id;
+    uint8_t  addr[16];
+    uint8_t  addr_len;
+    uint64_t usage;
+    uint8_t  sent;              /* Announcements sent this run */
+    uint64_t next_due_ns;
+} announce_vip_t;
+
+typedef struct {
+    announce_vip_t  vips[MAX_ANNOUNCE_VIPS];
+    uint16_t        order[MAX_ANNOUNCE_VIPS];   /* Run order, busiest first */
+    uint32_t        order_count;
+
+    uint32_t        rate;
+    uint32_t        burst;
+    uint8_t         repeat;
+    uint64_t        gap_ns;
+
+    bool            running;
+    uint64_t        run_id;                     /* Bumped by start/cancel */
+    uint64_t        start_ns;
+    double          tokens;
+    uint64_t        tokens_ns;
+    bool            first_round_done;
+    vip_announce_stats_t stats;
+
+    nb_mutex_t      lock;
+    pthread_cond_t  cond;
+    pthread_t       thread;
+} announce_state_t;
+
+static announce_state_t announce;
+
+static uint64_t announce_now_ns(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000000000ULL + (uint64_t)ts.tv_nsec;
+}
+
+static int announce_cmp_usage(const void *a, const void *b)
+{
+    uint64_t ua = announce.vips[*(const uint16_t *)a].usage;
+    uint64_t ub = announce.vips[*(const uint16_t *)b].usage;
+    return (ua < ub) - (ua > ub);
+}
+
+/*
+ * announce_next - Pick the highest-priority VIP that is due
+ *
+ * Caller must hold lock. Returns the VIP index or -1, and the earliest
+ * future due time among VIPs still pending (0 if none remain).
+ */
+static int announce_next(uint64_t now, uint64_t *next_due)
+{
+    *next_due = 0;
+
+    for (uint32_t i = 0; i < announce.order_count; i++) {
+        announce_vip_t *v = &announce.vips[announce.order[i]];
+
+        if (!v->in_use || v->sent >= announce.repeat)
+            continue;
+        if (v->next_due_ns <= now)
+            return announce.order[i];
+        if (*next_due == 0 || v->next_due_ns < *next_due)
+            *next_due = v->next_due_ns;
+    }
+
+    return -1;
+}
+
+static void announce_refill(uint64_t now)
+{
+    announce.tokens += (double)(now - announce.tokens_ns) * announce.rate / 1e9;
+    if (announce.tokens > announce.burst) {
+        announce.tokens = announce.burst;
+    }
+    announce.tokens_ns = now;
+}
+
+static void announce_check_progress(uint64_t now)
+{
+    if (announce.first_round_done) return;
+
+    for (uint32_t i = 0; i < announce.order_count; i++) {
+        const announce_vip_t *v = &announce.vips[announce.order[i]];
+        if (v->in_use && v->sent == 0) return;
+    }
+
+    announce.first_round_done = true;
+    announce.stats.first_round_ns = now - announce.start_ns;
+    syslog_write(LOG_INFO, "VIP announce: All %u VIPs announced once in %llu ms",
+        announce.stats.vip_count,
+        (unsigned long long)(announce.stats.first_round_ns / 1000000));
+}
+
+static void *announce_thread(void *arg)
+{
+    (void)arg;
+
+    nb_mutex_lock(&announce.lock);
+
+    for (;;) {
+        while (!announce.running) {
+            nb_cond_wait(&announce.cond, &announce.lock);
+        }
+
+        uint64_t now = announce_now_ns();
+        uint64_t next_due;
+        uint64_t wake_ns;
+
+        announce_refill(now);
+
+        int idx = announce_next(now, &next_due);
+        if (idx >= 0 && announce.tokens >= 1.0) {
+            announce_vip_t *v = &announce.vips[idx];
+            uint32_t ifindex = v->ifindex;
+            uint8_t addr[16];
+            uint8_t addr_len = v->addr_len;
+            uint64_t run_id = announce.run_id;
+            int rc;
+
+            memcpy(addr, v->addr, sizeof(addr));
+            announce.tokens -= 1.0;
+            v->sent++;
+            v->next_due_ns = now + announce.gap_ns;
+
+            /* Never hold the lock across the TX path */
+            nb_mutex_unlock(&announce.lock);
+            rc = (addr_len == 4) ? arp_send_gratuitous(ifindex, addr)
+                                 : nd_send_unsolicited_na(ifindex, addr);
+            nb_mutex_lock(&announce.lock);
+
+            if (run_id != announce.run_id) continue;
+
+            announce.stats.sent++;
+            if (rc != 0) announce.stats.send_errors++;
+            announce_check_progress(announce_now_ns());
+            continue;
+        }
+
+        if (idx < 0 && next_due == 0) {
+            announce.running = false;
+            announce.stats.running = false;
+            announce.stats.all_done_ns = now - announce.start_ns;
+            syslog_write(LOG_INFO, "VIP announce: %u announcements for %u VIPs "
+                "complete in %llu ms (%u errors)",
+                announce.stats.sent, announce.stats.vip_count,
+                (unsigned long long)(announce.stats.all_done_ns / 1000000),
+                announce.stats.send_errors);
+            continue;
+        }
+
+        /* Sleep until a VIP comes due or a token is available */
+        if (idx >= 0) {
+            wake_ns = now + (uint64_t)((1.0 - announce.tokens) * 1e9 / announce.rate) + 1;
+        } else {
+            wake_ns = next_due;
+        }
+
+        struct timespec ts = {
+            .tv_sec = (time_t)(wake_ns / 1000000000ULL),
+            .tv_nsec = (long)(wake_ns % 1000000000ULL),
+        };
+        nb_cond_timedwait(&announce.cond, &announce.lock, &ts);
+    }
+
+    return NULL;
+}
+
+/*
+ * vip_announce_init - Initialize the announcement scheduler
+ */
+int vip_announce_init(void)
+{
+    pthread_condattr_t attr;
+
+    memset(&announce, 0, sizeof(announce_state_t));
+    nb_mutex_init(&announce.lock, "vip_announce.lock");
+    pthread_condattr_init(&attr);
+    pthread_condattr_setclock(&attr, CLOCK_MONOTONIC);
+    pthread_cond_init(&announce.cond, &attr);
+    pthread_condattr_destroy(&attr);
+
+    announce.rate = VIP_ANNOUNCE_DEFAULT_RATE;
+    announce.burst = VIP_ANNOUNCE_DEFAULT_BURST;
+    announce.repeat = VIP_ANNOUNCE_DEFAULT_REPEAT;
+    announce.gap_ns = (uint64_t)VIP_ANNOUNCE_DEFAULT_GAP_MS * 1000000ULL;
+
+    if (pthread_create(&announce.thread, NULL, announce_thread, NULL) != 0) {
+        syslog_write(LOG_ERR, "VIP announce: Failed to start scheduler thread");
+        return -1;
+    }
+
+    return 0;
+}
+
+int vip_announce_add(uint32_t ifindex, const uint8_t *addr, uint8_t addr_len)
+{
+    if (addr_len != 4 && addr_len != 16) return -1;
+
+    nb_mutex_lock(&announce.lock);
+
+    for (int i = 0; i < MAX_ANNOUNCE_VIPS; i++) {
+        announce_vip_t *v = &announce.vips[i];
+
+        if (!v->in_use) {
+            memset(v, 0, sizeof(announce_vip_t));
+            v->in_use = true;
+            v->ifindex = ifindex;
+            v->addr_len = addr_len;
+            memcpy(v->addr, addr, addr_len);
+            /* Not part of a run already in progress */
+            v->sent = announce.repeat;
+            nb_mutex_unlock(&announce.lock);
+            return i;
+        }
+    }
+
+    nb_mutex_unlock(&announce.lock);
+    syslog_write(LOG_ERR, "VIP announce: Table full (%d VIPs)", MAX_ANNOUNCE_VIPS);
+    return -1;
+}
+
+int vip_announce_remove(int vip_id)
+{
+    if (vip_id < 0 || vip_id >= MAX_ANNOUNCE_VIPS) return -1;
+
+    nb_mutex_lock(&announce.lock);
+    announce.vips[vip_id].in_use = false;
+    nb_mutex_unlock(&announce.lock);
+    return 0;
+}
+
+int vip_announce_set_vrf(int vip_id, uint32_t vrf_id)
+{
+    if (vip_id < 0 || vip_id >= MAX_ANNOUNCE_VIPS) return -1;
+
+    nb_mutex_lock(&announce.lock);
+    announce.vips[vip_id].vrf_id = vrf_id;
+    nb_mutex_unlock(&announce.lock);
+    return 0;
+}
+
+int vip_announce_find(uint32_t ifindex, const uint8_t *addr, uint8_t addr_len)
+{
+    int id = -1;
+
+    nb_mutex_lock(&announce.lock);
+
+    for (int i = 0; i < MAX_ANNOUNCE_VIPS; i++) {
+        const announce_vip_t *v = &announce.vips[i];
+
+        if (v->in_use && v->ifindex == ifindex && v->addr_len == addr_len &&
+            memcmp(v->addr, addr, addr_len) == 0) {
+            id = i;
+            break;
+        }
+    }
+
+    nb_mutex_unlock(&announce.lock);
+    return id;
+}
+
+int vip_announce_get_list(vip_announce_entry_t *list, int max)
+{
+    int n = 0;
+
+    nb_mutex_lock(&announce.lock);
+
+    for (int i = 0; i < MAX_ANNOUNCE_VIPS && n < max; i++) {
+        const announce_vip_t *v = &announce.vips[i];
+
+        if (!v->in_use) continue;
+        list[n].vip_id = i;
+        list[n].ifindex = v->ifindex;
+        list[n].vrf_id = v->vrf_id;
+        list[n].addr_len = v->addr_len;
+        memcpy(list[n].addr, v->addr, sizeof(list[n].addr));
+        n++;
+    }
+
+    nb_mutex_unlock(&announce.lock);
+    return n;
+}
+
+void vip_announce_note_usage(int vip_id, uint64_t packets)
+{
+    if (vip_id < 0 || vip_id >= MAX_ANNOUNCE_VIPS) return;
+
+    nb_mutex_lock(&announce.lock);
+    announce.vips[vip_id].usage += packets;
+    nb_mutex_unlock(&announce.lock);
+}
+
+/*
+ * vip_announce_configure - CLI: 'cluster vip-announce rate R burst B repeat N gap MS'
+ */
+int vip_announce_configure(uint32_t rate, uint32_t burst, uint8_t repeat,
+                           uint32_t gap_ms)
+{
+    if (rate == 0 || burst == 0 || repeat == 0) {
+        syslog_write(LOG_ERR, "VIP announce: rate, burst and repeat must be non-zero");
+        return -1;
+    }
+
+    nb_mutex_lock(&announce.lock);
+    announce.rate = rate;
+    announce.burst = burst;
+    announce.repeat = repeat;
+    announce.gap_ns = (uint64_t)gap_ms * 1000000ULL;
+    pthread_cond_signal(&announce.cond);
+    nb_mutex_unlock(&announce.lock);
+
+    syslog_write(LOG_INFO, "VIP announce: rate=%u/s burst=%u repeat=%u gap=%u ms",
+        rate, burst, repeat, gap_ms);
+    return 0;
+}
+
+static bool announce_vrf_match(uint32_t vrf_id, const uint32_t *vrf_ids, int count)
+{
+    if (!vrf_ids) return true;
+
+    for (int i = 0; i < count; i++) {
+        if (vrf_ids[i] == vrf_id) return true;
+    }
+    return false;
+}
+
+/*
+ * announce_start - Schedule announcements for the VIPs in a VRF set
+ *
+ * A NULL set selects every VIP; with exclude, every VIP outside the
+ * set. Adding to a run in progress keeps its timing and stats; VIPs
+ * already in the run start over, since a second promotion means
+ * upstream state may have moved away again.
+ */
+static void announce_start(const uint32_t *vrf_ids, int count, bool exclude)
+{
+    uint32_t scheduled = 0;
+
+    nb_mutex_lock(&announce.lock);
+
+    uint64_t now = announce_now_ns();
+
+    if (!announce.running) {
+        memset(&announce.stats, 0, sizeof(vip_announce_stats_t));
+        announce.start_ns = now;
+        announce.tokens = announce.burst;
+        announce.tokens_ns = now;
+        announce.run_id++;
+        for (int i = 0; i < MAX_ANNOUNCE_VIPS; i++) {
+            announce.vips[i].sent = announce.repeat;
+        }
+    }
+
+    announce.order_count = 0;
+    for (int i = 0; i < MAX_ANNOUNCE_VIPS; i++) {
+        announce_vip_t *v = &announce.vips[i];
+
+        if (!v->in_use) continue;
+        if (announce_vrf_match(v->vrf_id, vrf_ids, count) != exclude) {
+            v->sent = 0;
+            v->next_due_ns = now;
+            scheduled++;
+        }
+        if (v->sent < announce.repeat) {
+            announce.order[announce.order_count++] = (uint16_t)i;
+        }
+    }
+    qsort(announce.order, announce.order_count, sizeof(uint16_t), announce_cmp_usage);
+
+    announce.stats.running = true;
+    announce.stats.vip_count += scheduled;
+    announce.first_round_done = false;
+    announce.running = true;
+
+    pthread_cond_signal(&announce.cond);
+    nb_mutex_unlock(&announce.lock);
+
+    syslog_write(LOG_INFO, "VIP announce: Announcing %u VIPs", scheduled);
+}
+
+void vip_announce_start_vrfs(const uint32_t *vrf_ids, int count)
+{
+    announce_start(vrf_ids, count, false);
+}
+
+void vip_announce_start_except(const uint32_t *vrf_ids, int count)
+{
+    announce_start(count ? vrf_ids : NULL, count, count > 0);
+}
+
+void vip_announce_start(void)
+{
+    announce_start(NULL, 0, false);
+}
+
+/*
+ * announce_cancel - Drop pending announcements for a VRF set, or for
+ * everything outside it
+ */
+static void announce_cancel(const uint32_t *vrf_ids, int count, bool exclude)
+{
+    nb_mutex_lock(&announce.lock);
+
+    for (int i = 0; i < MAX_ANNOUNCE_VIPS; i++) {
+        announce_vip_t *v = &announce.vips[i];
+
+        if (v->in_use && announce_vrf_match(v->vrf_id, vrf_ids, count) != exclude) {
+            v->sent = announce.repeat;
+        }
+    }
+    pthread_cond_signal(&announce.cond);
+
+    nb_mutex_unlock(&announce.lock);
+}
+
+void vip_announce_cancel_vrfs(const uint32_t *vrf_ids, int count)
+{
+    announce_cancel(vrf_ids, count, false);
+}
+
+void vip_announce_cancel_except(const uint32_t *vrf_ids, int count)
+{
+    announce_cancel(count ? vrf_ids : NULL, count, count > 0);
+}
+
+void vip_announce_cancel(void)
+{
+    nb_mutex_lock(&announce.lock);
+
+    if (announce.running) {
+        syslog_write(LOG_INFO, "VIP announce: Cancelled after %u announcements",
+            announce.stats.sent);
+    }
+    announce.running = false;
+    announce.stats.running = false;
+    announce.run_id++;
+
+    nb_mutex_unlock(&announce.lock);
+}
+
+void vip_announce_get_stats(vip_announce_stats_t *stats)
+{
+    nb_mutex_lock(&announce.lock);
+    memcpy(stats, &announce.stats, sizeof(vip_announce_stats_t));
+    nb_mutex_unlock(&announce.lock);
+}
@@ -0,0 +1,70 @@
+/*
+ * vip_announce.h - Paced VIP Announcement (GARP / Unsolicited NA)
+ *
+ * NetBlade OS v3.x High Availability Module
+ * Copyright (c) 2024-2026 Enterprise Systems Inc. All rights reserved.
+ */
+
+#ifndef VIP_ANNOUNCE_H
+#define VIP_ANNOUNCE_H
+
+#include <stdint.h>
+#include <stdbool.h>
+
+#define MAX_ANNOUNCE_VIPS           1024
+
+#define VIP_ANNOUNCE_DEFAULT_RATE   200     /* Announcements per second */
+#define VIP_ANNOUNCE_DEFAULT_BURST  20
+#define VIP_ANNOUNCE_DEFAULT_REPEAT 3       /* Announcements per VIP */
+#define VIP_ANNOUNCE_DEFAULT_GAP_MS 1000    /* Between repeats of one VIP */
+
+typedef struct {
+    bool     running;
+    uint32_t vip_count;
+    uint32_t sent;
+    uint32_t send_errors;
+    uint64_t first_round_ns;    /* Promotion -> every VIP announced once */
+    uint64_t all_done_ns;       /* Promotion -> every repeat sent */
+} vip_announce_stats_t;
+
+typedef struct {
+    int      vip_id;
+    uint32_t ifindex;
+    uint32_t vrf_id;
+    uint8_t  addr[16];
+    uint8_t  addr_len;
+} vip_announce_entry_t;
+
+int vip_announce_init(void);
+
+/* Returns a VIP id (>= 0) or -1. addr_len is 4 (GARP) or 16 (NA) */
+int vip_announce_add(uint32_t ifindex, const uint8_t *addr, uint8_t addr_len);
+int vip_announce_remove(int vip_id);
+/* VRF the VIP belongs to, for failover groups (default VRF 0) */
+int vip_announce_set_vrf(int vip_id, uint32_t vrf_id);
+/* VIP id of an address on an interface, or -1 */
+int vip_announce_find(uint32_t ifindex, const uint8_t *addr, uint8_t addr_len);
+/* Copy out up to max configured VIPs; returns how many */
+int vip_announce_get_list(vip_announce_entry_t *list, int max);
+
+/* Traffic counter from the data plane; higher usage is announced first */
+void vip_announce_note_usage(int vip_id, uint64_t packets);
+
+int vip_announce_configure(uint32_t rate, uint32_t burst, uint8_t repeat,
+                           uint32_t gap_ms);
+
+/* Begin announcing every VIP; called on promotion */
+void vip_announce_start(void);
+/* Abandon any announcements still pending; called on demotion */
+void vip_announce_cancel(void);
+
+/* Same, limited to the VIPs of a set of VRFs (failover group promotion) */
+void vip_announce_start_vrfs(const uint32_t *vrf_ids, int count);
+void vip_announce_cancel_vrfs(const uint32_t *vrf_ids, int count);
+/* Every VIP outside a set of VRFs (global role change with failover groups) */
+void vip_announce_start_except(const uint32_t *vrf_ids, int count);
+void vip_announce_cancel_except(const uint32_t *vrf_ids, int count);
+
+void vip_announce_get_stats(vip_announce_stats_t *stats);
+
+#endif /* VIP_ANNOUNCE_H */
@@ -0,0 +1,656 @@
+/*
+ * bgp_admission.c - BGP Session Bring-up Admission Control
+ *
+ * NetBlade OS v3.x Routing Engine
+ * Copyright (c) 2024-2026 Enterprise Systems Inc. All rights reserved.
+ *
+ * After a reboot or failover every peer in every VRF connects at once.
+ * If all of them exchange OPEN and start their initial table transfer
+ * together, they share the CPU so thinly that the last VRFs miss their
+ * hold time and flap, and the whole storm converges later than if the
+ * sessions had been taken a few at a time.
+ *
+ * A session therefore asks for a slot before it sends or answers OPEN
+ * and gives it back at End-of-RIB. Sessions beyond max_active wait in
+ * one FIFO per priority class; a freed slot goes to the head of the
+ * best class. Reserved slots are held back for CRITICAL sessions, so a
+ * critical VRF never waits behind bulk peers that got there first.
+ * Nothing waits past max_wait_ms: a waiting session has not started
+ * OPEN, so the bound only has to stay inside the peer's OpenSent hold
+ * timer and ConnectRetry, and at the bound the session is let in over
+ * the limit instead.
+ *
+ * Sessions belong to the worker that owns their VRF (bgp_shard). A slot
+ * freed on one worker may admit a session of another, so admissions are
+ * queued per worker and the owner is woken through its fd. That fd is
+ * a timerfd rather than an eventfd: a wake-up sets it to expire at
+ * once, and otherwise one of them is armed for the earliest max_wait_ms
+ * deadline, so an idle engine still lets the oldest session in on time.
+ *
+ * Tickets carry a generation, so a stale one from a session that has
+ * already finished cannot release the slot of whoever reused it.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+#include <stdbool.h>
+#include <errno.h>
+#include <time.h>
+#include <unistd.h>
+#include <sys/timerfd.h>
+#include <netinet/in.h>
+#include "bgp_admission.h"
+#include "bgp_shard.h"
+#include "syslog.h"
+#include "nb_mutex.h"
+#include "nb_boot.h"
+
+#define BGP_ADM_NONE            UINT32_MAX
+
+/* Ticket: generation in the high half, as bgp_io session handles */
+#define BGP_ADM_TICKET(i, gen)  (((uint32_t)(gen) << 16) | (i))
+#define BGP_ADM_INDEX(t)        ((t) & 0xffff)
+#define BGP_ADM_GEN(t)          ((uint16_t)((t) >> 16))
+
+#define BGP_ADM_FREE            0
+#define BGP_ADM_WAITING         1
+#define BGP_ADM_READY           2   /* Admitted, not yet delivered to the worker */
+#define BGP_ADM_ACTIVE          3
+
+typedef struct {
+    void     *session;
+    uint64_t  queued_ns;
+    uint64_t  admitted_ns;
+    uint32_t  prev;             /* Class queue or worker ready list */
+    uint32_t  next;             /* ...or the free list */
+    uint32_t  vrf_id;
+    uint16_t  gen;
+    uint8_t   state;
+    uint8_t   prio;
+    uint8_t   shard;
+} bgp_adm_entry_t;
+
+typedef struct {
+    uint32_t head;
+    uint32_t tail;
+} bgp_adm_list_t;
+
+typedef struct {
+    uint32_t vrf_id;
+    uint8_t  prio;
+} bgp_adm_vrf_prio_t;
+
+typedef struct {
+    uint32_t vrf_id;
+    uint8_t  addr[16];          /* IPv6, or IPv4-mapped */
+    uint8_t  prio;
+} bgp_adm_peer_prio_t;
+
+struct bgp_admission {
+    nb_mutex_t             lock;
+    uint32_t               max_active;
+    uint32_t               reserved;
+    uint64_t               max_wait_ns;
+
+    bgp_adm_entry_t        entries[BGP_ADM_MAX_TICKETS];
+    uint32_t               free_head;
+    bgp_adm_list_t         waiting[BGP_ADM_PRIOS];
+    bgp_adm_list_t         ready[BGP_SHARD_MAX];
+    int                    wake_fd[BGP_SHARD_MAX];     /* timerfd */
+    uint8_t                nshards;
+    uint64_t               armed_ns;       /* Deadline armed on armed_shard; 0: none */
+    uint8_t                armed_shard;
+    uint64_t               woken;          /* Workers woken and not yet polled */
+
+    bgp_adm_vrf_prio_t     vrf_prios[BGP_ADM_MAX_VRF_PRIOS];
+    int                    vrf_prio_count;
+    bgp_adm_peer_prio_t    peer_prios[BGP_ADM_MAX_PEER_PRIOS];
+    int                    peer_prio_count;
+
+    bgp_admission_stats_t  stats;
+};
+
+static const char *bgp_adm_prio_names[BGP_ADM_PRIOS] = {
+    "critical", "high", "normal", "low",
+};
+
+static uint64_t bgp_adm_now_ns(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000000000ULL + (uint64_t)ts.tv_nsec;
+}
+
+static void bgp_adm_list_push(bgp_admission_t *a, bgp_adm_list_t *l, uint32_t i)
+{
+    bgp_adm_entry_t *e = &a->entries[i];
+
+    e->prev = l->tail;
+    e->next = BGP_ADM_NONE;
+    if (l->tail != BGP_ADM_NONE) a->entries[l->tail].next = i;
+    else l->head = i;
+    l->tail = i;
+}
+
+static void bgp_adm_list_unlink(bgp_admission_t *a, bgp_adm_list_t *l, uint32_t i)
+{
+    bgp_adm_entry_t *e = &a->entries[i];
+
+    if (e->prev != BGP_ADM_NONE) a->entries[e->prev].next = e->next;
+    else l->head = e->next;
+    if (e->next != BGP_ADM_NONE) a->entries[e->next].prev = e->prev;
+    else l->tail = e->prev;
+    e->prev = e->next = BGP_ADM_NONE;
+}
+
+static bool bgp_adm_peer_key(const struct sockaddr *peer, uint8_t addr[16])
+{
+    memset(addr, 0, 16);
+    if (!peer) return false;
+
+    if (peer->sa_family == AF_INET) {
+        const struct sockaddr_in *sin = (const struct sockaddr_in *)peer;
+        addr[10] = addr[11] = 0xff;
+        memcpy(&addr[12], &sin->sin_addr, 4);
+        return true;
+    }
+    if (peer->sa_family == AF_INET6) {
+        memcpy(addr, &((const struct sockaddr_in6 *)peer)->sin6_addr, 16);
+        return true;
+    }
+    return false;
+}
+
+bgp_admission_t *bgp_admission_create(const bgp_admission_config_t *cfg)
+{
+    bgp_admission_t *a = calloc(1, sizeof(bgp_admission_t));
+    if (!a) return NULL;
+
+    long cpus = sysconf(_SC_NPROCESSORS_ONLN);
+
+    a->max_active = cfg && cfg->max_active ? cfg->max_active : (uint32_t)(cpus > 0 ? 2 * cpus : 2);
+    a->reserved = cfg ? cfg->reserved : 0;
+    if (a->reserved >= a->max_active) a->reserved = a->max_active - 1;
+    a->max_wait_ns = (uint64_t)(cfg && cfg->max_wait_ms ? cfg->max_wait_ms
+                                                        : BGP_ADM_DEFAULT_MAX_WAIT_MS) * 1000000ULL;
+
+    nb_mutex_init(&a->lock, "bgp_admission.lock");
+    if (cfg && cfg->expect_sessions) nb_boot_expect_sessions(cfg->expect_sessions);
+
+    for (uint32_t i = 0; i < BGP_ADM_MAX_TICKETS; i++) {
+        a->entries[i].next = i + 1 < BGP_ADM_MAX_TICKETS ? i + 1 : BGP_ADM_NONE;
+    }
+    a->free_head = 0;
+    for (int p = 0; p < BGP_ADM_PRIOS; p++) {
+        a->waiting[p].head = a->waiting[p].tail = BGP_ADM_NONE;
+    }
+
+    a->nshards = bgp_shard_count();
+    for (uint8_t s = 0; s < a->nshards; s++) {
+        a->ready[s].head = a->ready[s].tail = BGP_ADM_NONE;
+        a->wake_fd[s] = timerfd_create(CLOCK_MONOTONIC, TFD_NONBLOCK | TFD_CLOEXEC);
+        if (a->wake_fd[s] < 0) {
+            syslog_write(LOG_ERR, "BGP admission: Worker %d timerfd failed: %s",
+                s, strerror(errno));
+            a->nshards = s;
+            bgp_admission_destroy(a);
+            return NULL;
+        }
+    }
+
+    syslog_write(LOG_INFO, "BGP admission: %u sessions in initial sync (%u reserved "
+        "for critical), max wait %llu ms", a->max_active, a->reserved,
+        (unsigned long long)(a->max_wait_ns / 1000000ULL));
+    return a;
+}
+
+void bgp_admission_destroy(bgp_admission_t *a)
+{
+    if (!a) return;
+
+    for (uint8_t s = 0; s < a->nshards; s++) close(a->wake_fd[s]);
+    nb_mutex_destroy(&a->lock);
+    free(a);
+}
+
+int bgp_admission_set_vrf_prio(bgp_admission_t *a, uint32_t vrf_id, uint8_t prio)
+{
+    int ret = 0;
+
+    if (prio >= BGP_ADM_PRIOS) return -1;
+
+    nb_mutex_lock(&a->lock);
+
+    int i;
+    for (i = 0; i < a->vrf_prio_count; i++) {
+        if (a->vrf_prios[i].vrf_id == vrf_id) break;
+    }
+    if (i < a->vrf_prio_count) {
+        a->vrf_prios[i].prio = prio;
+    } else if (a->vrf_prio_count < BGP_ADM_MAX_VRF_PRIOS) {
+        a->vrf_prios[a->vrf_prio_count].vrf_id = vrf_id;
+        a->vrf_prios[a->vrf_prio_count].prio = prio;
+        a->vrf_prio_count++;
+    } else {
+        ret = -1;
+    }
+
+    nb_mutex_unlock(&a->lock);
+    return ret;
+}
+
+int bgp_admission_set_peer_prio(bgp_admission_t *a, uint32_t vrf_id,
+                                const struct sockaddr *peer, uint8_t prio)
+{
+    uint8_t addr[16];
+    int ret = 0;
+
+    if (prio >= BGP_ADM_PRIOS || !bgp_adm_peer_key(peer, addr)) return -1;
+
+    nb_mutex_lock(&a->lock);
+
+    int i;
+    for (i = 0; i < a->peer_prio_count; i++) {
+        if (a->peer_prios[i].vrf_id == vrf_id &&
+            memcmp(a->peer_prios[i].addr, addr, sizeof(addr)) == 0) break;
+    }
+    if (i < a->peer_prio_count) {
+        a->peer_prios[i].prio = prio;
+    } else if (a->peer_prio_count < BGP_ADM_MAX_PEER_PRIOS) {
+        bgp_adm_peer_prio_t *p = &a->peer_prios[a->peer_prio_count++];
+        p->vrf_id = vrf_id;
+        memcpy(p->addr, addr, sizeof(addr));
+        p->prio = prio;
+    } else {
+        ret = -1;
+    }
+
+    nb_mutex_unlock(&a->lock);
+    return ret;
+}
+
+/* Called with the lock held */
+static uint8_t bgp_adm_lookup_prio(bgp_admission_t *a, uint32_t vrf_id,
+                                   const struct sockaddr *peer)
+{
+    uint8_t addr[16];
+
+    if (a->peer_prio_count > 0 && bgp_adm_peer_key(peer, addr)) {
+        for (int i = 0; i < a->peer_prio_count; i++) {
+            if (a->peer_prios[i].vrf_id == vrf_id &&
+                memcmp(a->peer_prios[i].addr, addr, sizeof(addr)) == 0) {
+                return a->peer_prios[i].prio;
+            }
+        }
+    }
+    for (int i = 0; i < a->vrf_prio_count; i++) {
+        if (a->vrf_prios[i].vrf_id == vrf_id) return a->vrf_prios[i].prio;
+    }
+    return BGP_ADM_PRIO_NORMAL;
+}
+
+uint8_t bgp_admission_prio(bgp_admission_t *a, uint32_t vrf_id, const struct sockaddr *peer)
+{
+    nb_mutex_lock(&a->lock);
+    uint8_t prio = bgp_adm_lookup_prio(a, vrf_id, peer);
+    nb_mutex_unlock(&a->lock);
+    return prio;
+}
+
+static bool bgp_adm_has_slot(bgp_admission_t *a, uint8_t prio)
+{
+    uint32_t limit = prio == BGP_ADM_PRIO_CRITICAL ? a->max_active
+                                                   : a->max_active - a->reserved;
+    return a->stats.active < limit;
+}
+
+static void bgp_adm_account(bgp_admission_t *a, bgp_adm_entry_t *e, uint64_t now)
+{
+    uint64_t wait = now - e->queued_ns;
+
+    e->admitted_ns = now;
+    a->stats.active++;
+    a->stats.admitted++;
+    a->stats.admitted_class[e->prio]++;
+    a->stats.wait_ns_total[e->prio] += wait;
+    if (wait > a->stats.wait_ns_max[e->prio]) a->stats.wait_ns_max[e->prio] = wait;
+}
+
+/* Called with the lock held; returns the workers that must be woken */
+static uint64_t bgp_adm_admit(bgp_admission_t *a, uint32_t i, uint64_t now)
+{
+    bgp_adm_entry_t *e = &a->entries[i];
+
+    bgp_adm_list_unlink(a, &a->waiting[e->prio], i);
+    a->stats.waiting--;
+    bgp_adm_account(a, e, now);
+
+    e->state = BGP_ADM_READY;
+    bgp_adm_list_push(a, &a->ready[e->shard], i);
+    return 1ULL << e->shard;
+}
+
+/* Hand free slots to the best waiting classes. Called with the lock held */
+static uint64_t bgp_adm_fill(bgp_admission_t *a, uint64_t now)
+{
+    uint64_t wake = 0;
+
+    for (uint8_t p = 0; p < BGP_ADM_PRIOS; p++) {
+        while (a->waiting[p].head != BGP_ADM_NONE && bgp_adm_has_slot(a, p)) {
+            wake |= bgp_adm_admit(a, a->waiting[p].head, now);
+        }
+        /* Lower classes only get what is left once this one is empty */
+        if (a->waiting[p].head != BGP_ADM_NONE) break;
+    }
+    return wake;
+}
+
+/*
+ * Make the workers' timers expire at once. A wake-up replaces any
+ * deadline armed on that timer; the woken worker re-arms it when it
+ * polls. Called with the lock held, after bgp_adm_arm().
+ */
+static void bgp_adm_wake(bgp_admission_t *a, uint64_t wake)
+{
+    static const struct itimerspec now = { .it_value = { 0, 1 } };
+
+    for (uint8_t s = 0; wake; s++, wake >>= 1) {
+        if (!(wake & 1)) continue;
+        if (timerfd_settime(a->wake_fd[s], 0, &now, NULL) != 0) {
+            syslog_write(LOG_WARNING, "BGP admission: Cannot wake worker %d", s);
+            continue;
+        }
+        a->woken |= 1ULL << s;
+        if (s == a->armed_shard) a->armed_ns = 0;
+    }
+}
+
+/*
+ * Arm the timer of the worker owning the session that reaches
+ * max_wait_ms first. Queues are FIFO, so only their heads can be first.
+ * A worker with a wake-up pending is left alone: re-arming would lose
+ * the wake-up, and its poll arms the deadline anyway. Called with the
+ * lock held, after every change to the queues.
+ */
+static void bgp_adm_arm(bgp_admission_t *a)
+{
+    uint64_t due = UINT64_MAX;
+    uint8_t shard = 0;
+
+    for (uint8_t p = 0; p < BGP_ADM_PRIOS; p++) {
+        uint32_t i = a->waiting[p].head;
+        if (i == BGP_ADM_NONE) continue;
+        if (a->entries[i].queued_ns + a->max_wait_ns < due) {
+            due = a->entries[i].queued_ns + a->max_wait_ns;
+            shard = a->entries[i].shard;
+        }
+    }
+    if (due == UINT64_MAX || (due == a->armed_ns && shard == a->armed_shard)) return;
+    if (a->woken & (1ULL << shard)) {
+        a->armed_ns = 0;
+        return;
+    }
+
+    struct itimerspec its = {
+        .it_value = { .tv_sec = (time_t)(due / 1000000000ULL),
+                      .tv_nsec = (long)(due % 1000000000ULL) },
+    };
+    if (timerfd_settime(a->wake_fd[shard], TFD_TIMER_ABSTIME, &its, NULL) != 0) {
+        syslog_write(LOG_WARNING, "BGP admission: Cannot arm worker %d timer", shard);
+        return;
+    }
+    a->armed_ns = due;
+    a->armed_shard = shard;
+}
+
+/* Called with the lock held */
+static bgp_adm_entry_t *bgp_adm_entry(bgp_admission_t *a, bgp_adm_ticket_t ticket)
+{
+    uint32_t i = BGP_ADM_INDEX(ticket);
+
+    if (i >= BGP_ADM_MAX_TICKETS) return NULL;
+
+    bgp_adm_entry_t *e = &a->entries[i];
+    if (e->state == BGP_ADM_FREE || e->gen != BGP_ADM_GEN(ticket)) return NULL;
+    return e;
+}
+
+int bgp_admission_request(bgp_admission_t *a, uint8_t shard, uint32_t vrf_id,
+                          const struct sockaddr *peer, void *session,
+                          bgp_adm_ticket_t *ticket)
+{
+    if (shard >= a->nshards) return -1;
+
+    uint64_t now = bgp_adm_now_ns();
+
+    nb_mutex_lock(&a->lock);
+
+    uint32_t i = a->free_head;
+    if (i == BGP_ADM_NONE) {
+        nb_mutex_unlock(&a->lock);
+        syslog_write(LOG_ERR, "BGP admission: No tickets left for VRF %u", vrf_id);
+        return -1;
+    }
+    bgp_adm_entry_t *e = &a->entries[i];
+    a->free_head = e->next;
+
+    e->session = session;
+    e->vrf_id = vrf_id;
+    e->shard = shard;
+    e->prio = bgp_adm_lookup_prio(a, vrf_id, peer);
+    e->queued_ns = now;
+    e->prev = e->next = BGP_ADM_NONE;
+    *ticket = BGP_ADM_TICKET(i, e->gen);
+
+    /* Only go straight in if nobody of this class or better is waiting */
+    bool ahead = false;
+    for (uint8_t p = 0; p <= e->prio; p++) {
+        if (a->waiting[p].head != BGP_ADM_NONE) ahead = true;
+    }
+
+    int ret;
+    if (!ahead && bgp_adm_has_slot(a, e->prio)) {
+        e->state = BGP_ADM_ACTIVE;
+        bgp_adm_account(a, e, now);
+        ret = 1;
+    } else {
+        e->state = BGP_ADM_WAITING;
+        bgp_adm_list_push(a, &a->waiting[e->prio], i);
+        a->stats.waiting++;
+        a->stats.queued++;
+        bgp_adm_arm(a);
+        ret = 0;
+    }
+
+    nb_mutex_unlock(&a->lock);
+    return ret;
+}
+
+/* Drop an entry in any state. Called with the lock held; returns workers to wake */
+static uint64_t bgp_adm_release(bgp_admission_t *a, uint32_t i, uint64_t now)
+{
+    bgp_adm_entry_t *e = &a->entries[i];
+    uint64_t wake = 0;
+
+    switch (e->state) {
+    case BGP_ADM_WAITING:
+        bgp_adm_list_unlink(a, &a->waiting[e->prio], i);
+        a->stats.waiting--;
+        break;
+    case BGP_ADM_READY:
+        bgp_adm_list_unlink(a, &a->ready[e->shard], i);
+        /* fall through */
+    case BGP_ADM_ACTIVE:
+        a->stats.active--;
+        wake = bgp_adm_fill(a, now);
+        break;
+    default:
+        return 0;
+    }
+
+    e->state = BGP_ADM_FREE;
+    e->session = NULL;
+    e->gen++;
+    e->next = a->free_head;
+    a->free_head = i;
+    bgp_adm_arm(a);
+    return wake;
+}
+
+void bgp_admission_done(bgp_admission_t *a, bgp_adm_ticket_t ticket, bool ok)
+{
+    uint64_t now = bgp_adm_now_ns();
+
+    nb_mutex_lock(&a->lock);
+
+    bgp_adm_entry_t *e = bgp_adm_entry(a, ticket);
+    if (!e || e->state != BGP_ADM_ACTIVE) {
+        nb_mutex_unlock(&a->lock);
+        return;
+    }
+
+    uint64_t sync = now - e->admitted_ns;
+    void *session = e->session;
+    if (ok) {
+        a->stats.synced++;
+        a->stats.sync_ns_total += sync;
+        if (sync > a->stats.sync_ns_max) a->stats.sync_ns_max = sync;
+    } else {
+        a->stats.sync_failed++;
+    }
+    bgp_adm_wake(a, bgp_adm_release(a, BGP_ADM_INDEX(ticket), now));
+
+    nb_mutex_unlock(&a->lock);
+
+    if (ok) nb_boot_session_converged(session);
+}
+
+void bgp_admission_established(bgp_admission_t *a, bgp_adm_ticket_t ticket)
+{
+    nb_mutex_lock(&a->lock);
+    bgp_adm_entry_t *e = bgp_adm_entry(a, ticket);
+    bool active = e && e->state == BGP_ADM_ACTIVE;
+    if (active) a->stats.established++;
+    nb_mutex_unlock(&a->lock);
+
+    if (active) nb_boot_session_established();
+}
+
+void bgp_admission_cancel(bgp_admission_t *a, bgp_adm_ticket_t ticket)
+{
+    nb_mutex_lock(&a->lock);
+    if (!bgp_adm_entry(a, ticket)) {
+        nb_mutex_unlock(&a->lock);
+        return;
+    }
+    a->stats.cancelled++;
+    bgp_adm_wake(a, bgp_adm_release(a, BGP_ADM_INDEX(ticket), bgp_adm_now_ns()));
+    nb_mutex_unlock(&a->lock);
+}
+
+int bgp_admission_fd(bgp_admission_t *a, uint8_t shard)
+{
+    return shard < a->nshards ? a->wake_fd[shard] : -1;
+}
+
+int bgp_admission_poll(bgp_admission_t *a, uint8_t shard, bgp_admission_cb_t cb, void *ctx)
+{
+    uint64_t count, now = bgp_adm_now_ns();
+    uint32_t forced = 0;
+    int delivered = 0;
+
+    if (shard >= a->nshards) return -1;
+
+    if (read(a->wake_fd[shard], &count, sizeof(count)) < 0 && errno != EAGAIN) {
+        syslog_write(LOG_WARNING, "BGP admission: Worker %d timerfd read failed", shard);
+    }
+
+    nb_mutex_lock(&a->lock);
+
+    /* This timer has expired, or a wake-up replaced the deadline on it */
+    if (a->armed_shard == shard) a->armed_ns = 0;
+    a->woken &= ~(1ULL << shard);
+
+    /* Queues are FIFO, so only their heads can have waited too long */
+    uint64_t wake = 0;
+    for (uint8_t p = 0; p < BGP_ADM_PRIOS; p++) {
+        uint32_t i;
+        while ((i = a->waiting[p].head) != BGP_ADM_NONE &&
+               now - a->entries[i].queued_ns >= a->max_wait_ns) {
+            wake |= bgp_adm_admit(a, i, now);
+            a->stats.forced++;
+            forced++;
+        }
+    }
+
+    bgp_adm_list_t *ready = &a->ready[shard];
+    uint32_t i;
+    while ((i = ready->head) != BGP_ADM_NONE) {
+        bgp_adm_entry_t *e = &a->entries[i];
+        void *session = e->session;
+
+        bgp_adm_list_unlink(a, ready, i);
+        e->state = BGP_ADM_ACTIVE;
+
+        /* The callback may start OPEN or cancel the ticket */
+        bgp_adm_ticket_t ticket = BGP_ADM_TICKET(i, e->gen);
+        nb_mutex_unlock(&a->lock);
+        cb(ticket, session, ctx);
+        delivered++;
+        nb_mutex_lock(&a->lock);
+    }
+
+    /* Next deadline, whichever worker's head it belongs to */
+    bgp_adm_arm(a);
+    bgp_adm_wake(a, wake & ~(1ULL << shard));
+    nb_mutex_unlock(&a->lock);
+
+    if (forced > 0) {
+        syslog_write(LOG_WARNING, "BGP admission: %u sessions waited %llu ms, "
+            "admitted over the limit", forced,
+            (unsigned long long)(a->max_wait_ns / 1000000ULL));
+    }
+    return delivered;
+}
+
+void bgp_admission_get_stats(bgp_admission_t *a, bgp_admission_stats_t *stats)
+{
+    nb_mutex_lock(&a->lock);
+    *stats = a->stats;
+    nb_mutex_unlock(&a->lock);
+}
+
+const char *bgp_admission_prio_name(uint8_t prio)
+{
+    return prio < BGP_ADM_PRIOS ? bgp_adm_prio_names[prio] : "unknown";
+}
+
+void bgp_admission_dump(bgp_admission_t *a)
+{
+    bgp_admission_stats_t st;
+
+    bgp_admission_get_stats(a, &st);
+
+    syslog_write(LOG_INFO, "BGP admission: %u/%u active, %u waiting, %llu admitted "
+        "(%llu queued, %llu forced), %llu established, %llu synced, %llu failed, "
+        "%llu cancelled",
+        st.active, a->max_active, st.waiting, (unsigned long long)st.admitted,
+        (unsigned long long)st.queued, (unsigned long long)st.forced,
+        (unsigned long long)st.established, (unsigned long long)st.synced, (unsigned long long)st.sync_failed,
+        (unsigned long long)st.cancelled);
+
+    for (uint8_t p = 0; p < BGP_ADM_PRIOS; p++) {
+        if (st.admitted_class[p] == 0) continue;
+        syslog_write(LOG_INFO, "  %-8s %llu admitted, wait avg %.1f ms max %.1f ms",
+            bgp_adm_prio_names[p], (unsigned long long)st.admitted_class[p],
+            (double)st.wait_ns_total[p] / (double)st.admitted_class[p] / 1e6,
+            (double)st.wait_ns_max[p] / 1e6);
+    }
+    if (st.synced > 0) {
+        syslog_write(LOG_INFO, "  initial sync avg %.1f ms max %.1f ms",
+            (double)st.sync_ns_total / (double)st.synced / 1e6,
+            (double)st.sync_ns_max / 1e6);
+    }
+}
@@ -0,0 +1,104 @@
+/*
+ * bgp_admission.h - BGP Session Bring-up Admission Control
+ *
+ * NetBlade OS v3.x Routing Engine
+ * Copyright (c) 2024-2026 Enterprise Systems Inc. All rights reserved.
+ */
+
+#ifndef BGP_ADMISSION_H
+#define BGP_ADMISSION_H
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <sys/socket.h>
+
+#define BGP_ADM_MAX_TICKETS         16384   /* Matches BGP_IO_MAX_CONNS */
+#define BGP_ADM_MAX_VRF_PRIOS       256     /* Matches BGP_SHARD_MAX_VRFS */
+#define BGP_ADM_MAX_PEER_PRIOS      1024
+
+/* Priority classes; lower is admitted first */
+#define BGP_ADM_PRIO_CRITICAL       0
+#define BGP_ADM_PRIO_HIGH           1
+#define BGP_ADM_PRIO_NORMAL         2   /* Default */
+#define BGP_ADM_PRIO_LOW            3
+#define BGP_ADM_PRIOS               4
+
+/*
+ * Wait bound. A waiting session has not sent or answered OPEN, so only
+ * the peer's OpenSent hold timer (RFC 4271 suggests 4 minutes) and its
+ * ConnectRetry run against it. The default stays well inside both.
+ */
+#define BGP_ADM_DEFAULT_MAX_WAIT_MS 60000
+
+typedef uint32_t bgp_adm_ticket_t;
+
+typedef struct {
+    uint32_t max_active;        /* Sessions in initial sync at once; 0: 2 per CPU */
+    uint32_t reserved;          /* Of those, slots only CRITICAL sessions may use */
+    uint32_t max_wait_ms;       /* Admit anyway after this long; 0: default */
+    uint32_t expect_sessions;   /* Configured sessions whose End-of-RIB ends boot; 0: none */
+} bgp_admission_config_t;
+
+typedef struct {
+    uint32_t active;            /* Admitted, initial sync not finished */
+    uint32_t waiting;
+    uint64_t admitted;          /* Straight away or from the queue */
+    uint64_t queued;
+    uint64_t forced;            /* Admitted over the limit at max_wait_ms */
+    uint64_t cancelled;         /* Session went away while waiting or syncing */
+    uint64_t established;
+    uint64_t synced;
+    uint64_t sync_failed;
+    uint64_t wait_ns_max[BGP_ADM_PRIOS];
+    uint64_t wait_ns_total[BGP_ADM_PRIOS];
+    uint64_t admitted_class[BGP_ADM_PRIOS];
+    uint64_t sync_ns_max;
+    uint64_t sync_ns_total;
+} bgp_admission_stats_t;
+
+typedef struct bgp_admission bgp_admission_t;
+
+/* A queued session of this worker may now send or answer OPEN */
+typedef void (*bgp_admission_cb_t)(bgp_adm_ticket_t ticket, void *session, void *ctx);
+
+bgp_admission_t *bgp_admission_create(const bgp_admission_config_t *cfg);
+void bgp_admission_destroy(bgp_admission_t *a);
+
+/* Class for a VRF's sessions, and per-peer overrides of it */
+int bgp_admission_set_vrf_prio(bgp_admission_t *a, uint32_t vrf_id, uint8_t prio);
+int bgp_admission_set_peer_prio(bgp_admission_t *a, uint32_t vrf_id,
+                                const struct sockaddr *peer, uint8_t prio);
+uint8_t bgp_admission_prio(bgp_admission_t *a, uint32_t vrf_id, const struct sockaddr *peer);
+
+/*
+ * Ask to start a session's initial sync, before OPEN is sent or
+ * answered. Returns 1 if admitted now, 0 if queued (the owning worker's
+ * bgp_admission_poll() reports it later) or -1. *ticket is valid until
+ * bgp_admission_done() or bgp_admission_cancel(); calls with it after
+ * that are ignored, even once its slot has been reused.
+ */
+int bgp_admission_request(bgp_admission_t *a, uint8_t shard, uint32_t vrf_id,
+                          const struct sockaddr *peer, void *session,
+                          bgp_adm_ticket_t *ticket);
+
+/* The admitted session reached Established; the first one marks the boot timeline */
+void bgp_admission_established(bgp_admission_t *a, bgp_adm_ticket_t ticket);
+/* Initial table transfer finished (End-of-RIB) or the session failed */
+void bgp_admission_done(bgp_admission_t *a, bgp_adm_ticket_t ticket, bool ok);
+/* The session closed before bgp_admission_done() */
+void bgp_admission_cancel(bgp_admission_t *a, bgp_adm_ticket_t ticket);
+
+/*
+ * Each worker polls this fd for readability and then calls
+ * bgp_admission_poll(). It becomes readable on admissions for the
+ * worker and when one of its queued sessions reaches max_wait_ms.
+ */
+int bgp_admission_fd(bgp_admission_t *a, uint8_t shard);
+/* Deliver this worker's admissions and enforce max_wait_ms; returns sessions admitted */
+int bgp_admission_poll(bgp_admission_t *a, uint8_t shard, bgp_admission_cb_t cb, void *ctx);
+
+void bgp_admission_get_stats(bgp_admission_t *a, bgp_admission_stats_t *stats);
+const char *bgp_admission_prio_name(uint8_t prio);
+void bgp_admission_dump(bgp_admission_t *a);
+
+#endif /* BGP_ADMISSION_H */
@@ -0,0 +1,746 @@
+/*
+ * bgp_bmp.c - BGP Monitoring Protocol (RFC 7854) Exporter
+ *
+ * NetBlade OS v3.x Routing Engine
+ * Copyright (c) 2024-2026 Enterprise Systems Inc. All rights reserved.
+ *
+ * Streams peer up/down and route monitoring messages to a BMP collector
+ * without ever holding up routing.
+ *
+ * Each worker encodes its events straight into its own single-producer
+ * ring: a few header stores and a memcpy of the BGP PDU, with no lock
+ * and no syscall. A dedicated thread drains all rings into one send
+ * buffer and writes it to the collector. When the collector is slow the
+ * send buffer fills, the thread stops draining, the rings fill, and
+ * workers drop further events and count them. Route monitoring stops at
+ * three quarters of a ring so that peer up and down, which the collector
+ * needs to make sense of everything else, still get through.
+ *
+ * A Peer Down is never dropped for a peer whose Peer Up was queued: each
+ * such peer holds back room in its ring for one Peer Down, which falls
+ * back to a compact form without NOTIFICATION data when the full one
+ * does not fit. Otherwise the collector, and the replay below, would
+ * keep the peer up forever.
+ *
+ * The thread tracks which peers are up from the messages passing
+ * through it, so a collector that connects or reconnects gets
+ * Initiation followed by Peer Up for every established session. The
+ * replay is streamed through the send buffer a piece at a time, and the
+ * rings wait until it is done so that live events follow it in order.
+ */
+
+#define _GNU_SOURCE
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+#include <stdbool.h>
+#include <stdatomic.h>
+#include <errno.h>
+#include <time.h>
+#include <poll.h>
+#include <unistd.h>
+#include <fcntl.h>
+#include <pthread.h>
+#include <sys/socket.h>
+#include <netinet/in.h>
+#include "bgp_bmp.h"
+#include "syslog.h"
+
+#define BGP_BMP_VERSION         3
+#define BGP_BMP_COMMON_LEN      6
+#define BGP_BMP_PEER_HDR_LEN    42
+#define BGP_BMP_PEER_KEY_LEN    26      /* Peer type, flags, distinguisher, address */
+
+#define BGP_BMP_FLAG_V6         0x80
+#define BGP_BMP_FLAG_POST       0x40
+
+#define BGP_BMP_PEER_GLOBAL     0
+#define BGP_BMP_PEER_RD         1
+
+#define BGP_BMP_TLV_STRING      0
+#define BGP_BMP_TLV_SYS_DESCR   1
+#define BGP_BMP_TLV_SYS_NAME    2
+#define BGP_BMP_TLV_REASON      1       /* Termination */
+
+#define BGP_BMP_FLUSH_MS        10      /* Exporter poll interval when idle */
+#define BGP_BMP_CONNECT_MS      1000
+#define BGP_BMP_BACKOFF_MIN_MS  1000
+#define BGP_BMP_BACKOFF_MAX_MS  30000
+#define BGP_BMP_REPLAY_BUCKETS  4096    /* Power of two */
+
+/* Compact Peer Down: peer header, reason, and a NOTIFICATION without data */
+#define BGP_BMP_NOTIFY_MIN      21
+#define BGP_BMP_DOWN_MIN        BGP_BMP_REC_ALIGN(4 + BGP_BMP_COMMON_LEN + \
+                                    BGP_BMP_PEER_HDR_LEN + 1 + BGP_BMP_NOTIFY_MIN)
+
+/* Ring record header: length including the header, 4-byte aligned */
+#define BGP_BMP_REC_PAD         0x80000000U     /* Skip to the end of the ring */
+#define BGP_BMP_REC_ALIGN(n)    (((n) + 3U) & ~3U)
+
+#define BGP_NOTIFY_HOLD_EXPIRED 4
+
+typedef struct {
+    _Atomic uint64_t  head;                     /* Exporter */
+    uint8_t           pad1[56];
+    _Atomic uint64_t  tail;                     /* Worker */
+    uint32_t          up;       /* Peer Ups queued without a Peer Down; worker only */
+    _Atomic uint64_t  queued[BGP_BMP_MSG_TYPES];
+    _Atomic uint64_t  dropped[BGP_BMP_MSG_TYPES];
+    uint8_t          *buf;
+} bgp_bmp_ring_t;
+
+typedef struct bgp_bmp_replay bgp_bmp_replay_t;
+
+struct bgp_bmp_replay {
+    bgp_bmp_replay_t *next;
+    uint32_t          len;
+    uint8_t           msg[];    /* The Peer Up message */
+};
+
+struct bgp_bmp {
+    struct sockaddr_storage collector;
+    socklen_t               collector_len;
+    char                    sys_name[64];
+    uint8_t                 nshards;
+
+    bgp_bmp_ring_t          rings[BGP_BMP_MAX_SHARDS];
+
+    pthread_t               thread;
+    _Atomic bool            running;
+    int                     fd;
+    uint8_t                *out;
+    uint32_t                out_len;
+    uint32_t                out_msgs;
+    uint64_t                next_connect_ms;
+    uint32_t                backoff_ms;
+
+    bgp_bmp_replay_t       *replay[BGP_BMP_REPLAY_BUCKETS];
+    _Atomic uint32_t        peers_up;
+    uint32_t                replay_bucket;  /* Replay cursor; BUCKETS when done */
+    bgp_bmp_replay_t       *replay_next;
+
+    _Atomic uint64_t        sent;
+    _Atomic uint64_t        sent_bytes;
+    _Atomic uint64_t        discarded;
+    _Atomic uint64_t        lost;
+    _Atomic uint64_t        connects;
+    _Atomic uint64_t        disconnects;
+    _Atomic bool            connected;
+};
+
+static void bgp_bmp_put16(uint8_t *p, uint16_t v)
+{
+    p[0] = (uint8_t)(v >> 8);
+    p[1] = (uint8_t)v;
+}
+
+static void bgp_bmp_put32(uint8_t *p, uint32_t v)
+{
+    p[0] = (uint8_t)(v >> 24);
+    p[1] = (uint8_t)(v >> 16);
+    p[2] = (uint8_t)(v >> 8);
+    p[3] = (uint8_t)v;
+}
+
+static uint64_t bgp_bmp_now_ms(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000ULL + (uint64_t)ts.tv_nsec / 1000000ULL;
+}
+
+static void bgp_bmp_common(uint8_t *p, uint32_t len, uint8_t type)
+{
+    p[0] = BGP_BMP_VERSION;
+    bgp_bmp_put32(p + 1, len);
+    p[5] = type;
+}
+
+/* 16-byte BMP address: IPv6, or IPv4 in the last four bytes. Returns the port */
+static uint16_t bgp_bmp_addr(uint8_t *p, const struct sockaddr *sa, bool *v6)
+{
+    memset(p, 0, 16);
+    *v6 = false;
+
+    if (sa && sa->sa_family == AF_INET) {
+        const struct sockaddr_in *sin = (const struct sockaddr_in *)sa;
+        memcpy(p + 12, &sin->sin_addr, 4);
+        return ntohs(sin->sin_port);
+    }
+    if (sa && sa->sa_family == AF_INET6) {
+        const struct sockaddr_in6 *sin6 = (const struct sockaddr_in6 *)sa;
+        memcpy(p, &sin6->sin6_addr, 16);
+        *v6 = true;
+        return ntohs(sin6->sin6_port);
+    }
+    return 0;
+}
+
+static void bgp_bmp_peer_hdr(uint8_t *p, const bgp_bmp_peer_t *peer, uint8_t flags)
+{
+    struct timespec ts;
+    bool v6;
+
+    clock_gettime(CLOCK_REALTIME, &ts);
+
+    p[0] = peer->vrf_id ? BGP_BMP_PEER_RD : BGP_BMP_PEER_GLOBAL;
+    /* Distinguisher: a type 0 route distinguisher 0:vrf_id */
+    memset(p + 2, 0, 8);
+    if (peer->vrf_id) bgp_bmp_put32(p + 6, peer->vrf_id);
+    bgp_bmp_addr(p + 10, (const struct sockaddr *)&peer->addr, &v6);
+    p[1] = flags | (v6 ? BGP_BMP_FLAG_V6 : 0);
+    bgp_bmp_put32(p + 26, peer->as);
+    bgp_bmp_put32(p + 30, peer->bgp_id);
+    bgp_bmp_put32(p + 34, (uint32_t)ts.tv_sec);
+    bgp_bmp_put32(p + 38, (uint32_t)(ts.tv_nsec / 1000));
+}
+
+/* ---------------------------------------------------------------- worker side */
+
+/*
+ * Whether a message of len bytes fits in the ring. Every message leaves
+ * room for a compact Peer Down per other peer up. All but compact Peer
+ * Downs also leave room for one wrap of the ring, which compact Peer
+ * Downs cross at most once between two other messages.
+ */
+static bool bgp_bmp_fits(const bgp_bmp_ring_t *r, uint8_t type, uint32_t len,
+                         uint64_t tail, uint64_t head)
+{
+    uint32_t need = BGP_BMP_REC_ALIGN(4 + len);
+    uint32_t off = (uint32_t)(tail & (BGP_BMP_RING_SIZE - 1));
+    uint32_t pad = off + need > BGP_BMP_RING_SIZE ? BGP_BMP_RING_SIZE - off : 0;
+    uint64_t used = tail - head + pad + need;
+    uint64_t held;
+
+    if (type != BGP_BMP_PEER_DOWN) {
+        held = ((uint64_t)r->up + (type == BGP_BMP_PEER_UP) + 1) * BGP_BMP_DOWN_MIN;
+    } else if (need > BGP_BMP_DOWN_MIN) {
+        held = (uint64_t)r->up * BGP_BMP_DOWN_MIN;
+    } else {
+        held = (uint64_t)(r->up ? r->up - 1 : 0) * BGP_BMP_DOWN_MIN;
+    }
+    if (type == BGP_BMP_ROUTE_MONITORING && used > BGP_BMP_RING_SIZE / 4 * 3) return false;
+    return len <= BGP_BMP_MAX_MSG && used + held <= BGP_BMP_RING_SIZE;
+}
+
+/*
+ * Reserve len bytes in the shard's ring for a message of the given
+ * type. Returns where to encode it, or NULL if it was dropped.
+ */
+static uint8_t *bgp_bmp_reserve(bgp_bmp_t *b, uint8_t shard, uint8_t type, uint32_t len)
+{
+    if (!b || shard >= b->nshards) return NULL;
+
+    bgp_bmp_ring_t *r = &b->rings[shard];
+    uint32_t need = BGP_BMP_REC_ALIGN(4 + len);
+    uint64_t tail = atomic_load_explicit(&r->tail, memory_order_relaxed);
+    uint64_t head = atomic_load_explicit(&r->head, memory_order_acquire);
+    uint32_t off = (uint32_t)(tail & (BGP_BMP_RING_SIZE - 1));
+    uint32_t pad = off + need > BGP_BMP_RING_SIZE ? BGP_BMP_RING_SIZE - off : 0;
+
+    if (!bgp_bmp_fits(r, type, len, tail, head)) {
+        atomic_fetch_add_explicit(&r->dropped[type], 1, memory_order_relaxed);
+        return NULL;
+    }
+
+    if (pad) {
+        uint32_t mark = BGP_BMP_REC_PAD | pad;
+        memcpy(r->buf + off, &mark, 4);
+        tail += pad;
+        off = 0;
+    }
+    memcpy(r->buf + off, &need, 4);
+    return r->buf + off + 4;
+}
+
+/* Publish the message encoded after bgp_bmp_reserve() */
+static int bgp_bmp_commit(bgp_bmp_t *b, uint8_t shard, uint8_t type)
+{
+    bgp_bmp_ring_t *r = &b->rings[shard];
+    uint64_t tail = atomic_load_explicit(&r->tail, memory_order_relaxed);
+    uint32_t off = (uint32_t)(tail & (BGP_BMP_RING_SIZE - 1));
+    uint32_t word;
+
+    memcpy(&word, r->buf + off, 4);
+    if (word & BGP_BMP_REC_PAD) {
+        tail += word & ~BGP_BMP_REC_PAD;
+        memcpy(&word, r->buf, 4);
+    }
+
+    atomic_store_explicit(&r->tail, tail + word, memory_order_release);
+    atomic_fetch_add_explicit(&r->queued[type], 1, memory_order_relaxed);
+    if (type == BGP_BMP_PEER_UP) r->up++;
+    else if (type == BGP_BMP_PEER_DOWN && r->up > 0) r->up--;
+    return 0;
+}
+
+int bgp_bmp_peer_up(bgp_bmp_t *b, uint8_t shard, const bgp_bmp_peer_t *peer,
+                    const struct sockaddr *local, const uint8_t *sent_open, uint16_t sent_len,
+                    const uint8_t *recv_open, uint16_t recv_len)
+{
+    uint32_t len = BGP_BMP_COMMON_LEN + BGP_BMP_PEER_HDR_LEN + 20 + sent_len + recv_len;
+    uint8_t *p = bgp_bmp_reserve(b, shard, BGP_BMP_PEER_UP, len);
+    uint8_t remote[16];
+    bool v6;
+
+    if (!p) return -1;
+
+    bgp_bmp_common(p, len, BGP_BMP_PEER_UP);
+    bgp_bmp_peer_hdr(p + BGP_BMP_COMMON_LEN, peer, 0);
+
+    uint8_t *q = p + BGP_BMP_COMMON_LEN + BGP_BMP_PEER_HDR_LEN;
+    bgp_bmp_put16(q + 16, bgp_bmp_addr(q, local, &v6));
+    bgp_bmp_put16(q + 18, bgp_bmp_addr(remote, (const struct sockaddr *)&peer->addr, &v6));
+    memcpy(q + 20, sent_open, sent_len);
+    memcpy(q + 20 + sent_len, recv_open, recv_len);
+
+    return bgp_bmp_commit(b, shard, BGP_BMP_PEER_UP);
+}
+
+int bgp_bmp_peer_down(bgp_bmp_t *b, uint8_t shard, const bgp_bmp_peer_t *peer, uint8_t reason,
+                      const uint8_t *notification, uint16_t len, uint16_t fsm_event)
+{
+    bool notify = reason == BGP_BMP_DOWN_LOCAL_NOTIFY || reason == BGP_BMP_DOWN_REMOTE_NOTIFY;
+    uint32_t data = reason == BGP_BMP_DOWN_LOCAL_NO_NOTIFY ? 2 : notify ? len : 0;
+    uint32_t total = BGP_BMP_COMMON_LEN + BGP_BMP_PEER_HDR_LEN + 1 + data;
+
+    /* No room for the full NOTIFICATION: keep its code and subcode only */
+    if (notify && len > BGP_BMP_NOTIFY_MIN && b && shard < b->nshards) {
+        bgp_bmp_ring_t *r = &b->rings[shard];
+        if (!bgp_bmp_fits(r, BGP_BMP_PEER_DOWN, total,
+                          atomic_load_explicit(&r->tail, memory_order_relaxed),
+                          atomic_load_explicit(&r->head, memory_order_acquire))) {
+            data = BGP_BMP_NOTIFY_MIN;
+            total = BGP_BMP_COMMON_LEN + BGP_BMP_PEER_HDR_LEN + 1 + data;
+        }
+    }
+
+    uint8_t *p = bgp_bmp_reserve(b, shard, BGP_BMP_PEER_DOWN, total);
+
+    if (!p) return -1;
+
+    bgp_bmp_common(p, total, BGP_BMP_PEER_DOWN);
+    bgp_bmp_peer_hdr(p + BGP_BMP_COMMON_LEN, peer, 0);
+
+    uint8_t *q = p + BGP_BMP_COMMON_LEN + BGP_BMP_PEER_HDR_LEN;
+    q[0] = reason;
+    if (reason == BGP_BMP_DOWN_LOCAL_NO_NOTIFY) {
+        bgp_bmp_put16(q + 1, fsm_event);
+    } else if (data) {
+        memcpy(q + 1, notification, data);
+        if (data < len) bgp_bmp_put16(q + 1 + 16, (uint16_t)data);
+    }
+
+    return bgp_bmp_commit(b, shard, BGP_BMP_PEER_DOWN);
+}
+
+int bgp_bmp_hold_expired(bgp_bmp_t *b, uint8_t shard, const bgp_bmp_peer_t *peer)
+{
+    uint8_t notify[21];
+
+    /* RFC 4271 NOTIFICATION: marker, length, type 3, Hold Timer Expired, subcode 0 */
+    memset(notify, 0xff, 16);
+    bgp_bmp_put16(notify + 16, sizeof(notify));
+    notify[18] = 3;
+    notify[19] = BGP_NOTIFY_HOLD_EXPIRED;
+    notify[20] = 0;
+
+    return bgp_bmp_peer_down(b, shard, peer, BGP_BMP_DOWN_LOCAL_NOTIFY, notify,
+                             sizeof(notify), 0);
+}
+
+int bgp_bmp_route_monitor(bgp_bmp_t *b, uint8_t shard, const bgp_bmp_peer_t *peer,
+                          const uint8_t *update, uint16_t len, bool post_policy)
+{
+    uint32_t total = BGP_BMP_COMMON_LEN + BGP_BMP_PEER_HDR_LEN + len;
+    uint8_t *p = bgp_bmp_reserve(b, shard, BGP_BMP_ROUTE_MONITORING, total);
+
+    if (!p) return -1;
+
+    bgp_bmp_common(p, total, BGP_BMP_ROUTE_MONITORING);
+    bgp_bmp_peer_hdr(p + BGP_BMP_COMMON_LEN, peer, post_policy ? BGP_BMP_FLAG_POST : 0);
+    memcpy(p + BGP_BMP_COMMON_LEN + BGP_BMP_PEER_HDR_LEN, update, len);
+
+    return bgp_bmp_commit(b, shard, BGP_BMP_ROUTE_MONITORING);
+}
+
+/* ---------------------------------------------------------------- exporter */
+
+static uint32_t bgp_bmp_replay_hash(const uint8_t *key)
+{
+    uint32_t h = 2166136261U;
+
+    for (int i = 0; i < BGP_BMP_PEER_KEY_LEN; i++) h = (h ^ key[i]) * 16777619U;
+    return h & (BGP_BMP_REPLAY_BUCKETS - 1);
+}
+
+/* Keep Peer Up messages for established peers; drop them on Peer Down */
+static void bgp_bmp_track(bgp_bmp_t *b, const uint8_t *msg, uint32_t len)
+{
+    uint8_t type = msg[5];
+    const uint8_t *key = msg + BGP_BMP_COMMON_LEN;
+
+    if (type != BGP_BMP_PEER_UP && type != BGP_BMP_PEER_DOWN) return;
+
+    bgp_bmp_replay_t **link = &b->replay[bgp_bmp_replay_hash(key)];
+    while (*link) {
+        /* Flags differ only in V, which follows from the address */
+        if (memcmp((*link)->msg + BGP_BMP_COMMON_LEN, key, 1) == 0 &&
+            memcmp((*link)->msg + BGP_BMP_COMMON_LEN + 2, key + 2,
+                   BGP_BMP_PEER_KEY_LEN - 2) == 0) break;
+        link = &(*link)->next;
+    }
+
+    if (type == BGP_BMP_PEER_DOWN) {
+        if (*link) {
+            bgp_bmp_replay_t *r = *link;
+            *link = r->next;
+            free(r);
+            atomic_fetch_sub(&b->peers_up, 1);
+        }
+        return;
+    }
+
+    bgp_bmp_replay_t *r = malloc(sizeof(bgp_bmp_replay_t) + len);
+    if (!r) return;
+    r->len = len;
+    memcpy(r->msg, msg, len);
+
+    if (*link) {
+        r->next = (*link)->next;
+        free(*link);
+    } else {
+        r->next = NULL;
+        atomic_fetch_add(&b->peers_up, 1);
+    }
+    *link = r;
+}
+
+static bool bgp_bmp_out(bgp_bmp_t *b, const uint8_t *msg, uint32_t len)
+{
+    if (len > BGP_BMP_OUT_BUF - b->out_len) return false;
+
+    memcpy(b->out + b->out_len, msg, len);
+    b->out_len += len;
+    b->out_msgs++;
+    return true;
+}
+
+static void bgp_bmp_disconnect(bgp_bmp_t *b, const char *why)
+{
+    syslog_write(LOG_WARNING, "BGP bmp: Collector connection lost: %s", why);
+    close(b->fd);
+    b->fd = -1;
+    atomic_fetch_add(&b->lost, b->out_msgs);
+    atomic_fetch_add(&b->disconnects, 1);
+    atomic_store(&b->connected, false);
+    b->out_len = 0;
+    b->out_msgs = 0;
+    b->next_connect_ms = bgp_bmp_now_ms() + b->backoff_ms;
+}
+
+static void bgp_bmp_initiation(bgp_bmp_t *b)
+{
+    static const char descr[] = "NetBlade OS v3.x";
+    uint8_t msg[BGP_BMP_COMMON_LEN + 4 + sizeof(descr) + 4 + sizeof(b->sys_name)];
+    uint16_t name_len = (uint16_t)strlen(b->sys_name);
+    uint8_t *p = msg + BGP_BMP_COMMON_LEN;
+
+    bgp_bmp_put16(p, BGP_BMP_TLV_SYS_DESCR);
+    bgp_bmp_put16(p + 2, sizeof(descr) - 1);
+    memcpy(p + 4, descr, sizeof(descr) - 1);
+    p += 4 + sizeof(descr) - 1;
+    bgp_bmp_put16(p, BGP_BMP_TLV_SYS_NAME);
+    bgp_bmp_put16(p + 2, name_len);
+    memcpy(p + 4, b->sys_name, name_len);
+    p += 4 + name_len;
+
+    bgp_bmp_common(msg, (uint32_t)(p - msg), BGP_BMP_INITIATION);
+    bgp_bmp_out(b, msg, (uint32_t)(p - msg));
+}
+
+static void bgp_bmp_connect(bgp_bmp_t *b)
+{
+    struct pollfd pfd;
+    int err = 0;
+    socklen_t elen = sizeof(err);
+
+    b->fd = socket(b->collector.ss_family, SOCK_STREAM | SOCK_NONBLOCK | SOCK_CLOEXEC, 0);
+    if (b->fd < 0) goto fail;
+
+    if (connect(b->fd, (struct sockaddr *)&b->collector, b->collector_len) != 0) {
+        if (errno != EINPROGRESS) goto fail;
+        pfd.fd = b->fd;
+        pfd.events = POLLOUT;
+        if (poll(&pfd, 1, BGP_BMP_CONNECT_MS) != 1) {
+            errno = ETIMEDOUT;
+            goto fail;
+        }
+        if (getsockopt(b->fd, SOL_SOCKET, SO_ERROR, &err, &elen) != 0 || err != 0) {
+            errno = err;
+            goto fail;
+        }
+    }
+
+    syslog_write(LOG_INFO, "BGP bmp: Connected to collector, replaying %u peers",
+        atomic_load(&b->peers_up));
+    atomic_fetch_add(&b->connects, 1);
+    atomic_store(&b->connected, true);
+    b->backoff_ms = BGP_BMP_BACKOFF_MIN_MS;
+
+    /* RFC 7854 section 3.3: Initiation first, then Peer Up for every established session */
+    bgp_bmp_initiation(b);
+    b->replay_bucket = 0;
+    b->replay_next = NULL;
+    return;
+
+fail:
+    if (b->fd >= 0) close(b->fd);
+    b->fd = -1;
+    b->next_connect_ms = bgp_bmp_now_ms() + b->backoff_ms;
+    if (b->backoff_ms < BGP_BMP_BACKOFF_MAX_MS) b->backoff_ms *= 2;
+}
+
+static bool bgp_bmp_replaying(const bgp_bmp_t *b)
+{
+    return b->replay_next || b->replay_bucket < BGP_BMP_REPLAY_BUCKETS;
+}
+
+/*
+ * Continue the replay where the last call stopped. The table only
+ * changes as the rings drain, and they wait for the replay, so the
+ * cursor stays valid across flushes. Returns messages queued.
+ */
+static uint32_t bgp_bmp_replay(bgp_bmp_t *b)
+{
+    uint32_t taken = 0;
+
+    while (bgp_bmp_replaying(b)) {
+        if (!b->replay_next) {
+            b->replay_next = b->replay[b->replay_bucket++];
+            continue;
+        }
+        if (!bgp_bmp_out(b, b->replay_next->msg, b->replay_next->len)) break;
+        b->replay_next = b->replay_next->next;
+        taken++;
+    }
+    return taken;
+}
+
+/* Move records from the rings to the send buffer; returns records taken */
+static uint32_t bgp_bmp_drain(bgp_bmp_t *b)
+{
+    uint32_t taken = 0;
+
+    if (b->fd >= 0 && bgp_bmp_replaying(b)) {
+        taken = bgp_bmp_replay(b);
+        if (bgp_bmp_replaying(b)) return taken;
+    }
+
+    for (uint8_t s = 0; s < b->nshards; s++) {
+        bgp_bmp_ring_t *r = &b->rings[s];
+        uint64_t head = atomic_load_explicit(&r->head, memory_order_relaxed);
+        uint64_t tail = atomic_load_explicit(&r->tail, memory_order_acquire);
+
+        while (head != tail) {
+            uint32_t off = (uint32_t)(head & (BGP_BMP_RING_SIZE - 1));
+            uint32_t word;
+
+            memcpy(&word, r->buf + off, 4);
+            if (word & BGP_BMP_REC_PAD) {
+                head += word & ~BGP_BMP_REC_PAD;
+                continue;
+            }
+
+            const uint8_t *msg = r->buf + off + 4;
+            uint32_t len = ((uint32_t)msg[1] << 24) | ((uint32_t)msg[2] << 16) |
+                           ((uint32_t)msg[3] << 8) | msg[4];
+
+            if (b->fd >= 0) {
+                if (!bgp_bmp_out(b, msg, len)) break;   /* Collector behind */
+            } else {
+                atomic_fetch_add_explicit(&b->discarded, 1, memory_order_relaxed);
+            }
+            bgp_bmp_track(b, msg, len);
+            head += word;
+            taken++;
+        }
+        atomic_store_explicit(&r->head, head, memory_order_release);
+    }
+    return taken;
+}
+
+static void bgp_bmp_flush(bgp_bmp_t *b)
+{
+    uint32_t done = 0;
+
+    while (done < b->out_len) {
+        ssize_t n = send(b->fd, b->out + done, b->out_len - done, MSG_DONTWAIT | MSG_NOSIGNAL);
+        if (n < 0) {
+            if (errno == EINTR) continue;
+            if (errno == EAGAIN || errno == EWOULDBLOCK) break;
+            bgp_bmp_disconnect(b, strerror(errno));
+            return;
+        }
+        done += (uint32_t)n;
+    }
+
+    atomic_fetch_add_explicit(&b->sent_bytes, done, memory_order_relaxed);
+    if (done == b->out_len) {
+        atomic_fetch_add_explicit(&b->sent, b->out_msgs, memory_order_relaxed);
+        b->out_msgs = 0;
+    }
+    b->out_len -= done;
+    if (b->out_len) memmove(b->out, b->out + done, b->out_len);
+}
+
+static void bgp_bmp_terminate(bgp_bmp_t *b)
+{
+    uint8_t msg[BGP_BMP_COMMON_LEN + 6];
+    struct pollfd pfd = { .fd = b->fd, .events = POLLOUT };
+
+    bgp_bmp_common(msg, sizeof(msg), BGP_BMP_TERMINATION);
+    bgp_bmp_put16(msg + 6, BGP_BMP_TLV_REASON);
+    bgp_bmp_put16(msg + 8, 2);
+    bgp_bmp_put16(msg + 10, 0);     /* Session administratively closed */
+    bgp_bmp_out(b, msg, sizeof(msg));
+
+    uint64_t deadline = bgp_bmp_now_ms() + BGP_BMP_CONNECT_MS;
+    while (b->fd >= 0 && b->out_len > 0 && bgp_bmp_now_ms() < deadline) {
+        bgp_bmp_flush(b);
+        if (b->fd >= 0 && b->out_len > 0) poll(&pfd, 1, BGP_BMP_FLUSH_MS);
+    }
+}
+
+static void *bgp_bmp_thread(void *arg)
+{
+    bgp_bmp_t *b = arg;
+
+    pthread_setname_np(pthread_self(), "bgp-bmp");
+
+    while (atomic_load(&b->running)) {
+        if (b->fd < 0 && bgp_bmp_now_ms() >= b->next_connect_ms) bgp_bmp_connect(b);
+
+        uint32_t taken = bgp_bmp_drain(b);
+        if (b->fd >= 0 && b->out_len > 0) bgp_bmp_flush(b);
+
+        /* Busy: go round again. Idle or blocked on the collector: wait a little */
+        if (taken > 0 && (b->fd < 0 || b->out_len < BGP_BMP_OUT_BUF / 2)) continue;
+
+        struct pollfd pfd = { .fd = b->fd, .events = POLLOUT };
+        poll(&pfd, b->fd >= 0 && b->out_len > 0 ? 1 : 0, BGP_BMP_FLUSH_MS);
+    }
+
+    if (b->fd >= 0) {
+        bgp_bmp_drain(b);
+        bgp_bmp_terminate(b);
+        close(b->fd);
+        b->fd = -1;
+    }
+    return NULL;
+}
+
+bgp_bmp_t *bgp_bmp_create(const struct sockaddr *collector, socklen_t len,
+                          const char *sys_name, uint8_t nshards)
+{
+    if (!collector || len > sizeof(struct sockaddr_storage) ||
+        nshards == 0 || nshards > BGP_BMP_MAX_SHARDS) return NULL;
+
+    bgp_bmp_t *b = calloc(1, sizeof(bgp_bmp_t));
+    if (!b) return NULL;
+
+    memcpy(&b->collector, collector, len);
+    b->collector_len = len;
+    strncpy(b->sys_name, sys_name ? sys_name : "netblade", sizeof(b->sys_name) - 1);
+    b->nshards = nshards;
+    b->fd = -1;
+    b->backoff_ms = BGP_BMP_BACKOFF_MIN_MS;
+    b->replay_bucket = BGP_BMP_REPLAY_BUCKETS;
+
+    b->out = malloc(BGP_BMP_OUT_BUF);
+    if (!b->out) goto fail;
+    for (uint8_t s = 0; s < nshards; s++) {
+        b->rings[s].buf = malloc(BGP_BMP_RING_SIZE);
+        if (!b->rings[s].buf) goto fail;
+    }
+
+    atomic_store(&b->running, true);
+    if (pthread_create(&b->thread, NULL, bgp_bmp_thread, b) != 0) {
+        syslog_write(LOG_ERR, "BGP bmp: Cannot start exporter thread");
+        goto fail;
+    }
+
+    syslog_write(LOG_INFO, "BGP bmp: Exporting %d workers, %d KB queue each",
+        nshards, BGP_BMP_RING_SIZE / 1024);
+    return b;
+
+fail:
+    for (uint8_t s = 0; s < nshards; s++) free(b->rings[s].buf);
+    free(b->out);
+    free(b);
+    return NULL;
+}
+
+void bgp_bmp_destroy(bgp_bmp_t *b)
+{
+    if (!b) return;
+
+    atomic_store(&b->running, false);
+    pthread_join(b->thread, NULL);
+
+    for (int i = 0; i < BGP_BMP_REPLAY_BUCKETS; i++) {
+        bgp_bmp_replay_t *r = b->replay[i];
+        while (r) {
+            bgp_bmp_replay_t *next = r->next;
+            free(r);
+            r = next;
+        }
+    }
+    for (uint8_t s = 0; s < b->nshards; s++) free(b->rings[s].buf);
+    free(b->out);
+    free(b);
+}
+
+void bgp_bmp_get_stats(bgp_bmp_t *b, bgp_bmp_stats_t *stats)
+{
+    memset(stats, 0, sizeof(*stats));
+
+    for (uint8_t s = 0; s < b->nshards; s++) {
+        for (int t = 0; t < BGP_BMP_MSG_TYPES; t++) {
+            stats->queued[t] += atomic_load_explicit(&b->rings[s].queued[t], memory_order_relaxed);
+            stats->dropped[t] += atomic_load_explicit(&b->rings[s].dropped[t], memory_order_relaxed);
+        }
+    }
+    stats->sent = atomic_load(&b->sent);
+    stats->sent_bytes = atomic_load(&b->sent_bytes);
+    stats->discarded = atomic_load(&b->discarded);
+    stats->lost = atomic_load(&b->lost);
+    stats->connects = atomic_load(&b->connects);
+    stats->disconnects = atomic_load(&b->disconnects);
+    stats->peers_up = atomic_load(&b->peers_up);
+    stats->connected = atomic_load(&b->connected);
+}
+
+void bgp_bmp_dump(bgp_bmp_t *b)
+{
+    static const char *names[BGP_BMP_MSG_TYPES] = {
+        "route-monitoring", "stats-report", "peer-down", "peer-up", "initiation", "termination",
+    };
+    bgp_bmp_stats_t st;
+
+    bgp_bmp_get_stats(b, &st);
+
+    syslog_write(LOG_INFO, "BGP bmp: Collector %s, %u peers up; %llu messages sent "
+        "(%llu bytes), %llu discarded while disconnected, %llu lost on disconnect, "
+        "%llu connects", st.connected ? "connected" : "down", st.peers_up,
+        (unsigned long long)st.sent, (unsigned long long)st.sent_bytes,
+        (unsigned long long)st.discarded, (unsigned long long)st.lost,
+        (unsigned long long)st.connects);
+
+    for (int t = 0; t < BGP_BMP_MSG_TYPES; t++) {
+        if (st.queued[t] == 0 && st.dropped[t] == 0) continue;
+        syslog_write(LOG_INFO, "  %-16s %llu queued, %llu dropped", names[t],
+            (unsigned long long)st.queued[t], (unsigned long long)st.dropped[t]);
+    }
+}
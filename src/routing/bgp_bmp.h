@@ -0,0 +1,87 @@
+/*
+ * bgp_bmp.h - BGP Monitoring Protocol (RFC 7854) Exporter
+ *
+ * NetBlade OS v3.x Routing Engine
+ * Copyright (c) 2024-2026 Enterprise Systems Inc. All rights reserved.
+ */
+
+#ifndef BGP_BMP_H
+#define BGP_BMP_H
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <sys/socket.h>
+
+#define BGP_BMP_RING_SIZE       (1 << 20)   /* Per worker; power of two */
+#define BGP_BMP_OUT_BUF         (1 << 20)   /* Exporter send buffer */
+#define BGP_BMP_MAX_MSG         8192        /* Larger messages are dropped */
+#define BGP_BMP_MAX_SHARDS      64          /* Matches BGP_SHARD_MAX */
+
+/* Peer Down reasons, RFC 7854 section 4.9 */
+#define BGP_BMP_DOWN_LOCAL_NOTIFY   1   /* data: NOTIFICATION we sent */
+#define BGP_BMP_DOWN_LOCAL_NO_NOTIFY 2  /* data: FSM event code */
+#define BGP_BMP_DOWN_REMOTE_NOTIFY  3   /* data: NOTIFICATION we received */
+#define BGP_BMP_DOWN_REMOTE_NO_DATA 4   /* Transport closed */
+#define BGP_BMP_DOWN_DECONFIGURED   5
+
+/* Message types, RFC 7854 section 4.1 */
+#define BGP_BMP_ROUTE_MONITORING    0
+#define BGP_BMP_STATS_REPORT        1
+#define BGP_BMP_PEER_DOWN           2
+#define BGP_BMP_PEER_UP             3
+#define BGP_BMP_INITIATION          4
+#define BGP_BMP_TERMINATION         5
+#define BGP_BMP_MSG_TYPES           6
+
+typedef struct {
+    uint32_t vrf_id;            /* 0: global instance; else RD instance 0:vrf_id */
+    uint32_t as;
+    uint32_t bgp_id;
+    struct sockaddr_storage addr;   /* Peer address and port */
+} bgp_bmp_peer_t;
+
+typedef struct {
+    uint64_t queued[BGP_BMP_MSG_TYPES];
+    uint64_t dropped[BGP_BMP_MSG_TYPES];    /* Worker queue full; routing never waits */
+    uint64_t sent;
+    uint64_t sent_bytes;
+    uint64_t discarded;         /* Drained with no collector connected */
+    uint64_t lost;              /* Buffered when the collector connection failed */
+    uint64_t connects;
+    uint64_t disconnects;
+    uint32_t peers_up;          /* Replayed to a collector that (re)connects */
+    bool     connected;
+} bgp_bmp_stats_t;
+
+typedef struct bgp_bmp bgp_bmp_t;
+
+/* Start the exporter thread; it connects to the collector and reconnects as needed */
+bgp_bmp_t *bgp_bmp_create(const struct sockaddr *collector, socklen_t len,
+                          const char *sys_name, uint8_t nshards);
+/* Sends Termination if connected, then stops the thread */
+void bgp_bmp_destroy(bgp_bmp_t *b);
+
+/*
+ * Called by the worker owning the peer; each worker uses only its own
+ * shard's queue. These never block: when the queue is full the event
+ * is counted and dropped. Returns 0 if queued.
+ *
+ * Peer Down is the exception: room for it is held back while the peer
+ * is up, so it is only dropped for a peer whose Peer Up was. It is sent
+ * without NOTIFICATION data when only that room is left.
+ */
+int bgp_bmp_peer_up(bgp_bmp_t *b, uint8_t shard, const bgp_bmp_peer_t *peer,
+                    const struct sockaddr *local, const uint8_t *sent_open, uint16_t sent_len,
+                    const uint8_t *recv_open, uint16_t recv_len);
+int bgp_bmp_peer_down(bgp_bmp_t *b, uint8_t shard, const bgp_bmp_peer_t *peer, uint8_t reason,
+                      const uint8_t *notification, uint16_t len, uint16_t fsm_event);
+/* Peer Down with the Hold Timer Expired NOTIFICATION we sent */
+int bgp_bmp_hold_expired(bgp_bmp_t *b, uint8_t shard, const bgp_bmp_peer_t *peer);
+/* An UPDATE as received (pre-policy) or as installed (post-policy) */
+int bgp_bmp_route_monitor(bgp_bmp_t *b, uint8_t shard, const bgp_bmp_peer_t *peer,
+                          const uint8_t *update, uint16_t len, bool post_policy);
+
+void bgp_bmp_get_stats(bgp_bmp_t *b, bgp_bmp_stats_t *stats);
+void bgp_bmp_dump(bgp_bmp_t *b);
+
+#endif /* BGP_BMP_H */
@@ -0,0 +1,99 @@
+/*
+ * bgp_connect.h - Batched Outbound BGP Connects
+ *
+ * NetBlade OS v3.x Routing Engine
+ * Copyright (c) 2024-2026 Enterprise Systems Inc. All rights reserved.
+ */
+
+#ifndef BGP_CONNECT_H
+#define BGP_CONNECT_H
+
+#include <stdint.h>
+#include <sys/socket.h>
+#include "bgp_io.h"
+#include "bgp_wheel.h"
+
+#define BGP_CONNECT_MAX_PEERS       16384   /* Matches BGP_IO_MAX_CONNS */
+#define BGP_CONNECT_MAX_VRFS        256     /* Matches BGP_SHARD_MAX_VRFS */
+#define BGP_CONNECT_LAT_BUCKETS     16      /* Powers of two from 1 ms */
+
+/* Defaults for a zeroed bgp_connect_config_t */
+#define BGP_CONNECT_DEFAULT_BATCH       256
+#define BGP_CONNECT_DEFAULT_PER_VRF     64
+#define BGP_CONNECT_DEFAULT_PER_DEST    1
+#define BGP_CONNECT_DEFAULT_TIMEOUT_MS  10000
+
+typedef uint32_t bgp_connect_peer_t;
+
+typedef struct {
+    uint32_t batch;             /* Connects issued per poll */
+    uint32_t per_vrf;           /* In flight per VRF */
+    uint32_t per_dest;          /* In flight per remote address within a VRF */
+    uint32_t timeout_ms;        /* Per attempt */
+} bgp_connect_config_t;
+
+/*
+ * An attempt finished. On success fd is a connected non-blocking socket
+ * now owned by the caller, and retries stop until bgp_connect_start().
+ * On failure fd is -1 and the next attempt is already scheduled.
+ */
+typedef void (*bgp_connect_cb_t)(void *peer_ctx, int fd, int err);
+
+typedef struct {
+    uint64_t attempts;
+    uint64_t connected;
+    uint64_t refused;
+    uint64_t unreachable;       /* Host or network unreachable, other errors */
+    uint64_t timed_out;
+    uint64_t deferred_vrf;      /* Held back by the per-VRF cap */
+    uint64_t deferred_dest;     /* ...by the per-destination cap */
+    uint64_t timer_failed;      /* Retry or timeout refused by a full wheel, re-added later */
+    uint64_t batches;
+    uint64_t syscalls;
+    uint32_t in_flight;
+    uint64_t lat_ns_total;      /* Successful attempts */
+    uint64_t lat_ns_max;
+    uint64_t lat_hist[BGP_CONNECT_LAT_BUCKETS];
+} bgp_connect_stats_t;
+
+typedef struct {
+    uint32_t in_flight;
+    uint64_t attempts;
+    uint64_t connected;
+} bgp_connect_vrf_stats_t;
+
+typedef struct bgp_connect bgp_connect_t;
+
+/*
+ * One engine per worker, driven by the worker's wheel. Attempts use
+ * the same backend choice as bgp_io.
+ */
+bgp_connect_t *bgp_connect_create(uint8_t backend, bgp_wheel_t *wheel,
+                                  const bgp_connect_config_t *cfg, bgp_connect_cb_t cb);
+void bgp_connect_destroy(bgp_connect_t *c);
+
+/* ifindex is the VRF master device (0 for the default VRF); local may be NULL */
+int bgp_connect_add(bgp_connect_t *c, uint32_t vrf_id, uint32_t ifindex,
+                    const struct sockaddr *peer, socklen_t peer_len,
+                    const struct sockaddr *local, socklen_t local_len,
+                    uint32_t retry_ms, void *peer_ctx, bgp_connect_peer_t *id);
+int bgp_connect_remove(bgp_connect_t *c, bgp_connect_peer_t id);
+
+/* Begin connect-retry; the first attempt is made after delay_ms */
+int bgp_connect_start(bgp_connect_t *c, bgp_connect_peer_t id, uint32_t delay_ms);
+/* Session came up inbound or was shut down; any attempt in flight is abandoned */
+int bgp_connect_stop(bgp_connect_t *c, bgp_connect_peer_t id);
+
+/* The worker polls this fd for readability, runs its wheel, then bgp_connect_poll() */
+int bgp_connect_fd(bgp_connect_t *c);
+/*
+ * Issue due attempts as one batch, then handle completions for up to
+ * timeout_ms; without waiting while more peers are due than one batch
+ */
+int bgp_connect_poll(bgp_connect_t *c, int timeout_ms);
+
+void bgp_connect_get_stats(bgp_connect_t *c, bgp_connect_stats_t *stats);
+int bgp_connect_get_vrf_stats(bgp_connect_t *c, uint32_t vrf_id, bgp_connect_vrf_stats_t *stats);
+void bgp_connect_dump(bgp_connect_t *c);
+
+#endif /* BGP_CONNECT_H */
@@ -0,0 +1,496 @@
+/*
+ * bgp_dynamic.c - Dynamic BGP Neighbors from Listen Ranges
+ *
+ * NetBlade OS v3.x Routing Engine
+ * Copyright (c) 2024-2026 Enterprise Systems Inc. All rights reserved.
+ *
+ * Instead of configuring every neighbour, a VRF lists prefix ranges it
+ * accepts sessions from. A connection from an unknown source inside a
+ * range instantiates a peer from the range template; the peer goes away
+ * with its session.
+ *
+ * Peers are kept compact so that tens of thousands fit in memory sized
+ * once at start-up. They come from a preallocated pool and are indexed
+ * by (VRF, address) in a chained hash, so instantiating one is a pool
+ * pop and a hash insert. A peer keeps no timer configuration of its
+ * own: the template is the VRF's entry in bgp_timers, consulted when
+ * the OPEN arrives, and only the negotiated values are stored. Changing
+ * a VRF's timers therefore applies to every dynamic peer that opens
+ * afterwards without touching the pool.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+#include <stdbool.h>
+#include <time.h>
+#include <netinet/in.h>
+#include "bgp_dynamic.h"
+#include "bgp_timers.h"
+#include "syslog.h"
+#include "nb_mutex.h"
+
+#define BGP_DYN_NONE            UINT32_MAX
+#define BGP_DYN_FREE            UINT16_MAX      /* range of an unused slot */
+
+/* Handle: generation in the high half, slot + 1 in the low half */
+#define BGP_DYN_PEER(slot, gen) (((uint32_t)(gen) << 16) | ((slot) + 1))
+#define BGP_DYN_SLOT(p)         (((p) & 0xffff) - 1)
+#define BGP_DYN_GEN(p)          ((uint16_t)((p) >> 16))
+
+/* 48 bytes per peer */
+typedef struct {
+    uint8_t   addr[16];
+    void     *session;
+    uint32_t  vrf_id;
+    uint32_t  next;             /* Hash chain, or the free list */
+    uint32_t  remote_as;        /* 0 until OPEN */
+    uint16_t  range;
+    uint16_t  gen;
+    uint16_t  hold_time;
+    uint16_t  keepalive;
+} bgp_dyn_slot_t;
+
+typedef struct {
+    bgp_dyn_range_t  cfg;
+    bool             used;
+    bool             removing;
+} bgp_dyn_range_entry_t;
+
+struct bgp_dynamic {
+    nb_mutex_t             lock;
+    bgp_dyn_slot_t        *pool;
+    uint32_t               capacity;
+    uint32_t               free_head;
+    uint32_t              *buckets;
+    uint32_t               bucket_mask;
+
+    bgp_dyn_range_entry_t  ranges[BGP_DYN_MAX_RANGES];
+
+    bgp_dynamic_stats_t    stats;
+};
+
+static uint64_t bgp_dyn_now_ns(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000000000ULL + (uint64_t)ts.tv_nsec;
+}
+
+/* IPv4 becomes IPv4-mapped IPv6; *plen is adjusted to match */
+static bool bgp_dyn_key(const struct sockaddr *sa, uint8_t addr[16], uint8_t *plen)
+{
+    memset(addr, 0, 16);
+    if (!sa) return false;
+
+    if (sa->sa_family == AF_INET) {
+        addr[10] = addr[11] = 0xff;
+        memcpy(&addr[12], &((const struct sockaddr_in *)sa)->sin_addr, 4);
+        if (plen) {
+            if (*plen > 32) return false;
+            *plen += 96;
+        }
+        return true;
+    }
+    if (sa->sa_family == AF_INET6) {
+        const struct sockaddr_in6 *sin6 = (const struct sockaddr_in6 *)sa;
+        memcpy(addr, &sin6->sin6_addr, 16);
+        /* A v4 client on the dual-stack listener arrives v4-mapped already */
+        if (plen && *plen > 128) return false;
+        return true;
+    }
+    return false;
+}
+
+static bool bgp_dyn_prefix_match(const uint8_t *prefix, uint8_t len, const uint8_t *addr)
+{
+    uint8_t bytes = len / 8, bits = len % 8;
+
+    if (memcmp(prefix, addr, bytes) != 0) return false;
+    if (bits == 0) return true;
+
+    uint8_t mask = (uint8_t)(0xff << (8 - bits));
+    return (prefix[bytes] & mask) == (addr[bytes] & mask);
+}
+
+static uint32_t bgp_dyn_hash(bgp_dynamic_t *d, uint32_t vrf_id, const uint8_t addr[16])
+{
+    uint32_t h = 2166136261U ^ vrf_id;
+
+    for (int i = 0; i < 16; i++) h = (h ^ addr[i]) * 16777619U;
+    return h & d->bucket_mask;
+}
+
+/* Called with the lock held */
+static uint32_t bgp_dyn_lookup(bgp_dynamic_t *d, uint32_t vrf_id, const uint8_t addr[16])
+{
+    uint32_t i = d->buckets[bgp_dyn_hash(d, vrf_id, addr)];
+
+    while (i != BGP_DYN_NONE) {
+        bgp_dyn_slot_t *p = &d->pool[i];
+        if (p->vrf_id == vrf_id && memcmp(p->addr, addr, 16) == 0) return i;
+        i = p->next;
+    }
+    return BGP_DYN_NONE;
+}
+
+/* Called with the lock held */
+static bgp_dyn_slot_t *bgp_dyn_slot(bgp_dynamic_t *d, bgp_dyn_peer_t peer)
+{
+    uint32_t i = BGP_DYN_SLOT(peer);
+
+    if (peer == 0 || i >= d->capacity) return NULL;
+
+    bgp_dyn_slot_t *p = &d->pool[i];
+    if (p->range == BGP_DYN_FREE || p->gen != BGP_DYN_GEN(peer)) return NULL;
+    return p;
+}
+
+bgp_dynamic_t *bgp_dynamic_create(uint32_t max_peers)
+{
+    if (max_peers == 0) max_peers = BGP_DYN_DEFAULT_PEERS;
+    if (max_peers > BGP_DYN_MAX_PEERS) return NULL;
+
+    bgp_dynamic_t *d = calloc(1, sizeof(bgp_dynamic_t));
+    if (!d) return NULL;
+
+    uint32_t nbuckets = 1;
+    while (nbuckets < 2 * max_peers) nbuckets <<= 1;
+
+    d->pool = calloc(max_peers, sizeof(bgp_dyn_slot_t));
+    d->buckets = malloc(nbuckets * sizeof(uint32_t));
+    if (!d->pool || !d->buckets) {
+        free(d->pool);
+        free(d->buckets);
+        free(d);
+        return NULL;
+    }
+
+    nb_mutex_init(&d->lock, "bgp_dynamic.lock");
+    d->capacity = max_peers;
+    d->bucket_mask = nbuckets - 1;
+    memset(d->buckets, 0xff, nbuckets * sizeof(uint32_t));
+
+    for (uint32_t i = 0; i < max_peers; i++) {
+        d->pool[i].range = BGP_DYN_FREE;
+        d->pool[i].next = i + 1 < max_peers ? i + 1 : BGP_DYN_NONE;
+    }
+    d->free_head = 0;
+
+    d->stats.capacity = max_peers;
+    d->stats.memory = sizeof(bgp_dynamic_t) + (size_t)max_peers * sizeof(bgp_dyn_slot_t) +
+                      (size_t)nbuckets * sizeof(uint32_t);
+
+    syslog_write(LOG_INFO, "BGP dynamic: Pool of %u peers, %zu KB", max_peers,
+        d->stats.memory / 1024);
+    return d;
+}
+
+void bgp_dynamic_destroy(bgp_dynamic_t *d)
+{
+    if (!d) return;
+
+    nb_mutex_destroy(&d->lock);
+    free(d->buckets);
+    free(d->pool);
+    free(d);
+}
+
+int bgp_dynamic_add_range(bgp_dynamic_t *d, uint32_t vrf_id, const struct sockaddr *prefix,
+                          uint8_t len, uint32_t remote_as, uint32_t max_peers)
+{
+    uint8_t addr[16];
+    int r = -1;
+
+    if (!bgp_dyn_key(prefix, addr, &len)) return -1;
+
+    nb_mutex_lock(&d->lock);
+
+    for (int i = 0; i < BGP_DYN_MAX_RANGES; i++) {
+        if (d->ranges[i].used) continue;
+
+        bgp_dyn_range_entry_t *e = &d->ranges[i];
+        memset(e, 0, sizeof(*e));
+        e->used = true;
+        e->cfg.vrf_id = vrf_id;
+        e->cfg.prefix_len = len;
+        e->cfg.remote_as = remote_as;
+        e->cfg.max_peers = max_peers;
+        /* Keep host bits out so matching is a plain compare */
+        for (int b = 0; b < 16; b++) {
+            int keep = len - b * 8;
+            uint8_t mask = keep >= 8 ? 0xff : keep <= 0 ? 0 : (uint8_t)(0xff << (8 - keep));
+            e->cfg.prefix[b] = addr[b] & mask;
+        }
+        r = i;
+        break;
+    }
+
+    nb_mutex_unlock(&d->lock);
+
+    if (r < 0) {
+        syslog_write(LOG_ERR, "BGP dynamic: No room for another listen range in VRF %u", vrf_id);
+    }
+    return r;
+}
+
+/* Called with the lock held */
+static void bgp_dyn_free(bgp_dynamic_t *d, uint32_t i)
+{
+    bgp_dyn_slot_t *p = &d->pool[i];
+    uint32_t *link = &d->buckets[bgp_dyn_hash(d, p->vrf_id, p->addr)];
+
+    while (*link != i) link = &d->pool[*link].next;
+    *link = p->next;
+
+    d->ranges[p->range].cfg.peers--;
+    d->stats.peers--;
+    d->stats.released++;
+
+    p->range = BGP_DYN_FREE;
+    p->gen++;
+    p->session = NULL;
+    p->next = d->free_head;
+    d->free_head = i;
+}
+
+int bgp_dynamic_remove_range(bgp_dynamic_t *d, int range, bgp_dynamic_remove_cb_t cb, void *ctx)
+{
+    if (range < 0 || range >= BGP_DYN_MAX_RANGES) return -1;
+
+    nb_mutex_lock(&d->lock);
+
+    bgp_dyn_range_entry_t *e = &d->ranges[range];
+    if (!e->used || e->removing) {
+        nb_mutex_unlock(&d->lock);
+        return -1;
+    }
+    e->removing = true;
+
+    /* The owner tears each session down, normally releasing the peer from cb */
+    for (uint32_t i = 0; i < d->capacity && e->cfg.peers > 0; i++) {
+        bgp_dyn_slot_t *p = &d->pool[i];
+        if (p->range != (uint16_t)range) continue;
+
+        bgp_dyn_peer_t peer = BGP_DYN_PEER(i, p->gen);
+        void *session = p->session;
+
+        if (cb) {
+            nb_mutex_unlock(&d->lock);
+            cb(peer, session, ctx);
+            nb_mutex_lock(&d->lock);
+        }
+        if (bgp_dyn_slot(d, peer)) bgp_dyn_free(d, i);
+    }
+
+    syslog_write(LOG_INFO, "BGP dynamic: Removed range %d from VRF %u", range, e->cfg.vrf_id);
+    e->used = false;
+    e->removing = false;
+
+    nb_mutex_unlock(&d->lock);
+    return 0;
+}
+
+int bgp_dynamic_accept(bgp_dynamic_t *d, uint32_t vrf_id, const struct sockaddr *addr,
+                       void *session, bgp_dyn_peer_t *peer)
+{
+    uint64_t start = bgp_dyn_now_ns();
+    uint8_t key[16];
+
+    *peer = 0;
+    if (!bgp_dyn_key(addr, key, NULL)) return BGP_DYN_NO_RANGE;
+
+    nb_mutex_lock(&d->lock);
+
+    uint32_t i = bgp_dyn_lookup(d, vrf_id, key);
+    if (i != BGP_DYN_NONE) {
+        *peer = BGP_DYN_PEER(i, d->pool[i].gen);
+        nb_mutex_unlock(&d->lock);
+        return BGP_DYN_EXISTS;
+    }
+
+    int best = -1;
+    for (int r = 0; r < BGP_DYN_MAX_RANGES; r++) {
+        const bgp_dyn_range_entry_t *e = &d->ranges[r];
+        if (!e->used || e->removing || e->cfg.vrf_id != vrf_id) continue;
+        if (!bgp_dyn_prefix_match(e->cfg.prefix, e->cfg.prefix_len, key)) continue;
+        if (best < 0 || e->cfg.prefix_len > d->ranges[best].cfg.prefix_len) best = r;
+    }
+
+    int ret = BGP_DYN_OK;
+    if (best < 0) {
+        d->stats.rejected_range++;
+        ret = BGP_DYN_NO_RANGE;
+    } else if (d->ranges[best].cfg.max_peers &&
+               d->ranges[best].cfg.peers >= d->ranges[best].cfg.max_peers) {
+        d->stats.rejected_limit++;
+        ret = BGP_DYN_RANGE_FULL;
+    } else if (d->free_head == BGP_DYN_NONE) {
+        d->stats.rejected_limit++;
+        ret = BGP_DYN_POOL_FULL;
+    }
+    if (ret != BGP_DYN_OK) {
+        nb_mutex_unlock(&d->lock);
+        return ret;
+    }
+
+    i = d->free_head;
+    bgp_dyn_slot_t *p = &d->pool[i];
+    uint32_t *bucket = &d->buckets[bgp_dyn_hash(d, vrf_id, key)];
+
+    d->free_head = p->next;
+    memcpy(p->addr, key, 16);
+    p->vrf_id = vrf_id;
+    p->session = session;
+    p->range = (uint16_t)best;
+    p->remote_as = 0;
+    p->hold_time = 0;
+    p->keepalive = 0;
+    p->next = *bucket;
+    *bucket = i;
+
+    d->ranges[best].cfg.peers++;
+    if (++d->stats.peers > d->stats.peak) d->stats.peak = d->stats.peers;
+    d->stats.accepted++;
+    *peer = BGP_DYN_PEER(i, p->gen);
+
+    uint64_t ns = bgp_dyn_now_ns() - start;
+    d->stats.accept_ns_total += ns;
+    if (ns > d->stats.accept_ns_max) d->stats.accept_ns_max = ns;
+
+    nb_mutex_unlock(&d->lock);
+    return BGP_DYN_OK;
+}
+
+int bgp_dynamic_open(bgp_dynamic_t *d, bgp_dyn_peer_t peer, uint32_t remote_as,
+                     uint32_t remote_hold_time)
+{
+    nb_mutex_lock(&d->lock);
+
+    bgp_dyn_slot_t *p = bgp_dyn_slot(d, peer);
+    if (!p) {
+        nb_mutex_unlock(&d->lock);
+        return -1;
+    }
+
+    const bgp_dyn_range_t *r = &d->ranges[p->range].cfg;
+    if (r->remote_as && r->remote_as != remote_as) {
+        d->stats.rejected_as++;
+        nb_mutex_unlock(&d->lock);
+        syslog_write(LOG_WARNING, "BGP dynamic: OPEN from AS %u in VRF %u, range allows "
+            "AS %u only", remote_as, r->vrf_id, r->remote_as);
+        return -1;
+    }
+
+    uint32_t vrf_id = p->vrf_id;
+    nb_mutex_unlock(&d->lock);
+
+    /* The VRF's timers are the template; nothing is copied until now */
+    uint32_t hold = bgp_timers_get_hold_time(vrf_id, remote_hold_time);
+    uint32_t keepalive = bgp_timers_get_keepalive(vrf_id);
+    if (hold == 0) keepalive = 0;
+    else if (keepalive > hold / 3) keepalive = hold / 3;
+
+    nb_mutex_lock(&d->lock);
+    p = bgp_dyn_slot(d, peer);
+    if (p) {
+        p->remote_as = remote_as;
+        p->hold_time = (uint16_t)hold;
+        p->keepalive = (uint16_t)keepalive;
+    }
+    nb_mutex_unlock(&d->lock);
+    return p ? 0 : -1;
+}
+
+void bgp_dynamic_release(bgp_dynamic_t *d, bgp_dyn_peer_t peer)
+{
+    nb_mutex_lock(&d->lock);
+    if (bgp_dyn_slot(d, peer)) bgp_dyn_free(d, BGP_DYN_SLOT(peer));
+    nb_mutex_unlock(&d->lock);
+}
+
+bgp_dyn_peer_t bgp_dynamic_find(bgp_dynamic_t *d, uint32_t vrf_id, const struct sockaddr *addr)
+{
+    uint8_t key[16];
+    bgp_dyn_peer_t peer = 0;
+
+    if (!bgp_dyn_key(addr, key, NULL)) return 0;
+
+    nb_mutex_lock(&d->lock);
+    uint32_t i = bgp_dyn_lookup(d, vrf_id, key);
+    if (i != BGP_DYN_NONE) peer = BGP_DYN_PEER(i, d->pool[i].gen);
+    nb_mutex_unlock(&d->lock);
+    return peer;
+}
+
+int bgp_dynamic_get(bgp_dynamic_t *d, bgp_dyn_peer_t peer, bgp_dyn_peer_info_t *info)
+{
+    nb_mutex_lock(&d->lock);
+
+    bgp_dyn_slot_t *p = bgp_dyn_slot(d, peer);
+    if (p) {
+        info->vrf_id = p->vrf_id;
+        memcpy(info->addr, p->addr, 16);
+        info->range = p->range;
+        info->established = p->remote_as != 0;
+        info->remote_as = p->remote_as;
+        info->hold_time = p->hold_time;
+        info->keepalive = p->keepalive;
+        info->session = p->session;
+    }
+
+    nb_mutex_unlock(&d->lock);
+    return p ? 0 : -1;
+}
+
+int bgp_dynamic_get_range(bgp_dynamic_t *d, int range, bgp_dyn_range_t *info)
+{
+    int ret = -1;
+
+    if (range < 0 || range >= BGP_DYN_MAX_RANGES) return -1;
+
+    nb_mutex_lock(&d->lock);
+    if (d->ranges[range].used) {
+        *info = d->ranges[range].cfg;
+        ret = 0;
+    }
+    nb_mutex_unlock(&d->lock);
+    return ret;
+}
+
+void bgp_dynamic_get_stats(bgp_dynamic_t *d, bgp_dynamic_stats_t *stats)
+{
+    nb_mutex_lock(&d->lock);
+    *stats = d->stats;
+    nb_mutex_unlock(&d->lock);
+}
+
+void bgp_dynamic_dump(bgp_dynamic_t *d)
+{
+    bgp_dynamic_stats_t st;
+
+    bgp_dynamic_get_stats(d, &st);
+
+    syslog_write(LOG_INFO, "BGP dynamic: %u/%u peers (peak %u), %zu KB; %llu accepted, "
+        "%llu released; rejected %llu no range, %llu full, %llu bad AS",
+        st.peers, st.capacity, st.peak, st.memory / 1024,
+        (unsigned long long)st.accepted, (unsigned long long)st.released,
+        (unsigned long long)st.rejected_range, (unsigned long long)st.rejected_limit,
+        (unsigned long long)st.rejected_as);
+    if (st.accepted > 0) {
+        syslog_write(LOG_INFO, "  instantiate avg %.2f us max %.2f us",
+            (double)st.accept_ns_total / (double)st.accepted / 1e3,
+            (double)st.accept_ns_max / 1e3);
+    }
+
+    nb_mutex_lock(&d->lock);
+    for (int r = 0; r < BGP_DYN_MAX_RANGES; r++) {
+        const bgp_dyn_range_entry_t *e = &d->ranges[r];
+        if (!e->used) continue;
+        syslog_write(LOG_INFO, "  range %d: VRF %u /%u, AS %u, %u peers (limit %u)",
+            r, e->cfg.vrf_id, e->cfg.prefix_len, e->cfg.remote_as, e->cfg.peers,
+            e->cfg.max_peers);
+    }
+    nb_mutex_unlock(&d->lock);
+}
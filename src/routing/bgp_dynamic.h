@@ -0,0 +1,102 @@
+/*
+ * bgp_dynamic.h - Dynamic BGP Neighbors from Listen Ranges
+ *
+ * NetBlade OS v3.x Routing Engine
+ * Copyright (c) 2024-2026 Enterprise Systems Inc. All rights reserved.
+ */
+
+#ifndef BGP_DYNAMIC_H
+#define BGP_DYNAMIC_H
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <sys/socket.h>
+
+#define BGP_DYN_MAX_RANGES      256
+#define BGP_DYN_MAX_PEERS       65535   /* Pool ceiling; handles carry a 16-bit slot */
+#define BGP_DYN_DEFAULT_PEERS   10240
+
+/* bgp_dynamic_accept() results */
+#define BGP_DYN_OK              0
+#define BGP_DYN_NO_RANGE        -1      /* Source not in any range of the VRF */
+#define BGP_DYN_RANGE_FULL      -2      /* Range peer limit reached */
+#define BGP_DYN_POOL_FULL       -3
+#define BGP_DYN_EXISTS          -4      /* Already a peer; *peer is set to it */
+
+typedef uint32_t bgp_dyn_peer_t;       /* 0 is never a valid peer */
+
+typedef struct {
+    uint32_t vrf_id;
+    uint8_t  prefix[16];        /* IPv6, or IPv4-mapped */
+    uint8_t  prefix_len;        /* Of prefix[], so IPv4 /24 is 120 */
+    uint32_t remote_as;         /* 0: any */
+    uint32_t max_peers;         /* 0: no per-range limit */
+    uint32_t peers;
+} bgp_dyn_range_t;
+
+typedef struct {
+    uint32_t vrf_id;
+    uint8_t  addr[16];
+    uint16_t range;
+    bool     established;       /* OPEN accepted; timers negotiated */
+    uint32_t remote_as;
+    uint16_t hold_time;
+    uint16_t keepalive;
+    void    *session;
+} bgp_dyn_peer_info_t;
+
+typedef struct {
+    uint32_t peers;
+    uint32_t peak;
+    uint32_t capacity;
+    uint64_t accepted;
+    uint64_t released;
+    uint64_t rejected_range;    /* No range */
+    uint64_t rejected_limit;    /* Range or pool full */
+    uint64_t rejected_as;       /* OPEN from an AS the range does not allow */
+    uint64_t accept_ns_total;
+    uint64_t accept_ns_max;
+    size_t   memory;            /* Pool and index, allocated once */
+} bgp_dynamic_stats_t;
+
+typedef struct bgp_dynamic bgp_dynamic_t;
+
+/* A peer being torn down because its range was removed */
+typedef void (*bgp_dynamic_remove_cb_t)(bgp_dyn_peer_t peer, void *session, void *ctx);
+
+/* Pool and index for max_peers (0: default) are allocated here and never grow */
+bgp_dynamic_t *bgp_dynamic_create(uint32_t max_peers);
+void bgp_dynamic_destroy(bgp_dynamic_t *d);
+
+/* Accept sessions from peer/len in a VRF; returns the range id or -1 */
+int bgp_dynamic_add_range(bgp_dynamic_t *d, uint32_t vrf_id, const struct sockaddr *prefix,
+                          uint8_t len, uint32_t remote_as, uint32_t max_peers);
+int bgp_dynamic_remove_range(bgp_dynamic_t *d, int range, bgp_dynamic_remove_cb_t cb, void *ctx);
+
+/*
+ * An unconfigured source connected (bgp_listen). If it falls in one of
+ * the VRF's ranges (longest prefix wins) a peer is instantiated from
+ * the range template and BGP_DYN_OK returned.
+ */
+int bgp_dynamic_accept(bgp_dynamic_t *d, uint32_t vrf_id, const struct sockaddr *addr,
+                       void *session, bgp_dyn_peer_t *peer);
+
+/*
+ * The peer's OPEN arrived. Checks its AS against the range and
+ * negotiates hold time and keepalive from the VRF's bgp_timers entry.
+ * Returns -1 if the AS is not allowed.
+ */
+int bgp_dynamic_open(bgp_dynamic_t *d, bgp_dyn_peer_t peer, uint32_t remote_as,
+                     uint32_t remote_hold_time);
+
+/* The session went down; dynamic peers do not outlive it */
+void bgp_dynamic_release(bgp_dynamic_t *d, bgp_dyn_peer_t peer);
+
+bgp_dyn_peer_t bgp_dynamic_find(bgp_dynamic_t *d, uint32_t vrf_id, const struct sockaddr *addr);
+int bgp_dynamic_get(bgp_dynamic_t *d, bgp_dyn_peer_t peer, bgp_dyn_peer_info_t *info);
+int bgp_dynamic_get_range(bgp_dynamic_t *d, int range, bgp_dyn_range_t *info);
+
+void bgp_dynamic_get_stats(bgp_dynamic_t *d, bgp_dynamic_stats_t *stats);
+void bgp_dynamic_dump(bgp_dynamic_t *d);
+
+#endif /* BGP_DYNAMIC_H */
@@ -0,0 +1,652 @@
+/*
+ * bgp_io.c - BGP Session I/O Engine
+ *
+ * NetBlade OS v3.x Routing Engine
+ * Copyright (c) 2024-2026 Enterprise Systems Inc. All rights reserved.
+ *
+ * Socket I/O for BGP sessions, driven from the BGP process event loop.
+ * Sends are copied into a per-session buffer and written once per poll,
+ * so a burst of UPDATEs to one peer costs one write.
+ *
+ * Two backends behind one interface:
+ *
+ *   epoll  - level-triggered readiness, then recv()/send() per socket.
+ *            Roughly two syscalls per busy session per iteration.
+ *
+ *   uring  - one multishot receive per session, completing into a ring
+ *            of provided buffers, and fixed-buffer writes from transmit
+ *            buffers registered once at create time. All writes queued
+ *            in an iteration and the wait for completions go to the
+ *            kernel in a single io_uring_enter(), however many sessions
+ *            are busy.
+ *
+ * Built with HAVE_LIBURING for the uring backend; without it, or if the
+ * kernel refuses the ring, a uring request falls back to epoll. The
+ * uring backend is experimental: it has been compile-checked but not
+ * yet run against liburing, so epoll is the one to deploy.
+ *
+ * Transmit and receive buffers are mapped on the NUMA node of the
+ * thread that creates the engine, which should be the pinned worker
+ * that will run it.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+#include <stdbool.h>
+#include <errno.h>
+#include <unistd.h>
+#include <sys/epoll.h>
+#include <sys/socket.h>
+#include <sys/uio.h>
+#ifdef HAVE_LIBURING
+#include <liburing.h>
+#endif
+#include "bgp_io.h"
+#include "syslog.h"
+#include "nb_numa.h"
+
+#define BGP_IO_EPOLL_EVENTS     256
+
+/* uring user_data: op in the top byte, connection handle in the low word */
+#define BGP_IO_OP_RECV          1
+#define BGP_IO_OP_SEND          2
+#define BGP_IO_OP_CANCEL        3
+#define BGP_IO_UDATA(op, conn)  (((uint64_t)(op) << 56) | (conn))
+#define BGP_IO_UDATA_OP(u)      ((uint8_t)((u) >> 56))
+#define BGP_IO_UDATA_CONN(u)    ((bgp_io_conn_t)(u))
+
+#define BGP_IO_RX_BGID          0
+
+/* Handle: generation in the high half so stale completions are recognised */
+#define BGP_IO_CONN(slot, gen)  (((uint32_t)(gen) << 16) | (slot))
+#define BGP_IO_SLOT(conn)       ((conn) & 0xffff)
+#define BGP_IO_GEN(conn)        ((uint16_t)((conn) >> 16))
+
+typedef struct {
+    int       fd;               /* -1 if the slot is free */
+    uint16_t  gen;
+    void     *ctx;
+    uint8_t  *tx;               /* BGP_IO_TX_BUF_SIZE bytes in tx_pool */
+    uint32_t  tx_len;           /* Queued, including any write in flight */
+    uint32_t  tx_inflight;      /* Head of tx being written (uring) */
+    bool      tx_dirty;         /* On the flush list */
+    bool      closing;
+    bool      want_out;         /* EPOLLOUT armed (epoll) */
+    uint8_t   ops;              /* Requests outstanding (uring) */
+} bgp_io_slot_t;
+
+struct bgp_io {
+    uint8_t             backend;
+    int                 node;
+    uint32_t            max_conns;
+    bgp_io_recv_cb_t    recv_cb;
+    bgp_io_closed_cb_t  closed_cb;
+
+    bgp_io_slot_t      *slots;
+    uint32_t           *free_slots;
+    uint32_t            free_count;
+    uint32_t           *dirty;
+    uint32_t            dirty_count;
+    uint8_t            *tx_pool;
+
+    int                 epfd;
+    uint8_t            *rx_scratch;
+
+#ifdef HAVE_LIBURING
+    struct io_uring     ring;
+    struct io_uring_buf_ring *rx_ring;
+    uint8_t            *rx_pool;
+#endif
+
+    bgp_io_stats_t      stats;
+};
+
+static bgp_io_slot_t *bgp_io_slot(bgp_io_t *io, bgp_io_conn_t conn)
+{
+    uint32_t slot = BGP_IO_SLOT(conn);
+
+    if (slot >= io->max_conns) return NULL;
+
+    bgp_io_slot_t *s = &io->slots[slot];
+    if (s->fd < 0 || s->gen != BGP_IO_GEN(conn)) return NULL;
+    return s;
+}
+
+static bgp_io_conn_t bgp_io_handle(bgp_io_t *io, bgp_io_slot_t *s)
+{
+    return BGP_IO_CONN((uint32_t)(s - io->slots), s->gen);
+}
+
+static void bgp_io_free_slot(bgp_io_t *io, bgp_io_slot_t *s)
+{
+    uint32_t slot = (uint32_t)(s - io->slots);
+
+    /* Off the flush list, or the next session in this slot could not get on it */
+    if (s->tx_dirty) {
+        for (uint32_t i = 0; i < io->dirty_count; i++) {
+            if (io->dirty[i] == slot) {
+                io->dirty[i] = io->dirty[--io->dirty_count];
+                break;
+            }
+        }
+        s->tx_dirty = false;
+    }
+
+    close(s->fd);
+    s->fd = -1;
+    s->gen++;
+    s->ctx = NULL;
+    s->tx_len = 0;
+    s->tx_inflight = 0;
+    s->closing = false;
+    s->want_out = false;
+    io->free_slots[io->free_count++] = slot;
+}
+
+static void bgp_io_mark_dirty(bgp_io_t *io, bgp_io_slot_t *s)
+{
+    if (s->tx_dirty) return;
+    s->tx_dirty = true;
+    io->dirty[io->dirty_count++] = (uint32_t)(s - io->slots);
+}
+
+/* Socket failed or peer closed: stop further callbacks, tell the owner once */
+static void bgp_io_fail(bgp_io_t *io, bgp_io_slot_t *s, int err)
+{
+    if (s->closing) return;
+    s->closing = true;
+    io->closed_cb(s->ctx, err);
+}
+
+/* ---------------------------------------------------------------- epoll */
+
+static int bgp_io_epoll_mod(bgp_io_t *io, bgp_io_slot_t *s, bool want_out)
+{
+    struct epoll_event ev = {
+        .events = EPOLLIN | (want_out ? EPOLLOUT : 0),
+        .data.u64 = bgp_io_handle(io, s),
+    };
+
+    io->stats.syscalls++;
+    s->want_out = want_out;
+    return epoll_ctl(io->epfd, EPOLL_CTL_MOD, s->fd, &ev);
+}
+
+static void bgp_io_epoll_flush_one(bgp_io_t *io, bgp_io_slot_t *s)
+{
+    while (s->tx_len > 0) {
+        io->stats.syscalls++;
+        ssize_t n = send(s->fd, s->tx, s->tx_len, MSG_DONTWAIT | MSG_NOSIGNAL);
+        if (n < 0) {
+            if (errno == EINTR) continue;
+            if (errno == EAGAIN || errno == EWOULDBLOCK) break;
+            bgp_io_fail(io, s, errno);
+            return;
+        }
+        io->stats.tx_bytes += (uint64_t)n;
+        io->stats.tx_writes++;
+        s->tx_len -= (uint32_t)n;
+        if (s->tx_len > 0) memmove(s->tx, s->tx + n, s->tx_len);
+    }
+
+    bool want_out = s->tx_len > 0;
+    if (want_out != s->want_out) bgp_io_epoll_mod(io, s, want_out);
+}
+
+/* Returns false if a callback removed the session; s must not be used then */
+static bool bgp_io_epoll_read(bgp_io_t *io, bgp_io_slot_t *s)
+{
+    bgp_io_conn_t conn = bgp_io_handle(io, s);
+
+    for (;;) {
+        io->stats.syscalls++;
+        ssize_t n = recv(s->fd, io->rx_scratch, BGP_IO_RX_BUF_SIZE, MSG_DONTWAIT);
+        if (n < 0) {
+            if (errno == EINTR) continue;
+            if (errno != EAGAIN && errno != EWOULDBLOCK) bgp_io_fail(io, s, errno);
+            return bgp_io_slot(io, conn) == s;
+        }
+        if (n == 0) {
+            bgp_io_fail(io, s, 0);
+            return bgp_io_slot(io, conn) == s;
+        }
+
+        io->stats.rx_bytes += (uint64_t)n;
+        io->stats.rx_chunks++;
+        io->recv_cb(s->ctx, io->rx_scratch, (size_t)n);
+
+        /* The callback may have removed the session, and the slot been reused */
+        if (bgp_io_slot(io, conn) != s) return false;
+
+        /* Short read: drained. Level-triggered, so anything later is reported again */
+        if ((size_t)n < BGP_IO_RX_BUF_SIZE || s->closing) return true;
+    }
+}
+
+static int bgp_io_epoll_poll(bgp_io_t *io, int timeout_ms)
+{
+    struct epoll_event events[BGP_IO_EPOLL_EVENTS];
+
+    for (uint32_t i = 0; i < io->dirty_count; i++) {
+        bgp_io_slot_t *s = &io->slots[io->dirty[i]];
+        s->tx_dirty = false;
+        if (s->fd >= 0 && !s->closing && !s->want_out) bgp_io_epoll_flush_one(io, s);
+    }
+    io->dirty_count = 0;
+
+    io->stats.syscalls++;
+    int n = epoll_wait(io->epfd, events, BGP_IO_EPOLL_EVENTS, timeout_ms);
+    if (n < 0) return errno == EINTR ? 0 : -1;
+
+    for (int i = 0; i < n; i++) {
+        bgp_io_slot_t *s = bgp_io_slot(io, (bgp_io_conn_t)events[i].data.u64);
+        if (!s || s->closing) continue;
+
+        if ((events[i].events & (EPOLLIN | EPOLLHUP | EPOLLERR)) && !bgp_io_epoll_read(io, s)) {
+            continue;
+        }
+        if ((events[i].events & EPOLLOUT) && !s->closing) bgp_io_epoll_flush_one(io, s);
+    }
+    return n;
+}
+
+/* ---------------------------------------------------------------- uring */
+
+#ifdef HAVE_LIBURING
+
+static struct io_uring_sqe *bgp_io_sqe(bgp_io_t *io)
+{
+    struct io_uring_sqe *sqe = io_uring_get_sqe(&io->ring);
+    if (!sqe) {
+        io->stats.syscalls++;
+        io_uring_submit(&io->ring);
+        sqe = io_uring_get_sqe(&io->ring);
+    }
+    return sqe;
+}
+
+static int bgp_io_uring_arm_recv(bgp_io_t *io, bgp_io_slot_t *s)
+{
+    struct io_uring_sqe *sqe = bgp_io_sqe(io);
+    if (!sqe) return -1;
+
+    io_uring_prep_recv_multishot(sqe, s->fd, NULL, 0, 0);
+    sqe->flags |= IOSQE_BUFFER_SELECT;
+    sqe->buf_group = BGP_IO_RX_BGID;
+    io_uring_sqe_set_data64(sqe, BGP_IO_UDATA(BGP_IO_OP_RECV, bgp_io_handle(io, s)));
+    s->ops++;
+    return 0;
+}
+
+static void bgp_io_uring_write(bgp_io_t *io, bgp_io_slot_t *s)
+{
+    struct io_uring_sqe *sqe = bgp_io_sqe(io);
+    if (!sqe) {
+        bgp_io_mark_dirty(io, s);
+        return;
+    }
+
+    io_uring_prep_write_fixed(sqe, s->fd, s->tx, s->tx_len, 0, 0);
+    io_uring_sqe_set_data64(sqe, BGP_IO_UDATA(BGP_IO_OP_SEND, bgp_io_handle(io, s)));
+    s->tx_inflight = s->tx_len;
+    s->ops++;
+}
+
+static int bgp_io_uring_init(bgp_io_t *io)
+{
+    struct io_uring_params p;
+    struct iovec iov;
+    int ret;
+
+    memset(&p, 0, sizeof(p));
+    p.flags = IORING_SETUP_SINGLE_ISSUER | IORING_SETUP_DEFER_TASKRUN;
+    ret = io_uring_queue_init_params(BGP_IO_RING_ENTRIES, &io->ring, &p);
+    if (ret == -EINVAL) {
+        memset(&p, 0, sizeof(p));
+        ret = io_uring_queue_init_params(BGP_IO_RING_ENTRIES, &io->ring, &p);
+    }
+    if (ret < 0) {
+        syslog_write(LOG_WARNING, "BGP io: io_uring unavailable: %s", strerror(-ret));
+        return -1;
+    }
+
+    iov.iov_base = io->tx_pool;
+    iov.iov_len = (size_t)io->max_conns * BGP_IO_TX_BUF_SIZE;
+    ret = io_uring_register_buffers(&io->ring, &iov, 1);
+    if (ret < 0) {
+        syslog_write(LOG_WARNING, "BGP io: Cannot register send buffers: %s", strerror(-ret));
+        io_uring_queue_exit(&io->ring);
+        return -1;
+    }
+
+    io->rx_pool = nb_numa_alloc((size_t)BGP_IO_RX_BUFS * BGP_IO_RX_BUF_SIZE, io->node);
+    io->rx_ring = io->rx_pool ?
+        io_uring_setup_buf_ring(&io->ring, BGP_IO_RX_BUFS, BGP_IO_RX_BGID, 0, &ret) : NULL;
+    if (!io->rx_ring) {
+        syslog_write(LOG_WARNING, "BGP io: Cannot set up receive buffer ring");
+        nb_numa_free(io->rx_pool, (size_t)BGP_IO_RX_BUFS * BGP_IO_RX_BUF_SIZE);
+        io->rx_pool = NULL;
+        io_uring_queue_exit(&io->ring);
+        return -1;
+    }
+
+    int mask = io_uring_buf_ring_mask(BGP_IO_RX_BUFS);
+    for (int b = 0; b < BGP_IO_RX_BUFS; b++) {
+        io_uring_buf_ring_add(io->rx_ring, io->rx_pool + (size_t)b * BGP_IO_RX_BUF_SIZE,
+            BGP_IO_RX_BUF_SIZE, (unsigned short)b, mask, b);
+    }
+    io_uring_buf_ring_advance(io->rx_ring, BGP_IO_RX_BUFS);
+    return 0;
+}
+
+static void bgp_io_uring_exit(bgp_io_t *io)
+{
+    io_uring_free_buf_ring(&io->ring, io->rx_ring, BGP_IO_RX_BUFS, BGP_IO_RX_BGID);
+    io_uring_queue_exit(&io->ring);
+    nb_numa_free(io->rx_pool, (size_t)BGP_IO_RX_BUFS * BGP_IO_RX_BUF_SIZE);
+}
+
+/* s is NULL for a completion that outlived its session; only the buffer matters then */
+static void bgp_io_uring_recv_done(bgp_io_t *io, bgp_io_slot_t *s, struct io_uring_cqe *cqe,
+                                   int *recycled)
+{
+    bool more = cqe->flags & IORING_CQE_F_MORE;
+
+    if (cqe->flags & IORING_CQE_F_BUFFER) {
+        unsigned short bid = (unsigned short)(cqe->flags >> IORING_CQE_BUFFER_SHIFT);
+        uint8_t *buf = io->rx_pool + (size_t)bid * BGP_IO_RX_BUF_SIZE;
+
+        if (s && cqe->res > 0 && !s->closing) {
+            io->stats.rx_bytes += (uint64_t)cqe->res;
+            io->stats.rx_chunks++;
+            io->recv_cb(s->ctx, buf, (size_t)cqe->res);
+        }
+        io_uring_buf_ring_add(io->rx_ring, buf, BGP_IO_RX_BUF_SIZE, bid,
+            io_uring_buf_ring_mask(BGP_IO_RX_BUFS), (*recycled)++);
+    }
+
+    if (!s) return;
+    if (!more) s->ops--;
+    if (s->closing) return;
+
+    if (cqe->res == 0) {
+        bgp_io_fail(io, s, 0);
+    } else if (cqe->res == -ENOBUFS) {
+        io->stats.rx_nobufs++;
+        if (!more) bgp_io_uring_arm_recv(io, s);
+    } else if (cqe->res < 0) {
+        bgp_io_fail(io, s, -cqe->res);
+    } else if (!more) {
+        bgp_io_uring_arm_recv(io, s);
+    }
+}
+
+static void bgp_io_uring_send_done(bgp_io_t *io, bgp_io_slot_t *s, int res)
+{
+    s->ops--;
+
+    if (res < 0) {
+        s->tx_inflight = 0;
+        bgp_io_fail(io, s, -res);
+        return;
+    }
+
+    io->stats.tx_bytes += (uint64_t)res;
+    io->stats.tx_writes++;
+    s->tx_len -= (uint32_t)res;
+    s->tx_inflight = 0;
+    if (s->tx_len > 0) {
+        memmove(s->tx, s->tx + res, s->tx_len);
+        if (!s->closing) bgp_io_mark_dirty(io, s);
+    }
+}
+
+static int bgp_io_uring_poll(bgp_io_t *io, int timeout_ms)
+{
+    struct io_uring_cqe *cqe;
+    unsigned head, seen = 0;
+    int recycled = 0;
+    int ret;
+
+    for (uint32_t i = 0; i < io->dirty_count; i++) {
+        bgp_io_slot_t *s = &io->slots[io->dirty[i]];
+        s->tx_dirty = false;
+        if (s->fd >= 0 && !s->closing && s->tx_inflight == 0 && s->tx_len > 0) {
+            bgp_io_uring_write(io, s);
+        }
+    }
+    io->dirty_count = 0;
+
+    /* Submit and wait in one enter */
+    io->stats.syscalls++;
+    if (timeout_ms < 0) {
+        ret = io_uring_submit_and_wait(&io->ring, 1);
+    } else {
+        struct __kernel_timespec ts = {
+            .tv_sec = timeout_ms / 1000,
+            .tv_nsec = (long long)(timeout_ms % 1000) * 1000000,
+        };
+        ret = io_uring_submit_and_wait_timeout(&io->ring, &cqe, 1, &ts, NULL);
+    }
+    if (ret < 0 && ret != -ETIME && ret != -EINTR) return -1;
+
+    io_uring_for_each_cqe(&io->ring, head, cqe) {
+        uint64_t udata = io_uring_cqe_get_data64(cqe);
+        uint8_t op = BGP_IO_UDATA_OP(udata);
+        bgp_io_conn_t conn = BGP_IO_UDATA_CONN(udata);
+        uint32_t slot = BGP_IO_SLOT(conn);
+
+        seen++;
+
+        /* A closing slot keeps its fd and generation until its last completion */
+        bgp_io_slot_t *s = NULL;
+        if (slot < io->max_conns && io->slots[slot].fd >= 0 &&
+            io->slots[slot].gen == BGP_IO_GEN(conn)) {
+            s = &io->slots[slot];
+        }
+
+        if (op == BGP_IO_OP_RECV) {
+            bgp_io_uring_recv_done(io, s, cqe, &recycled);
+        } else if (op == BGP_IO_OP_SEND && s) {
+            bgp_io_uring_send_done(io, s, cqe->res);
+        }
+
+        if (s && s->closing && s->ops == 0) bgp_io_free_slot(io, s);
+    }
+
+    io_uring_cq_advance(&io->ring, seen);
+    if (recycled) io_uring_buf_ring_advance(io->rx_ring, recycled);
+    return (int)seen;
+}
+
+#endif /* HAVE_LIBURING */
+
+/* ---------------------------------------------------------------- common */
+
+bgp_io_t *bgp_io_create(uint8_t backend, uint32_t max_conns,
+                        bgp_io_recv_cb_t recv_cb, bgp_io_closed_cb_t closed_cb)
+{
+    if (max_conns == 0 || max_conns > BGP_IO_MAX_CONNS || !recv_cb || !closed_cb) return NULL;
+
+    bgp_io_t *io = calloc(1, sizeof(bgp_io_t));
+    if (!io) return NULL;
+
+    io->max_conns = max_conns;
+    io->recv_cb = recv_cb;
+    io->closed_cb = closed_cb;
+    io->epfd = -1;
+    io->node = nb_numa_current_node();
+    io->slots = calloc(max_conns, sizeof(bgp_io_slot_t));
+    io->free_slots = calloc(max_conns, sizeof(uint32_t));
+    io->dirty = calloc(max_conns, sizeof(uint32_t));
+    io->tx_pool = nb_numa_alloc((size_t)max_conns * BGP_IO_TX_BUF_SIZE, io->node);
+    if (!io->slots || !io->free_slots || !io->dirty || !io->tx_pool) goto fail;
+
+    for (uint32_t i = 0; i < max_conns; i++) {
+        io->slots[i].fd = -1;
+        io->slots[i].tx = io->tx_pool + (size_t)i * BGP_IO_TX_BUF_SIZE;
+        io->free_slots[i] = max_conns - 1 - i;
+    }
+    io->free_count = max_conns;
+
+    io->backend = BGP_IO_BACKEND_EPOLL;
+    if (backend == BGP_IO_BACKEND_URING) {
+#ifdef HAVE_LIBURING
+        if (bgp_io_uring_init(io) == 0) {
+            io->backend = BGP_IO_BACKEND_URING;
+            syslog_write(LOG_WARNING, "BGP io: io_uring backend is experimental");
+        }
+#else
+        syslog_write(LOG_WARNING, "BGP io: Built without io_uring support");
+#endif
+        if (io->backend != BGP_IO_BACKEND_URING) {
+            syslog_write(LOG_WARNING, "BGP io: Falling back to epoll");
+        }
+    }
+
+    if (io->backend == BGP_IO_BACKEND_EPOLL) {
+        io->epfd = epoll_create1(EPOLL_CLOEXEC);
+        io->rx_scratch = nb_numa_alloc(BGP_IO_RX_BUF_SIZE, io->node);
+        if (io->epfd < 0 || !io->rx_scratch) goto fail;
+    }
+
+    syslog_write(LOG_INFO, "BGP io: %s backend, %u sessions, node %d",
+        bgp_io_backend_name(io->backend), max_conns, io->node);
+    return io;
+
+fail:
+    if (io->epfd >= 0) close(io->epfd);
+    nb_numa_free(io->rx_scratch, BGP_IO_RX_BUF_SIZE);
+    nb_numa_free(io->tx_pool, (size_t)io->max_conns * BGP_IO_TX_BUF_SIZE);
+    free(io->dirty);
+    free(io->free_slots);
+    free(io->slots);
+    free(io);
+    return NULL;
+}
+
+void bgp_io_destroy(bgp_io_t *io)
+{
+    if (!io) return;
+
+#ifdef HAVE_LIBURING
+    /* Tearing down the ring cancels whatever is still in flight */
+    if (io->backend == BGP_IO_BACKEND_URING) bgp_io_uring_exit(io);
+#endif
+
+    for (uint32_t i = 0; i < io->max_conns; i++) {
+        if (io->slots[i].fd >= 0) close(io->slots[i].fd);
+    }
+    if (io->epfd >= 0) close(io->epfd);
+
+    nb_numa_free(io->rx_scratch, BGP_IO_RX_BUF_SIZE);
+    nb_numa_free(io->tx_pool, (size_t)io->max_conns * BGP_IO_TX_BUF_SIZE);
+    free(io->dirty);
+    free(io->free_slots);
+    free(io->slots);
+    free(io);
+}
+
+uint8_t bgp_io_backend(bgp_io_t *io)
+{
+    return io->backend;
+}
+
+const char *bgp_io_backend_name(uint8_t backend)
+{
+    return backend == BGP_IO_BACKEND_URING ? "io_uring" : "epoll";
+}
+
+int bgp_io_add(bgp_io_t *io, int fd, void *conn_ctx, bgp_io_conn_t *conn)
+{
+    if (fd < 0 || io->free_count == 0) return -1;
+
+    bgp_io_slot_t *s = &io->slots[io->free_slots[--io->free_count]];
+    s->fd = fd;
+    s->ctx = conn_ctx;
+    s->ops = 0;
+
+    int ret;
+    if (io->backend == BGP_IO_BACKEND_EPOLL) {
+        struct epoll_event ev = { .events = EPOLLIN, .data.u64 = bgp_io_handle(io, s) };
+        io->stats.syscalls++;
+        ret = epoll_ctl(io->epfd, EPOLL_CTL_ADD, fd, &ev);
+    } else {
+#ifdef HAVE_LIBURING
+        ret = bgp_io_uring_arm_recv(io, s);
+#else
+        ret = -1;
+#endif
+    }
+
+    if (ret != 0) {
+        s->fd = -1;
+        io->free_count++;
+        return -1;
+    }
+
+    *conn = bgp_io_handle(io, s);
+    return 0;
+}
+
+int bgp_io_remove(bgp_io_t *io, bgp_io_conn_t conn)
+{
+    bgp_io_slot_t *s = bgp_io_slot(io, conn);
+    if (!s) return -1;
+
+    s->closing = true;
+
+    if (io->backend == BGP_IO_BACKEND_EPOLL) {
+        io->stats.syscalls++;
+        epoll_ctl(io->epfd, EPOLL_CTL_DEL, s->fd, NULL);
+        bgp_io_free_slot(io, s);
+        return 0;
+    }
+
+#ifdef HAVE_LIBURING
+    if (s->ops == 0) {
+        bgp_io_free_slot(io, s);
+        return 0;
+    }
+
+    /* The fd stays open until the cancelled requests complete */
+    struct io_uring_sqe *sqe = bgp_io_sqe(io);
+    if (sqe) {
+        io_uring_prep_cancel_fd(sqe, s->fd, IORING_ASYNC_CANCEL_ALL);
+        io_uring_sqe_set_data64(sqe, BGP_IO_UDATA(BGP_IO_OP_CANCEL, conn));
+    }
+#endif
+    return 0;
+}
+
+int bgp_io_send(bgp_io_t *io, bgp_io_conn_t conn, const void *data, size_t len)
+{
+    bgp_io_slot_t *s = bgp_io_slot(io, conn);
+    if (!s || s->closing) return -1;
+
+    if (len > BGP_IO_TX_BUF_SIZE - s->tx_len) {
+        io->stats.tx_full++;
+        return -1;
+    }
+
+    /* Appending past tx_inflight never touches bytes the kernel is reading */
+    memcpy(s->tx + s->tx_len, data, len);
+    s->tx_len += (uint32_t)len;
+    bgp_io_mark_dirty(io, s);
+    return 0;
+}
+
+int bgp_io_poll(bgp_io_t *io, int timeout_ms)
+{
+#ifdef HAVE_LIBURING
+    if (io->backend == BGP_IO_BACKEND_URING) return bgp_io_uring_poll(io, timeout_ms);
+#endif
+    return bgp_io_epoll_poll(io, timeout_ms);
+}
+
+void bgp_io_get_stats(bgp_io_t *io, bgp_io_stats_t *stats)
+{
+    memcpy(stats, &io->stats, sizeof(bgp_io_stats_t));
+}
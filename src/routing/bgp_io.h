@@ -0,0 +1,64 @@
+/*
+ * bgp_io.h - BGP Session I/O Engine
+ *
+ * NetBlade OS v3.x Routing Engine
+ * Copyright (c) 2024-2026 Enterprise Systems Inc. All rights reserved.
+ */
+
+#ifndef BGP_IO_H
+#define BGP_IO_H
+
+#include <stdint.h>
+#include <stddef.h>
+
+#define BGP_IO_BACKEND_EPOLL    0
+#define BGP_IO_BACKEND_URING    1   /* Experimental; needs HAVE_LIBURING, else falls back to epoll */
+
+#define BGP_IO_MAX_CONNS        16384
+#define BGP_IO_TX_BUF_SIZE      16384   /* Per session, queued until the next poll */
+#define BGP_IO_RX_BUF_SIZE      16384
+#define BGP_IO_RX_BUFS          1024    /* Provided receive buffers; power of two */
+#define BGP_IO_RING_ENTRIES     4096
+
+typedef struct bgp_io bgp_io_t;
+typedef uint32_t bgp_io_conn_t;
+
+/* Stream bytes as they arrive; the data is only valid during the call */
+typedef void (*bgp_io_recv_cb_t)(void *conn_ctx, const uint8_t *data, size_t len);
+/* Peer closed (err 0) or the socket failed; the owner calls bgp_io_remove() */
+typedef void (*bgp_io_closed_cb_t)(void *conn_ctx, int err);
+
+typedef struct {
+    uint64_t syscalls;          /* send/recv/epoll_* or io_uring_enter */
+    uint64_t rx_bytes;
+    uint64_t rx_chunks;
+    uint64_t tx_bytes;
+    uint64_t tx_writes;
+    uint64_t tx_full;           /* bgp_io_send() refused, buffer full */
+    uint64_t rx_nobufs;         /* Provided buffers exhausted; receive re-armed */
+} bgp_io_stats_t;
+
+bgp_io_t *bgp_io_create(uint8_t backend, uint32_t max_conns,
+                        bgp_io_recv_cb_t recv_cb, bgp_io_closed_cb_t closed_cb);
+void bgp_io_destroy(bgp_io_t *io);
+uint8_t bgp_io_backend(bgp_io_t *io);
+const char *bgp_io_backend_name(uint8_t backend);
+
+/* Takes ownership of a connected, non-blocking socket */
+int bgp_io_add(bgp_io_t *io, int fd, void *conn_ctx, bgp_io_conn_t *conn);
+/* Stops callbacks for conn at once; the socket is closed when I/O drains */
+int bgp_io_remove(bgp_io_t *io, bgp_io_conn_t conn);
+
+/* Queue bytes for the session. Returns -1 if they do not fit */
+int bgp_io_send(bgp_io_t *io, bgp_io_conn_t conn, const void *data, size_t len);
+
+/*
+ * Write all queued data, wait up to timeout_ms (-1: forever) for I/O
+ * and run callbacks. One call is one event-loop iteration of the BGP
+ * process; returns the number of completions handled or -1.
+ */
+int bgp_io_poll(bgp_io_t *io, int timeout_ms);
+
+void bgp_io_get_stats(bgp_io_t *io, bgp_io_stats_t *stats);
+
+#endif /* BGP_IO_H */
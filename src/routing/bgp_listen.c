@@ -0,0 +1,282 @@
+/*
+ * bgp_listen.c - Per-Worker BGP Listeners
+ *
+ * NetBlade OS v3.x Routing Engine
+ * Copyright (c) 2024-2026 Enterprise Systems Inc. All rights reserved.
+ *
+ * Every BGP worker has its own listening socket on the BGP port, all
+ * in one SO_REUSEPORT group, so accepts never serialise on a shared
+ * queue. A classic BPF program attached to the group picks the socket
+ * from the SYN's ingress device: for a VRF that is the VRF master, and
+ * the program maps its ifindex to the owning worker (bgp_shard). Group
+ * sockets are indexed in bind order, which is shard order here.
+ * Anything the program does not know goes to the default VRF's worker.
+ *
+ * The accepted socket's bound device is checked again after accept. A
+ * connection that still lands on the wrong worker - a VRF created since
+ * the last bgp_listen_steer(), or a kernel without the program - is
+ * passed to its owner through a small queue and an eventfd, so sessions
+ * are only ever touched by the worker that owns their VRF.
+ *
+ * One listener set serves all VRFs, which needs
+ * net.ipv4.tcp_l3mdev_accept=1.
+ */
+
+#define _GNU_SOURCE
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+#include <stdbool.h>
+#include <errno.h>
+#include <unistd.h>
+#include <sys/socket.h>
+#include <sys/eventfd.h>
+#include <netinet/in.h>
+#include <linux/filter.h>
+#include "bgp_listen.h"
+#include "bgp_shard.h"
+#include "syslog.h"
+#include "nb_mutex.h"
+
+#ifndef SO_ATTACH_REUSEPORT_CBPF
+#define SO_ATTACH_REUSEPORT_CBPF    51
+#endif
+#ifndef SO_BINDTOIFINDEX
+#define SO_BINDTOIFINDEX            62
+#endif
+
+/* Load, then one compare and one return per VRF, then the default return */
+#define BGP_LISTEN_PROG_MAX         (2 + 2 * BGP_SHARD_MAX_VRFS)
+
+typedef struct {
+    int      fd;
+    uint32_t vrf_id;
+} bgp_listen_handoff_t;
+
+typedef struct {
+    int                   fd;
+    int                   event_fd;
+    nb_mutex_t            lock;         /* Handoff queue */
+    bgp_listen_handoff_t  queue[BGP_LISTEN_HANDOFF_QUEUE];
+    uint32_t              head;
+    uint32_t              tail;
+    bgp_listen_stats_t    stats;
+} bgp_listen_worker_t;
+
+struct bgp_listen {
+    uint16_t             port;
+    uint8_t              nshards;
+    bgp_listen_worker_t  workers[BGP_SHARD_MAX];
+};
+
+static int bgp_listen_socket(uint16_t port)
+{
+    struct sockaddr_in6 addr;
+    int on = 1, off = 0;
+
+    int fd = socket(AF_INET6, SOCK_STREAM | SOCK_NONBLOCK | SOCK_CLOEXEC, 0);
+    if (fd < 0) return -1;
+
+    setsockopt(fd, IPPROTO_IPV6, IPV6_V6ONLY, &off, sizeof(off));
+    setsockopt(fd, SOL_SOCKET, SO_REUSEADDR, &on, sizeof(on));
+    if (setsockopt(fd, SOL_SOCKET, SO_REUSEPORT, &on, sizeof(on)) != 0) goto fail;
+
+    memset(&addr, 0, sizeof(addr));
+    addr.sin6_family = AF_INET6;
+    addr.sin6_addr = in6addr_any;
+    addr.sin6_port = htons(port);
+
+    if (bind(fd, (struct sockaddr *)&addr, sizeof(addr)) != 0) goto fail;
+    if (listen(fd, BGP_LISTEN_BACKLOG) != 0) goto fail;
+    return fd;
+
+fail:
+    close(fd);
+    return -1;
+}
+
+bgp_listen_t *bgp_listen_create(uint16_t port)
+{
+    bgp_listen_t *l = calloc(1, sizeof(bgp_listen_t));
+    if (!l) return NULL;
+
+    l->port = port;
+    l->nshards = bgp_shard_count();
+
+    for (uint8_t s = 0; s < l->nshards; s++) {
+        bgp_listen_worker_t *w = &l->workers[s];
+
+        nb_mutex_init(&w->lock, "bgp_listen.handoff");
+        w->fd = bgp_listen_socket(port);
+        w->event_fd = eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+
+        if (w->fd < 0 || w->event_fd < 0) {
+            syslog_write(LOG_ERR, "BGP listen: Worker %d socket on port %d failed: %s",
+                s, port, strerror(errno));
+            if (w->fd >= 0) close(w->fd);
+            if (w->event_fd >= 0) close(w->event_fd);
+            nb_mutex_destroy(&w->lock);
+            l->nshards = s;
+            bgp_listen_destroy(l);
+            return NULL;
+        }
+    }
+
+    if (bgp_listen_steer(l) != 0) {
+        syslog_write(LOG_WARNING, "BGP listen: No steering program, "
+            "relying on post-accept handoff");
+    }
+
+    syslog_write(LOG_INFO, "BGP listen: Port %d, %d workers", port, l->nshards);
+    return l;
+}
+
+void bgp_listen_destroy(bgp_listen_t *l)
+{
+    if (!l) return;
+
+    for (uint8_t s = 0; s < l->nshards; s++) {
+        bgp_listen_worker_t *w = &l->workers[s];
+
+        close(w->fd);
+        close(w->event_fd);
+        for (uint32_t i = w->head; i != w->tail; i++) {
+            close(w->queue[i & (BGP_LISTEN_HANDOFF_QUEUE - 1)].fd);
+        }
+        nb_mutex_destroy(&w->lock);
+    }
+    free(l);
+}
+
+int bgp_listen_steer(bgp_listen_t *l)
+{
+    static struct sock_filter prog[BGP_LISTEN_PROG_MAX];
+    bgp_shard_vrf_t vrfs[BGP_SHARD_MAX_VRFS];
+    int n = bgp_shard_get_vrfs(vrfs, BGP_SHARD_MAX_VRFS);
+    int len = 0;
+
+    prog[len++] = (struct sock_filter)BPF_STMT(BPF_LD | BPF_W | BPF_ABS,
+        SKF_AD_OFF + SKF_AD_IFINDEX);
+
+    for (int i = 0; i < n; i++) {
+        if (vrfs[i].ifindex == 0) continue;
+        prog[len++] = (struct sock_filter)BPF_JUMP(BPF_JMP | BPF_JEQ | BPF_K,
+            vrfs[i].ifindex, 0, 1);
+        prog[len++] = (struct sock_filter)BPF_STMT(BPF_RET | BPF_K, vrfs[i].shard);
+    }
+
+    prog[len++] = (struct sock_filter)BPF_STMT(BPF_RET | BPF_K, bgp_shard_of_vrf(0));
+
+    struct sock_fprog fprog = { .len = (unsigned short)len, .filter = prog };
+
+    /* The program belongs to the group; attaching through any member replaces it */
+    if (setsockopt(l->workers[0].fd, SOL_SOCKET, SO_ATTACH_REUSEPORT_CBPF,
+                   &fprog, sizeof(fprog)) != 0) {
+        syslog_write(LOG_ERR, "BGP listen: Attaching steering program failed: %s",
+            strerror(errno));
+        return -1;
+    }
+    return 0;
+}
+
+int bgp_listen_fd(bgp_listen_t *l, uint8_t shard)
+{
+    return shard < l->nshards ? l->workers[shard].fd : -1;
+}
+
+int bgp_listen_handoff_fd(bgp_listen_t *l, uint8_t shard)
+{
+    return shard < l->nshards ? l->workers[shard].event_fd : -1;
+}
+
+static void bgp_listen_handoff(bgp_listen_t *l, uint8_t from, uint8_t to, int fd,
+                               uint32_t vrf_id)
+{
+    bgp_listen_worker_t *w = &l->workers[to];
+    bool queued = false;
+
+    nb_mutex_lock(&w->lock);
+    if (w->tail - w->head < BGP_LISTEN_HANDOFF_QUEUE) {
+        w->queue[w->tail & (BGP_LISTEN_HANDOFF_QUEUE - 1)] =
+            (bgp_listen_handoff_t){ .fd = fd, .vrf_id = vrf_id };
+        w->tail++;
+        queued = true;
+    }
+    nb_mutex_unlock(&w->lock);
+
+    if (!queued) {
+        l->workers[from].stats.dropped++;
+        close(fd);
+        return;
+    }
+
+    uint64_t one = 1;
+    if (write(w->event_fd, &one, sizeof(one)) < 0 && errno != EAGAIN) {
+        syslog_write(LOG_WARNING, "BGP listen: Cannot wake worker %d", to);
+    }
+    l->workers[from].stats.handed_off++;
+}
+
+int bgp_listen_accept(bgp_listen_t *l, uint8_t shard, bgp_listen_accept_cb_t cb, void *ctx)
+{
+    if (shard >= l->nshards) return -1;
+
+    bgp_listen_worker_t *w = &l->workers[shard];
+    int delivered = 0;
+
+    for (;;) {
+        int fd = accept4(w->fd, NULL, NULL, SOCK_NONBLOCK | SOCK_CLOEXEC);
+        if (fd < 0) {
+            if (errno == EINTR || errno == ECONNABORTED) continue;
+            break;
+        }
+        w->stats.accepted++;
+
+        /* With tcp_l3mdev_accept the child is bound to the VRF it arrived in */
+        int ifindex = 0;
+        socklen_t optlen = sizeof(ifindex);
+        if (getsockopt(fd, SOL_SOCKET, SO_BINDTOIFINDEX, &ifindex, &optlen) != 0) {
+            ifindex = 0;
+        }
+
+        uint32_t vrf_id = bgp_shard_vrf_of_ifindex((uint32_t)ifindex);
+        uint8_t owner = bgp_shard_of_vrf(vrf_id);
+
+        if (owner == shard || owner >= l->nshards) {
+            w->stats.local++;
+            cb(fd, vrf_id, ctx);
+            delivered++;
+        } else {
+            bgp_listen_handoff(l, shard, owner, fd, vrf_id);
+        }
+    }
+
+    uint64_t count;
+    if (read(w->event_fd, &count, sizeof(count)) == (ssize_t)sizeof(count)) {
+        for (;;) {
+            bgp_listen_handoff_t h;
+
+            nb_mutex_lock(&w->lock);
+            bool have = w->head != w->tail;
+            if (have) h = w->queue[w->head++ & (BGP_LISTEN_HANDOFF_QUEUE - 1)];
+            nb_mutex_unlock(&w->lock);
+
+            if (!have) break;
+            w->stats.received++;
+            cb(h.fd, h.vrf_id, ctx);
+            delivered++;
+        }
+    }
+
+    return delivered;
+}
+
+void bgp_listen_get_stats(bgp_listen_t *l, uint8_t shard, bgp_listen_stats_t *stats)
+{
+    if (shard >= l->nshards) {
+        memset(stats, 0, sizeof(bgp_listen_stats_t));
+        return;
+    }
+    memcpy(stats, &l->workers[shard].stats, sizeof(bgp_listen_stats_t));
+}
@@ -0,0 +1,46 @@
+/*
+ * bgp_listen.h - Per-Worker BGP Listeners
+ *
+ * NetBlade OS v3.x Routing Engine
+ * Copyright (c) 2024-2026 Enterprise Systems Inc. All rights reserved.
+ */
+
+#ifndef BGP_LISTEN_H
+#define BGP_LISTEN_H
+
+#include <stdint.h>
+
+#define BGP_PORT                    179
+#define BGP_LISTEN_BACKLOG          1024
+#define BGP_LISTEN_HANDOFF_QUEUE    1024    /* Per worker; power of two */
+
+typedef struct bgp_listen bgp_listen_t;
+
+/* A new session socket (non-blocking) for a VRF this worker owns */
+typedef void (*bgp_listen_accept_cb_t)(int fd, uint32_t vrf_id, void *ctx);
+
+typedef struct {
+    uint64_t accepted;          /* Accepted on this worker's socket */
+    uint64_t local;             /* ...for a VRF this worker owns */
+    uint64_t handed_off;        /* ...passed on to the owning worker */
+    uint64_t received;          /* Handed in by other workers */
+    uint64_t dropped;           /* Owner's handoff queue full; connection reset */
+} bgp_listen_stats_t;
+
+/* One SO_REUSEPORT socket per bgp_shard worker, steered by ingress VRF */
+bgp_listen_t *bgp_listen_create(uint16_t port);
+void bgp_listen_destroy(bgp_listen_t *l);
+
+/* (Re)build the steering program from bgp_shard; call after VRF changes */
+int bgp_listen_steer(bgp_listen_t *l);
+
+/* Each worker polls both fds for readability and then calls bgp_listen_accept() */
+int bgp_listen_fd(bgp_listen_t *l, uint8_t shard);
+int bgp_listen_handoff_fd(bgp_listen_t *l, uint8_t shard);
+
+/* Accept pending connections and take over handed-in ones; returns sessions delivered */
+int bgp_listen_accept(bgp_listen_t *l, uint8_t shard, bgp_listen_accept_cb_t cb, void *ctx);
+
+void bgp_listen_get_stats(bgp_listen_t *l, uint8_t shard, bgp_listen_stats_t *stats);
+
+#endif /* BGP_LISTEN_H */
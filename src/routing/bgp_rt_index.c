@@ -0,0 +1,345 @@
+/*
+ * bgp_rt_index.c - Route-Target Import Index for L3VPN
+ *
+ * NetBlade OS v3.x Routing Engine
+ * Copyright (c) 2024-2026 Enterprise Systems Inc. All rights reserved.
+ *
+ * Importing a VPN route used to mean comparing its route-targets with
+ * the import list of every VRF. With thousands of VRFs that costs far
+ * more than the route. This index maps each route-target to the set of
+ * VRFs importing it: one hash probe per route-target on the route, then
+ * a walk over just the VRFs that match.
+ *
+ * A VRF set is a bitmap over vrf_id with a one-word summary of its
+ * non-empty words, so walking it costs O(members) rather than
+ * BGP_RT_MAX_VRFS / 64 words. Bitmaps are indexed by vrf_id itself,
+ * so VRF ids must be below BGP_RT_MAX_VRFS; larger ones are refused.
+ *
+ * Workers read the index without a lock: route-target slots are
+ * published with release ordering and never removed, and configuration
+ * changes flip individual bits atomically. A VRF's new route-targets
+ * are set before its dropped ones are cleared, so a route imported
+ * while the VRF is being reconfigured may briefly match both lists,
+ * but never neither of them. A route with several route-targets reads
+ * their entries one by one, so it retries if a change ran meanwhile.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+#include <stdbool.h>
+#include <stdatomic.h>
+#include "bgp_rt_index.h"
+#include "nb_mutex.h"
+#include "syslog.h"
+
+typedef struct {
+    _Atomic uint64_t summary;
+    _Atomic uint64_t words[BGP_RT_WORDS];
+    uint32_t         vrfs;          /* Writer only */
+} bgp_rt_entry_t;
+
+typedef struct {
+    _Atomic uint64_t          rt;   /* 0: empty */
+    bgp_rt_entry_t *_Atomic   entry;
+} bgp_rt_slot_t;
+
+struct bgp_rt_index {
+    bgp_rt_slot_t *slots;
+    uint32_t       mask;
+    uint32_t       capacity;        /* Route-targets; slots stay under 3/4 full */
+    uint32_t       used;
+
+    /* Current import list per VRF, for computing differences */
+    uint64_t      *imports[BGP_RT_MAX_VRFS];
+    uint16_t       nimports[BGP_RT_MAX_VRFS];
+
+    uint32_t       rts;
+    uint32_t       vrfs;
+    uint64_t       updates;
+    size_t         memory;
+    _Atomic uint32_t seq;           /* Odd while a VRF's bits are changing */
+    nb_mutex_t     lock;
+};
+
+static uint32_t bgp_rt_hash(uint64_t rt)
+{
+    rt ^= rt >> 33;
+    rt *= 0xff51afd7ed558ccdULL;
+    rt ^= rt >> 33;
+    return (uint32_t)rt;
+}
+
+static bgp_rt_entry_t *bgp_rt_find(const bgp_rt_index_t *idx, uint64_t rt)
+{
+    for (uint32_t i = bgp_rt_hash(rt) & idx->mask; ; i = (i + 1) & idx->mask) {
+        uint64_t k = atomic_load_explicit(&idx->slots[i].rt, memory_order_acquire);
+        if (k == rt) return atomic_load_explicit(&idx->slots[i].entry, memory_order_relaxed);
+        if (k == 0) return NULL;
+    }
+}
+
+/* Caller holds the lock */
+static bgp_rt_entry_t *bgp_rt_insert(bgp_rt_index_t *idx, uint64_t rt)
+{
+    uint32_t i = bgp_rt_hash(rt) & idx->mask;
+
+    for (;; i = (i + 1) & idx->mask) {
+        uint64_t k = atomic_load_explicit(&idx->slots[i].rt, memory_order_relaxed);
+        if (k == rt) return atomic_load_explicit(&idx->slots[i].entry, memory_order_relaxed);
+        if (k == 0) break;
+    }
+
+    if (idx->used >= idx->capacity) return NULL;
+
+    bgp_rt_entry_t *e = calloc(1, sizeof(bgp_rt_entry_t));
+    if (!e) return NULL;
+
+    /* Entry first, then the key that makes it visible to readers */
+    atomic_store_explicit(&idx->slots[i].entry, e, memory_order_relaxed);
+    atomic_store_explicit(&idx->slots[i].rt, rt, memory_order_release);
+    idx->used++;
+    idx->memory += sizeof(bgp_rt_entry_t);
+    return e;
+}
+
+static bool bgp_rt_listed(const uint64_t *rts, uint16_t count, uint64_t rt)
+{
+    for (uint16_t i = 0; i < count; i++) {
+        if (rts[i] == rt) return true;
+    }
+    return false;
+}
+
+static void bgp_rt_set_bit(bgp_rt_index_t *idx, bgp_rt_entry_t *e, uint32_t vrf_id)
+{
+    uint32_t w = vrf_id / 64;
+
+    atomic_fetch_or_explicit(&e->words[w], 1ULL << (vrf_id % 64), memory_order_relaxed);
+    atomic_fetch_or_explicit(&e->summary, 1ULL << w, memory_order_release);
+    if (e->vrfs++ == 0) idx->rts++;
+    idx->updates++;
+}
+
+static void bgp_rt_clear_bit(bgp_rt_index_t *idx, bgp_rt_entry_t *e, uint32_t vrf_id)
+{
+    uint32_t w = vrf_id / 64;
+    uint64_t bit = 1ULL << (vrf_id % 64);
+
+    if ((atomic_fetch_and_explicit(&e->words[w], ~bit, memory_order_release) & ~bit) == 0) {
+        atomic_fetch_and_explicit(&e->summary, ~(1ULL << w), memory_order_release);
+    }
+    if (--e->vrfs == 0) idx->rts--;
+    idx->updates++;
+}
+
+bgp_rt_index_t *bgp_rt_index_create(uint32_t max_rts)
+{
+    uint32_t slots = 1;
+
+    if (max_rts == 0) max_rts = BGP_RT_DEFAULT_RTS;
+    while (slots < (uint64_t)max_rts * 4 / 3 + 1) slots <<= 1;
+
+    bgp_rt_index_t *idx = calloc(1, sizeof(bgp_rt_index_t));
+    if (!idx) return NULL;
+
+    idx->slots = calloc(slots, sizeof(bgp_rt_slot_t));
+    if (!idx->slots) {
+        free(idx);
+        return NULL;
+    }
+    idx->mask = slots - 1;
+    idx->capacity = max_rts;
+    idx->memory = sizeof(bgp_rt_index_t) + (size_t)slots * sizeof(bgp_rt_slot_t);
+    nb_mutex_init(&idx->lock, "bgp.rt_index");
+
+    syslog_write(LOG_INFO, "BGP rt-index: %u route-targets, %u VRFs, %u KB",
+        max_rts, BGP_RT_MAX_VRFS, (unsigned)(idx->memory / 1024));
+    return idx;
+}
+
+void bgp_rt_index_destroy(bgp_rt_index_t *idx)
+{
+    if (!idx) return;
+
+    for (uint32_t i = 0; i <= idx->mask; i++) {
+        free(atomic_load(&idx->slots[i].entry));
+    }
+    for (uint32_t v = 0; v < BGP_RT_MAX_VRFS; v++) free(idx->imports[v]);
+    nb_mutex_destroy(&idx->lock);
+    free(idx->slots);
+    free(idx);
+}
+
+/*
+ * bgp_rt_index_set_imports - Apply a VRF's import route-target list
+ *
+ * Called when a VRF is configured, reconfigured or deleted. Entries for
+ * route-targets new to the index are created before any bit changes, so
+ * on failure the VRF keeps its previous imports. The list is stored
+ * without repeats, so each route-target is cleared once on the next
+ * change.
+ */
+int bgp_rt_index_set_imports(bgp_rt_index_t *idx, uint32_t vrf_id,
+                             const uint64_t *rts, uint16_t count)
+{
+    if (vrf_id >= BGP_RT_MAX_VRFS) {
+        syslog_write(LOG_ERR, "BGP rt-index: VRF %u out of range (limit %u), imports ignored",
+            vrf_id, BGP_RT_MAX_VRFS);
+        return -1;
+    }
+    if (count > BGP_RT_MAX_IMPORTS || (count && !rts)) return -1;
+
+    uint64_t *list = NULL;
+    uint16_t n = 0;
+
+    if (count) {
+        list = malloc(count * sizeof(uint64_t));
+        if (!list) return -1;
+        for (uint16_t i = 0; i < count; i++) {
+            if (!bgp_rt_listed(list, n, rts[i])) list[n++] = rts[i];
+        }
+    }
+
+    nb_mutex_lock(&idx->lock);
+
+    for (uint16_t i = 0; i < n; i++) {
+        if (!bgp_rt_insert(idx, list[i])) {
+            nb_mutex_unlock(&idx->lock);
+            syslog_write(LOG_ERR, "BGP rt-index: Route-target table full (%u), "
+                "VRF %u imports unchanged", idx->capacity, vrf_id);
+            free(list);
+            return -1;
+        }
+    }
+
+    uint64_t *old = idx->imports[vrf_id];
+    uint16_t old_count = idx->nimports[vrf_id];
+
+    /* Set before clearing: a concurrent import matches the old list or the new one */
+    atomic_fetch_add_explicit(&idx->seq, 1, memory_order_relaxed);
+    atomic_thread_fence(memory_order_release);
+    for (uint16_t i = 0; i < n; i++) {
+        if (!bgp_rt_listed(old, old_count, list[i])) {
+            bgp_rt_set_bit(idx, bgp_rt_find(idx, list[i]), vrf_id);
+        }
+    }
+    for (uint16_t i = 0; i < old_count; i++) {
+        if (!bgp_rt_listed(list, n, old[i])) {
+            bgp_rt_clear_bit(idx, bgp_rt_find(idx, old[i]), vrf_id);
+        }
+    }
+    atomic_fetch_add_explicit(&idx->seq, 1, memory_order_release);
+
+    if (old_count == 0 && n > 0) idx->vrfs++;
+    if (old_count > 0 && n == 0) idx->vrfs--;
+    idx->imports[vrf_id] = list;
+    idx->nimports[vrf_id] = n;
+
+    nb_mutex_unlock(&idx->lock);
+
+    free(old);
+    return 0;
+}
+
+uint32_t bgp_rt_index_match(bgp_rt_index_t *idx, const uint64_t *rts, uint16_t count,
+                            bgp_rt_vrfset_t *set)
+{
+    uint32_t n = 0, seq;
+
+    /*
+     * Entries are read one after another, so a reconfiguration landing
+     * between two of them could show the first before its new bit is set
+     * and the second after its old bit is cleared. Retry if one ran.
+     */
+retry:
+    while ((seq = atomic_load_explicit(&idx->seq, memory_order_acquire)) & 1) ;
+    set->summary = 0;
+
+    for (uint16_t i = 0; i < count; i++) {
+        bgp_rt_entry_t *e = bgp_rt_find(idx, rts[i]);
+        if (!e) continue;
+
+        uint64_t s = atomic_load_explicit(&e->summary, memory_order_acquire);
+        while (s) {
+            uint32_t w = (uint32_t)__builtin_ctzll(s);
+            uint64_t v = atomic_load_explicit(&e->words[w], memory_order_relaxed);
+
+            s &= s - 1;
+            if (set->summary & (1ULL << w)) {
+                set->words[w] |= v;
+            } else {
+                set->words[w] = v;
+                set->summary |= 1ULL << w;
+            }
+        }
+    }
+
+    atomic_thread_fence(memory_order_acquire);
+    if (count > 1 && atomic_load_explicit(&idx->seq, memory_order_relaxed) != seq) goto retry;
+
+    for (uint64_t s = set->summary; s; s &= s - 1) {
+        n += (uint32_t)__builtin_popcountll(set->words[__builtin_ctzll(s)]);
+    }
+    return n;
+}
+
+uint32_t bgp_rt_index_import(bgp_rt_index_t *idx, const uint64_t *rts, uint16_t count,
+                             bgp_rt_import_cb_t cb, void *ctx)
+{
+    bgp_rt_vrfset_t set;
+    uint32_t n = 0;
+
+    if (count == 1) {
+        /* Most VPN routes carry one route-target: walk its entry directly */
+        bgp_rt_entry_t *e = bgp_rt_find(idx, rts[0]);
+        if (!e) return 0;
+
+        for (uint64_t s = atomic_load_explicit(&e->summary, memory_order_acquire); s; s &= s - 1) {
+            uint32_t w = (uint32_t)__builtin_ctzll(s);
+            for (uint64_t v = atomic_load_explicit(&e->words[w], memory_order_relaxed); v; v &= v - 1) {
+                cb(w * 64 + (uint32_t)__builtin_ctzll(v), ctx);
+                n++;
+            }
+        }
+        return n;
+    }
+
+    bgp_rt_index_match(idx, rts, count, &set);
+
+    for (uint64_t s = set.summary; s; s &= s - 1) {
+        uint32_t w = (uint32_t)__builtin_ctzll(s);
+        for (uint64_t v = set.words[w]; v; v &= v - 1) {
+            cb(w * 64 + (uint32_t)__builtin_ctzll(v), ctx);
+            n++;
+        }
+    }
+    return n;
+}
+
+void bgp_rt_index_get_stats(bgp_rt_index_t *idx, bgp_rt_index_stats_t *stats)
+{
+    nb_mutex_lock(&idx->lock);
+
+    stats->rts = idx->rts;
+    stats->capacity = idx->capacity;
+    stats->vrfs = idx->vrfs;
+    stats->updates = idx->updates;
+    stats->memory = idx->memory;
+    for (uint32_t v = 0; v < BGP_RT_MAX_VRFS; v++) {
+        stats->memory += idx->nimports[v] * sizeof(uint64_t);
+    }
+
+    nb_mutex_unlock(&idx->lock);
+}
+
+void bgp_rt_index_dump(bgp_rt_index_t *idx)
+{
+    bgp_rt_index_stats_t st;
+
+    bgp_rt_index_get_stats(idx, &st);
+    syslog_write(LOG_INFO, "BGP rt-index: %u route-targets (capacity %u) imported by "
+        "%u VRFs, %llu updates, %zu KB", st.rts, st.capacity, st.vrfs,
+        (unsigned long long)st.updates, st.memory / 1024);
+}
@@ -0,0 +1,72 @@
+/*
+ * bgp_rt_index.h - Route-Target Import Index for L3VPN
+ *
+ * NetBlade OS v3.x Routing Engine
+ * Copyright (c) 2024-2026 Enterprise Systems Inc. All rights reserved.
+ */
+
+#ifndef BGP_RT_INDEX_H
+#define BGP_RT_INDEX_H
+
+#include <stdint.h>
+#include <stddef.h>
+
+#define BGP_RT_MAX_VRFS         4096    /* vrf_id must be below this; bitmaps index it directly */
+#define BGP_RT_WORDS            (BGP_RT_MAX_VRFS / 64)
+#define BGP_RT_MAX_IMPORTS      64      /* Import route-targets per VRF */
+#define BGP_RT_DEFAULT_RTS      65536   /* Distinct route-targets */
+
+/* Route-target extended communities (RFC 4360), as the 8 bytes read big-endian */
+#define BGP_RT_AS2(as, val)     ((0x0002ULL << 48) | ((uint64_t)(uint16_t)(as) << 32) | (uint32_t)(val))
+#define BGP_RT_IPV4(ip, val)    ((0x0102ULL << 48) | ((uint64_t)(uint32_t)(ip) << 16) | (uint16_t)(val))
+#define BGP_RT_AS4(as, val)     ((0x0202ULL << 48) | ((uint64_t)(uint32_t)(as) << 16) | (uint16_t)(val))
+
+/*
+ * A set of VRFs. Bit w of summary says words[w] is in use; words not
+ * flagged hold garbage, so a set never needs clearing.
+ */
+typedef struct {
+    uint64_t summary;
+    uint64_t words[BGP_RT_WORDS];
+} bgp_rt_vrfset_t;
+
+typedef struct {
+    uint32_t rts;               /* Route-targets imported by at least one VRF */
+    uint32_t capacity;
+    uint32_t vrfs;              /* VRFs with imports */
+    uint64_t updates;           /* VRF bits set or cleared */
+    size_t   memory;
+} bgp_rt_index_stats_t;
+
+typedef struct bgp_rt_index bgp_rt_index_t;
+
+typedef void (*bgp_rt_import_cb_t)(uint32_t vrf_id, void *ctx);
+
+bgp_rt_index_t *bgp_rt_index_create(uint32_t max_rts);
+void bgp_rt_index_destroy(bgp_rt_index_t *idx);
+
+/*
+ * Configuration side, serialised internally. Replaces the VRF's import
+ * route-targets; only the difference from the previous list touches
+ * the index. A count of 0 removes the VRF. Returns -1 for a vrf_id of
+ * BGP_RT_MAX_VRFS or more.
+ */
+int bgp_rt_index_set_imports(bgp_rt_index_t *idx, uint32_t vrf_id,
+                             const uint64_t *rts, uint16_t count);
+
+/*
+ * Import side, lock-free and safe from any worker while configuration
+ * changes. Cost is O(route-targets on the route + matching VRFs),
+ * independent of how many VRFs exist.
+ */
+/* Every VRF importing any of rts, each once; returns how many */
+uint32_t bgp_rt_index_import(bgp_rt_index_t *idx, const uint64_t *rts, uint16_t count,
+                             bgp_rt_import_cb_t cb, void *ctx);
+/* Same VRFs as a set; returns how many */
+uint32_t bgp_rt_index_match(bgp_rt_index_t *idx, const uint64_t *rts, uint16_t count,
+                            bgp_rt_vrfset_t *set);
+
+void bgp_rt_index_get_stats(bgp_rt_index_t *idx, bgp_rt_index_stats_t *stats);
+void bgp_rt_index_dump(bgp_rt_index_t *idx);
+
+#endif /* BGP_RT_INDEX_H */
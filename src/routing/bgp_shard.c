@@ -0,0 +1,200 @@
+/*
+ * bgp_shard.c - VRF to BGP Worker Shard Assignment
+ *
+ * NetBlade OS v3.x Routing Engine
+ * Copyright (c) 2024-2026 Enterprise Systems Inc. All rights reserved.
+ *
+ * Each BGP worker owns a fixed set of VRFs: their timers, RIBs and
+ * sessions are touched from that worker only. A VRF lands on
+ * vrf_id % nshards unless pinned, so its owner does not change when
+ * other VRFs come and go. The default VRF always belongs to the
+ * shard of vrf_id 0.
+ *
+ * Workers are spread over NUMA nodes in contiguous blocks, so with two
+ * nodes and eight workers, workers 0-3 run on node 0 and 4-7 on node 1.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+#include <stdbool.h>
+#include <net/if.h>
+#include "bgp_shard.h"
+#include "vrf_manager.h"
+#include "syslog.h"
+#include "nb_mutex.h"
+#include "nb_numa.h"
+
+typedef struct {
+    bgp_shard_vrf_t vrf;
+    char            name[64];
+    bool            pinned;
+} bgp_shard_entry_t;
+
+static struct {
+    uint8_t            nshards;
+    bgp_shard_entry_t  vrfs[BGP_SHARD_MAX_VRFS];
+    int                vrf_count;
+    nb_mutex_t         lock;
+} shards = {
+    .nshards = 1,
+    .lock = NB_MUTEX_INITIALIZER("bgp_shard.lock"),
+};
+
+static bgp_shard_entry_t *bgp_shard_find(uint32_t vrf_id)
+{
+    for (int i = 0; i < shards.vrf_count; i++) {
+        if (shards.vrfs[i].vrf.vrf_id == vrf_id) return &shards.vrfs[i];
+    }
+    return NULL;
+}
+
+static uint8_t bgp_shard_default(uint32_t vrf_id)
+{
+    return (uint8_t)(vrf_id % shards.nshards);
+}
+
+int bgp_shard_init(uint8_t nshards)
+{
+    if (nshards == 0 || nshards > BGP_SHARD_MAX) return -1;
+
+    nb_mutex_lock(&shards.lock);
+    shards.nshards = nshards;
+    shards.vrf_count = 0;
+    nb_mutex_unlock(&shards.lock);
+
+    return bgp_shard_refresh();
+}
+
+int bgp_shard_refresh(void)
+{
+    vrf_info_t list[BGP_SHARD_MAX_VRFS];
+    int count = vrf_manager_get_vrf_list(list, BGP_SHARD_MAX_VRFS);
+
+    if (count < 0) {
+        syslog_write(LOG_ERR, "BGP shard: Failed to get VRF list");
+        return -1;
+    }
+
+    nb_mutex_lock(&shards.lock);
+
+    bgp_shard_entry_t old[BGP_SHARD_MAX_VRFS];
+    int old_count = shards.vrf_count;
+    memcpy(old, shards.vrfs, sizeof(bgp_shard_entry_t) * (size_t)old_count);
+
+    shards.vrf_count = 0;
+    for (int i = 0; i < count; i++) {
+        bgp_shard_entry_t *e = &shards.vrfs[shards.vrf_count++];
+
+        memset(e, 0, sizeof(bgp_shard_entry_t));
+        e->vrf.vrf_id = list[i].vrf_id;
+        strncpy(e->name, list[i].vrf_name, sizeof(e->name) - 1);
+        e->vrf.ifindex = list[i].vrf_id ? if_nametoindex(e->name) : 0;
+        e->vrf.shard = bgp_shard_default(e->vrf.vrf_id);
+
+        /* Pins survive a refresh */
+        for (int j = 0; j < old_count; j++) {
+            if (old[j].vrf.vrf_id == e->vrf.vrf_id && old[j].pinned) {
+                e->vrf.shard = old[j].vrf.shard;
+                e->pinned = true;
+            }
+        }
+    }
+
+    nb_mutex_unlock(&shards.lock);
+
+    syslog_write(LOG_INFO, "BGP shard: %d VRFs across %d workers", count, shards.nshards);
+    return 0;
+}
+
+uint8_t bgp_shard_count(void)
+{
+    return shards.nshards;
+}
+
+uint8_t bgp_shard_of_vrf(uint32_t vrf_id)
+{
+    nb_mutex_lock(&shards.lock);
+    bgp_shard_entry_t *e = bgp_shard_find(vrf_id);
+    uint8_t shard = e ? e->vrf.shard : bgp_shard_default(vrf_id);
+    nb_mutex_unlock(&shards.lock);
+
+    return shard;
+}
+
+int bgp_shard_pin(uint32_t vrf_id, uint8_t shard)
+{
+    nb_mutex_lock(&shards.lock);
+
+    bgp_shard_entry_t *e = bgp_shard_find(vrf_id);
+    if (!e || shard >= shards.nshards) {
+        nb_mutex_unlock(&shards.lock);
+        return -1;
+    }
+    e->vrf.shard = shard;
+    e->pinned = true;
+
+    nb_mutex_unlock(&shards.lock);
+    return 0;
+}
+
+int bgp_shard_node(uint8_t shard)
+{
+    int nodes = nb_numa_node_count();
+
+    if (shard >= shards.nshards) return 0;
+    return (int)((uint32_t)shard * (uint32_t)nodes / shards.nshards);
+}
+
+int bgp_shard_bind_worker(uint8_t shard)
+{
+    if (shard >= shards.nshards) return -1;
+    if (nb_numa_node_count() == 1) return 0;
+
+    return nb_numa_pin_thread(bgp_shard_node(shard));
+}
+
+uint32_t bgp_shard_vrf_of_ifindex(uint32_t ifindex)
+{
+    uint32_t vrf_id = 0;
+
+    if (ifindex == 0) return 0;
+
+    nb_mutex_lock(&shards.lock);
+    for (int i = 0; i < shards.vrf_count; i++) {
+        if (shards.vrfs[i].vrf.ifindex == ifindex) {
+            vrf_id = shards.vrfs[i].vrf.vrf_id;
+            break;
+        }
+    }
+    nb_mutex_unlock(&shards.lock);
+
+    return vrf_id;
+}
+
+int bgp_shard_get_vrfs(bgp_shard_vrf_t *vrfs, int max)
+{
+    int n = 0;
+
+    nb_mutex_lock(&shards.lock);
+    for (int i = 0; i < shards.vrf_count && n < max; i++) {
+        vrfs[n++] = shards.vrfs[i].vrf;
+    }
+    nb_mutex_unlock(&shards.lock);
+
+    return n;
+}
+
+void bgp_shard_dump(void)
+{
+    nb_mutex_lock(&shards.lock);
+    syslog_write(LOG_DEBUG, "BGP shards: %d workers, %d VRFs", shards.nshards, shards.vrf_count);
+    for (int i = 0; i < shards.vrf_count; i++) {
+        bgp_shard_entry_t *e = &shards.vrfs[i];
+        syslog_write(LOG_DEBUG, "  VRF %u '%s' ifindex %u -> worker %u node %d%s",
+            e->vrf.vrf_id, e->name, e->vrf.ifindex, e->vrf.shard,
+            bgp_shard_node(e->vrf.shard), e->pinned ? " (pinned)" : "");
+    }
+    nb_mutex_unlock(&shards.lock);
+}
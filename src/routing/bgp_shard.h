@@ -0,0 +1,46 @@
+/*
+ * bgp_shard.h - VRF to BGP Worker Shard Assignment
+ *
+ * NetBlade OS v3.x Routing Engine
+ * Copyright (c) 2024-2026 Enterprise Systems Inc. All rights reserved.
+ */
+
+#ifndef BGP_SHARD_H
+#define BGP_SHARD_H
+
+#include <stdint.h>
+
+#define BGP_SHARD_MAX           64
+#define BGP_SHARD_MAX_VRFS      256     /* Matches MAX_VRF_INSTANCES in bgp_timers.c */
+
+typedef struct {
+    uint32_t vrf_id;
+    uint32_t ifindex;           /* VRF master device; 0 for the default VRF */
+    uint8_t  shard;
+} bgp_shard_vrf_t;
+
+/* Assign every VRF from vrf_manager to one of nshards workers */
+int bgp_shard_init(uint8_t nshards);
+/* Re-read the VRF list after VRF configuration changes */
+int bgp_shard_refresh(void);
+
+uint8_t bgp_shard_count(void);
+
+/* The worker owning a VRF's timers, RIB and sessions */
+uint8_t bgp_shard_of_vrf(uint32_t vrf_id);
+/* Pin a VRF to a worker instead of the vrf_id-based default */
+int bgp_shard_pin(uint32_t vrf_id, uint8_t shard);
+
+/* NUMA node of a worker; its VRFs' timers, RIB arena and buffers live there */
+int bgp_shard_node(uint8_t shard);
+/* Pin the calling worker thread to its node; each worker calls this first */
+int bgp_shard_bind_worker(uint8_t shard);
+
+/* Resolve an ingress (VRF device) ifindex; unknown ifindexes are the default VRF */
+uint32_t bgp_shard_vrf_of_ifindex(uint32_t ifindex);
+
+/* Snapshot for building steering programs and for 'show bgp shards' */
+int bgp_shard_get_vrfs(bgp_shard_vrf_t *vrfs, int max);
+void bgp_shard_dump(void);
+
+#endif /* BGP_SHARD_H */
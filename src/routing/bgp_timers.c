@@ -13,11 +13,16 @@
 #include <string.h>
 #include <stdint.h>
 #include <stdbool.h>
+#include <stdatomic.h>
 #include <time.h>
 #include "bgp_timers.h"
 #include "bgp_peer.h"
 #include "vrf_manager.h"
 #include "syslog.h"
+#include "nb_prof.h"
+#include "nb_numa.h"
+#include "nb_boot.h"
+#include "nb_telemetry.h"
 
 /* Default timer values (seconds) */
 #define BGP_DEFAULT_HOLD_TIME       180
@@ -48,6 +53,116 @@ typedef struct {
 static vrf_timer_config_t vrf_timers[MAX_VRF_INSTANCES];
 static int vrf_timer_count = 0;
 
+/*
+ * Read copies of vrf_timers[] on each NUMA node, so a worker looking up
+ * hold and keepalive times stays on its own node. vrf_timers[] remains
+ * the master and is republished after every change. Each copy is
+ * guarded by a sequence count: readers retry a lookup that overlapped
+ * a republish, so they never act on a half-copied entry and the copy
+ * is never freed or replaced under them.
+ */
+typedef struct {
+    _Atomic uint32_t   seq;         /* Odd while being rewritten */
+    vrf_timer_config_t timers[MAX_VRF_INSTANCES];
+} vrf_timers_replica_t;
+
+static vrf_timers_replica_t *_Atomic vrf_timers_node[NB_NUMA_MAX_NODES];
+
+static void bgp_timers_publish(void)
+{
+    int nodes = nb_numa_node_count();
+
+    for (int n = 0; n < nodes; n++) {
+        vrf_timers_replica_t *r = atomic_load_explicit(&vrf_timers_node[n], memory_order_relaxed);
+
+        if (!r) {
+            r = nb_numa_alloc(sizeof(vrf_timers_replica_t), n);
+            if (!r) continue;
+            memcpy(r->timers, vrf_timers, sizeof(vrf_timers));
+            /* Readers fall back to the master until the copy is published */
+            atomic_store_explicit(&vrf_timers_node[n], r, memory_order_release);
+            continue;
+        }
+
+        uint32_t seq = atomic_load_explicit(&r->seq, memory_order_relaxed);
+        atomic_store_explicit(&r->seq, seq + 1, memory_order_relaxed);
+        atomic_thread_fence(memory_order_release);
+        memcpy(r->timers, vrf_timers, sizeof(vrf_timers));
+        atomic_store_explicit(&r->seq, seq + 2, memory_order_release);
+    }
+}
+
+/*
+ * Push per-VRF timer configuration to telemetry subscribers as
+ * "bgp/vrf/<id>/hold_time" and ".../keepalive". Only values that
+ * changed go out.
+ */
+static void bgp_timers_export(void)
+{
+    char path[NB_TELEMETRY_KEY_LEN];
+
+    for (int i = 0; i < MAX_VRF_INSTANCES; i++) {
+        const vrf_timer_config_t *t = &vrf_timers[i];
+        if (!t->initialized && !t->configured) continue;
+
+        snprintf(path, sizeof(path), "bgp/vrf/%u/hold_time", t->vrf_id);
+        nb_telemetry_set(nb_telemetry_key(path, NB_TELEMETRY_STATE), t->hold_time);
+        snprintf(path, sizeof(path), "bgp/vrf/%u/keepalive", t->vrf_id);
+        nb_telemetry_set(nb_telemetry_key(path, NB_TELEMETRY_STATE), t->keepalive);
+    }
+}
+
+/* Observer of user-configured changes, e.g. the ISSU change log */
+static void (*timers_change_cb)(uint32_t vrf_id, uint32_t hold_time, uint32_t keepalive,
+                                void *ctx);
+static void *timers_change_ctx;
+
+void bgp_timers_set_change_cb(void (*cb)(uint32_t vrf_id, uint32_t hold_time,
+                                         uint32_t keepalive, void *ctx), void *ctx)
+{
+    timers_change_cb = cb;
+    timers_change_ctx = ctx;
+}
+
+/*
+ * Copy out the initialized entry for vrf_id from the caller's node.
+ * Before the first publish, or if the node's copy could not be
+ * allocated, the master is read instead.
+ */
+static bool bgp_timers_lookup(uint32_t vrf_id, vrf_timer_config_t *out)
+{
+    vrf_timers_replica_t *r = atomic_load_explicit(&vrf_timers_node[nb_numa_current_node()],
+                                                   memory_order_acquire);
+
+    if (!r) {
+        for (int i = 0; i < MAX_VRF_INSTANCES; i++) {
+            if (vrf_timers[i].vrf_id == vrf_id && vrf_timers[i].initialized) {
+                *out = vrf_timers[i];
+                return true;
+            }
+        }
+        return false;
+    }
+
+    for (;;) {
+        uint32_t seq = atomic_load_explicit(&r->seq, memory_order_acquire);
+        bool found = false;
+
+        if (seq & 1) continue;
+
+        for (int i = 0; i < MAX_VRF_INSTANCES; i++) {
+            if (r->timers[i].vrf_id == vrf_id && r->timers[i].initialized) {
+                *out = r->timers[i];
+                found = true;
+                break;
+            }
+        }
+
+        atomic_thread_fence(memory_order_acquire);
+        if (atomic_load_explicit(&r->seq, memory_order_relaxed) == seq) return found;
+    }
+}
+
 /*
  * bgp_timers_init - Initialize BGP timers for all VRF instances
  *
@@ -59,6 +174,8 @@ static int vrf_timer_count = 0;
  */
 int bgp_timers_init(void)
 {
+    NB_PROF_SCOPE(NB_PROF_BGP_TIMERS);
+
     int num_vrfs = vrf_manager_get_count();  /* includes default VRF */
     int named_vrf_count;
 
@@ -171,6 +288,9 @@ int bgp_timers_init(void)
     syslog_write(LOG_INFO, "BGP timers: Initialized %d VRF timer entries",
         vrf_timer_count);
 
+    bgp_timers_publish();
+    bgp_timers_export();
+    nb_boot_mark(NB_BOOT_TIMERS_READY);
     return 0;
 }
 
@@ -184,18 +304,20 @@ int bgp_timers_init(void)
  */
 uint32_t bgp_timers_get_hold_time(uint32_t vrf_id, uint32_t remote_hold_time)
 {
-    for (int i = 0; i < MAX_VRF_INSTANCES; i++) {
-        if (vrf_timers[i].vrf_id == vrf_id && vrf_timers[i].initialized) {
-            uint32_t local_hold = vrf_timers[i].hold_time;
+    NB_PROF_SCOPE(NB_PROF_BGP_TIMERS);
 
-            /* RFC 4271: Use the minimum of local and remote hold times */
-            if (remote_hold_time == BGP_HOLD_TIME_DISABLED ||
-                local_hold == BGP_HOLD_TIME_DISABLED) {
-                return BGP_HOLD_TIME_DISABLED;
-            }
+    vrf_timer_config_t t;
+
+    if (bgp_timers_lookup(vrf_id, &t)) {
+        uint32_t local_hold = t.hold_time;
 
-            return (local_hold < remote_hold_time) ? local_hold : remote_hold_time;
+        /* RFC 4271: Use the minimum of local and remote hold times */
+        if (remote_hold_time == BGP_HOLD_TIME_DISABLED ||
+            local_hold == BGP_HOLD_TIME_DISABLED) {
+            return BGP_HOLD_TIME_DISABLED;
         }
+
+        return (local_hold < remote_hold_time) ? local_hold : remote_hold_time;
     }
 
     /*
@@ -219,14 +341,16 @@ uint32_t bgp_timers_get_hold_time(uint32_t vrf_id, uint32_t remote_hold_time)
  */
 uint32_t bgp_timers_get_keepalive(uint32_t vrf_id)
 {
-    for (int i = 0; i < MAX_VRF_INSTANCES; i++) {
-        if (vrf_timers[i].vrf_id == vrf_id && vrf_timers[i].initialized) {
-            if (vrf_timers[i].keepalive > 0) {
-                return vrf_timers[i].keepalive;
-            }
-            /* If keepalive not explicitly set, use hold_time / 3 */
-            return vrf_timers[i].hold_time / 3;
+    NB_PROF_SCOPE(NB_PROF_BGP_TIMERS);
+
+    vrf_timer_config_t t;
+
+    if (bgp_timers_lookup(vrf_id, &t)) {
+        if (t.keepalive > 0) {
+            return t.keepalive;
         }
+        /* If keepalive not explicitly set, use hold_time / 3 */
+        return t.hold_time / 3;
     }
 
     syslog_write(LOG_WARNING, "BGP timers: No keepalive for VRF %d", vrf_id);
@@ -241,6 +365,8 @@ uint32_t bgp_timers_get_keepalive(uint32_t vrf_id)
  */
 int bgp_timers_set(uint32_t vrf_id, uint32_t hold_time, uint32_t keepalive)
 {
+    NB_PROF_SCOPE(NB_PROF_BGP_TIMERS);
+
     if (hold_time != BGP_HOLD_TIME_DISABLED && hold_time < BGP_MIN_HOLD_TIME) {
         syslog_write(LOG_ERR, "BGP timers: Hold time %d below minimum %d",
             hold_time, BGP_MIN_HOLD_TIME);
@@ -252,6 +378,11 @@ int bgp_timers_set(uint32_t vrf_id, uint32_t hold_time, uint32_t keepalive)
             vrf_timers[i].hold_time = hold_time;
             vrf_timers[i].keepalive = keepalive;
             vrf_timers[i].configured = true;
+            bgp_timers_publish();
+            bgp_timers_export();
+            if (timers_change_cb) {
+                timers_change_cb(vrf_id, hold_time, keepalive, timers_change_ctx);
+            }
 
             syslog_write(LOG_INFO, "BGP timers: VRF %d set hold=%d keepalive=%d",
                 vrf_id, hold_time, keepalive);
@@ -263,6 +394,34 @@ int bgp_timers_set(uint32_t vrf_id, uint32_t hold_time, uint32_t keepalive)
     return -1;
 }
 
+/*
+ * bgp_timers_get_configured - Export user-configured VRF timers
+ *
+ * Used to hand configuration to a peer (e.g. ISSU bulk sync), which
+ * re-applies each entry with bgp_timers_set(). Defaults are not
+ * exported since the peer derives them itself.
+ *
+ * Returns the number of entries written (at most max).
+ */
+int bgp_timers_get_configured(uint32_t *vrf_ids, uint32_t *hold_times,
+                              uint32_t *keepalives, int max)
+{
+    NB_PROF_SCOPE(NB_PROF_BGP_TIMERS);
+
+    int n = 0;
+
+    for (int i = 0; i < MAX_VRF_INSTANCES && n < max; i++) {
+        if (!vrf_timers[i].configured) continue;
+
+        vrf_ids[n] = vrf_timers[i].vrf_id;
+        hold_times[n] = vrf_timers[i].hold_time;
+        keepalives[n] = vrf_timers[i].keepalive;
+        n++;
+    }
+
+    return n;
+}
+
 /*
  * bgp_timers_dump - Debug function to dump all timer state
  */
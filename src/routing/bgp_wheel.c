@@ -0,0 +1,344 @@
+/*
+ * bgp_wheel.c - Per-Worker BGP Timer Wheel
+ *
+ * NetBlade OS v3.x Routing Engine
+ * Copyright (c) 2024-2026 Enterprise Systems Inc. All rights reserved.
+ *
+ * A hashed timing wheel: a timer goes into the slot for its expiry tick
+ * modulo BGP_WHEEL_SLOTS, so adding and cancelling are O(1) however many
+ * thousands of hold, keepalive and connect-retry timers a worker holds.
+ * Timers further out than one turn share slots with nearer ones and are
+ * skipped until their turn comes round. Each slot keeps the earliest
+ * tick it holds, so bgp_wheel_next_ms() sleeps until a timer is really
+ * due rather than waking once a turn for a slot whose timers are not.
+ *
+ * Everything due in the same tick fires from one bgp_wheel_run(), which
+ * lets callers gather the work their timers start - connects, say - and
+ * issue it as a batch afterwards.
+ *
+ * Most BGP timers only need to fire within a window, so the wheel is
+ * free to pick the tick. It picks the latest multiple of the largest
+ * power of two that fits the window. Unrelated timers with overlapping
+ * windows land on the same few ticks, and an idle worker with
+ * thousands of peers wakes a handful of times per second instead of
+ * once per timer. Windows come from the slack setting and are bounded
+ * per timer type: keepalives may only go early, hold timers only late
+ * and by no more than a tenth of the hold time.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+#include <stdbool.h>
+#include <time.h>
+#include "bgp_wheel.h"
+#include "syslog.h"
+
+#define BGP_WHEEL_NONE          UINT32_MAX
+#define BGP_WHEEL_EXPIRED       BGP_WHEEL_SLOTS     /* List of timers being fired */
+#define BGP_WHEEL_UNUSED        UINT16_MAX
+
+/* Handle: generation in the high half, entry + 1 in the low half */
+#define BGP_WHEEL_TIMER(idx, gen)   (((uint32_t)(gen) << 16) | ((idx) + 1))
+#define BGP_WHEEL_IDX(t)            (((t) & 0xffff) - 1)
+#define BGP_WHEEL_GEN(t)            ((uint16_t)((t) >> 16))
+
+typedef struct {
+    uint64_t        expires;    /* Tick */
+    bgp_wheel_cb_t  cb;
+    void           *ctx;
+    uint32_t        prev;
+    uint32_t        next;       /* Also the free list */
+    uint16_t        gen;
+    uint16_t        list;       /* Slot, BGP_WHEEL_EXPIRED or BGP_WHEEL_UNUSED */
+} bgp_wheel_entry_t;
+
+struct bgp_wheel {
+    uint32_t            tick_ms;
+    uint64_t            origin_ms;
+    uint64_t            now_tick;   /* Every tick up to here has been run */
+    uint32_t            max_timers;
+    uint32_t            pending;
+    uint32_t            slack_ms;
+
+    bgp_wheel_entry_t  *entries;
+    uint32_t            free_head;
+    uint32_t            heads[BGP_WHEEL_SLOTS + 1];
+    uint64_t            due[BGP_WHEEL_SLOTS];   /* No timer in the slot expires before this */
+
+    bgp_wheel_stats_t   stats;
+};
+
+static uint64_t bgp_wheel_clock_ms(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000ULL + (uint64_t)ts.tv_nsec / 1000000ULL;
+}
+
+static uint64_t bgp_wheel_tick_now(bgp_wheel_t *w)
+{
+    return (bgp_wheel_clock_ms() - w->origin_ms) / w->tick_ms;
+}
+
+static void bgp_wheel_link(bgp_wheel_t *w, uint32_t i, uint16_t list)
+{
+    bgp_wheel_entry_t *e = &w->entries[i];
+
+    e->list = list;
+    e->prev = BGP_WHEEL_NONE;
+    e->next = w->heads[list];
+    if (e->next != BGP_WHEEL_NONE) w->entries[e->next].prev = i;
+    w->heads[list] = i;
+    if (list < BGP_WHEEL_SLOTS && e->expires < w->due[list]) w->due[list] = e->expires;
+}
+
+static void bgp_wheel_unlink(bgp_wheel_t *w, uint32_t i)
+{
+    bgp_wheel_entry_t *e = &w->entries[i];
+
+    if (e->prev != BGP_WHEEL_NONE) w->entries[e->prev].next = e->next;
+    else w->heads[e->list] = e->next;
+    if (e->next != BGP_WHEEL_NONE) w->entries[e->next].prev = e->prev;
+    e->list = BGP_WHEEL_UNUSED;
+}
+
+static void bgp_wheel_release(bgp_wheel_t *w, uint32_t i)
+{
+    bgp_wheel_entry_t *e = &w->entries[i];
+
+    e->gen++;
+    e->cb = NULL;
+    e->ctx = NULL;
+    e->next = w->free_head;
+    w->free_head = i;
+    w->pending--;
+}
+
+bgp_wheel_t *bgp_wheel_create(uint32_t tick_ms, uint32_t max_timers)
+{
+    if (max_timers == 0 || max_timers > BGP_WHEEL_MAX_TIMERS - 1) return NULL;
+
+    bgp_wheel_t *w = calloc(1, sizeof(bgp_wheel_t));
+    if (!w) return NULL;
+
+    w->entries = calloc(max_timers, sizeof(bgp_wheel_entry_t));
+    if (!w->entries) {
+        free(w);
+        return NULL;
+    }
+
+    w->tick_ms = tick_ms ? tick_ms : BGP_WHEEL_TICK_MS;
+    w->origin_ms = bgp_wheel_clock_ms();
+    w->max_timers = max_timers;
+    w->slack_ms = BGP_WHEEL_SLACK_MS;
+
+    for (uint32_t i = 0; i < max_timers; i++) {
+        w->entries[i].list = BGP_WHEEL_UNUSED;
+        w->entries[i].next = i + 1 < max_timers ? i + 1 : BGP_WHEEL_NONE;
+    }
+    for (uint32_t s = 0; s <= BGP_WHEEL_SLOTS; s++) w->heads[s] = BGP_WHEEL_NONE;
+    for (uint32_t s = 0; s < BGP_WHEEL_SLOTS; s++) w->due[s] = UINT64_MAX;
+
+    return w;
+}
+
+void bgp_wheel_destroy(bgp_wheel_t *w)
+{
+    if (!w) return;
+    free(w->entries);
+    free(w);
+}
+
+void bgp_wheel_set_slack(bgp_wheel_t *w, uint32_t slack_ms)
+{
+    w->slack_ms = slack_ms;
+}
+
+/* Expire at a tick from lo to hi after now, aligned so neighbours share it */
+static bgp_wheel_timer_t bgp_wheel_insert(bgp_wheel_t *w, uint64_t lo, uint64_t hi,
+                                          bgp_wheel_cb_t cb, void *ctx)
+{
+    uint32_t i = w->free_head;
+
+    if (!cb) return 0;
+    if (i == BGP_WHEEL_NONE) {
+        syslog_write(LOG_ERR, "BGP wheel: All %u timers in use", w->max_timers);
+        return 0;
+    }
+    w->free_head = w->entries[i].next;
+    w->pending++;
+    w->stats.added++;
+
+    uint64_t now = bgp_wheel_tick_now(w);
+    if (now < w->now_tick) now = w->now_tick;
+
+    /* Never into the tick being run, or it would wait a full turn */
+    lo = now + (lo ? lo : 1);
+    hi = now + (hi > lo - now ? hi : lo - now);
+
+    /* The window always holds a multiple of the largest power of two not above its size */
+    uint64_t g = 1;
+    while (g * 2 <= hi - lo + 1 && g * 2 <= BGP_WHEEL_SLOTS / 4) g *= 2;
+    uint64_t expires = hi / g * g;
+    if (expires < lo) expires = lo;
+    if (expires != lo) w->stats.coalesced++;
+
+    bgp_wheel_entry_t *e = &w->entries[i];
+    e->expires = expires;
+    e->cb = cb;
+    e->ctx = ctx;
+    bgp_wheel_link(w, i, (uint16_t)(e->expires & (BGP_WHEEL_SLOTS - 1)));
+
+    return BGP_WHEEL_TIMER(i, e->gen);
+}
+
+bgp_wheel_timer_t bgp_wheel_add_window(bgp_wheel_t *w, uint32_t min_ms, uint32_t max_ms,
+                                       bgp_wheel_cb_t cb, void *ctx)
+{
+    uint64_t lo = ((uint64_t)min_ms + w->tick_ms - 1) / w->tick_ms;
+    uint64_t hi = (uint64_t)max_ms / w->tick_ms;
+
+    return bgp_wheel_insert(w, lo, hi, cb, ctx);
+}
+
+bgp_wheel_timer_t bgp_wheel_add(bgp_wheel_t *w, uint32_t delay_ms, bgp_wheel_cb_t cb, void *ctx)
+{
+    uint32_t slack = w->slack_ms < delay_ms / 8 ? w->slack_ms : delay_ms / 8;
+
+    return bgp_wheel_add_window(w, delay_ms, delay_ms + slack, cb, ctx);
+}
+
+bgp_wheel_timer_t bgp_wheel_add_keepalive(bgp_wheel_t *w, uint32_t interval_ms,
+                                          bgp_wheel_cb_t cb, void *ctx)
+{
+    /* Early is always safe for the peer's hold timer; late never is */
+    uint32_t min_ms = interval_ms > w->slack_ms ? interval_ms - w->slack_ms : 0;
+    if (min_ms < BGP_WHEEL_KEEPALIVE_MIN) {
+        min_ms = interval_ms < BGP_WHEEL_KEEPALIVE_MIN ? interval_ms : BGP_WHEEL_KEEPALIVE_MIN;
+    }
+
+    return bgp_wheel_add_window(w, min_ms, interval_ms, cb, ctx);
+}
+
+bgp_wheel_timer_t bgp_wheel_add_hold(bgp_wheel_t *w, uint32_t hold_ms, bgp_wheel_cb_t cb, void *ctx)
+{
+    /* Expiring early would reset a healthy session; late only delays detection */
+    uint32_t slack = hold_ms / BGP_WHEEL_HOLD_SLACK_DIV;
+    if (slack > w->slack_ms) slack = w->slack_ms;
+
+    /* One tick more, since the current tick is already partly gone */
+    return bgp_wheel_add_window(w, hold_ms + w->tick_ms, hold_ms + w->tick_ms + slack, cb, ctx);
+}
+
+void bgp_wheel_cancel(bgp_wheel_t *w, bgp_wheel_timer_t t)
+{
+    uint32_t i = BGP_WHEEL_IDX(t);
+
+    if (t == 0 || i >= w->max_timers) return;
+
+    bgp_wheel_entry_t *e = &w->entries[i];
+    if (e->gen != BGP_WHEEL_GEN(t) || e->list == BGP_WHEEL_UNUSED) return;
+
+    bgp_wheel_unlink(w, i);
+    bgp_wheel_release(w, i);
+}
+
+int bgp_wheel_run(bgp_wheel_t *w)
+{
+    uint64_t now = bgp_wheel_tick_now(w);
+    int fired = 0;
+
+    w->stats.wakeups++;
+    if (now <= w->now_tick) {
+        w->stats.idle++;
+        return 0;
+    }
+
+    /* After a long stall each slot only needs visiting once */
+    uint64_t span = now - w->now_tick;
+    if (span > BGP_WHEEL_SLOTS) span = BGP_WHEEL_SLOTS;
+
+    for (uint64_t tick = now - span + 1; tick <= now; tick++) {
+        uint32_t slot = tick & (BGP_WHEEL_SLOTS - 1);
+        uint32_t i = w->heads[slot];
+
+        /* Cancels leave due early; it is made exact again here */
+        w->due[slot] = UINT64_MAX;
+        while (i != BGP_WHEEL_NONE) {
+            uint32_t next = w->entries[i].next;
+            if (w->entries[i].expires <= now) {
+                bgp_wheel_unlink(w, i);
+                bgp_wheel_link(w, i, BGP_WHEEL_EXPIRED);
+            } else if (w->entries[i].expires < w->due[slot]) {
+                w->due[slot] = w->entries[i].expires;
+            }
+            i = next;
+        }
+    }
+    w->now_tick = now;
+
+    /* Callbacks may add or cancel timers, including ones still to fire here */
+    uint32_t i;
+    while ((i = w->heads[BGP_WHEEL_EXPIRED]) != BGP_WHEEL_NONE) {
+        bgp_wheel_entry_t *e = &w->entries[i];
+        bgp_wheel_cb_t cb = e->cb;
+        void *ctx = e->ctx;
+
+        bgp_wheel_unlink(w, i);
+        bgp_wheel_release(w, i);
+        cb(ctx);
+        fired++;
+    }
+
+    if (!fired) w->stats.idle++;
+    w->stats.fired += (uint64_t)fired;
+    return fired;
+}
+
+int bgp_wheel_next_ms(bgp_wheel_t *w)
+{
+    if (w->pending == 0) return -1;
+
+    uint64_t elapsed = bgp_wheel_clock_ms() - w->origin_ms;
+    uint64_t now = elapsed / w->tick_ms;
+
+    if (now > w->now_tick) return 0;
+
+    /* A slot's timers may all be turns away; the nearest tick is only a bound */
+    uint64_t next = UINT64_MAX;
+    for (uint64_t d = 1; d <= BGP_WHEEL_SLOTS && now + d < next; d++) {
+        uint64_t due = w->due[(now + d) & (BGP_WHEEL_SLOTS - 1)];
+        if (due < next) next = due;
+    }
+    if (next == UINT64_MAX) return 0;       /* All being fired */
+
+    uint64_t ms = next * w->tick_ms - elapsed;
+    return ms > INT32_MAX ? INT32_MAX : (int)ms;
+}
+
+uint32_t bgp_wheel_pending(bgp_wheel_t *w)
+{
+    return w->pending;
+}
+
+void bgp_wheel_get_stats(bgp_wheel_t *w, bgp_wheel_stats_t *stats)
+{
+    *stats = w->stats;
+    stats->uptime_ms = bgp_wheel_clock_ms() - w->origin_ms;
+}
+
+void bgp_wheel_dump(bgp_wheel_t *w)
+{
+    bgp_wheel_stats_t st;
+
+    bgp_wheel_get_stats(w, &st);
+    double secs = st.uptime_ms ? (double)st.uptime_ms / 1000.0 : 1.0;
+
+    syslog_write(LOG_INFO, "BGP wheel: %u pending, tick %u ms, slack %u ms; "
+        "%.1f wakeups/s (%.1f idle), %.1f timers per wakeup, %llu of %llu coalesced",
+        w->pending, w->tick_ms, w->slack_ms, (double)st.wakeups / secs, (double)st.idle / secs,
+        st.wakeups ? (double)st.fired / (double)st.wakeups : 0.0,
+        (unsigned long long)st.coalesced, (unsigned long long)st.added);
+}
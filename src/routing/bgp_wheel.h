@@ -0,0 +1,67 @@
+/*
+ * bgp_wheel.h - Per-Worker BGP Timer Wheel
+ *
+ * NetBlade OS v3.x Routing Engine
+ * Copyright (c) 2024-2026 Enterprise Systems Inc. All rights reserved.
+ */
+
+#ifndef BGP_WHEEL_H
+#define BGP_WHEEL_H
+
+#include <stdint.h>
+
+#define BGP_WHEEL_SLOTS         1024    /* Power of two */
+#define BGP_WHEEL_MAX_TIMERS    65536
+#define BGP_WHEEL_TICK_MS       10      /* Default resolution */
+#define BGP_WHEEL_SLACK_MS      250     /* Default coalescing window */
+#define BGP_WHEEL_KEEPALIVE_MIN 1000    /* RFC 4271: at most one KEEPALIVE per second */
+#define BGP_WHEEL_HOLD_SLACK_DIV 10     /* Hold expiry late by at most 1/10 of hold time */
+
+typedef struct bgp_wheel bgp_wheel_t;
+typedef uint32_t bgp_wheel_timer_t;     /* 0 is never a valid timer */
+
+typedef void (*bgp_wheel_cb_t)(void *ctx);
+
+typedef struct {
+    uint64_t wakeups;           /* bgp_wheel_run() calls */
+    uint64_t idle;              /* ...that fired nothing */
+    uint64_t fired;
+    uint64_t added;
+    uint64_t coalesced;         /* Deadline moved within its window to share a tick */
+    uint64_t uptime_ms;
+} bgp_wheel_stats_t;
+
+/* One wheel per worker; it is not locked */
+bgp_wheel_t *bgp_wheel_create(uint32_t tick_ms, uint32_t max_timers);
+void bgp_wheel_destroy(bgp_wheel_t *w);
+
+/* Window timers may be moved by up to this much to share a wakeup; 0 disables */
+void bgp_wheel_set_slack(bgp_wheel_t *w, uint32_t slack_ms);
+
+/*
+ * Fire cb once, delay_ms from now (rounded up to a tick) or up to the
+ * slack later, but never more than 1/8 of delay_ms late. Returns 0 on
+ * failure.
+ */
+bgp_wheel_timer_t bgp_wheel_add(bgp_wheel_t *w, uint32_t delay_ms, bgp_wheel_cb_t cb, void *ctx);
+/* Fire anywhere from min_ms to max_ms from now, wherever it best shares a tick */
+bgp_wheel_timer_t bgp_wheel_add_window(bgp_wheel_t *w, uint32_t min_ms, uint32_t max_ms,
+                                       bgp_wheel_cb_t cb, void *ctx);
+/* Send KEEPALIVE: may go early by the slack, never late, never under a second */
+bgp_wheel_timer_t bgp_wheel_add_keepalive(bgp_wheel_t *w, uint32_t interval_ms,
+                                          bgp_wheel_cb_t cb, void *ctx);
+/* Hold timer: never early; late by a tick plus the slack, capped at hold_ms / BGP_WHEEL_HOLD_SLACK_DIV */
+bgp_wheel_timer_t bgp_wheel_add_hold(bgp_wheel_t *w, uint32_t hold_ms, bgp_wheel_cb_t cb, void *ctx);
+/* Stale or already fired timers are ignored */
+void bgp_wheel_cancel(bgp_wheel_t *w, bgp_wheel_timer_t t);
+
+/* Run everything due; returns timers fired */
+int bgp_wheel_run(bgp_wheel_t *w);
+/* Poll timeout until the earliest timer is due, or -1 with no timers */
+int bgp_wheel_next_ms(bgp_wheel_t *w);
+
+uint32_t bgp_wheel_pending(bgp_wheel_t *w);
+void bgp_wheel_get_stats(bgp_wheel_t *w, bgp_wheel_stats_t *stats);
+void bgp_wheel_dump(bgp_wheel_t *w);
+
+#endif /* BGP_WHEEL_H */
@@ -0,0 +1,156 @@
+/*
+ * rt_arena.c - Node-Local Arena for Routing Table Memory
+ *
+ * NetBlade OS v3.x Routing Engine
+ * Copyright (c) 2024-2026 Enterprise Systems Inc. All rights reserved.
+ *
+ * Bump allocation from large chunks mapped on the owning worker's NUMA
+ * node, with per-size-class free lists so route churn reuses memory in
+ * place. Nothing is returned to the system until the arena is
+ * destroyed.
+ *
+ * A full table touches chunks at random on every lookup and best-path
+ * walk, and with 4 KB pages a multi-million-route RIB spans far more
+ * pages than the TLB covers. Huge page chunks cut that by a factor of
+ * 512; tools/bench/rt_arena_bench.c measures what it buys.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+#include "rt_arena.h"
+#include "nb_numa.h"
+#include "syslog.h"
+
+#define RT_ARENA_CLASSES        (RT_ARENA_MAX_OBJ / RT_ARENA_ALIGN)
+
+typedef struct rt_arena_chunk {
+    struct rt_arena_chunk *next;
+    size_t                 size;
+} rt_arena_chunk_t;
+
+typedef struct rt_arena_free_obj {
+    struct rt_arena_free_obj *next;
+} rt_arena_free_obj_t;
+
+struct rt_arena {
+    int                   node;
+    uint32_t              flags;
+    size_t                chunk_size;
+    rt_arena_chunk_t     *chunks;
+    uint8_t              *cur;
+    uint8_t              *end;
+    rt_arena_free_obj_t  *free_lists[RT_ARENA_CLASSES];
+    rt_arena_stats_t      stats;
+};
+
+static size_t rt_arena_class(size_t size)
+{
+    return (size + RT_ARENA_ALIGN - 1) / RT_ARENA_ALIGN - 1;
+}
+
+static int rt_arena_grow(rt_arena_t *a)
+{
+    size_t size = a->chunk_size;
+    uint8_t backing = NB_NUMA_PAGES_SMALL;
+    rt_arena_chunk_t *c;
+
+    if (a->flags & RT_ARENA_HUGE) {
+        c = nb_numa_alloc_huge(&size, a->node, &backing);
+    } else {
+        c = nb_numa_alloc(size, a->node);
+    }
+    if (!c) {
+        syslog_write(LOG_ERR, "RT arena: Out of memory on node %d", a->node);
+        return -1;
+    }
+
+    c->next = a->chunks;
+    c->size = size;
+    a->chunks = c;
+    a->cur = (uint8_t *)c + RT_ARENA_ALIGN;
+    a->end = (uint8_t *)c + size;
+    a->stats.chunks++;
+    a->stats.reserved += size;
+    if (backing == NB_NUMA_PAGES_HUGETLB) a->stats.chunks_hugetlb++;
+    if (backing == NB_NUMA_PAGES_THP) a->stats.chunks_thp++;
+
+    /* Say once per arena when huge pages were asked for and not delivered */
+    if ((a->flags & RT_ARENA_HUGE) && backing == NB_NUMA_PAGES_SMALL && a->stats.chunks == 1) {
+        syslog_write(LOG_WARNING, "RT arena: No huge pages on node %d, using 4k pages", a->node);
+    }
+    return 0;
+}
+
+rt_arena_t *rt_arena_create(int node, size_t chunk_size, uint32_t flags)
+{
+    if (chunk_size == 0) chunk_size = RT_ARENA_CHUNK_SIZE;
+    /* Room for the chunk header and the largest object, or alloc overruns a new chunk */
+    if (chunk_size < RT_ARENA_MIN_CHUNK) chunk_size = RT_ARENA_MIN_CHUNK;
+    if (node < 0) node = nb_numa_current_node();
+
+    /* The arena header lives with its memory */
+    rt_arena_t *a = nb_numa_alloc(sizeof(rt_arena_t), node);
+    if (!a) return NULL;
+
+    memset(a, 0, sizeof(rt_arena_t));
+    a->node = node;
+    a->flags = flags;
+    a->chunk_size = chunk_size;
+    a->stats.node = node;
+    return a;
+}
+
+void rt_arena_destroy(rt_arena_t *a)
+{
+    if (!a) return;
+
+    rt_arena_chunk_t *c = a->chunks;
+    while (c) {
+        rt_arena_chunk_t *next = c->next;
+        nb_numa_free(c, c->size);
+        c = next;
+    }
+    nb_numa_free(a, sizeof(rt_arena_t));
+}
+
+void *rt_arena_alloc(rt_arena_t *a, size_t size)
+{
+    if (size == 0 || size > RT_ARENA_MAX_OBJ) return NULL;
+
+    size_t cls = rt_arena_class(size);
+    rt_arena_free_obj_t *obj = a->free_lists[cls];
+
+    if (obj) {
+        a->free_lists[cls] = obj->next;
+    } else {
+        size_t bytes = (cls + 1) * RT_ARENA_ALIGN;
+        if ((size_t)(a->end - a->cur) < bytes && rt_arena_grow(a) != 0) return NULL;
+        obj = (rt_arena_free_obj_t *)a->cur;
+        a->cur += bytes;
+    }
+
+    a->stats.allocs++;
+    a->stats.in_use += (cls + 1) * RT_ARENA_ALIGN;
+    return obj;
+}
+
+void rt_arena_free(rt_arena_t *a, void *p, size_t size)
+{
+    if (!p || size == 0 || size > RT_ARENA_MAX_OBJ) return;
+
+    size_t cls = rt_arena_class(size);
+    rt_arena_free_obj_t *obj = p;
+
+    obj->next = a->free_lists[cls];
+    a->free_lists[cls] = obj;
+
+    a->stats.frees++;
+    a->stats.in_use -= (cls + 1) * RT_ARENA_ALIGN;
+}
+
+void rt_arena_get_stats(rt_arena_t *a, rt_arena_stats_t *stats)
+{
+    memcpy(stats, &a->stats, sizeof(rt_arena_stats_t));
+}
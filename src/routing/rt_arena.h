@@ -0,0 +1,50 @@
+/*
+ * rt_arena.h - Node-Local Arena for Routing Table Memory
+ *
+ * NetBlade OS v3.x Routing Engine
+ * Copyright (c) 2024-2026 Enterprise Systems Inc. All rights reserved.
+ */
+
+#ifndef RT_ARENA_H
+#define RT_ARENA_H
+
+#include <stdint.h>
+#include <stddef.h>
+
+#define RT_ARENA_CHUNK_SIZE     (4u << 20)
+#define RT_ARENA_ALIGN          16
+#define RT_ARENA_MAX_OBJ        512     /* Larger requests are refused */
+#define RT_ARENA_MIN_CHUNK      (RT_ARENA_ALIGN + RT_ARENA_MAX_OBJ)  /* Smaller is rounded up */
+
+/* rt_arena_create() flags */
+#define RT_ARENA_HUGE           0x1     /* Back chunks with 2 MB pages where possible */
+
+typedef struct rt_arena rt_arena_t;
+
+typedef struct {
+    int      node;
+    uint32_t chunks;
+    uint32_t chunks_hugetlb;
+    uint32_t chunks_thp;
+    uint64_t reserved;          /* Bytes mapped */
+    uint64_t in_use;            /* Bytes handed out and not freed */
+    uint64_t allocs;
+    uint64_t frees;
+} rt_arena_stats_t;
+
+/*
+ * One arena per BGP worker, owned by that worker and not locked. Chunks
+ * come from the given NUMA node; -1 takes the caller's current node.
+ * With RT_ARENA_HUGE, chunks are rounded up to 2 MB and fall back to
+ * normal pages when no huge pages are available.
+ */
+rt_arena_t *rt_arena_create(int node, size_t chunk_size, uint32_t flags);
+void rt_arena_destroy(rt_arena_t *a);
+
+/* Routes, paths and attributes; size must be passed back to rt_arena_free() */
+void *rt_arena_alloc(rt_arena_t *a, size_t size);
+void rt_arena_free(rt_arena_t *a, void *p, size_t size);
+
+void rt_arena_get_stats(rt_arena_t *a, rt_arena_stats_t *stats);
+
+#endif /* RT_ARENA_H */
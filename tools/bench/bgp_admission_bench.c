@@ -0,0 +1,148 @@
+/*
+ * bgp_admission_bench.c - BGP Admission Control Wait Bound Benchmark
+ *
+ * NetBlade OS v3.x Development Tools
+ * Copyright (c) 2024-2026 Enterprise Systems Inc. All rights reserved.
+ *
+ * One slot, a 200 ms max wait and two workers. A session takes the slot
+ * and keeps it; four more queue 40 ms apart, alternating workers. After
+ * that the engine is idle: the workers only sleep in poll() on their
+ * admission fds. Each queued session must still be let in within
+ * max_wait_ms of asking.
+ *
+ *   idle     - nothing else happens
+ *   release  - the slot is given back 20 ms in, so the first waiter is
+ *              admitted from the release path and the rest still by
+ *              their deadlines
+ *
+ *   cc -O2 -std=gnu11 -Isrc/routing -Isrc/common \
+ *      tools/bench/bgp_admission_bench.c src/routing/bgp_admission.c \
+ *      src/common/nb_mutex.c -lpthread -o bgp_admission_bench
+ *   ./bgp_admission_bench
+ */
+
+#define _GNU_SOURCE
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <stdbool.h>
+#include <time.h>
+#include <poll.h>
+#include "bgp_admission.h"
+
+#define BENCH_SHARDS    2
+#define BENCH_WAITERS   4
+#define BENCH_GAP_MS    40
+#define BENCH_WAIT_MS   200
+#define BENCH_SLACK_MS  20
+
+void syslog_write(int level, const char *fmt, ...)
+{
+    (void)level;
+    (void)fmt;
+}
+
+uint8_t bgp_shard_count(void)
+{
+    return BENCH_SHARDS;
+}
+
+void nb_boot_expect_sessions(uint32_t count)
+{
+    (void)count;
+}
+
+void nb_boot_session_established(void)
+{
+}
+
+void nb_boot_session_converged(const void *session)
+{
+    (void)session;
+}
+
+static double bench_t0;
+static double bench_queued[BENCH_WAITERS + 1];
+static double bench_admitted[BENCH_WAITERS + 1];
+
+static double now_ms(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec * 1e3 + ts.tv_nsec * 1e-6 - bench_t0;
+}
+
+static void bench_cb(bgp_adm_ticket_t ticket, void *session, void *ctx)
+{
+    (void)ticket;
+    (void)ctx;
+    bench_admitted[(intptr_t)session] = now_ms();
+}
+
+static int bench_run(const char *name, int release_ms)
+{
+    bgp_admission_config_t cfg = { .max_active = 1, .max_wait_ms = BENCH_WAIT_MS };
+    bgp_adm_ticket_t first, ticket;
+    struct pollfd pfd[BENCH_SHARDS];
+    int next = 1, admitted = 0, bad = 0;
+
+    bgp_admission_t *a = bgp_admission_create(&cfg);
+    if (!a) return -1;
+    for (int s = 0; s < BENCH_SHARDS; s++) {
+        pfd[s].fd = bgp_admission_fd(a, (uint8_t)s);
+        pfd[s].events = POLLIN;
+    }
+
+    bench_t0 = 0;
+    bench_t0 = now_ms();
+    if (bgp_admission_request(a, 0, 1, NULL, (void *)0, &first) != 1) return -1;
+
+    /* Run until everyone is in, or well past the last deadline */
+    while (admitted < BENCH_WAITERS && now_ms() < BENCH_WAITERS * BENCH_GAP_MS + 3 * BENCH_WAIT_MS) {
+        double t = now_ms();
+
+        if (next <= BENCH_WAITERS && t >= (next - 1) * BENCH_GAP_MS) {
+            bench_queued[next] = t;
+            bench_admitted[next] = -1;
+            if (bgp_admission_request(a, (uint8_t)(next % BENCH_SHARDS), 1, NULL,
+                                      (void *)(intptr_t)next, &ticket) != 0) return -1;
+            next++;
+        }
+        if (release_ms && t >= release_ms) {
+            bgp_admission_done(a, first, true);
+            release_ms = 0;
+        }
+
+        if (poll(pfd, BENCH_SHARDS, next <= BENCH_WAITERS ? 1 : 1000) <= 0) continue;
+        for (int s = 0; s < BENCH_SHARDS; s++) {
+            if (pfd[s].revents & POLLIN) admitted += bgp_admission_poll(a, (uint8_t)s, bench_cb, NULL);
+        }
+    }
+
+    printf("%s:\n", name);
+    for (int i = 1; i <= BENCH_WAITERS; i++) {
+        double waited = bench_admitted[i] - bench_queued[i];
+
+        if (bench_admitted[i] < 0) {
+            printf("  session %d (worker %d) queued at %5.1f ms, never admitted\n",
+                i, i % BENCH_SHARDS, bench_queued[i]);
+            bad = 1;
+            continue;
+        }
+        printf("  session %d (worker %d) queued at %5.1f ms, admitted after %5.1f ms\n",
+            i, i % BENCH_SHARDS, bench_queued[i], waited);
+        if (waited > BENCH_WAIT_MS + BENCH_SLACK_MS) bad = 1;
+    }
+
+    bgp_admission_destroy(a);
+    return bad ? -1 : 0;
+}
+
+int main(void)
+{
+    int bad = 0;
+
+    if (bench_run("idle", 0) != 0) bad = 1;
+    if (bench_run("release", 20) != 0) bad = 1;
+    return bad;
+}
@@ -0,0 +1,298 @@
+/*
+ * bgp_connect_bench.c - Batched Outbound Connect Benchmark
+ *
+ * NetBlade OS v3.x Development Tools
+ * Copyright (c) 2024-2026 Enterprise Systems Inc. All rights reserved.
+ *
+ * Starts connect-retry for N peers spread over 40 VRFs, each on its own
+ * loopback address, against a local listener; every tenth peer points
+ * at a closed port and is refused. Reports time, system calls per
+ * attempt and the most attempts in flight against the per-VRF cap.
+ *
+ * Two checks follow, both against a listener that drops SYNs, so the
+ * attempts stay in flight until they time out:
+ *
+ *   caps   - 40 peers with one address, ten in each of four VRFs. The
+ *            per-destination cap of 3 applies per VRF: 12 in flight.
+ *   batch  - 512 peers due at once with a batch of 16 and a poll
+ *            timeout of one second. Every attempt must be issued
+ *            without waiting out the timeout between batches.
+ *
+ * And one against a closed port:
+ *
+ *   full   - 16 refused peers retrying every 100 ms on a wheel with room
+ *            for 4 timers. Every peer must keep retrying.
+ *
+ *   cc -O2 -std=gnu11 -Isrc/routing -Isrc/common [-DHAVE_LIBURING] \
+ *      tools/bench/bgp_connect_bench.c src/routing/bgp_connect.c \
+ *      src/routing/bgp_wheel.c src/routing/bgp_io.c src/common/nb_numa.c \
+ *      -lpthread [-luring] -o bgp_connect_bench
+ *   ./bgp_connect_bench [backend] [peers]      (default 0 4000; 1: io_uring, experimental)
+ */
+
+#define _GNU_SOURCE
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <string.h>
+#include <unistd.h>
+#include <time.h>
+#include <sys/socket.h>
+#include <sys/resource.h>
+#include <netinet/in.h>
+#include <arpa/inet.h>
+#include "bgp_connect.h"
+
+#define BENCH_VRFS      40
+#define BENCH_FULL_PEERS 16
+#define BENCH_FULL_TRIES 3
+
+void syslog_write(int level, const char *fmt, ...)
+{
+    (void)level;
+    (void)fmt;
+}
+
+static int bench_ok, bench_failed;
+
+static double now_ms(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec * 1e3 + ts.tv_nsec * 1e-6;
+}
+
+static void bench_cb(void *peer_ctx, int fd, int err)
+{
+    (void)peer_ctx;
+    (void)err;
+    if (fd >= 0) {
+        close(fd);
+        bench_ok++;
+    } else {
+        bench_failed++;
+    }
+}
+
+static int bench_listen(struct sockaddr_in *sa, int backlog)
+{
+    socklen_t sl = sizeof(*sa);
+    int on = 1;
+    int fd = socket(AF_INET, SOCK_STREAM | SOCK_NONBLOCK, 0);
+
+    memset(sa, 0, sizeof(*sa));
+    sa->sin_family = AF_INET;
+    setsockopt(fd, SOL_SOCKET, SO_REUSEADDR, &on, sizeof(on));
+    if (fd < 0 || bind(fd, (struct sockaddr *)sa, sl) != 0 || listen(fd, backlog) != 0) return -1;
+    getsockname(fd, (struct sockaddr *)sa, &sl);
+    return fd;
+}
+
+/* 127.0.x.y, a different loopback address per peer */
+static void bench_addr(struct sockaddr_in *a, int i, in_port_t port)
+{
+    memset(a, 0, sizeof(*a));
+    a->sin_family = AF_INET;
+    a->sin_port = port;
+    a->sin_addr.s_addr = htonl(0x7f000000U | ((uint32_t)(i / 250) << 8) | (uint32_t)(1 + i % 250));
+}
+
+static int bench_storm(uint8_t backend, int peers)
+{
+    struct sockaddr_in sa, closed;
+    bgp_connect_config_t cfg = { .batch = 512, .per_vrf = 32, .per_dest = 4 };
+    bgp_connect_stats_t st;
+    bgp_connect_peer_t id;
+    uint32_t max_in_flight = 0;
+
+    int ls = bench_listen(&sa, 8192);
+    int cs = bench_listen(&closed, 1);
+    if (ls < 0 || cs < 0) return -1;
+    close(cs);
+
+    bgp_wheel_t *w = bgp_wheel_create(BGP_WHEEL_TICK_MS, 65000);
+    bgp_connect_t *c = bgp_connect_create(backend, w, &cfg, bench_cb);
+    if (!w || !c) return -1;
+
+    srand(1);
+    for (int i = 0; i < peers; i++) {
+        struct sockaddr_in a;
+        bench_addr(&a, i, i % 10 == 9 ? closed.sin_port : sa.sin_port);
+        if (bgp_connect_add(c, (uint32_t)(i % BENCH_VRFS), 0, (struct sockaddr *)&a, sizeof(a),
+                            NULL, 0, 120000, NULL, &id) != 0) return -1;
+        bgp_connect_start(c, id, (uint32_t)(rand() % 500));
+    }
+
+    double t = now_ms();
+    bench_ok = bench_failed = 0;
+    while (bench_ok + bench_failed < peers) {
+        int fd;
+
+        bgp_wheel_run(w);
+        bgp_connect_poll(c, 5);
+        bgp_connect_get_stats(c, &st);
+        if (st.in_flight > max_in_flight) max_in_flight = st.in_flight;
+        while ((fd = accept(ls, NULL, NULL)) >= 0) close(fd);
+    }
+    t = now_ms() - t;
+
+    bgp_connect_get_stats(c, &st);
+    printf("%-8s storm: %d peers in %.0f ms, %d connected, %d refused, "
+        "%.2f syscalls/attempt, max %u in flight (cap %u)\n",
+        bgp_io_backend_name(backend), peers, t, bench_ok, bench_failed,
+        (double)st.syscalls / (double)st.attempts, max_in_flight, BENCH_VRFS * cfg.per_vrf);
+
+    bgp_connect_destroy(c);
+    bgp_wheel_destroy(w);
+    close(ls);
+    return 0;
+}
+
+static int bench_caps(uint8_t backend)
+{
+    struct sockaddr_in sa;
+    bgp_connect_config_t cfg = { .per_vrf = 100, .per_dest = 3, .timeout_ms = 300 };
+    bgp_connect_stats_t st;
+    bgp_connect_peer_t id;
+    uint32_t max_in_flight = 0;
+
+    int ls = bench_listen(&sa, 0);
+    if (ls < 0) return -1;
+    sa.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+
+    bgp_wheel_t *w = bgp_wheel_create(BGP_WHEEL_TICK_MS, 1000);
+    bgp_connect_t *c = bgp_connect_create(backend, w, &cfg, bench_cb);
+    if (!w || !c) return -1;
+
+    for (int i = 0; i < 40; i++) {
+        if (bgp_connect_add(c, (uint32_t)(i % 4), 0, (struct sockaddr *)&sa, sizeof(sa),
+                            NULL, 0, 60000, NULL, &id) != 0) return -1;
+        bgp_connect_start(c, id, 0);
+    }
+
+    bench_ok = bench_failed = 0;
+    while (bench_ok + bench_failed < 40) {
+        bgp_wheel_run(w);
+        bgp_connect_poll(c, 10);
+        bgp_connect_get_stats(c, &st);
+        if (st.in_flight > max_in_flight) max_in_flight = st.in_flight;
+    }
+
+    bgp_connect_get_stats(c, &st);
+    printf("%-8s caps: max %u in flight (want 12), %llu deferred by the peer cap\n",
+        bgp_io_backend_name(backend), max_in_flight, (unsigned long long)st.deferred_dest);
+
+    bgp_connect_destroy(c);
+    bgp_wheel_destroy(w);
+    close(ls);
+    return max_in_flight == 12 ? 0 : -1;
+}
+
+static int bench_batch(uint8_t backend)
+{
+    struct sockaddr_in sa;
+    bgp_connect_config_t cfg = { .batch = 16, .per_vrf = 1024, .timeout_ms = 5000 };
+    bgp_connect_stats_t st;
+    bgp_connect_peer_t id;
+    int polls = 0;
+
+    int ls = bench_listen(&sa, 0);
+    if (ls < 0) return -1;
+
+    bgp_wheel_t *w = bgp_wheel_create(BGP_WHEEL_TICK_MS, 1000);
+    bgp_connect_t *c = bgp_connect_create(backend, w, &cfg, bench_cb);
+    if (!w || !c) return -1;
+
+    for (int i = 0; i < 512; i++) {
+        struct sockaddr_in a;
+        bench_addr(&a, i, sa.sin_port);
+        if (bgp_connect_add(c, 1, 0, (struct sockaddr *)&a, sizeof(a),
+                            NULL, 0, 60000, NULL, &id) != 0) return -1;
+        bgp_connect_start(c, id, 0);
+    }
+
+    /* The poll issuing the last batch waits for completions; the ones before it must not */
+    double t0 = now_ms(), t;
+    do {
+        t = now_ms() - t0;
+        bgp_connect_poll(c, 1000);
+        bgp_connect_get_stats(c, &st);
+        polls++;
+    } while (st.attempts < 512);
+
+    printf("%-8s batch: 512 attempts in %d polls, last batch issued after %.1f ms\n",
+        bgp_io_backend_name(backend), polls, t);
+
+    bgp_connect_destroy(c);
+    bgp_wheel_destroy(w);
+    close(ls);
+    return t < 1000 ? 0 : -1;
+}
+
+static int full_tries[BENCH_FULL_PEERS];
+
+static void bench_full_cb(void *peer_ctx, int fd, int err)
+{
+    (void)err;
+    if (fd >= 0) close(fd);
+    full_tries[(intptr_t)peer_ctx]++;
+}
+
+static int bench_full(uint8_t backend)
+{
+    struct sockaddr_in sa;
+    bgp_connect_stats_t st;
+    bgp_connect_peer_t id;
+    int least = 0;
+
+    int cs = bench_listen(&sa, 1);
+    if (cs < 0) return -1;
+    close(cs);
+
+    bgp_wheel_t *w = bgp_wheel_create(BGP_WHEEL_TICK_MS, 4);
+    bgp_connect_t *c = bgp_connect_create(backend, w, NULL, bench_full_cb);
+    if (!w || !c) return -1;
+
+    for (intptr_t i = 0; i < BENCH_FULL_PEERS; i++) {
+        struct sockaddr_in a;
+        bench_addr(&a, (int)i, sa.sin_port);
+        if (bgp_connect_add(c, 1, 0, (struct sockaddr *)&a, sizeof(a),
+                            NULL, 0, 100, (void *)i, &id) != 0) return -1;
+        bgp_connect_start(c, id, 0);
+    }
+
+    double t0 = now_ms();
+    while (least < BENCH_FULL_TRIES && now_ms() - t0 < 5000) {
+        bgp_wheel_run(w);
+        bgp_connect_poll(c, 10);
+        least = full_tries[0];
+        for (int i = 1; i < BENCH_FULL_PEERS; i++) {
+            if (full_tries[i] < least) least = full_tries[i];
+        }
+    }
+
+    bgp_connect_get_stats(c, &st);
+    printf("%-8s full: fewest attempts per peer %d (want %d) after %.0f ms, "
+        "%llu timers re-added\n", bgp_io_backend_name(backend), least, BENCH_FULL_TRIES,
+        now_ms() - t0, (unsigned long long)st.timer_failed);
+
+    bgp_connect_destroy(c);
+    bgp_wheel_destroy(w);
+    return least >= BENCH_FULL_TRIES ? 0 : -1;
+}
+
+int main(int argc, char **argv)
+{
+    uint8_t backend = argc > 1 ? (uint8_t)atoi(argv[1]) : BGP_IO_BACKEND_EPOLL;
+    int peers = argc > 2 ? atoi(argv[2]) : 4000;
+    struct rlimit rl = { 65536, 65536 };
+
+    if (peers < 1 || peers > 60000) return 1;
+    setrlimit(RLIMIT_NOFILE, &rl);
+
+    if (bench_storm(backend, peers) != 0) return 1;
+    if (bench_caps(backend) != 0) return 1;
+    if (bench_batch(backend) != 0) return 1;
+    if (bench_full(backend) != 0) return 1;
+    return 0;
+}
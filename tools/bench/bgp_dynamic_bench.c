@@ -0,0 +1,126 @@
+/*
+ * bgp_dynamic_bench.c - Dynamic BGP Neighbor Benchmark
+ *
+ * NetBlade OS v3.x Development Tools
+ * Copyright (c) 2024-2026 Enterprise Systems Inc. All rights reserved.
+ *
+ * Gives each of 40 VRFs a 10.0.0.0/8 listen range and fills the pool
+ * with peers from 10.2.0.0/16, each taken through OPEN. Reports the
+ * memory allocated for the pool and index and the instantiation time
+ * kept by the engine.
+ *
+ * Then checks each rejection against the full pool, plus longest-prefix
+ * match and the range peer limit once slots are released. The VRF
+ * timer table is stubbed with a 90 s hold time and 30 s keepalive.
+ *
+ *   cc -O2 -std=gnu11 -Isrc/routing -Isrc/common \
+ *      tools/bench/bgp_dynamic_bench.c src/routing/bgp_dynamic.c \
+ *      src/common/nb_mutex.c -lpthread -o bgp_dynamic_bench
+ *   ./bgp_dynamic_bench [peers]                 (default 10240)
+ */
+
+#define _GNU_SOURCE
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <string.h>
+#include <netinet/in.h>
+#include <arpa/inet.h>
+#include "bgp_dynamic.h"
+
+#define BENCH_VRFS      40
+
+void syslog_write(int level, const char *fmt, ...)
+{
+    (void)level;
+    (void)fmt;
+}
+
+uint32_t bgp_timers_get_hold_time(uint32_t vrf_id, uint32_t remote_hold_time)
+{
+    (void)vrf_id;
+    return remote_hold_time < 90 ? remote_hold_time : 90;
+}
+
+uint32_t bgp_timers_get_keepalive(uint32_t vrf_id)
+{
+    (void)vrf_id;
+    return 30;
+}
+
+static struct sockaddr *bench_addr(struct sockaddr_in *a, uint32_t ip)
+{
+    memset(a, 0, sizeof(*a));
+    a->sin_family = AF_INET;
+    a->sin_addr.s_addr = htonl(ip);
+    return (struct sockaddr *)a;
+}
+
+static int bench_check(const char *what, int got, int want)
+{
+    printf("  %-26s %3d (want %d)\n", what, got, want);
+    return got == want ? 0 : -1;
+}
+
+int main(int argc, char **argv)
+{
+    uint32_t peers = argc > 1 ? (uint32_t)atoi(argv[1]) : BGP_DYN_DEFAULT_PEERS;
+    struct sockaddr_in a;
+    bgp_dynamic_stats_t st;
+    bgp_dyn_peer_info_t info;
+    bgp_dyn_peer_t p;
+    int bad = 0;
+
+    if (peers < BENCH_VRFS || peers > BGP_DYN_MAX_PEERS) return 1;
+
+    bgp_dynamic_t *d = bgp_dynamic_create(peers);
+    if (!d) return 1;
+
+    for (uint32_t v = 0; v < BENCH_VRFS; v++) {
+        if (bgp_dynamic_add_range(d, v, bench_addr(&a, 0x0a000000), 8, 65001, 0) < 0) return 1;
+    }
+    int tight = bgp_dynamic_add_range(d, 0, bench_addr(&a, 0x0a010000), 16, 0, 1);
+    if (tight < 0) return 1;
+
+    for (uint32_t i = 0; i < peers; i++) {
+        if (bgp_dynamic_accept(d, i % BENCH_VRFS, bench_addr(&a, 0x0a020000 + i), NULL, &p) != BGP_DYN_OK ||
+            bgp_dynamic_open(d, p, 65001, 180) != 0) return 1;
+    }
+
+    bgp_dynamic_get_stats(d, &st);
+    printf("%u peers in %d VRFs: %zu KB, %.0f bytes per peer; instantiate avg %.2f us max %.2f us\n",
+        st.peers, BENCH_VRFS, st.memory / 1024, (double)st.memory / st.capacity,
+        (double)st.accept_ns_total / (double)st.accepted / 1e3, (double)st.accept_ns_max / 1e3);
+
+    p = bgp_dynamic_find(d, 5, bench_addr(&a, 0x0a020005));
+    if (!p || bgp_dynamic_get(d, p, &info) != 0) return 1;
+    printf("  negotiated hold %u keepalive %u\n", info.hold_time, info.keepalive);
+
+    bad |= bench_check("outside every range", bgp_dynamic_accept(d, 0,
+        bench_addr(&a, 0x0b000001), NULL, &p), BGP_DYN_NO_RANGE);
+    bad |= bench_check("pool full", bgp_dynamic_accept(d, 0,
+        bench_addr(&a, 0x0a030001), NULL, &p), BGP_DYN_POOL_FULL);
+    bad |= bench_check("already a peer", bgp_dynamic_accept(d, 5,
+        bench_addr(&a, 0x0a020005), NULL, &p), BGP_DYN_EXISTS);
+
+    /* Free two slots: the /16 takes one peer, then its limit applies */
+    bgp_dynamic_release(d, bgp_dynamic_find(d, 0, bench_addr(&a, 0x0a020000)));
+    bgp_dynamic_release(d, bgp_dynamic_find(d, 1, bench_addr(&a, 0x0a020001)));
+    bad |= bench_check("longest prefix", bgp_dynamic_accept(d, 0,
+        bench_addr(&a, 0x0a010001), NULL, &p), BGP_DYN_OK);
+    bgp_dynamic_get(d, p, &info);
+    bad |= bench_check("  ...matched range", info.range, tight);
+    bad |= bench_check("range full", bgp_dynamic_accept(d, 0,
+        bench_addr(&a, 0x0a010002), NULL, &p), BGP_DYN_RANGE_FULL);
+    bad |= bench_check("bad AS", bgp_dynamic_accept(d, 1,
+        bench_addr(&a, 0x0a020001), NULL, &p), BGP_DYN_OK);
+    bad |= bench_check("  ...OPEN", bgp_dynamic_open(d, p, 65002, 180), -1);
+
+    bgp_dynamic_get_stats(d, &st);
+    printf("  rejected %llu no range, %llu full, %llu bad AS\n",
+        (unsigned long long)st.rejected_range, (unsigned long long)st.rejected_limit,
+        (unsigned long long)st.rejected_as);
+
+    bgp_dynamic_destroy(d);
+    return bad ? 1 : 0;
+}
@@ -0,0 +1,320 @@
+/*
+ * bgp_io_bench.c - BGP Session I/O Engine Benchmark
+ *
+ * NetBlade OS v3.x Development Tools
+ * Copyright (c) 2024-2026 Enterprise Systems Inc. All rights reserved.
+ *
+ * Opens N loopback TCP sessions and hands the server ends to the
+ * engine. A driver thread plays the peers: first it pushes a table of
+ * PER bytes into every session, then it drains a table of the same
+ * size that the engine sends back in 4 KB messages. Reports throughput,
+ * engine CPU time and system calls per MB each way.
+ *
+ * Before that, a churn check removes every session from inside its
+ * receive callback while more data is waiting to be read. Half of them
+ * are replaced at once by a new socket, which takes over the freed
+ * slot. No closed callback may fire for a removed session, and every
+ * replacement must still receive and send.
+ *
+ *   cc -O2 -std=gnu11 -Isrc/routing -Isrc/common [-DHAVE_LIBURING] \
+ *      tools/bench/bgp_io_bench.c src/routing/bgp_io.c src/common/nb_numa.c \
+ *      -lpthread [-luring] -o bgp_io_bench
+ *   ./bgp_io_bench [backend] [sessions] [MB]     (default 0 2000 4; 1: io_uring, experimental)
+ */
+
+#define _GNU_SOURCE
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <stdbool.h>
+#include <stdatomic.h>
+#include <string.h>
+#include <unistd.h>
+#include <fcntl.h>
+#include <time.h>
+#include <errno.h>
+#include <pthread.h>
+#include <sys/socket.h>
+#include <sys/epoll.h>
+#include <sys/resource.h>
+#include <netinet/in.h>
+#include <arpa/inet.h>
+#include "bgp_io.h"
+
+void syslog_write(int level, const char *fmt, ...)
+{
+    (void)level;
+    (void)fmt;
+}
+
+static int bench_sessions = 2000;
+static size_t bench_per = 4u << 20;
+static int *cli, *srv;
+static bgp_io_conn_t *conns;
+static uint64_t rx_total;
+static _Atomic uint64_t drv_rx;
+static uint32_t closed_calls;
+
+static double now_s(clockid_t clk)
+{
+    struct timespec ts;
+    clock_gettime(clk, &ts);
+    return ts.tv_sec + ts.tv_nsec * 1e-9;
+}
+
+static void bench_rx(void *ctx, const uint8_t *data, size_t len)
+{
+    (void)ctx;
+    (void)data;
+    rx_total += len;
+}
+
+static void bench_closed(void *ctx, int err)
+{
+    (void)ctx;
+    (void)err;
+    closed_calls++;
+}
+
+static int bench_pair(int ls, const struct sockaddr_in *sa, int *c, int *s)
+{
+    *c = socket(AF_INET, SOCK_STREAM, 0);
+    if (*c < 0 || connect(*c, (const struct sockaddr *)sa, sizeof(*sa)) != 0) return -1;
+    *s = accept4(ls, NULL, NULL, SOCK_NONBLOCK);
+    if (*s < 0) return -1;
+    fcntl(*c, F_SETFL, O_NONBLOCK);
+    return 0;
+}
+
+/* Churn check: the receive callback removes its session and reuses the slot */
+typedef struct {
+    bgp_io_t       *io;
+    int             ls;
+    struct sockaddr_in sa;
+    int             index;
+} churn_ctx_t;
+
+static churn_ctx_t *churn;
+static int churn_removed;
+
+static void churn_rx(void *ctx, const uint8_t *data, size_t len)
+{
+    churn_ctx_t *c = ctx;
+    int fc, fs;
+
+    (void)data;
+    rx_total += len;
+    if (!c) return;
+
+    bgp_io_remove(c->io, conns[c->index]);
+    close(cli[c->index]);
+    churn_removed++;
+    if (c->index % 2) return;
+    if (bench_pair(c->ls, &c->sa, &fc, &fs) != 0 ||
+        bgp_io_add(c->io, fs, NULL, &conns[c->index]) != 0) {
+        return;
+    }
+    cli[c->index] = fc;
+}
+
+static int bench_churn(uint8_t backend, int ls, const struct sockaddr_in *sa, int n)
+{
+    static const char ping[64];
+    static const char burst[BGP_IO_RX_BUF_SIZE * 2];
+    char buf[256];
+    bgp_io_t *io = bgp_io_create(backend, (uint32_t)n, churn_rx, bench_closed);
+
+    if (!io) return -1;
+    churn = calloc((size_t)n, sizeof(*churn));
+    for (int i = 0; i < n; i++) {
+        churn[i] = (churn_ctx_t){ io, ls, *sa, i };
+        if (bench_pair(ls, sa, &cli[i], &srv[i]) != 0 ||
+            bgp_io_add(io, srv[i], &churn[i], &conns[i]) != 0) return -1;
+        /* More than one read's worth, so the engine reads on after the callback */
+        send(cli[i], burst, sizeof(burst), 0);
+    }
+
+    closed_calls = 0;
+    churn_removed = 0;
+    for (int k = 0; k < 100 && churn_removed < n; k++) bgp_io_poll(io, 10);
+
+    /* Replacements (ctx NULL) must receive and send like any other session */
+    int replaced = n / 2;
+    rx_total = 0;
+    for (int i = 0; i < n; i += 2) {
+        send(cli[i], ping, sizeof(ping), 0);
+        bgp_io_send(io, conns[i], ping, sizeof(ping));
+    }
+    for (int k = 0; k < 100 && rx_total < (uint64_t)replaced * sizeof(ping); k++) {
+        bgp_io_poll(io, 10);
+    }
+
+    int echoed = 0;
+    for (int i = 0; i < n; i += 2) {
+        if (recv(cli[i], buf, sizeof(buf), 0) == (ssize_t)sizeof(ping)) echoed++;
+    }
+
+    printf("%-8s churn: %d/%d removed in callback, %u closed callbacks, "
+        "%llu/%d bytes in, %d/%d replacements echoed\n",
+        bgp_io_backend_name(bgp_io_backend(io)), churn_removed, n, closed_calls,
+        (unsigned long long)rx_total, replaced * (int)sizeof(ping), echoed, replaced);
+
+    int ok = churn_removed == n && closed_calls == 0 &&
+             rx_total == (uint64_t)replaced * sizeof(ping) && echoed == replaced;
+    for (int i = 0; i < n; i += 2) {
+        bgp_io_remove(io, conns[i]);
+        close(cli[i]);
+    }
+    for (int k = 0; k < 5; k++) bgp_io_poll(io, 0);
+    bgp_io_destroy(io);
+    free(churn);
+    return ok ? 0 : -1;
+}
+
+/* Peers push a table */
+static void *drv_send(void *arg)
+{
+    static char msg[4096];
+    size_t *left = calloc((size_t)bench_sessions, sizeof(size_t));
+    struct epoll_event ev[256];
+    int ep = epoll_create1(0);
+    int live = bench_sessions;
+
+    (void)arg;
+    for (int i = 0; i < bench_sessions; i++) {
+        struct epoll_event e = { .events = EPOLLOUT, .data.u32 = (uint32_t)i };
+        left[i] = bench_per;
+        epoll_ctl(ep, EPOLL_CTL_ADD, cli[i], &e);
+    }
+    while (live) {
+        int n = epoll_wait(ep, ev, 256, 100);
+        for (int k = 0; k < n; k++) {
+            int i = (int)ev[k].data.u32;
+            while (left[i]) {
+                ssize_t w = send(cli[i], msg, left[i] < sizeof(msg) ? left[i] : sizeof(msg),
+                    MSG_DONTWAIT);
+                if (w <= 0) break;
+                left[i] -= (size_t)w;
+            }
+            if (!left[i]) {
+                epoll_ctl(ep, EPOLL_CTL_DEL, cli[i], NULL);
+                live--;
+            }
+        }
+    }
+    close(ep);
+    free(left);
+    return NULL;
+}
+
+/* Peers receive a table */
+static void *drv_recv(void *arg)
+{
+    static char buf[65536];
+    struct epoll_event ev[256];
+    int ep = epoll_create1(0);
+
+    (void)arg;
+    for (int i = 0; i < bench_sessions; i++) {
+        struct epoll_event e = { .events = EPOLLIN, .data.u32 = (uint32_t)i };
+        epoll_ctl(ep, EPOLL_CTL_ADD, cli[i], &e);
+    }
+    while (drv_rx < (uint64_t)bench_sessions * bench_per) {
+        int n = epoll_wait(ep, ev, 256, 100);
+        for (int k = 0; k < n; k++) {
+            ssize_t r;
+            while ((r = recv(cli[ev[k].data.u32], buf, sizeof(buf), MSG_DONTWAIT)) > 0) {
+                drv_rx += (uint64_t)r;
+            }
+        }
+    }
+    close(ep);
+    return NULL;
+}
+
+int main(int argc, char **argv)
+{
+    uint8_t backend = argc > 1 ? (uint8_t)atoi(argv[1]) : BGP_IO_BACKEND_EPOLL;
+    struct rlimit rl = { 65536, 65536 };
+    struct sockaddr_in sa = { .sin_family = AF_INET, .sin_addr.s_addr = htonl(INADDR_LOOPBACK) };
+    socklen_t sl = sizeof(sa);
+    bgp_io_stats_t st0, st1;
+    pthread_t th;
+
+    if (argc > 2) bench_sessions = atoi(argv[2]);
+    if (argc > 3) bench_per = (size_t)atoi(argv[3]) << 20;
+    setrlimit(RLIMIT_NOFILE, &rl);
+
+    int ls = socket(AF_INET, SOCK_STREAM, 0);
+    if (ls < 0 || bind(ls, (struct sockaddr *)&sa, sl) != 0 || listen(ls, 4096) != 0) return 1;
+    getsockname(ls, (struct sockaddr *)&sa, &sl);
+
+    cli = calloc((size_t)bench_sessions, sizeof(int));
+    srv = calloc((size_t)bench_sessions, sizeof(int));
+    conns = calloc((size_t)bench_sessions, sizeof(bgp_io_conn_t));
+
+    int n = bench_sessions < 256 ? bench_sessions : 256;
+    if (bench_churn(backend, ls, &sa, n) != 0) return 1;
+
+    for (int i = 0; i < bench_sessions; i++) {
+        if (bench_pair(ls, &sa, &cli[i], &srv[i]) != 0) return 1;
+    }
+    bgp_io_t *io = bgp_io_create(backend, (uint32_t)bench_sessions, bench_rx, bench_closed);
+    if (!io) return 1;
+    for (int i = 0; i < bench_sessions; i++) {
+        if (bgp_io_add(io, srv[i], NULL, &conns[i]) != 0) return 1;
+    }
+
+    double mb = (double)bench_sessions * (double)bench_per / 1e6;
+
+    rx_total = 0;
+    bgp_io_get_stats(io, &st0);
+    pthread_create(&th, NULL, drv_send, NULL);
+    double t = now_s(CLOCK_MONOTONIC), c = now_s(CLOCK_THREAD_CPUTIME_ID);
+    while (rx_total < (uint64_t)bench_sessions * bench_per) bgp_io_poll(io, 10);
+    double tw = now_s(CLOCK_MONOTONIC) - t, tc = now_s(CLOCK_THREAD_CPUTIME_ID) - c;
+    pthread_join(th, NULL);
+    bgp_io_get_stats(io, &st1);
+    printf("%-8s %d sessions inbound:  %.0f MB/s, engine cpu %.3f s, %.2f syscalls/MB\n",
+        bgp_io_backend_name(bgp_io_backend(io)), bench_sessions, mb / tw, tc,
+        (double)(st1.syscalls - st0.syscalls) / mb);
+
+    /* UPDATE stream of 4 KB messages */
+    static char msg[4096];
+    size_t *left = calloc((size_t)bench_sessions, sizeof(size_t));
+    int live = bench_sessions;
+
+    for (int i = 0; i < bench_sessions; i++) left[i] = bench_per;
+    bgp_io_get_stats(io, &st0);
+    pthread_create(&th, NULL, drv_recv, NULL);
+    t = now_s(CLOCK_MONOTONIC);
+    c = now_s(CLOCK_THREAD_CPUTIME_ID);
+    while (live) {
+        for (int i = 0; i < bench_sessions; i++) {
+            while (left[i]) {
+                size_t m = left[i] < sizeof(msg) ? left[i] : sizeof(msg);
+                if (bgp_io_send(io, conns[i], msg, m) != 0) break;
+                left[i] -= m;
+                if (!left[i]) live--;
+            }
+        }
+        bgp_io_poll(io, 1);
+    }
+    while (drv_rx < (uint64_t)bench_sessions * bench_per) bgp_io_poll(io, 1);
+    tw = now_s(CLOCK_MONOTONIC) - t;
+    tc = now_s(CLOCK_THREAD_CPUTIME_ID) - c;
+    pthread_join(th, NULL);
+    bgp_io_get_stats(io, &st1);
+    printf("%-8s %d sessions outbound: %.0f MB/s, engine cpu %.3f s, %.2f syscalls/MB\n",
+        bgp_io_backend_name(bgp_io_backend(io)), bench_sessions, mb / tw, tc,
+        (double)(st1.syscalls - st0.syscalls) / mb);
+
+    for (int i = 0; i < bench_sessions; i++) {
+        bgp_io_remove(io, conns[i]);
+        close(cli[i]);
+    }
+    for (int k = 0; k < 5; k++) bgp_io_poll(io, 0);
+    bgp_io_destroy(io);
+    free(left);
+    return 0;
+}
@@ -0,0 +1,214 @@
+/*
+ * bgp_rt_index_bench.c - Route-Target Import Index Benchmark
+ *
+ * NetBlade OS v3.x Development Tools
+ * Copyright (c) 2024-2026 Enterprise Systems Inc. All rights reserved.
+ *
+ * Configures 4096 VRFs, each importing its own route-target and that of
+ * a 16-VRF hub, with every 64th VRF also importing a shared-services
+ * route-target. Then imports 1M VPN routes, most carrying one
+ * route-target and every tenth also its hub's, and compares the cost
+ * with scanning every VRF's import list, which was how routes were
+ * imported before the index. Both give the same VRFs on a sample.
+ *
+ * Checks that follow:
+ *
+ *   reconfig - moving a VRF off its hub and deleting another leave the
+ *              expected VRF counts behind
+ *   repeats  - a list naming a route-target twice, then an empty list,
+ *              leave the index as it was
+ *   swap     - a reader importing a route that carries A and B never
+ *              misses a VRF that keeps switching between importing
+ *              A only and B only
+ *   range    - a vrf_id of BGP_RT_MAX_VRFS is refused
+ *
+ *   cc -O2 -std=gnu11 -Isrc/routing -Isrc/common \
+ *      tools/bench/bgp_rt_index_bench.c src/routing/bgp_rt_index.c \
+ *      src/common/nb_mutex.c -lpthread -o bgp_rt_index_bench
+ *   ./bgp_rt_index_bench [routes]               (default 1000000)
+ */
+
+#define _GNU_SOURCE
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <stdbool.h>
+#include <stdatomic.h>
+#include <time.h>
+#include <pthread.h>
+#include "bgp_rt_index.h"
+
+#define BENCH_VRFS      BGP_RT_MAX_VRFS
+#define BENCH_SAMPLE    20000
+#define BENCH_SWAPS     200000
+
+void syslog_write(int level, const char *fmt, ...)
+{
+    (void)level;
+    (void)fmt;
+}
+
+static uint64_t imports[BENCH_VRFS][3];
+static uint16_t nimports[BENCH_VRFS];
+static uint64_t (*routes)[2];
+static uint16_t *nroute;
+static uint64_t hits;
+
+static bgp_rt_index_t *swap_idx;
+static _Atomic bool swap_done;
+static uint64_t swap_missed, swap_reads;
+
+static double now_s(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec + ts.tv_nsec * 1e-9;
+}
+
+static uint64_t bench_rand(void)
+{
+    static uint64_t x = 88172645463325252ULL;
+
+    x ^= x << 13;
+    x ^= x >> 7;
+    x ^= x << 17;
+    return x;
+}
+
+static void bench_hit(uint32_t vrf_id, void *ctx)
+{
+    (void)vrf_id;
+    (void)ctx;
+    hits++;
+}
+
+static void *bench_swap_reader(void *arg)
+{
+    static const uint64_t rts[2] = { BGP_RT_AS2(64512, 1), BGP_RT_AS2(64512, 2) };
+    bgp_rt_vrfset_t set;
+
+    (void)arg;
+    while (!atomic_load_explicit(&swap_done, memory_order_relaxed)) {
+        if (bgp_rt_index_match(swap_idx, rts, 2, &set) == 0) swap_missed++;
+        swap_reads++;
+    }
+    return NULL;
+}
+
+static int bench_check(const char *what, uint32_t got, uint32_t want)
+{
+    printf("  %-34s %u (want %u)\n", what, got, want);
+    return got == want ? 0 : -1;
+}
+
+int main(int argc, char **argv)
+{
+    int nroutes = argc > 1 ? atoi(argv[1]) : 1000000;
+    bgp_rt_index_stats_t st, st0;
+    bgp_rt_vrfset_t set;
+    uint64_t q;
+    int bad = 0;
+
+    if (nroutes < BENCH_SAMPLE) return 1;
+
+    bgp_rt_index_t *idx = bgp_rt_index_create(0);
+    routes = calloc((size_t)nroutes, sizeof(*routes));
+    nroute = calloc((size_t)nroutes, sizeof(*nroute));
+    if (!idx || !routes || !nroute) return 1;
+
+    double t = now_s();
+    for (uint32_t v = 0; v < BENCH_VRFS; v++) {
+        imports[v][0] = BGP_RT_AS2(65000, v);
+        imports[v][1] = BGP_RT_AS2(65001, v / 16);
+        nimports[v] = 2;
+        if (v % 64 == 0) imports[v][nimports[v]++] = BGP_RT_AS2(65002, 1);
+        if (bgp_rt_index_set_imports(idx, v, imports[v], nimports[v]) != 0) return 1;
+    }
+    printf("configure %d VRFs: %.2f ms\n", BENCH_VRFS, (now_s() - t) * 1e3);
+
+    for (int r = 0; r < nroutes; r++) {
+        uint32_t v = (uint32_t)(bench_rand() % BENCH_VRFS);
+
+        routes[r][0] = BGP_RT_AS2(65000, v);
+        nroute[r] = 1;
+        if (r % 10 == 0) {
+            routes[r][1] = BGP_RT_AS2(65001, v / 16);
+            nroute[r] = 2;
+        }
+        if (r % 1000 == 1) routes[r][0] = BGP_RT_AS2(65002, 1);
+        if (r % 97 == 3) routes[r][0] = BGP_RT_AS2(64999, 1);     /* Imported nowhere */
+    }
+
+    hits = 0;
+    t = now_s();
+    for (int r = 0; r < nroutes; r++) bgp_rt_index_import(idx, routes[r], nroute[r], bench_hit, NULL);
+    double ti = (now_s() - t) / nroutes;
+    printf("index: %d routes -> %llu imports, %.1f ms, %.0f ns/route\n", nroutes,
+        (unsigned long long)hits, ti * nroutes * 1e3, ti * 1e9);
+
+    /* Every VRF's import list against every route-target on the route */
+    hits = 0;
+    t = now_s();
+    for (int r = 0; r < BENCH_SAMPLE; r++) {
+        for (uint32_t v = 0; v < BENCH_VRFS; v++) {
+            bool hit = false;
+            for (uint16_t i = 0; i < nimports[v] && !hit; i++) {
+                for (uint16_t j = 0; j < nroute[r]; j++) {
+                    if (imports[v][i] == routes[r][j]) hit = true;
+                }
+            }
+            if (hit) hits++;
+        }
+    }
+    double ts = (now_s() - t) / BENCH_SAMPLE;
+    uint64_t scanned = hits;
+    printf("scan:  %.0f ns/route, %.1f s for %d routes; index %.0fx faster\n",
+        ts * 1e9, ts * nroutes, nroutes, ts / ti);
+
+    hits = 0;
+    for (int r = 0; r < BENCH_SAMPLE; r++) bgp_rt_index_import(idx, routes[r], nroute[r], bench_hit, NULL);
+    printf("  first %d routes: scan %llu imports, index %llu\n", BENCH_SAMPLE,
+        (unsigned long long)scanned, (unsigned long long)hits);
+    if (hits != scanned) bad = 1;
+
+    printf("reconfig\n");
+    q = BGP_RT_AS2(65000, 5);
+    bgp_rt_index_set_imports(idx, 5, &q, 1);
+    bgp_rt_index_set_imports(idx, 64, NULL, 0);
+    q = BGP_RT_AS2(65001, 0);
+    bad |= bench_check("hub 0 VRFs", bgp_rt_index_match(idx, &q, 1, &set), 15);
+    q = BGP_RT_AS2(65002, 1);
+    bad |= bench_check("shared-services VRFs", bgp_rt_index_match(idx, &q, 1, &set), 63);
+
+    printf("repeats\n");
+    uint64_t twice[2] = { BGP_RT_AS2(64513, 1), BGP_RT_AS2(64513, 1) };
+    bgp_rt_index_get_stats(idx, &st0);
+    bgp_rt_index_set_imports(idx, 64, twice, 2);
+    bgp_rt_index_get_stats(idx, &st);
+    bad |= bench_check("route-targets after [A, A]", st.rts, st0.rts + 1);
+    bgp_rt_index_set_imports(idx, 64, NULL, 0);
+    bgp_rt_index_get_stats(idx, &st);
+    bad |= bench_check("route-targets after []", st.rts, st0.rts);
+    bad |= bench_check("VRFs with imports", st.vrfs, st0.vrfs);
+
+    printf("swap\n");
+    pthread_t th;
+    uint64_t a = BGP_RT_AS2(64512, 1), b = BGP_RT_AS2(64512, 2);
+    swap_idx = idx;
+    bgp_rt_index_set_imports(idx, 7, &a, 1);
+    pthread_create(&th, NULL, bench_swap_reader, NULL);
+    for (int i = 0; i < BENCH_SWAPS; i++) bgp_rt_index_set_imports(idx, 7, i & 1 ? &a : &b, 1);
+    atomic_store(&swap_done, true);
+    pthread_join(th, NULL);
+    printf("  %d swaps, %llu reads\n", BENCH_SWAPS, (unsigned long long)swap_reads);
+    bad |= bench_check("reads missing the VRF", (uint32_t)swap_missed, 0);
+
+    printf("range\n");
+    bad |= bench_check("set_imports(BGP_RT_MAX_VRFS)",
+        (uint32_t)bgp_rt_index_set_imports(idx, BGP_RT_MAX_VRFS, &a, 1), (uint32_t)-1);
+
+    bgp_rt_index_destroy(idx);
+    free(routes);
+    free(nroute);
+    return bad ? 1 : 0;
+}
@@ -0,0 +1,224 @@
+/*
+ * cluster_rejoin_bench.c - Persisted Rejoin and Delta Sync Benchmark
+ *
+ * NetBlade OS v3.x Development Tools
+ * Copyright (c) 2024-2026 Enterprise Systems Inc. All rights reserved.
+ *
+ * Two cluster instances in one process with queued sync delivery, as
+ * in cluster_sync_bench. The ACTIVE side is attached to the HA MAC
+ * table, so learning entries feeds its change log. After a full sync
+ * the STANDBY "reboots": its instance is destroyed while more entries
+ * are learned, then recreated from its persisted state and asks for a
+ * delta. Finally the ACTIVE's sync instance is recreated, as after a
+ * restart, which must force a full sync on the next request.
+ *
+ *   cc -O2 -std=gnu11 -Isrc/ha -Isrc/common tools/bench/cluster_rejoin_bench.c \
+ *      src/ha/cluster_sync.c src/ha/cluster_state.c src/ha/cluster_groups.c \
+ *      src/ha/cluster_journal.c src/ha/cluster_persist.c src/ha/heartbeat_stats.c \
+ *      src/ha/mac_table.c src/common/nb_mutex.c src/common/nb_prof.c \
+ *      src/common/nb_telemetry.c -lpthread -o cluster_rejoin_bench
+ *   ./cluster_rejoin_bench [macs] [changes]      (default 100000 1000)
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <stdbool.h>
+#include <time.h>
+#include <unistd.h>
+#include "cluster_sync.h"
+#include "cluster_track.h"
+#include "mac_table.h"
+#include "vip_announce.h"
+#include "vrf_manager.h"
+
+#define BENCH_STATE     "/tmp/cluster_rejoin_bench.state"
+
+/* Node-wide side effects, stubbed */
+void syslog_write(int level, const char *fmt, ...) { (void)level; (void)fmt; }
+void cluster_activate_virtual_ips(void) {}
+void cluster_release_virtual_ips(void) {}
+void cluster_activate_vrf_virtual_ips(uint32_t vrf_id) { (void)vrf_id; }
+void cluster_release_vrf_virtual_ips(uint32_t vrf_id) { (void)vrf_id; }
+long get_system_uptime(void) { return 0; }
+long get_peer_uptime(void) { return 0; }
+int heartbeat_send(const heartbeat_msg_t *msg) { (void)msg; return 0; }
+void vip_announce_start(void) {}
+void vip_announce_cancel(void) {}
+void vip_announce_start_vrfs(const uint32_t *v, int n) { (void)v; (void)n; }
+void vip_announce_cancel_vrfs(const uint32_t *v, int n) { (void)v; (void)n; }
+void vip_announce_start_except(const uint32_t *v, int n) { (void)v; (void)n; }
+void vip_announce_cancel_except(const uint32_t *v, int n) { (void)v; (void)n; }
+int vip_announce_get_list(vip_announce_entry_t *list, int max) { (void)list; (void)max; return 0; }
+int vip_announce_find(uint32_t ifindex, const uint8_t *addr, uint8_t addr_len)
+{
+    (void)ifindex; (void)addr; (void)addr_len;
+    return -1;
+}
+int vip_announce_add(uint32_t ifindex, const uint8_t *addr, uint8_t addr_len)
+{
+    (void)ifindex; (void)addr; (void)addr_len;
+    return -1;
+}
+int vip_announce_set_vrf(int vip_id, uint32_t vrf_id) { (void)vip_id; (void)vrf_id; return 0; }
+uint8_t cluster_track_get_health(void) { return CLUSTER_HEALTH_MAX; }
+uint8_t cluster_track_get_health_mask(uint64_t mask) { (void)mask; return CLUSTER_HEALTH_MAX; }
+int cluster_track_subscribe(cluster_health_cb_t cb, void *ctx) { (void)cb; (void)ctx; return 0; }
+void cluster_track_claim(uint64_t claim, uint64_t release) { (void)claim; (void)release; }
+int vrf_manager_get_count(void) { return 0; }
+int vrf_manager_get_vrf_list(vrf_info_t *list, int max) { (void)list; (void)max; return 0; }
+int bgp_timers_set(uint32_t vrf_id, uint32_t hold_time, uint32_t keepalive)
+{
+    (void)vrf_id; (void)hold_time; (void)keepalive;
+    return 0;
+}
+int bgp_timers_get_configured(uint32_t *vrf_ids, uint32_t *hold_times, uint32_t *keepalives, int max)
+{
+    (void)vrf_ids; (void)hold_times; (void)keepalives; (void)max;
+    return 0;
+}
+void bgp_timers_set_change_cb(void (*cb)(uint32_t vrf_id, uint32_t hold_time,
+                                         uint32_t keepalive, void *ctx), void *ctx)
+{
+    (void)cb; (void)ctx;
+}
+
+/* Per-direction message queue */
+typedef struct {
+    cluster_sync_msg_t *msgs;
+    int                 count;
+    int                 cap;
+    int                 head;
+} bench_queue_t;
+
+static bench_queue_t to_a, to_b;
+
+static uint64_t now_ns(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000000000ULL + (uint64_t)ts.tv_nsec;
+}
+
+static int bench_queue(const cluster_sync_msg_t *msg, void *ctx)
+{
+    bench_queue_t *q = ctx;
+
+    if (q->count == q->cap) {
+        q->cap = q->cap ? q->cap * 2 : 64;
+        q->msgs = realloc(q->msgs, (size_t)q->cap * sizeof(*msg));
+        if (!q->msgs) return -1;
+    }
+    q->msgs[q->count++] = *msg;
+    return 0;
+}
+
+static void bench_pump(cluster_sync_t *sa, cluster_sync_t *sb)
+{
+    while (to_a.head < to_a.count || to_b.head < to_b.count) {
+        while (to_b.head < to_b.count) cluster_sync_receive(sb, &to_b.msgs[to_b.head++]);
+        while (to_a.head < to_a.count) cluster_sync_receive(sa, &to_a.msgs[to_a.head++]);
+    }
+}
+
+static int bench_heartbeat(cluster_t *c, const heartbeat_msg_t *msg, void *ctx)
+{
+    (void)c;
+    return ctx ? cluster_receive((cluster_t *)ctx, msg) : 0;
+}
+
+/* Learn 'count' new HA entries in a range of their own */
+static void bench_learn(uint8_t range, int count)
+{
+    uint8_t mac[6] = { range, 0, 0, 0, 0, 0 };
+    uint32_t now = (uint32_t)(now_ns() / 1000000000ULL);
+
+    for (int i = 0; i < count; i++) {
+        mac[2] = (uint8_t)(i >> 16);
+        mac[3] = (uint8_t)(i >> 8);
+        mac[4] = (uint8_t)i;
+        mac_table_learn(mac_table_ha_instance(), mac, 10, (uint32_t)(i % 48), MAC_OWNER_HA, now);
+    }
+}
+
+int main(int argc, char **argv)
+{
+    int macs = argc > 1 ? atoi(argv[1]) : 100000;
+    int changes = argc > 2 ? atoi(argv[2]) : 1000;
+    static const cluster_ops_t ops = { .send = bench_heartbeat };
+    cluster_sync_stats_t st;
+    uint64_t epoch, version, t0, t1;
+
+    unlink(BENCH_STATE);
+    if (mac_table_ha_init((uint32_t)(macs + 4 * changes) * 2, 300) != 0) return 1;
+    bench_learn(2, macs);
+
+    cluster_t *b = cluster_create(2, "B", &ops, NULL);
+    cluster_t *a = cluster_create(1, "A", &ops, b);
+    cluster_destroy(b);
+    b = cluster_create(2, "B", &ops, a);
+    cluster_enable_persist(b, BENCH_STATE);
+    cluster_set_role(a, 1);     /* ACTIVE */
+    cluster_set_role(b, 2);     /* STANDBY */
+    cluster_tick(a);
+    cluster_tick(b);
+    cluster_tick(a);
+
+    cluster_sync_t *sa = cluster_sync_create(a, bench_queue, &to_b);
+    cluster_sync_t *sb = cluster_sync_create(b, bench_queue, &to_a);
+    cluster_sync_attach(sa);
+
+    t0 = now_ns();
+    cluster_sync_start(sa);
+    bench_pump(sa, sb);
+    t1 = now_ns();
+    cluster_sync_get_stats(sa, &st);
+    printf("full sync:   %u records, %.1f ms\n", st.records_sent, (double)(t1 - t0) / 1e6);
+
+    /* Live changes stream to the synced peer; its tick persists the sync point */
+    bench_learn(4, changes);
+    bench_pump(sa, sb);
+    cluster_tick(b);
+    cluster_get_sync_point(b, &epoch, &version);
+    printf("before reboot: STANDBY at epoch %llu version %llu\n",
+        (unsigned long long)epoch, (unsigned long long)version);
+
+    /* STANDBY reboots; what is sent meanwhile is lost */
+    cluster_sync_destroy(sb);
+    cluster_destroy(b);
+    bench_learn(6, changes);
+    to_b.head = to_b.count;
+
+    b = cluster_create(2, "B", &ops, a);
+    int rejoined = cluster_enable_persist(b, BENCH_STATE);
+    sb = cluster_sync_create(b, bench_queue, &to_a);
+
+    t0 = now_ns();
+    cluster_sync_request_delta(sb);
+    bench_pump(sa, sb);
+    t1 = now_ns();
+    cluster_sync_get_stats(sa, &st);
+    cluster_get_sync_point(b, &epoch, &version);
+    printf("rejoin:      rejoined %d, delta %d, %u records, %.3f ms, now at version %llu of %llu\n",
+        rejoined, st.delta, st.records_sent, (double)(t1 - t0) / 1e6,
+        (unsigned long long)version, (unsigned long long)st.version);
+    bool delta_ok = rejoined && st.delta && version == st.version;
+
+    /* ACTIVE's change log restarts: its versions must not be trusted as a delta */
+    cluster_sync_destroy(sa);
+    to_a.head = to_a.count;
+    sa = cluster_sync_create(a, bench_queue, &to_b);
+    cluster_sync_attach(sa);
+    bench_learn(8, changes);
+    to_b.head = to_b.count;
+
+    cluster_sync_request_delta(sb);
+    bench_pump(sa, sb);
+    cluster_sync_get_stats(sa, &st);
+    printf("log restart: delta %d, %u records (full sync expected)\n", st.delta, st.records_sent);
+
+    cluster_sync_destroy(sa);
+    cluster_sync_destroy(sb);
+    unlink(BENCH_STATE);
+    return !delta_ok || st.delta;
+}
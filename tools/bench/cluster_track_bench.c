@@ -0,0 +1,224 @@
+/*
+ * cluster_track_bench.c - Tracked Object and Failover Group Health Test
+ *
+ * NetBlade OS v3.x Development Tools
+ * Copyright (c) 2024-2026 Enterprise Systems Inc. All rights reserved.
+ *
+ * Runs an HA pair in one process: A follows the real cluster_track
+ * table, B keeps full health. Heartbeats are queued and delivered
+ * between steps. Failover group 0 holds VRF 10 and tracks a BGP session
+ * in it; the uplink interface is tracked node-wide.
+ *
+ *   group     - the group's session goes down: only group 0 moves to B,
+ *               A stays ACTIVE with full node-wide health
+ *   node      - the uplink goes down as well: the cluster moves to B
+ *   removed   - both come back and the group is removed; when the
+ *               session goes down again it counts node-wide
+ *   order     - two threads flap an interface each while a slow
+ *               subscriber watches: its calls must never overlap and
+ *               the last score it sees must be the final one
+ *
+ *   cc -O2 -std=gnu11 -Isrc/ha -Isrc/common tools/bench/cluster_track_bench.c \
+ *      src/ha/cluster_track.c src/ha/cluster_state.c src/ha/cluster_groups.c \
+ *      src/ha/cluster_journal.c src/ha/cluster_persist.c src/ha/heartbeat_stats.c \
+ *      src/common/nb_mutex.c src/common/nb_prof.c src/common/nb_telemetry.c \
+ *      -lpthread -o cluster_track_bench
+ *   ./cluster_track_bench
+ */
+
+#include <stdio.h>
+#include <stdint.h>
+#include <stdbool.h>
+#include <string.h>
+#include <unistd.h>
+#include <pthread.h>
+#include <stdatomic.h>
+#include "cluster_instance.h"
+#include "cluster_track.h"
+#include "cluster_groups.h"
+#include "interface_manager.h"
+#include "vrf_manager.h"
+
+#define BENCH_UPLINK    1
+#define BENCH_VRF       10
+#define BENCH_FLAPS     2000
+
+/* Node-wide side effects, stubbed */
+void syslog_write(int level, const char *fmt, ...) { (void)level; (void)fmt; }
+void cluster_activate_virtual_ips(void) {}
+void cluster_release_virtual_ips(void) {}
+void cluster_activate_mac_tables(void) {}
+void cluster_flush_mac_tables(void) {}
+void cluster_activate_vrf_virtual_ips(uint32_t vrf_id) { (void)vrf_id; }
+void cluster_release_vrf_virtual_ips(uint32_t vrf_id) { (void)vrf_id; }
+long get_system_uptime(void) { return 0; }
+long get_peer_uptime(void) { return 0; }
+int heartbeat_send(const heartbeat_msg_t *msg) { (void)msg; return 0; }
+void vip_announce_start(void) {}
+void vip_announce_cancel(void) {}
+void vip_announce_start_vrfs(const uint32_t *v, int n) { (void)v; (void)n; }
+void vip_announce_cancel_vrfs(const uint32_t *v, int n) { (void)v; (void)n; }
+void vip_announce_start_except(const uint32_t *v, int n) { (void)v; (void)n; }
+void vip_announce_cancel_except(const uint32_t *v, int n) { (void)v; (void)n; }
+int vrf_manager_get_count(void) { return 0; }
+int vrf_manager_get_vrf_list(vrf_info_t *list, int max) { (void)list; (void)max; return 0; }
+int interface_manager_subscribe_link(interface_link_cb_t cb, void *ctx) { (void)cb; (void)ctx; return 0; }
+int interface_manager_get_link_state(uint32_t ifindex, bool *link_up) { (void)ifindex; *link_up = true; return 0; }
+
+/* One queued heartbeat per direction; a newer one replaces it */
+typedef struct {
+    cluster_t       *to;
+    heartbeat_msg_t  msg;
+    bool             pending;
+} bench_link_t;
+
+static bench_link_t to_a, to_b;
+
+static int bench_send(cluster_t *c, const heartbeat_msg_t *msg, void *ctx)
+{
+    bench_link_t *l = ctx;
+
+    (void)c;
+    l->msg = *msg;
+    l->pending = true;
+    return 0;
+}
+
+static bool bench_detached;
+
+static void bench_health(uint8_t health, void *ctx)
+{
+    if (!bench_detached) cluster_set_health((cluster_t *)ctx, health);
+}
+
+static atomic_int order_in_cb;
+static int order_overlaps, order_calls;
+static uint8_t order_last;
+
+static void bench_order_cb(uint8_t health, void *ctx)
+{
+    (void)ctx;
+    if (atomic_fetch_add(&order_in_cb, 1) != 0) order_overlaps++;
+    order_last = health;
+    order_calls++;
+    usleep(20);
+    atomic_fetch_sub(&order_in_cb, 1);
+}
+
+/* Flap one interface, ending down */
+static void *bench_flap(void *arg)
+{
+    uint32_t ifindex = (uint32_t)(uintptr_t)arg;
+
+    for (int i = 0; i < BENCH_FLAPS; i++) {
+        cluster_track_interface_event(ifindex, (i & 1) == 0);
+    }
+    return NULL;
+}
+
+/* Exchange heartbeats until both sides settle */
+static void bench_settle(cluster_t *a, cluster_t *b)
+{
+    for (int r = 0; r < 8; r++) {
+        cluster_tick(a);
+        cluster_tick(b);
+        for (int i = 0; i < 4 && (to_a.pending || to_b.pending); i++) {
+            if (to_b.pending) {
+                to_b.pending = false;
+                cluster_receive(to_b.to, &to_b.msg);
+            }
+            if (to_a.pending) {
+                to_a.pending = false;
+                cluster_receive(to_a.to, &to_a.msg);
+            }
+        }
+    }
+}
+
+static const char *bench_role(uint8_t role)
+{
+    static const char *names[] = { "INIT", "ACTIVE", "STANDBY", "SPLIT" };
+    return role < 4 ? names[role] : "?";
+}
+
+static int bench_check(const char *step, cluster_t *a, cluster_t *b,
+                       uint8_t want_a, uint8_t want_group_a, uint8_t want_health)
+{
+    cluster_status_t sa, sb;
+    uint8_t ga = 0, gb = 0, health = cluster_track_get_health();
+
+    cluster_status(a, &sa);
+    cluster_status(b, &sb);
+    cluster_group_status(a, 0, &ga, NULL);
+    cluster_group_status(b, 0, &gb, NULL);
+
+    printf("%-8s node health %3u  A %-7s B %-7s  group 0: A %-8s B %s\n", step, health,
+        bench_role(sa.local_role), bench_role(sb.local_role),
+        cluster_group_role_name(ga), cluster_group_role_name(gb));
+    return sa.local_role == want_a && ga == want_group_a && health == want_health ? 0 : -1;
+}
+
+int main(void)
+{
+    static const uint8_t peer[4] = { 10, 0, 0, 2 };
+    const uint32_t vrfs[1] = { BENCH_VRF };
+    int bad = 0;
+
+    cluster_track_init();
+    int uplink = cluster_track_add_interface(BENCH_UPLINK, 100);
+    int session = cluster_track_add_bgp_session(BENCH_VRF, peer, 4, 200);
+    if (uplink < 0 || session < 0) return 1;
+    cluster_track_bgp_event(BENCH_VRF, peer, 4, true);
+
+    static const cluster_ops_t ops_a = { .send = bench_send };
+    static const cluster_ops_t ops_b = { .send = bench_send };
+    cluster_t *a = cluster_create(1, "A0001", &ops_a, &to_b);
+    cluster_t *b = cluster_create(2, "B0001", &ops_b, &to_a);
+    if (!a || !b) return 1;
+    to_a.to = a;
+    to_b.to = b;
+
+    cluster_track_subscribe(bench_health, a);
+    cluster_set_role(a, 1);
+    cluster_set_role(b, 2);
+
+    /* Group 0 prefers the lower serial, A, while both are healthy */
+    if (cluster_group_add(a, 0, "tenant", vrfs, 1) != 0 ||
+        cluster_group_add(b, 0, "tenant", vrfs, 1) != 0 ||
+        cluster_group_track(a, 0, 1ULL << session, CLUSTER_HEALTH_MAX) != 0) return 1;
+    bench_settle(a, b);
+    bad |= bench_check("start", a, b, 1, GROUP_ROLE_ACTIVE, CLUSTER_HEALTH_MAX);
+
+    cluster_track_bgp_event(BENCH_VRF, peer, 4, false);
+    bench_settle(a, b);
+    bad |= bench_check("group", a, b, 1, GROUP_ROLE_DEGRADED, CLUSTER_HEALTH_MAX);
+
+    cluster_track_interface_event(BENCH_UPLINK, false);
+    bench_settle(a, b);
+    bad |= bench_check("node", a, b, 2, GROUP_ROLE_DEGRADED, CLUSTER_HEALTH_MAX - 100);
+
+    cluster_track_interface_event(BENCH_UPLINK, true);
+    cluster_track_bgp_event(BENCH_VRF, peer, 4, true);
+    cluster_group_remove(a, 0);
+    cluster_track_bgp_event(BENCH_VRF, peer, 4, false);
+    bench_settle(a, b);
+    bad |= bench_check("removed", a, b, 2, GROUP_ROLE_INIT, CLUSTER_HEALTH_MAX - 200);
+
+    pthread_t th[2];
+    bench_detached = true;
+    cluster_track_add_interface(BENCH_UPLINK + 1, 1);
+    cluster_track_add_interface(BENCH_UPLINK + 2, 2);
+    cluster_track_subscribe(bench_order_cb, NULL);
+    for (int i = 0; i < 2; i++) {
+        pthread_create(&th[i], NULL, bench_flap, (void *)(uintptr_t)(BENCH_UPLINK + 1 + i));
+    }
+    for (int i = 0; i < 2; i++) pthread_join(th[i], NULL);
+    uint8_t health = cluster_track_get_health();
+    printf("order    %d calls, %d overlapping, last score %u, final %u\n",
+        order_calls, order_overlaps, order_last, health);
+    if (order_overlaps || order_last != health) bad = 1;
+
+    cluster_destroy(a);
+    cluster_destroy(b);
+    return bad ? 1 : 0;
+}
@@ -0,0 +1,158 @@
+/*
+ * heartbeat_shm_bench.c - Shared-Memory Heartbeat Loss Detection Test
+ *
+ * NetBlade OS v3.x Development Tools
+ * Copyright (c) 2024-2026 Enterprise Systems Inc. All rights reserved.
+ *
+ * Forks into two "supervisors" on one shared-memory heartbeat region,
+ * ACTIVE in the parent and STANDBY in the child. Both tick for a second,
+ * then the child kills itself with SIGKILL. The parent reports how long
+ * after the child's last pulse the loss was declared, along with the
+ * message, retry and monitor wakeup counts. Run as root (or with
+ * CAP_SYS_NICE) so the pulse thread gets SCHED_FIFO; without it a
+ * loaded machine can show false losses at sub-millisecond settings.
+ *
+ * With 'midwrite' the child first leaves its message sequence odd, as
+ * if it died between the two halves of a publish, and keeps pulsing
+ * for 10 ms before the kill. The loss must still be declared, and the
+ * slot must come back even when the standby reattaches.
+ *
+ *   cc -O2 -std=gnu11 -Isrc/ha -Isrc/common tools/bench/heartbeat_shm_bench.c \
+ *      src/ha/heartbeat_shm.c src/ha/cluster_state.c src/ha/cluster_groups.c \
+ *      src/ha/cluster_journal.c src/ha/cluster_persist.c src/ha/heartbeat_stats.c \
+ *      src/common/nb_mutex.c src/common/nb_prof.c src/common/nb_telemetry.c \
+ *      -lpthread -lrt -o heartbeat_shm_bench
+ *   ./heartbeat_shm_bench [pulse_us] [miss] [midwrite]     (default 100 5)
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <stdatomic.h>
+#include <string.h>
+#include <signal.h>
+#include <fcntl.h>
+#include <time.h>
+#include <unistd.h>
+#include <sys/wait.h>
+#include <sys/mman.h>
+#include "heartbeat_shm.h"
+#include "cluster_track.h"
+#include "vrf_manager.h"
+
+#define BENCH_SHM_NAME  "/netblade-hb-bench"
+
+/* Region layout, from heartbeat_shm.c: 64-byte header, then the slots */
+#define BENCH_SLOT_SIZE_OFF     8
+#define BENCH_MSG_SEQ_OFF       64
+
+/* Node-wide side effects, stubbed */
+void syslog_write(int level, const char *fmt, ...) { (void)level; (void)fmt; }
+void cluster_activate_virtual_ips(void) {}
+void cluster_release_virtual_ips(void) {}
+void cluster_activate_mac_tables(void) {}
+void cluster_flush_mac_tables(void) {}
+void cluster_activate_vrf_virtual_ips(uint32_t vrf_id) { (void)vrf_id; }
+void cluster_release_vrf_virtual_ips(uint32_t vrf_id) { (void)vrf_id; }
+long get_system_uptime(void) { return 0; }
+long get_peer_uptime(void) { return 0; }
+int heartbeat_send(const heartbeat_msg_t *msg) { (void)msg; return 0; }
+void vip_announce_start(void) {}
+void vip_announce_cancel(void) {}
+void vip_announce_start_except(const uint32_t *v, int n) { (void)v; (void)n; }
+void vip_announce_cancel_except(const uint32_t *v, int n) { (void)v; (void)n; }
+void vip_announce_start_vrfs(const uint32_t *v, int n) { (void)v; (void)n; }
+void vip_announce_cancel_vrfs(const uint32_t *v, int n) { (void)v; (void)n; }
+uint8_t cluster_track_get_health(void) { return CLUSTER_HEALTH_MAX; }
+uint8_t cluster_track_get_health_mask(uint64_t mask) { (void)mask; return CLUSTER_HEALTH_MAX; }
+int cluster_track_subscribe(cluster_health_cb_t cb, void *ctx) { (void)cb; (void)ctx; return 0; }
+void cluster_track_claim(uint64_t claim, uint64_t release) { (void)claim; (void)release; }
+int vrf_manager_get_count(void) { return 0; }
+int vrf_manager_get_vrf_list(vrf_info_t *list, int max) { (void)list; (void)max; return 0; }
+
+/* The msg_seq word of a slot, in a mapping of the bench's own */
+static _Atomic uint32_t *bench_msg_seq(uint8_t slot)
+{
+    int fd = shm_open(BENCH_SHM_NAME, O_RDWR, 0600);
+    if (fd < 0) return NULL;
+
+    uint8_t *raw = mmap(NULL, 4096, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+    close(fd);
+    if (raw == MAP_FAILED) return NULL;
+
+    uint32_t slot_size;
+    memcpy(&slot_size, raw + BENCH_SLOT_SIZE_OFF, sizeof(slot_size));
+    return (_Atomic uint32_t *)(raw + 64 + slot * slot_size + BENCH_MSG_SEQ_OFF);
+}
+
+int main(int argc, char **argv)
+{
+    uint32_t pulse_us = argc > 1 ? (uint32_t)atoi(argv[1]) : HB_SHM_DEFAULT_PULSE_US;
+    uint32_t miss = argc > 2 ? (uint32_t)atoi(argv[2]) : HB_SHM_DEFAULT_MISS;
+    int midwrite = argc > 3 && strcmp(argv[3], "midwrite") == 0;
+    struct timespec tick = { 0, 10 * 1000000 };
+
+    shm_unlink(BENCH_SHM_NAME);
+
+    pid_t pid = fork();
+    if (pid < 0) return 1;
+    uint8_t slot = (pid == 0);
+
+    hb_shm_t *h = hb_shm_open(BENCH_SHM_NAME, slot);
+    if (!h || hb_shm_configure(h, pulse_us, miss) != 0) return 1;
+
+    static const cluster_ops_t ops = { .send = hb_shm_cluster_send };
+    cluster_t *c = cluster_create(7, slot ? "S1" : "S0", &ops, h);
+
+    cluster_set_role(c, slot ? 2 : 1);      /* STANDBY : ACTIVE */
+    hb_shm_start(h, c);
+
+    for (int i = 0; i < 100; i++) {
+        cluster_tick(c);
+        nanosleep(&tick, NULL);
+    }
+
+    /* The STANDBY supervisor dies without any chance to clean up */
+    if (slot == 1) {
+        if (midwrite) {
+            _Atomic uint32_t *seq = bench_msg_seq(1);
+            struct timespec pulses = { 0, 10 * 1000000 };
+
+            if (seq) atomic_fetch_or(seq, 1);
+            nanosleep(&pulses, NULL);
+        }
+        kill(getpid(), SIGKILL);
+    }
+
+    for (int i = 0; i < 20; i++) nanosleep(&tick, NULL);
+    waitpid(pid, NULL, 0);
+
+    hb_shm_stats_t st;
+    cluster_status_t cs;
+
+    hb_shm_get_stats(h, &st);
+    cluster_status(c, &cs);
+    printf("pulse %u us, miss %u: %llu pulses, %llu msgs sent, %llu received, "
+        "%llu read retries, %llu monitor wakeups\n", pulse_us, miss,
+        (unsigned long long)st.pulses, (unsigned long long)st.msgs_sent,
+        (unsigned long long)st.msgs_received, (unsigned long long)st.read_retries,
+        (unsigned long long)st.wakeups);
+    printf("losses %u, detected %.1f us after last pulse, heartbeat_up %d\n",
+        st.losses, (double)st.last_detect_ns / 1e3, cs.heartbeat_up);
+
+    int bad = st.losses != 1 || cs.heartbeat_up;
+    if (midwrite) {
+        /* The standby restarts on its old slot */
+        hb_shm_t *again = hb_shm_open(BENCH_SHM_NAME, 1);
+        _Atomic uint32_t *seq = bench_msg_seq(1);
+
+        printf("midwrite: %llu reads abandoned, slot 1 sequence %s after reattach\n",
+            (unsigned long long)st.read_abandoned, seq && (*seq & 1) ? "odd" : "even");
+        if (!again || !seq || (*seq & 1) || st.read_abandoned == 0) bad = 1;
+        hb_shm_close(again);
+    }
+
+    hb_shm_close(h);
+    shm_unlink(BENCH_SHM_NAME);
+    return bad;
+}
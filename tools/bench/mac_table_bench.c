@@ -0,0 +1,212 @@
+/*
+ * mac_table_bench.c - MAC Table Learn/Lookup/Age Benchmark
+ *
+ * NetBlade OS v3.x Development Tools
+ * Copyright (c) 2024-2026 Enterprise Systems Inc. All rights reserved.
+ *
+ * Learns N MACs spread over 4094 VLANs, half of them HA-owned, looks
+ * each up with the HA owner in service, then ages the whole table out
+ * with one wheel step and checks nothing is left. Then:
+ *
+ *   zero   - 00:00:00:00:00:00 on VLAN 0 is an ordinary key: learned,
+ *            looked up, walked and deleted like any other
+ *   churn  - a reader thread looks up a fixed half of a table while the
+ *            main thread fills the rest and empties it again, forcing
+ *            cuckoo displacements; the reader must never miss
+ *
+ * Exits non-zero if any step misbehaves.
+ *
+ *   cc -O2 -std=gnu11 -Isrc/ha -Isrc/common tools/bench/mac_table_bench.c \
+ *      src/ha/mac_table.c src/common/nb_mutex.c -lpthread -o mac_table_bench
+ *   ./mac_table_bench [entries]
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdarg.h>
+#include <stdint.h>
+#include <stdbool.h>
+#include <time.h>
+#include <pthread.h>
+#include <stdatomic.h>
+#include "mac_table.h"
+
+#define BENCH_CHURN_CAP     65536
+#define BENCH_CHURN_MS      1000
+
+void syslog_write(int level, const char *fmt, ...)
+{
+    (void)level;
+    (void)fmt;
+}
+
+static double now_ns(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec * 1e9 + ts.tv_nsec;
+}
+
+static void make_mac(uint8_t mac[6], uint32_t i)
+{
+    mac[0] = 0x02;
+    mac[1] = (uint8_t)(i >> 24);
+    mac[2] = (uint8_t)(i >> 16);
+    mac[3] = (uint8_t)(i >> 8);
+    mac[4] = (uint8_t)i;
+    mac[5] = 0x07;
+}
+
+static int bench_count_cb(const uint8_t mac[6], uint16_t vlan, uint32_t ifindex,
+                          uint32_t last_seen, void *ctx)
+{
+    (void)mac;
+    (void)vlan;
+    (void)ifindex;
+    (void)last_seen;
+    (*(int *)ctx)++;
+    return 0;
+}
+
+static int bench_zero(void)
+{
+    static const uint8_t zero[6];
+    mac_table_t *t = mac_table_create(16, 300);
+    uint32_t ifindex = 0;
+    int walked = 0, walked_after = 0;
+
+    if (!t) return -1;
+
+    /* A freed neighbour first, so the zero key shares the table with a dead entry */
+    uint8_t mac[6];
+    make_mac(mac, 1);
+    mac_table_learn(t, mac, 1, 1, MAC_OWNER_LOCAL, 100);
+    mac_table_delete(t, mac, 1);
+
+    int learned = mac_table_learn(t, zero, 0, 5, MAC_OWNER_LOCAL, 100);
+    int found = mac_table_lookup(t, zero, 0, &ifindex);
+    mac_table_walk(t, MAC_OWNER_LOCAL, bench_count_cb, &walked);
+    int deleted = mac_table_delete(t, zero, 0);
+    int gone = mac_table_lookup(t, zero, 0, NULL);
+    mac_table_walk(t, MAC_OWNER_LOCAL, bench_count_cb, &walked_after);
+
+    printf("zero: learn %d, lookup %d (ifindex %u), walked %d, delete %d, "
+        "then lookup %d, walked %d\n", learned, found, ifindex, walked, deleted,
+        gone, walked_after);
+
+    mac_table_destroy(t);
+    return learned == 0 && found == 0 && ifindex == 5 && walked == 1 &&
+        deleted == 0 && gone != 0 && walked_after == 0 ? 0 : -1;
+}
+
+typedef struct {
+    mac_table_t   *t;
+    uint32_t       n;
+    atomic_bool    stop;
+    uint64_t       lookups;
+    uint64_t       misses;
+} bench_reader_t;
+
+static void *bench_reader(void *arg)
+{
+    bench_reader_t *r = arg;
+    uint8_t mac[6];
+
+    while (!atomic_load(&r->stop)) {
+        for (uint32_t i = 0; i < r->n; i++) {
+            uint32_t ifindex;
+            make_mac(mac, i);
+            if (mac_table_lookup(r->t, mac, (uint16_t)(i % 4094), &ifindex) != 0 ||
+                ifindex != i + 1) r->misses++;
+        }
+        r->lookups += r->n;
+    }
+    return NULL;
+}
+
+static int bench_churn(void)
+{
+    mac_table_t *t = mac_table_create(BENCH_CHURN_CAP, 300);
+    bench_reader_t r = { .t = t, .n = BENCH_CHURN_CAP / 2 };
+    uint32_t churn = BENCH_CHURN_CAP - r.n - BENCH_CHURN_CAP / 32;
+    uint64_t rounds = 0, full = 0;
+    uint8_t mac[6];
+    pthread_t th;
+
+    if (!t) return -1;
+    for (uint32_t i = 0; i < r.n; i++) {
+        make_mac(mac, i);
+        if (mac_table_learn(t, mac, (uint16_t)(i % 4094), i + 1, MAC_OWNER_LOCAL, 100) != 0) return -1;
+    }
+
+    if (pthread_create(&th, NULL, bench_reader, &r) != 0) return -1;
+    double t0 = now_ns();
+    while (now_ns() - t0 < BENCH_CHURN_MS * 1e6) {
+        for (uint32_t i = 0; i < churn; i++) {
+            make_mac(mac, 0x80000000u | i);
+            full += mac_table_learn(t, mac, (uint16_t)(i % 4094), 0, MAC_OWNER_LOCAL, 100) != 0;
+        }
+        for (uint32_t i = 0; i < churn; i++) {
+            make_mac(mac, 0x80000000u | i);
+            mac_table_delete(t, mac, (uint16_t)(i % 4094));
+        }
+        rounds++;
+    }
+    atomic_store(&r.stop, true);
+    pthread_join(th, NULL);
+    double secs = (now_ns() - t0) / 1e9;
+
+    printf("churn: %u fixed, %u churned x %llu rounds (%llu full), "
+        "%.1f M lookups/s, %llu missed\n", r.n, churn, (unsigned long long)rounds,
+        (unsigned long long)full, (double)r.lookups / secs / 1e6,
+        (unsigned long long)r.misses);
+
+    mac_table_destroy(t);
+    return r.misses == 0 && full == 0 ? 0 : -1;
+}
+
+int main(int argc, char **argv)
+{
+    uint32_t n = argc > 1 ? (uint32_t)strtoul(argv[1], NULL, 10) : 1000000;
+    mac_table_t *t = mac_table_create(n, 300);
+    uint8_t mac[6];
+    int fail = 0, miss = 0, visible = 0;
+
+    if (!t) return 1;
+
+    double t0 = now_ns();
+    for (uint32_t i = 0; i < n; i++) {
+        make_mac(mac, i);
+        fail += mac_table_learn(t, mac, (uint16_t)(i % 4094), i, (uint8_t)(i & 1), 100) != 0;
+    }
+    double t1 = now_ns();
+
+    mac_table_set_ha_active(t, true);
+    for (uint32_t i = 0; i < n; i++) {
+        uint32_t ifindex;
+        make_mac(mac, i);
+        if (mac_table_lookup(t, mac, (uint16_t)(i % 4094), &ifindex) != 0 || ifindex != i) miss++;
+    }
+    double t2 = now_ns();
+
+    int kept = mac_table_age(t, 399);
+    int aged = mac_table_age(t, 400);
+    double t3 = now_ns();
+
+    for (uint32_t i = 0; i < n; i++) {
+        make_mac(mac, i);
+        visible += mac_table_lookup(t, mac, (uint16_t)(i % 4094), NULL) == 0;
+    }
+
+    printf("%u entries: learn %.1f ns (%d failed), lookup %.1f ns (%d missed)\n",
+        n, (t1 - t0) / n, fail, (t2 - t1) / n, miss);
+    printf("age-out: %d early, %d at expiry in %.1f ms, %u left, %d visible\n",
+        kept, aged, (t3 - t2) / 1e6, mac_table_count(t), visible);
+
+    mac_table_destroy(t);
+
+    int bad = fail || miss || kept || (uint32_t)aged != n;
+    if (bench_zero() != 0) bad = 1;
+    if (bench_churn() != 0) bad = 1;
+    return bad;
+}
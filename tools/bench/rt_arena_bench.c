@@ -0,0 +1,190 @@
+/*
+ * rt_arena_bench.c - Routing Arena Page Size Benchmark
+ *
+ * NetBlade OS v3.x Development Tools
+ * Copyright (c) 2024-2026 Enterprise Systems Inc. All rights reserved.
+ *
+ * Allocates N 64-byte routes from an rt_arena, links them into one
+ * random cycle and walks it, so every step is a dependent load on a
+ * random route the way a full-table lookup or best-path walk is. Runs
+ * once on 4k pages and once with RT_ARENA_HUGE, and reports for each
+ * the backing the chunks got, ns per lookup and dTLB load misses per
+ * lookup from perf_event_open.
+ *
+ * RT_ARENA_HUGE takes the hugetlb pool when it has pages, otherwise
+ * transparent huge pages. To compare all three, run it once with the
+ * pool empty and once with it reserved:
+ *
+ *   echo 0 > /proc/sys/vm/nr_hugepages     (4k and THP)
+ *   echo 200 > /proc/sys/vm/nr_hugepages   (4k and hugetlb, 256 MB)
+ *
+ * Where the dTLB counter is not available (VMs that hide the PMU, or
+ * perf_event_paranoid above 2) the misses are reported as not counted
+ * and only the timing is measured.
+ *
+ *   cc -O2 -std=gnu11 -Isrc/routing -Isrc/common tools/bench/rt_arena_bench.c \
+ *      src/routing/rt_arena.c src/common/nb_numa.c -lpthread -o rt_arena_bench
+ *   ./rt_arena_bench [routes] [lookups]        (default 4194304 20000000)
+ */
+
+#define _GNU_SOURCE
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <stdbool.h>
+#include <string.h>
+#include <errno.h>
+#include <time.h>
+#include <unistd.h>
+#include <sys/ioctl.h>
+#include <sys/syscall.h>
+#include <linux/perf_event.h>
+#include "nb_numa.h"
+#include "rt_arena.h"
+
+typedef struct route {
+    struct route *next;
+    uint32_t      prefix;
+    uint32_t      nh;
+    uint8_t       attrs[48];
+} route_t;
+
+static volatile uint64_t bench_sink;
+
+void syslog_write(int level, const char *fmt, ...)
+{
+    (void)level;
+    (void)fmt;
+}
+
+static double now_s(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec + ts.tv_nsec * 1e-9;
+}
+
+static uint64_t bench_rand(void)
+{
+    static uint64_t x = 88172645463325252ULL;
+
+    x ^= x << 13;
+    x ^= x >> 7;
+    x ^= x << 17;
+    return x;
+}
+
+/* dTLB load misses of this thread; -1 with errno set when not counted */
+static int bench_dtlb_open(void)
+{
+    struct perf_event_attr pe;
+
+    memset(&pe, 0, sizeof(pe));
+    pe.size = sizeof(pe);
+    pe.type = PERF_TYPE_HW_CACHE;
+    pe.config = PERF_COUNT_HW_CACHE_DTLB |
+                (PERF_COUNT_HW_CACHE_OP_READ << 8) |
+                (PERF_COUNT_HW_CACHE_RESULT_MISS << 16);
+    pe.disabled = 1;
+    pe.exclude_kernel = 1;
+    pe.exclude_hv = 1;
+    return (int)syscall(SYS_perf_event_open, &pe, 0, -1, -1, 0);
+}
+
+/* AnonHugePages of the whole process, in kB */
+static long bench_thp_kb(void)
+{
+    char line[128];
+    long kb = -1;
+
+    FILE *f = fopen("/proc/self/smaps_rollup", "r");
+    if (!f) return -1;
+    while (fgets(line, sizeof(line), f)) {
+        if (sscanf(line, "AnonHugePages: %ld kB", &kb) == 1) break;
+    }
+    fclose(f);
+    return kb;
+}
+
+static int bench_run(const char *name, uint32_t flags, size_t nroutes, long lookups)
+{
+    rt_arena_stats_t st;
+    const char *backing = "4k";
+    long thp0 = bench_thp_kb();
+
+    rt_arena_t *a = rt_arena_create(-1, 0, flags);
+    route_t **tab = malloc(nroutes * sizeof(route_t *));
+    if (!a || !tab) return -1;
+
+    for (size_t i = 0; i < nroutes; i++) {
+        tab[i] = rt_arena_alloc(a, sizeof(route_t));
+        if (!tab[i]) return -1;
+        memset(tab[i], 0, sizeof(route_t));
+        tab[i]->prefix = (uint32_t)i;
+    }
+
+    /* Shuffle, then link in shuffled order: one cycle through every route */
+    for (size_t i = nroutes - 1; i > 0; i--) {
+        size_t j = (size_t)(bench_rand() % (i + 1));
+        route_t *t = tab[i];
+        tab[i] = tab[j];
+        tab[j] = t;
+    }
+    for (size_t i = 0; i < nroutes; i++) tab[i]->next = tab[(i + 1) % nroutes];
+
+    rt_arena_get_stats(a, &st);
+    if (st.chunks_hugetlb == st.chunks) backing = "hugetlb";
+    else if (st.chunks_thp == st.chunks) backing = "thp";
+    else if (st.chunks_hugetlb || st.chunks_thp) backing = "mixed";
+    long thp = bench_thp_kb() - thp0;
+
+    /* One pass first so faults and khugepaged are out of the way */
+    route_t *r = tab[0];
+    for (size_t i = 0; i < nroutes; i++) r = r->next;
+
+    int fd = bench_dtlb_open();
+    int perf_errno = fd < 0 ? errno : 0;
+    if (fd >= 0) {
+        ioctl(fd, PERF_EVENT_IOC_RESET, 0);
+        ioctl(fd, PERF_EVENT_IOC_ENABLE, 0);
+    }
+
+    uint64_t sum = 0;
+    double t = now_s();
+    for (long i = 0; i < lookups; i++) {
+        r = r->next;
+        sum += r->prefix;
+    }
+    t = now_s() - t;
+
+    long long misses = -1;
+    if (fd >= 0) {
+        ioctl(fd, PERF_EVENT_IOC_DISABLE, 0);
+        if (read(fd, &misses, sizeof(misses)) != sizeof(misses)) misses = -1;
+        close(fd);
+    }
+
+    printf("%-5s %-8s %4u chunks, %6.1f MB, AnonHugePages %+6ld kB: %6.1f ns/lookup",
+        name, backing, st.chunks, st.reserved / 1048576.0, thp, t * 1e9 / lookups);
+    if (misses >= 0) printf(", %.3f dTLB misses/lookup\n", (double)misses / lookups);
+    else printf(", dTLB misses not counted (%s)\n", strerror(perf_errno ? perf_errno : EIO));
+
+    bench_sink = sum;
+    free(tab);
+    rt_arena_destroy(a);
+    return 0;
+}
+
+int main(int argc, char **argv)
+{
+    long nroutes = argc > 1 ? atol(argv[1]) : 4194304;
+    long lookups = argc > 2 ? atol(argv[2]) : 20000000;
+    int bad = 0;
+
+    if (nroutes < 2 || lookups < 1) return 1;
+
+    printf("%ld routes of %zu bytes, %ld lookups\n", nroutes, sizeof(route_t), lookups);
+    if (bench_run("small", 0, (size_t)nroutes, lookups) != 0) bad = 1;
+    if (bench_run("huge", RT_ARENA_HUGE, (size_t)nroutes, lookups) != 0) bad = 1;
+    return bad;
+}
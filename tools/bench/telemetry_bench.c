@@ -0,0 +1,181 @@
+/*
+ * telemetry_bench.c - Streaming Telemetry Benchmark
+ *
+ * NetBlade OS v3.x Development Tools
+ * Copyright (c) 2024-2026 Enterprise Systems Inc. All rights reserved.
+ *
+ * Serves a few cluster and timer keys on a local socket and checks
+ * what subscribers see:
+ *
+ *   flips     - a role and a heartbeat that change and change back
+ *               within microseconds reach an on-change subscriber as
+ *               four lines, in order
+ *   suppress  - a quiet sample subscription sends nothing until its
+ *               heartbeat resends everything
+ *   overrun   - more changes than the log holds resynchronise the
+ *               subscriber, which still ends on the last value
+ *   snapshot  - a snapshot several times the client buffer, which is
+ *               streamed across flushes and ends in "sync"
+ *
+ * Also reports the cost of setting a key to the value it already has.
+ *
+ *   cc -O2 -std=gnu11 -Isrc/common tools/bench/telemetry_bench.c \
+ *      src/common/nb_telemetry.c src/common/nb_mutex.c -lpthread -o telemetry_bench
+ *   ./telemetry_bench [keys]                    (default 4000 for the snapshot)
+ */
+
+#define _GNU_SOURCE
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <stdbool.h>
+#include <string.h>
+#include <time.h>
+#include <poll.h>
+#include <unistd.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include "nb_telemetry.h"
+
+#define BENCH_SOCK      "/tmp/telemetry_bench.sock"
+
+void syslog_write(int level, const char *fmt, ...)
+{
+    (void)level;
+    (void)fmt;
+}
+
+static double now_ns(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec * 1e9 + ts.tv_nsec;
+}
+
+static int bench_subscribe(const char *line)
+{
+    struct sockaddr_un sun = { .sun_family = AF_UNIX };
+    int fd = socket(AF_UNIX, SOCK_STREAM, 0);
+
+    strcpy(sun.sun_path, BENCH_SOCK);
+    if (fd < 0 || connect(fd, (struct sockaddr *)&sun, sizeof(sun)) != 0 ||
+        write(fd, line, strlen(line)) != (ssize_t)strlen(line)) return -1;
+    return fd;
+}
+
+static char bench_last[128];
+
+/*
+ * Read lines until the stream is quiet for quiet_ms. Returns how many
+ * arrived. Those containing 'match' are counted, the last one is kept
+ * in bench_last, and they are printed when verbose.
+ */
+static int bench_read(int fd, int quiet_ms, const char *match, bool verbose, int *matched)
+{
+    static char buf[1 << 16];
+    int lines = 0, len = 0;
+
+    if (matched) *matched = 0;
+    for (;;) {
+        struct pollfd pfd = { .fd = fd, .events = POLLIN };
+        if (poll(&pfd, 1, quiet_ms) <= 0) break;
+
+        ssize_t n = read(fd, buf + len, sizeof(buf) - 1 - (size_t)len);
+        if (n <= 0) break;
+        len += (int)n;
+        buf[len] = '\0';
+
+        char *line = buf, *nl;
+        while ((nl = strchr(line, '\n'))) {
+            *nl = '\0';
+            lines++;
+            if (match && strstr(line, match)) {
+                if (matched) (*matched)++;
+                snprintf(bench_last, sizeof(bench_last), "%.127s", line);
+                if (verbose) printf("    %s\n", line);
+            }
+            line = nl + 1;
+        }
+        len -= (int)(line - buf);
+        memmove(buf, line, (size_t)len);
+    }
+    return lines;
+}
+
+int main(int argc, char **argv)
+{
+    int nbig = argc > 1 ? atoi(argv[1]) : 4000;
+    nb_telemetry_stats_t st;
+    int matched, bad = 0;
+
+    if (nbig < 1 || nbig > NB_TELEMETRY_MAX_KEYS - 8) return 1;
+
+    int role = nb_telemetry_key("cluster/1/role", NB_TELEMETRY_STATE);
+    int hb = nb_telemetry_key("cluster/1/heartbeat_up", NB_TELEMETRY_STATE);
+    int margin = nb_telemetry_key("cluster/1/hold_margin_ms", NB_TELEMETRY_SAMPLED);
+    int hold = nb_telemetry_key("bgp/vrf/5/hold_time", NB_TELEMETRY_STATE);
+
+    nb_telemetry_set(role, 2);
+    nb_telemetry_set(hb, 1);
+    nb_telemetry_set(margin, 2900);
+    nb_telemetry_set(hold, 180);
+
+    /* Long paths so the snapshot is several client buffers */
+    for (int i = 0; i < nbig; i++) {
+        char path[NB_TELEMETRY_KEY_LEN];
+        snprintf(path, sizeof(path), "bench/snapshot/%s/%05d",
+            "a-rather-long-component-for-the-test", i);
+        nb_telemetry_set(nb_telemetry_key(path, NB_TELEMETRY_STATE), i + 1);
+    }
+
+    if (nb_telemetry_start(BENCH_SOCK) != 0) return 1;
+
+    int oc = bench_subscribe("subscribe cluster/ on-change\n");
+    int sp = bench_subscribe("subscribe cluster/1/ sample 200 suppress heartbeat 3000\n");
+    if (oc < 0 || sp < 0) return 1;
+    bench_read(oc, 100, NULL, false, NULL);
+    bench_read(sp, 100, NULL, false, NULL);
+
+    printf("flips: role 2->1->2, heartbeat 1->0->1\n");
+    nb_telemetry_set(role, 1);
+    nb_telemetry_set(role, 2);
+    nb_telemetry_set(hb, 0);
+    nb_telemetry_set(hb, 1);
+    if (bench_read(oc, 100, "cluster/", true, &matched) != 4) bad = 1;
+    bench_read(sp, 300, NULL, false, NULL);
+
+    printf("suppress: 1 s quiet, then the heartbeat\n");
+    int quiet = bench_read(sp, 1000, NULL, false, NULL);
+    int beat = bench_read(sp, 2500, NULL, false, NULL);
+    printf("    %d lines while quiet, %d at the heartbeat\n", quiet, beat);
+    if (quiet != 0 || beat != 3) bad = 1;
+
+    double t = now_ns();
+    for (int i = 0; i < 10000000; i++) nb_telemetry_set(role, 2);
+    printf("unchanged set: %.2f ns\n", (now_ns() - t) / 1e7);
+
+    int bg = bench_subscribe("subscribe bgp/ on-change\n");
+    if (bg < 0) return 1;
+    bench_read(bg, 100, NULL, false, NULL);
+    nb_telemetry_get_stats(&st);
+    uint64_t resyncs = st.resyncs;
+    for (int i = 0; i < 2 * NB_TELEMETRY_LOG_SIZE; i++) nb_telemetry_set(hold, i + 1);
+    int lines = bench_read(bg, 200, "hold_time", false, NULL);
+    nb_telemetry_get_stats(&st);
+    printf("overrun: %d changes -> %d lines, %llu resyncs, last \"%s\"\n",
+        2 * NB_TELEMETRY_LOG_SIZE, lines, (unsigned long long)(st.resyncs - resyncs), bench_last);
+    char *value = strrchr(bench_last, ' ');
+    if (st.resyncs == resyncs || !value || atoi(value + 1) != 2 * NB_TELEMETRY_LOG_SIZE) bad = 1;
+
+    t = now_ns();
+    int big = bench_subscribe("subscribe bench/ on-change\n");
+    if (big < 0) return 1;
+    lines = bench_read(big, 200, "sync", false, &matched);
+    printf("snapshot: %d keys, %d lines with sync %d in %.1f ms (client buffer %d KB)\n",
+        nbig, lines, matched, (now_ns() - t) / 1e6 - 200, NB_TELEMETRY_OUT_BUF / 1024);
+    if (lines != nbig + 1 || matched != 1) bad = 1;
+
+    nb_telemetry_dump();
+    nb_telemetry_stop();
+    return bad;
+}